@@ -179,37 +179,65 @@ namespace Falcor
 
         size_t getBufferCount() const { return mpBufferLayouts.size(); }
 
-        void addVertexAttribDclToProg(Program* pProg) const
+        /** Get the vertex attribute defines addVertexAttribDclToProg() sets, as a bit mask. Layouts with the same mask use the same program variant.
+        */
+        uint32_t getProgramVariant() const
         {
-            pProg->removeDefine("HAS_TEXCRD");
-            pProg->removeDefine("HAS_COLORS");
-            pProg->removeDefine("HAS_LIGHTMAP_UV");
-
+            uint32_t variant = 0;
             for (const auto& l : mpBufferLayouts)
             {
                 if(l)
                 {
                     for (uint32_t i = 0; i < l->getElementCount(); i++)
                     {
-                        if (l->getElementShaderLocation(i) == VERTEX_TEXCOORD_LOC)
-                        {
-                            pProg->addDefine("HAS_TEXCRD");
-                        }
-                        if (l->getElementShaderLocation(i) == VERTEX_LIGHTMAP_UV_LOC)
-                        {
-                            pProg->addDefine("HAS_LIGHTMAP_UV");
-                        }
-                        if (l->getElementShaderLocation(i) == VERTEX_DIFFUSE_COLOR_LOC)
-                        {
-                            pProg->addDefine("HAS_COLORS");
-                        }
+                        const uint32_t location = l->getElementShaderLocation(i);
+                        const ResourceFormat format = l->getElementFormat(i);
+                        if (location == VERTEX_TEXCOORD_LOC)        variant |= kHasTexCrd;
+                        if (location == VERTEX_LIGHTMAP_UV_LOC)     variant |= kHasLightmapUv;
+                        if (location == VERTEX_DIFFUSE_COLOR_LOC)   variant |= kHasColors;
+
+                        // Compressed attributes, see VertexCompression
+                        if (location == VERTEX_POSITION_LOC && format == ResourceFormat::RGBA16Unorm)   variant |= kHasQuantizedPosition;
+                        if (location == VERTEX_NORMAL_LOC && format == ResourceFormat::RG16Snorm)       variant |= kHasOctahedralNormal;
+                        if (location == VERTEX_BITANGENT_LOC && format == ResourceFormat::RG16Snorm)    variant |= kHasOctahedralBitangent;
                     }
                 }
             }
+            return variant;
+        }
+
+        /** The number of bits used by getProgramVariant()
+        */
+        static const uint32_t kProgramVariantBits = 6;
+
+        void addVertexAttribDclToProg(Program* pProg) const
+        {
+            static const char* kDefines[kProgramVariantBits] = { "HAS_TEXCRD", "HAS_LIGHTMAP_UV", "HAS_COLORS", "HAS_QUANTIZED_POSITION", "HAS_OCTAHEDRAL_NORMAL", "HAS_OCTAHEDRAL_BITANGENT" };
+            const uint32_t variant = getProgramVariant();
+            for (uint32_t bit = 0; bit < kProgramVariantBits; bit++)
+            {
+                if (variant & (1 << bit))
+                {
+                    pProg->addDefine(kDefines[bit]);
+                }
+                else
+                {
+                    pProg->removeDefine(kDefines[bit]);
+                }
+            }
         }
 
     private:
         VertexLayout() { mpBufferLayouts.reserve(16); }
+
+        // Bits of getProgramVariant()
+        static const uint32_t kHasTexCrd = 0x1;
+        static const uint32_t kHasLightmapUv = 0x2;
+        static const uint32_t kHasColors = 0x4;
+        static const uint32_t kHasQuantizedPosition = 0x8;
+        static const uint32_t kHasOctahedralNormal = 0x10;
+        static const uint32_t kHasOctahedralBitangent = 0x20;
+
         std::vector<VertexBufferLayout::SharedConstPtr> mpBufferLayouts;
     };
 }
\ No newline at end of file
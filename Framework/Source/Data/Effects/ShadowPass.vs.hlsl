@@ -43,7 +43,7 @@ ShadowPassVSOut main(VS_IN vIn)
 {
     ShadowPassVSOut vOut; 
     mat4 worldMat = getWorldMat(vIn);
-    vOut.pos = mul(worldMat, vIn.pos);
+    vOut.pos = mul(worldMat, getVertexPosition(vIn));
 #ifdef _APPLY_PROJECTION
     vOut.pos = mul(gCam.viewProjMat, vOut.pos);
 #endif
@@ -48,7 +48,7 @@ EditorVSOut main(VS_IN vIn)
     vOut.vOut = defaultVS(vIn);
 
 #ifdef PICKING
-    vOut.drawID = gDrawId[vIn.instanceID];
+    vOut.drawID = getMeshInstanceData(vIn.instanceID).drawId;
 #endif
 
 #ifdef CULL_REAR_SECTION
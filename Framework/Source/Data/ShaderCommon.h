@@ -49,12 +49,30 @@ cbuffer InternalPerFrameCB : register(b10)
 
 cbuffer InternalPerMeshCB : register(b11)
 {
-    mat4 gWorldMat[64]; // If the mesh has bones, these are the bones matrices
-    mat3 gWorldInvTransposeMat[64]; // Per-instance matrices for transforming normals
-    uint32_t gDrawId[64]; // Zero-based order/ID of Mesh Instances drawn per SceneRenderer::renderScene call.
+    mat4 gWorldMat[64]; // The bones matrices if the mesh has bones. Otherwise, the per-instance matrices of programs which don't read gMeshInstances.
+    mat3 gWorldInvTransposeMat[64]; // The matrices for transforming normals, used like gWorldMat
+    uint32_t gDrawId[64]; // Per-instance draw IDs of programs which don't read gMeshInstances
     uint32_t gMeshId;
+    uint32_t gFirstInstance; // Index of the draw's first instance in gMeshInstances
+    vec3 gPositionScale; // Dequantization of the vertex positions, see getVertexPosition()
+    vec3 gPositionBias;
 };
 
+struct MeshInstanceData
+{
+    mat4 worldMat;
+    float4x3 worldInvTransposeMat; // Matrix for transforming normals. Each column is padded to 4 floats, use the upper 3x3.
+    uint32_t drawId; // Zero-based order/ID of Mesh Instances drawn per SceneRenderer::renderScene call.
+    uint3 pad;
+};
+
+StructuredBuffer<MeshInstanceData> gMeshInstances; // Per-instance data of all the mesh instances drawn per SceneRenderer::renderScene call
+
+MeshInstanceData getMeshInstanceData(uint instanceID)
+{
+    return gMeshInstances[gFirstInstance + instanceID];
+}
+
 #ifdef _VERTEX_BLENDING
 mat4 getBlendedWorldMat(vec4 weights, uint4 ids)
 {
@@ -93,12 +93,52 @@ struct VS_OUT
 #endif
 };
 
+// Octahedral decoding of unit vectors stored as RG16Snorm. See VertexCompression.
+float3 decodeOctahedral(float2 e)
+{
+    float3 v = float3(e.xy, 1 - abs(e.x) - abs(e.y));
+    if (v.z < 0)
+    {
+        float2 s = float2(v.x >= 0 ? 1 : -1, v.y >= 0 ? 1 : -1);
+        v.xy = (1 - abs(v.yx)) * s;
+    }
+    return normalize(v);
+}
+
+// Object-space vertex attributes. Use these instead of reading VS_IN directly, since the mesh can store them compressed.
+float4 getVertexPosition(VS_IN vIn)
+{
+#ifdef HAS_QUANTIZED_POSITION
+    return float4(vIn.pos.xyz * gPositionScale + gPositionBias, 1);
+#else
+    return vIn.pos;
+#endif
+}
+
+float3 getVertexNormal(VS_IN vIn)
+{
+#ifdef HAS_OCTAHEDRAL_NORMAL
+    return decodeOctahedral(vIn.normal.xy);
+#else
+    return vIn.normal;
+#endif
+}
+
+float3 getVertexBitangent(VS_IN vIn)
+{
+#ifdef HAS_OCTAHEDRAL_BITANGENT
+    return decodeOctahedral(vIn.bitangent.xy);
+#else
+    return vIn.bitangent;
+#endif
+}
+
 float4x4 getWorldMat(VS_IN vIn)
 {
 #ifdef _VERTEX_BLENDING
     float4x4 worldMat = getBlendedWorldMat(vIn.boneWeights, vIn.boneIds);
 #else
-    float4x4 worldMat = gWorldMat[vIn.instanceID];
+    float4x4 worldMat = getMeshInstanceData(vIn.instanceID).worldMat;
 #endif
     return worldMat;
 }
@@ -108,7 +148,7 @@ float3x3 getWorldInvTransposeMat(VS_IN vIn)
 #ifdef _VERTEX_BLENDING
     float3x3 worldInvTransposeMat = getBlendedInvTransposeWorldMat(vIn.boneWeights, vIn.boneIds);
 #else
-    float3x3 worldInvTransposeMat = gWorldInvTransposeMat[vIn.instanceID];
+    float3x3 worldInvTransposeMat = (float3x3)getMeshInstanceData(vIn.instanceID).worldInvTransposeMat;
 #endif
     return worldInvTransposeMat;
 }
@@ -117,7 +157,7 @@ VS_OUT defaultVS(VS_IN vIn)
 {
     VS_OUT vOut;
     float4x4 worldMat = getWorldMat(vIn);
-    float4 posW = mul(worldMat, vIn.pos);
+    float4 posW = mul(worldMat, getVertexPosition(vIn));
     vOut.posW = posW.xyz;
     vOut.posH = mul(gCam.viewProjMat, posW);
 
@@ -133,8 +173,8 @@ VS_OUT defaultVS(VS_IN vIn)
     vOut.colorV = 0;
 #endif
 
-    vOut.normalW = mul(getWorldInvTransposeMat(vIn), vIn.normal).xyz;
-    vOut.bitangentW = mul((float3x3)worldMat, vIn.bitangent).xyz;
+    vOut.normalW = mul(getWorldInvTransposeMat(vIn), getVertexNormal(vIn)).xyz;
+    vOut.bitangentW = mul((float3x3)worldMat, getVertexBitangent(vIn)).xyz;
     vOut.prevPosH = mul(gCam.prevViewProjMat, posW);
 
 #ifdef _SINGLE_PASS_STEREO
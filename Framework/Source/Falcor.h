@@ -78,6 +78,8 @@
 #include "Graphics/GraphicsState.h"
 #include "Graphics/FullScreenPass.h"
 #include "Graphics/TextureHelper.h"
+#include "Graphics/BlockCompressor.h"
+#include "Graphics/TextureCache.h"
 #include "Graphics/Light.h"
 #include "Graphics/Program.h"
 #include "Graphics/GraphicsProgram.h"
@@ -101,12 +103,17 @@
 #include "Graphics/Scene/SceneRenderer.h"
 #include "Graphics/Scene/Editor/SceneEditor.h"
 #include "Graphics/Scene/SceneUtils.h"
+#include "Graphics/Scene/TransformStore.h"
+#include "Graphics/Scene/OcclusionCuller.h"
+#include "Graphics/Scene/SceneRaycaster.h"
 
 
 // Math
 #include "Utils/Math/FalcorMath.h"
 #include "Utils/Math/CubicSpline.h"
 #include "Utils/Math/ParallelReduction.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
+#include "Utils/Math/RadixSort.h"
 
 // Utils
 #include "Utils/Bitmap.h"
@@ -122,10 +129,14 @@
 #include "Utils/Profiler.h"
 #include "Utils/StringUtils.h"
 #include "Utils/BinaryFileStream.h"
+#include "Utils/BinaryMemoryStream.h"
+#include "Utils/MemoryMappedFile.h"
 #include "Utils/Video/VideoEncoder.h"
 #include "Utils/Video/VideoEncoderUI.h"
 #include "Utils/Video/VideoDecoder.h"
 #include "Utils/ProgressBar.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/AsyncLoadTask.h"
 
 // VR
 #include "VR/OpenVR/VRSystem.h"
@@ -0,0 +1,1214 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BlockCompressor.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+#include <cstring>
+#include <emmintrin.h>
+
+namespace Falcor
+{
+    static const uint32_t kBlockRowGrainSize = 4;   // Rows of blocks per task
+
+    // BC7 interpolation weights of the second endpoint, out of 64
+    static const uint32_t kWeights2[4] = { 0, 21, 43, 64 };
+    static const uint32_t kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+    static const uint32_t kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+    // The pixels in the second subset of each BC7 two-subset partition, one bit per pixel in raster order
+    static const uint16_t kPartitions2[64] =
+    {
+        0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+        0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+        0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+        0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+    };
+
+    // The pixel of the second subset whose index has an implicit zero high bit
+    static const uint8_t kAnchors2[64] =
+    {
+        15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+        15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+        15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+         6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+    };
+
+    static const uint32_t kAllPixels = 0xffff;
+
+    // The 16 pixels of a block, one array per channel in raster order, from 0 to 255
+    struct BlockPixels
+    {
+        alignas(16) float c[4][16];
+    };
+
+    // Assembles a block, least significant bit first
+    class BitWriter
+    {
+    public:
+        void write(uint32_t value, uint32_t bitCount)
+        {
+            const uint64_t bits = value & ((1ull << bitCount) - 1);
+            const uint32_t shift = mPosition & 63;
+            mBits[mPosition >> 6] |= bits << shift;
+            if(shift + bitCount > 64)
+            {
+                mBits[1] |= bits >> (64 - shift);
+            }
+            mPosition += bitCount;
+        }
+
+        void store(uint8_t* pDst) const
+        {
+            assert(mPosition == 128);
+            memcpy(pDst, mBits, sizeof(mBits));
+        }
+
+    private:
+        uint64_t mBits[2] = { 0, 0 };
+        uint32_t mPosition = 0;
+    };
+
+    static inline float clampColor(float value)
+    {
+        return std::min(std::max(value, 0.0f), 255.0f);
+    }
+
+    static inline uint32_t roundToUint(float value, uint32_t maxValue)
+    {
+        return (uint32_t)std::min(std::max(value + 0.5f, 0.0f), (float)maxValue);
+    }
+
+    // Blocks on the right and bottom edges repeat the last column and row
+    static void loadBlock(const uint8_t* pRgba, uint32_t width, uint32_t height, uint32_t rowPitch, uint32_t blockX, uint32_t blockY, BlockPixels& block)
+    {
+        for(uint32_t y = 0; y < 4; y++)
+        {
+            const uint8_t* pRow = pRgba + (size_t)std::min(blockY * 4 + y, height - 1) * rowPitch;
+            for(uint32_t x = 0; x < 4; x++)
+            {
+                const uint8_t* pPixel = pRow + std::min(blockX * 4 + x, width - 1) * 4;
+                for(uint32_t c = 0; c < 4; c++)
+                {
+                    block.c[c][y * 4 + x] = pPixel[c];
+                }
+            }
+        }
+    }
+
+    /** Find the nearest palette entry of each pixel
+        \param[in] firstChannel, channelCount The channels compared. Palette entries hold the channels starting at firstChannel.
+        \param[in] pixelMask The pixels to find entries for. The indices of the others are left unchanged.
+        \return The squared error of the pixels in the mask
+    */
+    static float selectIndices(const BlockPixels& block, uint32_t firstChannel, uint32_t channelCount, const float palette[][4], uint32_t paletteSize, uint32_t pixelMask, uint8_t indices[16])
+    {
+        float error = 0;
+        for(uint32_t group = 0; group < 4; group++)
+        {
+            if(((pixelMask >> (group * 4)) & 0xf) == 0)
+            {
+                continue;
+            }
+
+            __m128 pixel[4];
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                pixel[c] = _mm_load_ps(&block.c[firstChannel + c][group * 4]);
+            }
+
+            __m128 bestError = _mm_set1_ps(FLT_MAX);
+            __m128i bestIndex = _mm_setzero_si128();
+            for(uint32_t i = 0; i < paletteSize; i++)
+            {
+                __m128 distance = _mm_setzero_ps();
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    const __m128 delta = _mm_sub_ps(pixel[c], _mm_set1_ps(palette[i][c]));
+                    distance = _mm_add_ps(distance, _mm_mul_ps(delta, delta));
+                }
+                const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, bestError));
+                bestError = _mm_min_ps(distance, bestError);
+                bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(i)), _mm_andnot_si128(closer, bestIndex));
+            }
+
+            alignas(16) float groupError[4];
+            alignas(16) int32_t groupIndex[4];
+            _mm_store_ps(groupError, bestError);
+            _mm_store_si128((__m128i*)groupIndex, bestIndex);
+            for(uint32_t lane = 0; lane < 4; lane++)
+            {
+                const uint32_t pixel = group * 4 + lane;
+                if(pixelMask & (1 << pixel))
+                {
+                    indices[pixel] = (uint8_t)groupIndex[lane];
+                    error += groupError[lane];
+                }
+            }
+        }
+        return error;
+    }
+
+    /** Fit a line through the pixels in the mask, along their principal axis
+        \param[out] endpoints The extreme projections of the pixels on the line
+    */
+    static void fitLine(const BlockPixels& block, uint32_t firstChannel, uint32_t channelCount, uint32_t pixelMask, float endpoints[2][4])
+    {
+        float mean[4] = { 0, 0, 0, 0 };
+        float minValue[4] = { 255, 255, 255, 255 };
+        float maxValue[4] = { 0, 0, 0, 0 };
+        uint32_t count = 0;
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            if(pixelMask & (1 << i))
+            {
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    const float value = block.c[firstChannel + c][i];
+                    mean[c] += value;
+                    minValue[c] = std::min(minValue[c], value);
+                    maxValue[c] = std::max(maxValue[c], value);
+                }
+                count++;
+            }
+        }
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            mean[c] /= (float)std::max(count, 1u);
+        }
+
+        float covariance[4][4] = {};
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            if(pixelMask & (1 << i))
+            {
+                for(uint32_t a = 0; a < channelCount; a++)
+                {
+                    for(uint32_t b = 0; b < channelCount; b++)
+                    {
+                        covariance[a][b] += (block.c[firstChannel + a][i] - mean[a]) * (block.c[firstChannel + b][i] - mean[b]);
+                    }
+                }
+            }
+        }
+
+        // Power iterations, starting from the diagonal of the bounding box
+        float axis[4] = { 0, 0, 0, 0 };
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            axis[c] = maxValue[c] - minValue[c];
+        }
+        for(uint32_t iteration = 0; iteration < 8; iteration++)
+        {
+            float next[4] = { 0, 0, 0, 0 };
+            float length = 0;
+            for(uint32_t a = 0; a < channelCount; a++)
+            {
+                for(uint32_t b = 0; b < channelCount; b++)
+                {
+                    next[a] += covariance[a][b] * axis[b];
+                }
+                length = std::max(length, std::abs(next[a]));
+            }
+            if(length < 1e-6f)
+            {
+                break;
+            }
+            for(uint32_t c = 0; c < channelCount; c++)
+            {
+                axis[c] = next[c] / length;
+            }
+        }
+
+        float lengthSquared = 0;
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            lengthSquared += axis[c] * axis[c];
+        }
+        float minT = 0;
+        float maxT = 0;
+        if(lengthSquared > 1e-12f)
+        {
+            minT = FLT_MAX;
+            maxT = -FLT_MAX;
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                if(pixelMask & (1 << i))
+                {
+                    float t = 0;
+                    for(uint32_t c = 0; c < channelCount; c++)
+                    {
+                        t += (block.c[firstChannel + c][i] - mean[c]) * axis[c];
+                    }
+                    minT = std::min(minT, t);
+                    maxT = std::max(maxT, t);
+                }
+            }
+            minT /= lengthSquared;
+            maxT /= lengthSquared;
+        }
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            endpoints[0][c] = clampColor(mean[c] + axis[c] * minT);
+            endpoints[1][c] = clampColor(mean[c] + axis[c] * maxT);
+        }
+    }
+
+    /** Solve for the endpoints which minimize the squared error of the pixels in the mask, given the weight of the second endpoint in each pixel
+        \return false if the weights don't determine the endpoints, in which case the endpoints are left unchanged
+    */
+    static bool fitEndpoints(const BlockPixels& block, uint32_t firstChannel, uint32_t channelCount, uint32_t pixelMask, const float weights[16], float endpoints[2][4])
+    {
+        float aa = 0;
+        float ab = 0;
+        float bb = 0;
+        float ap[4] = { 0, 0, 0, 0 };
+        float bp[4] = { 0, 0, 0, 0 };
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            if(pixelMask & (1 << i))
+            {
+                const float b = weights[i];
+                const float a = 1.0f - b;
+                aa += a * a;
+                ab += a * b;
+                bb += b * b;
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    ap[c] += a * block.c[firstChannel + c][i];
+                    bp[c] += b * block.c[firstChannel + c][i];
+                }
+            }
+        }
+
+        const float determinant = aa * bb - ab * ab;
+        if(std::abs(determinant) < 1e-6f)
+        {
+            return false;
+        }
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            endpoints[0][c] = clampColor((bb * ap[c] - ab * bp[c]) / determinant);
+            endpoints[1][c] = clampColor((aa * bp[c] - ab * ap[c]) / determinant);
+        }
+        return true;
+    }
+
+    static uint32_t getRefinementCount(BlockCompressor::Quality quality)
+    {
+        return (quality == BlockCompressor::Quality::Fast) ? 0 : ((quality == BlockCompressor::Quality::Normal) ? 1 : 2);
+    }
+
+    //
+    // BC1 color blocks
+    //
+
+    static uint16_t quantize565(const float color[4])
+    {
+        return (uint16_t)((roundToUint(color[0] * (31.0f / 255.0f), 31) << 11) | (roundToUint(color[1] * (63.0f / 255.0f), 63) << 5) | roundToUint(color[2] * (31.0f / 255.0f), 31));
+    }
+
+    static void expand565(uint16_t value, float color[4])
+    {
+        const uint32_t r = (value >> 11) & 31;
+        const uint32_t g = (value >> 5) & 63;
+        const uint32_t b = value & 31;
+        color[0] = (float)((r << 3) | (r >> 2));
+        color[1] = (float)((g << 2) | (g >> 4));
+        color[2] = (float)((b << 3) | (b >> 2));
+        color[3] = 255.0f;
+    }
+
+    struct ColorBlock
+    {
+        uint16_t endpoints[2];
+        uint8_t indices[16];
+        float error = FLT_MAX;
+    };
+
+    // Evaluate a pair of quantized endpoints. Blocks with transparent pixels use the 3-color mode, the others the 4-color mode.
+    static ColorBlock evaluateColorEndpoints(const BlockPixels& block, uint32_t opaqueMask, uint16_t endpoint0, uint16_t endpoint1)
+    {
+        ColorBlock result;
+        const bool transparentMode = (opaqueMask != kAllPixels);
+        if((endpoint0 < endpoint1) != transparentMode && endpoint0 != endpoint1)
+        {
+            std::swap(endpoint0, endpoint1);
+        }
+        result.endpoints[0] = endpoint0;
+        result.endpoints[1] = endpoint1;
+
+        float palette[4][4];
+        expand565(endpoint0, palette[0]);
+        expand565(endpoint1, palette[1]);
+        uint32_t paletteSize;
+        if(endpoint0 == endpoint1)
+        {
+            // Index 0 decodes to the same color in both modes
+            paletteSize = 1;
+        }
+        else if(transparentMode)
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                palette[2][c] = (palette[0][c] + palette[1][c]) * 0.5f;
+            }
+            paletteSize = 3;
+        }
+        else
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                palette[2][c] = (palette[0][c] * 2 + palette[1][c]) * (1.0f / 3.0f);
+                palette[3][c] = (palette[0][c] + palette[1][c] * 2) * (1.0f / 3.0f);
+            }
+            paletteSize = 4;
+        }
+
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            result.indices[i] = 3;
+        }
+        result.error = selectIndices(block, 0, 3, palette, paletteSize, opaqueMask, result.indices);
+        return result;
+    }
+
+    static void encodeColorBlock(const BlockPixels& block, BlockCompressor::Quality quality, bool allowTransparency, uint8_t* pDst)
+    {
+        uint32_t opaqueMask = kAllPixels;
+        if(allowTransparency)
+        {
+            opaqueMask = 0;
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                opaqueMask |= (block.c[3][i] >= 128.0f) ? (1 << i) : 0;
+            }
+        }
+
+        ColorBlock best;
+        if(opaqueMask == 0)
+        {
+            // Black endpoints in the 3-color mode, every pixel transparent
+            best.endpoints[0] = 0;
+            best.endpoints[1] = 0;
+            memset(best.indices, 3, sizeof(best.indices));
+        }
+        else
+        {
+            float endpoints[2][4];
+            fitLine(block, 0, 3, opaqueMask, endpoints);
+            if(quality != BlockCompressor::Quality::Fast)
+            {
+                // Inset the endpoints, since the extreme pixels rarely sit on the line
+                for(uint32_t c = 0; c < 3; c++)
+                {
+                    const float inset = (endpoints[1][c] - endpoints[0][c]) / 16.0f;
+                    endpoints[0][c] += inset;
+                    endpoints[1][c] -= inset;
+                }
+            }
+            best = evaluateColorEndpoints(block, opaqueMask, quantize565(endpoints[0]), quantize565(endpoints[1]));
+
+            const uint32_t refinementCount = getRefinementCount(quality);
+            for(uint32_t refinement = 0; refinement < refinementCount && best.error > 0; refinement++)
+            {
+                static const float kWeights4Color[4] = { 0, 1, 1.0f / 3.0f, 2.0f / 3.0f };
+                static const float kWeights3Color[4] = { 0, 1, 0.5f, 0 };
+                const float* pIndexWeights = (opaqueMask == kAllPixels) ? kWeights4Color : kWeights3Color;
+                float weights[16];
+                for(uint32_t i = 0; i < 16; i++)
+                {
+                    weights[i] = pIndexWeights[best.indices[i]];
+                }
+                expand565(best.endpoints[0], endpoints[0]);
+                expand565(best.endpoints[1], endpoints[1]);
+                if(fitEndpoints(block, 0, 3, opaqueMask, weights, endpoints) == false)
+                {
+                    break;
+                }
+                const ColorBlock refined = evaluateColorEndpoints(block, opaqueMask, quantize565(endpoints[0]), quantize565(endpoints[1]));
+                if(refined.error >= best.error)
+                {
+                    break;
+                }
+                best = refined;
+            }
+        }
+
+        uint32_t indexBits = 0;
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            indexBits |= (uint32_t)best.indices[i] << (i * 2);
+        }
+        memcpy(pDst, best.endpoints, 4);
+        memcpy(pDst + 4, &indexBits, 4);
+    }
+
+    //
+    // BC4 channel blocks, also used for the alpha of BC3 and the channels of BC5
+    //
+
+    struct ChannelBlock
+    {
+        uint8_t endpoints[2];
+        uint8_t indices[16];
+        float error = FLT_MAX;
+    };
+
+    // The 8-value mode is used when the first endpoint is larger, the 6-value mode with 0 and 255 otherwise
+    static ChannelBlock evaluateChannelEndpoints(const BlockPixels& block, uint32_t channel, uint8_t endpoint0, uint8_t endpoint1)
+    {
+        ChannelBlock result;
+        result.endpoints[0] = endpoint0;
+        result.endpoints[1] = endpoint1;
+
+        float palette[8][4];
+        palette[0][0] = endpoint0;
+        palette[1][0] = endpoint1;
+        if(endpoint0 > endpoint1)
+        {
+            for(uint32_t i = 2; i < 8; i++)
+            {
+                palette[i][0] = (float)((8 - i) * endpoint0 + (i - 1) * endpoint1) / 7.0f;
+            }
+        }
+        else
+        {
+            for(uint32_t i = 2; i < 6; i++)
+            {
+                palette[i][0] = (float)((6 - i) * endpoint0 + (i - 1) * endpoint1) / 5.0f;
+            }
+            palette[6][0] = 0;
+            palette[7][0] = 255;
+        }
+        result.error = selectIndices(block, channel, 1, palette, 8, kAllPixels, result.indices);
+        return result;
+    }
+
+    static void encodeChannelBlock(const BlockPixels& block, uint32_t channel, BlockCompressor::Quality quality, uint8_t* pDst)
+    {
+        float minValue = 255;
+        float maxValue = 0;
+        float innerMin = 255;
+        float innerMax = 0;
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            const float value = block.c[channel][i];
+            minValue = std::min(minValue, value);
+            maxValue = std::max(maxValue, value);
+            if(value > 0 && value < 255)
+            {
+                innerMin = std::min(innerMin, value);
+                innerMax = std::max(innerMax, value);
+            }
+        }
+
+        ChannelBlock best = evaluateChannelEndpoints(block, channel, (uint8_t)roundToUint(maxValue, 255), (uint8_t)roundToUint(minValue, 255));
+
+        // Blocks with both extremes can fit the other pixels more tightly in the 6-value mode
+        if(quality == BlockCompressor::Quality::High && innerMin <= innerMax && best.error > 0)
+        {
+            const ChannelBlock inner = evaluateChannelEndpoints(block, channel, (uint8_t)roundToUint(innerMin, 255), (uint8_t)roundToUint(innerMax, 255));
+            best = (inner.error < best.error) ? inner : best;
+        }
+
+        const uint32_t refinementCount = getRefinementCount(quality);
+        for(uint32_t refinement = 0; refinement < refinementCount && best.error > 0 && best.endpoints[0] > best.endpoints[1]; refinement++)
+        {
+            float weights[16];
+            uint32_t mask = 0;
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                const uint32_t index = best.indices[i];
+                weights[i] = (index == 0) ? 0.0f : ((index == 1) ? 1.0f : (float)(index - 1) / 7.0f);
+                mask |= 1 << i;
+            }
+            float endpoints[2][4];
+            if(fitEndpoints(block, channel, 1, mask, weights, endpoints) == false)
+            {
+                break;
+            }
+            const uint8_t endpoint0 = (uint8_t)roundToUint(endpoints[0][0], 255);
+            const uint8_t endpoint1 = (uint8_t)roundToUint(endpoints[1][0], 255);
+            if(endpoint0 <= endpoint1)
+            {
+                break;
+            }
+            const ChannelBlock refined = evaluateChannelEndpoints(block, channel, endpoint0, endpoint1);
+            if(refined.error >= best.error)
+            {
+                break;
+            }
+            best = refined;
+        }
+
+        uint64_t indexBits = 0;
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            indexBits |= (uint64_t)best.indices[i] << (i * 3);
+        }
+        pDst[0] = best.endpoints[0];
+        pDst[1] = best.endpoints[1];
+        memcpy(pDst + 2, &indexBits, 6);
+    }
+
+    //
+    // BC7 blocks, in mode 6 (one subset, RGBA), mode 5 (one subset, RGB with separate alpha) and mode 1 (two subsets, RGB)
+    //
+
+    struct Bc7Subset
+    {
+        uint8_t endpoints[2][4];    // Quantized, without the p-bits
+        uint8_t pBits[2];
+        float error = FLT_MAX;
+    };
+
+    struct Bc7Block
+    {
+        uint8_t data[16];
+        float error = FLT_MAX;
+    };
+
+    static inline uint32_t getBc7ChannelCount(uint32_t mode)
+    {
+        return (mode == 6) ? 4 : 3;
+    }
+
+    static inline uint32_t getBc7PaletteSize(uint32_t mode)
+    {
+        return (mode == 6) ? 16 : ((mode == 5) ? 4 : 8);
+    }
+
+    static inline const uint32_t* getBc7Weights(uint32_t mode)
+    {
+        return (mode == 6) ? kWeights4 : ((mode == 5) ? kWeights2 : kWeights3);
+    }
+
+    // Mode 6 endpoints have 7 bits and a p-bit per endpoint. Mode 5 color endpoints have 7 bits and no p-bit. Mode 1 endpoints have 6 bits and a p-bit shared by the subset.
+    static inline uint32_t expandBc7Endpoint(uint32_t value, uint32_t pBit, uint32_t mode)
+    {
+        if(mode == 6)
+        {
+            return (value << 1) | pBit;
+        }
+        const uint32_t value7 = (mode == 5) ? value : ((value << 1) | pBit);
+        return (value7 << 1) | (value7 >> 6);
+    }
+
+    static inline uint32_t quantizeBc7Endpoint(float value, uint32_t pBit, uint32_t mode)
+    {
+        if(mode == 6)
+        {
+            return roundToUint((value - pBit) * 0.5f, 127);
+        }
+        return (mode == 5) ? roundToUint(value * (127.0f / 255.0f), 127) : roundToUint((value * (127.0f / 255.0f) - pBit) * 0.5f, 63);
+    }
+
+    static void buildBc7Palette(const Bc7Subset& subset, uint32_t mode, uint32_t channelCount, float palette[16][4])
+    {
+        const uint32_t paletteSize = getBc7PaletteSize(mode);
+        const uint32_t* pWeights = getBc7Weights(mode);
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            const uint32_t e0 = expandBc7Endpoint(subset.endpoints[0][c], subset.pBits[0], mode);
+            const uint32_t e1 = expandBc7Endpoint(subset.endpoints[1][c], subset.pBits[1], mode);
+            for(uint32_t i = 0; i < paletteSize; i++)
+            {
+                palette[i][c] = (float)(((64 - pWeights[i]) * e0 + pWeights[i] * e1 + 32) >> 6);
+            }
+        }
+    }
+
+    /** Quantize a subset's endpoints, trying the p-bits allowed by the mode
+        \param[in] isOpaque Only use odd mode 6 endpoints, the only ones which decode to an alpha of 255
+    */
+    static Bc7Subset quantizeBc7Subset(const BlockPixels& block, uint32_t mode, uint32_t pixelMask, const float endpoints[2][4], bool searchPBits, bool isOpaque, uint8_t indices[16])
+    {
+        const uint32_t channelCount = getBc7ChannelCount(mode);
+        const uint32_t paletteSize = getBc7PaletteSize(mode);
+        const uint32_t combinationCount = (mode == 6) ? 4 : ((mode == 1) ? 2 : 1);
+        Bc7Subset best;
+        uint8_t candidateIndices[16];
+        for(uint32_t combination = (mode == 6 && isOpaque) ? 3 : 0; combination < combinationCount; combination++)
+        {
+            Bc7Subset candidate;
+            candidate.pBits[0] = combination & 1;
+            candidate.pBits[1] = (mode == 6) ? (combination >> 1) : candidate.pBits[0];
+
+            if(searchPBits == false && mode == 6 && isOpaque == false)
+            {
+                // Pick each endpoint's p-bit by its own quantization error, and evaluate once
+                if(combination > 0)
+                {
+                    break;
+                }
+                for(uint32_t e = 0; e < 2; e++)
+                {
+                    float errors[2] = { 0, 0 };
+                    for(uint32_t pBit = 0; pBit < 2; pBit++)
+                    {
+                        for(uint32_t c = 0; c < channelCount; c++)
+                        {
+                            const float delta = (float)expandBc7Endpoint(quantizeBc7Endpoint(endpoints[e][c], pBit, mode), pBit, mode) - endpoints[e][c];
+                            errors[pBit] += delta * delta;
+                        }
+                    }
+                    candidate.pBits[e] = (errors[1] < errors[0]) ? 1 : 0;
+                }
+            }
+
+            for(uint32_t e = 0; e < 2; e++)
+            {
+                for(uint32_t c = 0; c < channelCount; c++)
+                {
+                    candidate.endpoints[e][c] = (uint8_t)quantizeBc7Endpoint(endpoints[e][c], candidate.pBits[e], mode);
+                }
+            }
+
+            float palette[16][4];
+            buildBc7Palette(candidate, mode, channelCount, palette);
+            candidate.error = selectIndices(block, 0, channelCount, palette, paletteSize, pixelMask, candidateIndices);
+            if(candidate.error < best.error)
+            {
+                best = candidate;
+                for(uint32_t i = 0; i < 16; i++)
+                {
+                    if(pixelMask & (1 << i))
+                    {
+                        indices[i] = candidateIndices[i];
+                    }
+                }
+            }
+        }
+        return best;
+    }
+
+    // Fit, quantize and refine the endpoints of a subset
+    static Bc7Subset encodeBc7Subset(const BlockPixels& block, uint32_t mode, uint32_t pixelMask, BlockCompressor::Quality quality, bool isOpaque, uint8_t indices[16])
+    {
+        const uint32_t channelCount = getBc7ChannelCount(mode);
+        const bool searchPBits = (quality != BlockCompressor::Quality::Fast);
+        float endpoints[2][4];
+        fitLine(block, 0, channelCount, pixelMask, endpoints);
+        Bc7Subset best = quantizeBc7Subset(block, mode, pixelMask, endpoints, searchPBits, isOpaque, indices);
+
+        const uint32_t* pWeights = getBc7Weights(mode);
+        const uint32_t refinementCount = getRefinementCount(quality);
+        for(uint32_t refinement = 0; refinement < refinementCount && best.error > 0; refinement++)
+        {
+            float weights[16];
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                weights[i] = (pixelMask & (1 << i)) ? (float)pWeights[indices[i]] / 64.0f : 0.0f;
+            }
+            if(fitEndpoints(block, 0, channelCount, pixelMask, weights, endpoints) == false)
+            {
+                break;
+            }
+            uint8_t refinedIndices[16];
+            const Bc7Subset refined = quantizeBc7Subset(block, mode, pixelMask, endpoints, searchPBits, isOpaque, refinedIndices);
+            if(refined.error >= best.error)
+            {
+                break;
+            }
+            best = refined;
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                if(pixelMask & (1 << i))
+                {
+                    indices[i] = refinedIndices[i];
+                }
+            }
+        }
+        return best;
+    }
+
+    // The anchor pixel of a subset has an implicit zero high index bit. Swapping the endpoints and inverting the indices clears it.
+    static void fixBc7Anchor(Bc7Subset& subset, uint32_t pixelMask, uint32_t anchor, uint32_t indexBits, uint8_t indices[16])
+    {
+        const uint32_t maxIndex = (1 << indexBits) - 1;
+        if(indices[anchor] <= (maxIndex >> 1))
+        {
+            return;
+        }
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            std::swap(subset.endpoints[0][c], subset.endpoints[1][c]);
+        }
+        std::swap(subset.pBits[0], subset.pBits[1]);
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            if(pixelMask & (1 << i))
+            {
+                indices[i] = (uint8_t)(maxIndex - indices[i]);
+            }
+        }
+    }
+
+    /** Find mode 6 endpoints whose interpolation reproduces a color exactly. Every channel uses the same index.
+        Opaque blocks only use odd endpoints, so a zero channel can't be reproduced and decodes as 1. Mode 5 encodes those.
+        \return false if no endpoints were found
+    */
+    static bool findSolidBc7Endpoints(const float color[4], bool isOpaque, Bc7Subset& subset, uint8_t& index)
+    {
+        for(uint32_t combination = isOpaque ? 3 : 0; combination < 4; combination++)
+        {
+            subset.pBits[0] = combination & 1;
+            subset.pBits[1] = combination >> 1;
+            for(index = 1; index < 15; index++)
+            {
+                const int32_t weight = (int32_t)kWeights4[index];
+                uint32_t foundChannels = 0;
+                for(uint32_t c = 0; c < 4 && foundChannels == c; c++)
+                {
+                    // The decoder computes ((64 - w) * e0 + w * e1 + 32) >> 6, which gives a range of e1 for every e0
+                    const int32_t value = (int32_t)color[c];
+                    for(int32_t q0 = 0; q0 < 128 && foundChannels == c; q0++)
+                    {
+                        const int32_t e0 = q0 * 2 + subset.pBits[0];
+                        const int32_t low = value * 64 - 32 - (64 - weight) * e0;
+                        const int32_t high = value * 64 + 31 - (64 - weight) * e0;
+                        if(high < 0)
+                        {
+                            break;
+                        }
+                        const int32_t e1Min = std::max(low, 0) / weight + ((std::max(low, 0) % weight) ? 1 : 0);
+                        const int32_t q1 = (e1Min - subset.pBits[1] + 1) / 2;
+                        const int32_t e1 = q1 * 2 + subset.pBits[1];
+                        if(q1 < 128 && e1 * weight <= high)
+                        {
+                            subset.endpoints[0][c] = (uint8_t)q0;
+                            subset.endpoints[1][c] = (uint8_t)q1;
+                            foundChannels++;
+                        }
+                    }
+                }
+                if(foundChannels == 4)
+                {
+                    subset.error = 0;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    static Bc7Block encodeBc7Mode6(const BlockPixels& block, BlockCompressor::Quality quality, bool isOpaque)
+    {
+        bool isSolid = true;
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            for(uint32_t i = 1; i < 16; i++)
+            {
+                isSolid = isSolid && (block.c[c][i] == block.c[c][0]);
+            }
+        }
+
+        // Flat blocks would otherwise lose the lowest bit of the channels whose p-bits don't match
+        uint8_t indices[16];
+        Bc7Subset subset;
+        const float color[4] = { block.c[0][0], block.c[1][0], block.c[2][0], block.c[3][0] };
+        uint8_t solidIndex;
+        if(isSolid && findSolidBc7Endpoints(color, isOpaque, subset, solidIndex))
+        {
+            memset(indices, solidIndex, sizeof(indices));
+        }
+        else
+        {
+            subset = encodeBc7Subset(block, 6, kAllPixels, quality, isOpaque, indices);
+        }
+        fixBc7Anchor(subset, kAllPixels, 0, 4, indices);
+
+        BitWriter writer;
+        writer.write(1 << 6, 7);
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            writer.write(subset.endpoints[0][c], 7);
+            writer.write(subset.endpoints[1][c], 7);
+        }
+        writer.write(subset.pBits[0], 1);
+        writer.write(subset.pBits[1], 1);
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            writer.write(indices[i], (i == 0) ? 3 : 4);
+        }
+
+        Bc7Block result;
+        writer.store(result.data);
+        result.error = subset.error;
+        return result;
+    }
+
+    /** Find mode 5 color endpoints whose interpolation reproduces an RGB color exactly. Index 1 reaches every 8-bit value from two 7-bit endpoints.
+        \return false if no endpoints were found
+    */
+    static bool findSolidBc7Mode5Endpoints(const float color[4], Bc7Subset& subset)
+    {
+        const uint32_t weight = kWeights2[1];
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            const uint32_t value = (uint32_t)color[c];
+            bool isFound = false;
+            for(uint32_t q0 = 0; q0 < 128 && isFound == false; q0++)
+            {
+                const uint32_t e0 = expandBc7Endpoint(q0, 0, 5);
+                for(uint32_t q1 = 0; q1 < 128 && isFound == false; q1++)
+                {
+                    if((((64 - weight) * e0 + weight * expandBc7Endpoint(q1, 0, 5) + 32) >> 6) == value)
+                    {
+                        subset.endpoints[0][c] = (uint8_t)q0;
+                        subset.endpoints[1][c] = (uint8_t)q1;
+                        isFound = true;
+                    }
+                }
+            }
+            if(isFound == false)
+            {
+                return false;
+            }
+        }
+        subset.pBits[0] = subset.pBits[1] = 0;
+        subset.error = 0;
+        return true;
+    }
+
+    // Mode 5 for opaque blocks, with both alpha endpoints at 255. Its color endpoints reach 0, unlike the odd endpoints of opaque mode 6 blocks.
+    static Bc7Block encodeBc7Mode5(const BlockPixels& block, BlockCompressor::Quality quality)
+    {
+        bool isSolid = true;
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            for(uint32_t i = 1; i < 16; i++)
+            {
+                isSolid = isSolid && (block.c[c][i] == block.c[c][0]);
+            }
+        }
+
+        uint8_t indices[16];
+        Bc7Subset subset;
+        const float color[4] = { block.c[0][0], block.c[1][0], block.c[2][0], block.c[3][0] };
+        if(isSolid && findSolidBc7Mode5Endpoints(color, subset))
+        {
+            memset(indices, 1, sizeof(indices));
+        }
+        else
+        {
+            subset = encodeBc7Subset(block, 5, kAllPixels, quality, true, indices);
+        }
+        fixBc7Anchor(subset, kAllPixels, 0, 2, indices);
+
+        BitWriter writer;
+        writer.write(1 << 5, 6);
+        writer.write(0, 2);     // No channel rotation
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            writer.write(subset.endpoints[0][c], 7);
+            writer.write(subset.endpoints[1][c], 7);
+        }
+        writer.write(255, 8);
+        writer.write(255, 8);
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            writer.write(indices[i], (i == 0) ? 1 : 2);
+        }
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            writer.write(0, (i == 0) ? 1 : 2);
+        }
+
+        Bc7Block result;
+        writer.store(result.data);
+        result.error = subset.error;
+        return result;
+    }
+
+    static Bc7Block encodeBc7Mode1(const BlockPixels& block, BlockCompressor::Quality quality, float maxError)
+    {
+        // Evaluate every partition with fitted endpoints only, then refine the best one
+        uint32_t bestPartition = 0;
+        float bestError = FLT_MAX;
+        for(uint32_t partition = 0; partition < 64; partition++)
+        {
+            float error = 0;
+            uint8_t indices[16];
+            for(uint32_t subsetIndex = 0; subsetIndex < 2 && error < bestError; subsetIndex++)
+            {
+                const uint32_t mask = subsetIndex ? kPartitions2[partition] : (~kPartitions2[partition] & kAllPixels);
+                error += encodeBc7Subset(block, 1, mask, BlockCompressor::Quality::Fast, true, indices).error;
+            }
+            if(error < bestError)
+            {
+                bestError = error;
+                bestPartition = partition;
+            }
+        }
+
+        Bc7Block result;
+        if(bestError >= maxError)
+        {
+            return result;
+        }
+
+        uint8_t indices[16];
+        Bc7Subset subsets[2];
+        const uint32_t masks[2] = { ~kPartitions2[bestPartition] & kAllPixels, kPartitions2[bestPartition] };
+        const uint32_t anchors[2] = { 0, kAnchors2[bestPartition] };
+        for(uint32_t s = 0; s < 2; s++)
+        {
+            subsets[s] = encodeBc7Subset(block, 1, masks[s], quality, true, indices);
+            fixBc7Anchor(subsets[s], masks[s], anchors[s], 3, indices);
+        }
+
+        BitWriter writer;
+        writer.write(1 << 1, 2);
+        writer.write(bestPartition, 6);
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            writer.write(subsets[0].endpoints[0][c], 6);
+            writer.write(subsets[0].endpoints[1][c], 6);
+            writer.write(subsets[1].endpoints[0][c], 6);
+            writer.write(subsets[1].endpoints[1][c], 6);
+        }
+        writer.write(subsets[0].pBits[0], 1);
+        writer.write(subsets[1].pBits[0], 1);
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            writer.write(indices[i], (i == anchors[0] || i == anchors[1]) ? 2 : 3);
+        }
+        writer.store(result.data);
+        result.error = subsets[0].error + subsets[1].error;
+        return result;
+    }
+
+    static void encodeBc7Block(const BlockPixels& block, BlockCompressor::Quality quality, uint8_t* pDst)
+    {
+        bool isOpaque = true;
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            isOpaque = isOpaque && (block.c[3][i] == 255.0f);
+        }
+        Bc7Block best = encodeBc7Mode6(block, quality, isOpaque);
+
+        // Opaque mode 6 blocks can't decode a channel to 0. Fast only tries mode 5 on blocks which need it.
+        bool hasZeroChannel = false;
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                hasZeroChannel = hasZeroChannel || (block.c[c][i] == 0.0f);
+            }
+        }
+        if(isOpaque && best.error > 0 && (quality != BlockCompressor::Quality::Fast || hasZeroChannel))
+        {
+            const Bc7Block mode5 = encodeBc7Mode5(block, quality);
+            best = (mode5.error < best.error) ? mode5 : best;
+        }
+
+        // Mode 1 has no alpha, so it is only an option for opaque blocks
+        if(quality == BlockCompressor::Quality::High && isOpaque && best.error > 0)
+        {
+            const Bc7Block mode1 = encodeBc7Mode1(block, quality, best.error);
+            best = (mode1.error < best.error) ? mode1 : best;
+        }
+        memcpy(pDst, best.data, sizeof(best.data));
+    }
+
+    //
+    // Images
+    //
+
+    static uint32_t getBlockSize(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::BC1Unorm:
+        case ResourceFormat::BC1UnormSrgb:
+        case ResourceFormat::BC4Unorm:
+            return 8;
+        default:
+            return 16;
+        }
+    }
+
+    static void encodeBlock(const BlockPixels& block, ResourceFormat format, BlockCompressor::Quality quality, uint8_t* pDst)
+    {
+        switch(format)
+        {
+        case ResourceFormat::BC1Unorm:
+        case ResourceFormat::BC1UnormSrgb:
+            encodeColorBlock(block, quality, true, pDst);
+            break;
+        case ResourceFormat::BC3Unorm:
+        case ResourceFormat::BC3UnormSrgb:
+            encodeChannelBlock(block, 3, quality, pDst);
+            encodeColorBlock(block, quality, false, pDst + 8);
+            break;
+        case ResourceFormat::BC4Unorm:
+            encodeChannelBlock(block, 0, quality, pDst);
+            break;
+        case ResourceFormat::BC5Unorm:
+            encodeChannelBlock(block, 0, quality, pDst);
+            encodeChannelBlock(block, 1, quality, pDst + 8);
+            break;
+        case ResourceFormat::BC7Unorm:
+        case ResourceFormat::BC7UnormSrgb:
+            encodeBc7Block(block, quality, pDst);
+            break;
+        default:
+            should_not_get_here();
+        }
+    }
+
+    // The linear value of each sRGB byte, and the linear values halfway between consecutive bytes
+    struct SrgbTables
+    {
+        float toLinear[256];
+        float thresholds[255];
+
+        SrgbTables()
+        {
+            auto srgbToLinear = [](float value) { return (value <= 0.04045f) ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f); };
+            for(uint32_t i = 0; i < 256; i++)
+            {
+                toLinear[i] = srgbToLinear((float)i / 255.0f);
+            }
+            for(uint32_t i = 0; i < 255; i++)
+            {
+                thresholds[i] = srgbToLinear(((float)i + 0.5f) / 255.0f);
+            }
+        }
+    };
+
+    // Box-filter an image to half its size. The last row and column of odd sizes are dropped.
+    static void downsample(const std::vector<uint8_t>& src, uint32_t width, uint32_t height, bool isSrgb, std::vector<uint8_t>& dst)
+    {
+        static const SrgbTables kSrgb;
+        const uint32_t dstWidth = std::max(width / 2, 1u);
+        const uint32_t dstHeight = std::max(height / 2, 1u);
+        dst.resize((size_t)dstWidth * dstHeight * 4);
+        ThreadPool::getGlobalPool()->parallelFor(dstHeight, 64, [&](uint32_t first, uint32_t last)
+        {
+            for(uint32_t y = first; y < last; y++)
+            {
+                const uint32_t y0 = std::min(y * 2, height - 1);
+                const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+                for(uint32_t x = 0; x < dstWidth; x++)
+                {
+                    const uint32_t x0 = std::min(x * 2, width - 1);
+                    const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+                    const uint8_t* pSrc[4] = { &src[((size_t)y0 * width + x0) * 4], &src[((size_t)y0 * width + x1) * 4], &src[((size_t)y1 * width + x0) * 4], &src[((size_t)y1 * width + x1) * 4] };
+                    uint8_t* pDst = &dst[((size_t)y * dstWidth + x) * 4];
+                    for(uint32_t c = 0; c < 4; c++)
+                    {
+                        if(isSrgb && c < 3)
+                        {
+                            const float linear = (kSrgb.toLinear[pSrc[0][c]] + kSrgb.toLinear[pSrc[1][c]] + kSrgb.toLinear[pSrc[2][c]] + kSrgb.toLinear[pSrc[3][c]]) * 0.25f;
+                            pDst[c] = (uint8_t)(std::upper_bound(kSrgb.thresholds, kSrgb.thresholds + 255, linear) - kSrgb.thresholds);
+                        }
+                        else
+                        {
+                            pDst[c] = (uint8_t)((pSrc[0][c] + pSrc[1][c] + pSrc[2][c] + pSrc[3][c] + 2) / 4);
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    bool BlockCompressor::isFormatSupported(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::BC1Unorm:
+        case ResourceFormat::BC1UnormSrgb:
+        case ResourceFormat::BC3Unorm:
+        case ResourceFormat::BC3UnormSrgb:
+        case ResourceFormat::BC4Unorm:
+        case ResourceFormat::BC5Unorm:
+        case ResourceFormat::BC7Unorm:
+        case ResourceFormat::BC7UnormSrgb:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    std::vector<uint8_t> BlockCompressor::compress(const uint8_t* pRgba, uint32_t width, uint32_t height, uint32_t rowPitch, ResourceFormat format, Quality quality)
+    {
+        if(isFormatSupported(format) == false || width == 0 || height == 0)
+        {
+            return std::vector<uint8_t>();
+        }
+
+        const uint32_t blockSize = getBlockSize(format);
+        const uint32_t blocksX = (width + 3) / 4;
+        const uint32_t blocksY = (height + 3) / 4;
+        std::vector<uint8_t> blocks((size_t)blocksX * blocksY * blockSize);
+        ThreadPool::getGlobalPool()->parallelFor(blocksY, kBlockRowGrainSize, [&](uint32_t first, uint32_t last)
+        {
+            BlockPixels block;
+            for(uint32_t blockY = first; blockY < last; blockY++)
+            {
+                for(uint32_t blockX = 0; blockX < blocksX; blockX++)
+                {
+                    loadBlock(pRgba, width, height, rowPitch, blockX, blockY, block);
+                    encodeBlock(block, format, quality, &blocks[((size_t)blockY * blocksX + blockX) * blockSize]);
+                }
+            }
+        });
+        return blocks;
+    }
+
+    std::vector<uint8_t> BlockCompressor::compressWithMips(const uint8_t* pRgba, uint32_t width, uint32_t height, ResourceFormat format, Quality quality, uint32_t& mipCount)
+    {
+        mipCount = 0;
+        std::vector<uint8_t> blocks = compress(pRgba, width, height, width * 4, format, quality);
+        if(blocks.empty())
+        {
+            return blocks;
+        }
+        mipCount = 1;
+
+        const bool isSrgb = isSrgbFormat(format);
+        std::vector<uint8_t> level;
+        std::vector<uint8_t> nextLevel(pRgba, pRgba + (size_t)width * height * 4);
+        while(width > 1 || height > 1)
+        {
+            level.swap(nextLevel);
+            downsample(level, width, height, isSrgb, nextLevel);
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+            const std::vector<uint8_t> levelBlocks = compress(nextLevel.data(), width, height, width * 4, format, quality);
+            blocks.insert(blocks.end(), levelBlocks.begin(), levelBlocks.end());
+            mipCount++;
+        }
+        return blocks;
+    }
+}
@@ -0,0 +1,75 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "API/Formats.h"
+
+namespace Falcor
+{
+    /** CPU encoder for the BC1, BC3, BC4, BC5 and BC7 block-compressed formats, so that compressed textures can be produced offline without a GPU.\n
+        Rows of blocks are encoded in parallel on the global thread pool. Within a block, the palette searches and error evaluations process 4 pixels at a time with SSE.
+        The input is always 8-bit RGBA. BC4 encodes the red channel, BC5 the red and green channels. BC1 uses its transparent mode for blocks with pixels whose alpha is below 128.
+    */
+    class BlockCompressor
+    {
+    public:
+        enum class Quality
+        {
+            Fast,       ///< Endpoints from the principal axis of each block. BC7 uses mode 6, and mode 5 for opaque blocks with a zero channel.
+            Normal,     ///< Also refines the endpoints with a least-squares fit and searches the BC7 p-bits
+            High,       ///< Also refines the endpoints a second time, and tries the 64 two-subset partitions of BC7 mode 1 on opaque blocks. Several times slower than Normal.
+        };
+
+        /** Check if a format can be encoded. The sRGB variants of BC1, BC3 and BC7 are supported, the SNORM variants of BC4 and BC5 are not.
+        */
+        static bool isFormatSupported(ResourceFormat format);
+
+        /** Compress an image
+            \param[in] pRgba The pixels, 4 bytes in RGBA order each
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[in] rowPitch The distance between two rows of pixels, in bytes
+            \param[in] format The block-compressed format
+            \param[in] quality The quality of the encoding
+            \return The blocks, one row of blocks after the other. Empty if the format isn't supported.
+        */
+        static std::vector<uint8_t> compress(const uint8_t* pRgba, uint32_t width, uint32_t height, uint32_t rowPitch, ResourceFormat format, Quality quality = Quality::Normal);
+
+        /** Compress an image and its mip-chain, down to 1x1. The mip-levels are box-filtered, in linear space for the sRGB formats.
+            \param[in] pRgba The pixels of the top mip-level, 4 bytes in RGBA order each, with tightly packed rows
+            \param[in] width The width of the image
+            \param[in] height The height of the image
+            \param[in] format The block-compressed format
+            \param[in] quality The quality of the encoding
+            \param[out] mipCount The number of mip-levels
+            \return The blocks of the mip-levels, largest first. Empty if the format isn't supported.
+        */
+        static std::vector<uint8_t> compressWithMips(const uint8_t* pRgba, uint32_t width, uint32_t height, ResourceFormat format, Quality quality, uint32_t& mipCount);
+    };
+}
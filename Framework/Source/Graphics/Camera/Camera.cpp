@@ -31,6 +31,10 @@
 #include "utils/AABB.h"
 #include "Utils/math/FalcorMath.h"
 #include "API/ConstantBuffer.h"
+#include <emmintrin.h>
+#ifdef __AVX__
+#include <immintrin.h>
+#endif
 
 namespace Falcor
 {
@@ -194,6 +198,94 @@ namespace Falcor
         return !isInside;
     }
 
+    Camera::Containment Camera::getContainment(const BoundingBox& box) const
+    {
+        calculateCameraParameters();
+
+        Containment result = Containment::Inside;
+        for (int plane = 0; plane < 6; plane++)
+        {
+            glm::vec3 signedExtent = box.extent * mFrustumPlanes[plane].sign;
+
+            // The corner furthest along the plane normal is outside, so is the entire box
+            if (glm::dot(box.center + signedExtent, mFrustumPlanes[plane].xyz) <= mFrustumPlanes[plane].negW)
+            {
+                return Containment::Outside;
+            }
+
+            // The nearest corner is outside, the box straddles the plane
+            if (glm::dot(box.center - signedExtent, mFrustumPlanes[plane].xyz) <= mFrustumPlanes[plane].negW)
+            {
+                result = Containment::Intersecting;
+            }
+        }
+
+        return result;
+    }
+
+    void Camera::cullBoundingBoxes(const BoundingBoxArray& boxes, std::vector<uint32_t>& visibility) const
+    {
+        cullBoundingBoxes(boxes, 0, boxes.size(), visibility);
+    }
+
+    void Camera::cullBoundingBoxes(const BoundingBoxArray& boxes, uint32_t firstBox, uint32_t boxCount, std::vector<uint32_t>& visibility) const
+    {
+        assert(firstBox + boxCount <= boxes.size());
+        calculateCameraParameters();
+
+        visibility.assign((boxCount + 31) / 32, 0);
+
+        const float* cx = boxes.center[0].data() + firstBox;
+        const float* cy = boxes.center[1].data() + firstBox;
+        const float* cz = boxes.center[2].data() + firstBox;
+        const float* ex = boxes.extent[0].data() + firstBox;
+        const float* ey = boxes.extent[1].data() + firstBox;
+        const float* ez = boxes.extent[2].data() + firstBox;
+
+        // The math below matches isObjectCulled() operation for operation, so both paths produce identical results.
+        // Batches always start at a multiple of their width, so a batch's bits never straddle two words.
+        uint32_t i = 0;
+#ifdef __AVX__
+        for (; i + 8 <= boxCount; i += 8)
+        {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int plane = 0; plane < 6; plane++)
+            {
+                const auto& p = mFrustumPlanes[plane];
+                __m256 x = _mm256_add_ps(_mm256_loadu_ps(cx + i), _mm256_mul_ps(_mm256_loadu_ps(ex + i), _mm256_set1_ps(p.sign.x)));
+                __m256 y = _mm256_add_ps(_mm256_loadu_ps(cy + i), _mm256_mul_ps(_mm256_loadu_ps(ey + i), _mm256_set1_ps(p.sign.y)));
+                __m256 z = _mm256_add_ps(_mm256_loadu_ps(cz + i), _mm256_mul_ps(_mm256_loadu_ps(ez + i), _mm256_set1_ps(p.sign.z)));
+                __m256 dr = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, _mm256_set1_ps(p.xyz.x)), _mm256_mul_ps(y, _mm256_set1_ps(p.xyz.y))), _mm256_mul_ps(z, _mm256_set1_ps(p.xyz.z)));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(dr, _mm256_set1_ps(p.negW), _CMP_GT_OQ));
+            }
+            visibility[i / 32] |= uint32_t(_mm256_movemask_ps(inside)) << (i % 32);
+        }
+#endif
+        for (; i + 4 <= boxCount; i += 4)
+        {
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int plane = 0; plane < 6; plane++)
+            {
+                const auto& p = mFrustumPlanes[plane];
+                __m128 x = _mm_add_ps(_mm_loadu_ps(cx + i), _mm_mul_ps(_mm_loadu_ps(ex + i), _mm_set1_ps(p.sign.x)));
+                __m128 y = _mm_add_ps(_mm_loadu_ps(cy + i), _mm_mul_ps(_mm_loadu_ps(ey + i), _mm_set1_ps(p.sign.y)));
+                __m128 z = _mm_add_ps(_mm_loadu_ps(cz + i), _mm_mul_ps(_mm_loadu_ps(ez + i), _mm_set1_ps(p.sign.z)));
+                __m128 dr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(p.xyz.x)), _mm_mul_ps(y, _mm_set1_ps(p.xyz.y))), _mm_mul_ps(z, _mm_set1_ps(p.xyz.z)));
+                inside = _mm_and_ps(inside, _mm_cmpgt_ps(dr, _mm_set1_ps(p.negW)));
+            }
+            visibility[i / 32] |= uint32_t(_mm_movemask_ps(inside)) << (i % 32);
+        }
+
+        // Remainder
+        for (; i < boxCount; i++)
+        {
+            if (isObjectCulled(boxes.get(firstBox + i)) == false)
+            {
+                visibility[i / 32] |= 1u << (i % 32);
+            }
+        }
+    }
+
     void Camera::setRightEyeMatrices(const glm::mat4& view, const glm::mat4& proj)
     {
         mData.rightEyeViewMat = view;
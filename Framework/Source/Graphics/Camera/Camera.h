@@ -36,6 +36,7 @@
 namespace Falcor
 {
     struct BoundingBox;
+    struct BoundingBoxArray;
     class ConstantBuffer;
 
     /** Camera class
@@ -158,6 +159,29 @@ namespace Falcor
         */
         bool isObjectCulled(const BoundingBox& box) const;
 
+        /** Result of a bounding box vs. frustum containment test
+        */
+        enum class Containment
+        {
+            Outside,        ///< The box is completely outside the frustum
+            Intersecting,   ///< The box is partially inside the frustum
+            Inside          ///< The box is completely inside the frustum
+        };
+
+        /** Check how a bounding box is contained in the camera frustum. Unlike isObjectCulled(), this also detects boxes which are completely inside the frustum.
+        */
+        Containment getContainment(const BoundingBox& box) const;
+
+        /** Check a batch of bounding boxes against the frustum. Tests multiple boxes at once using SIMD, and gives the same results as calling isObjectCulled() for each box.
+            \param[in] boxes The boxes to test
+            \param[out] visibility Bitmask with a bit per box, set if the box is not culled. The bit of box N is bit (N % 32) of visibility[N / 32].
+        */
+        void cullBoundingBoxes(const BoundingBoxArray& boxes, std::vector<uint32_t>& visibility) const;
+
+        /** Check a range of a bounding box list against the frustum. Same as the above, but only tests boxCount boxes starting at firstBox. Bits in the visibility mask are relative to firstBox.
+        */
+        void cullBoundingBoxes(const BoundingBoxArray& boxes, uint32_t firstBox, uint32_t boxCount, std::vector<uint32_t>& visibility) const;
+
         void setIntoConstantBuffer(ConstantBuffer* pBuffer, const std::string& varName) const;
         void setIntoConstantBuffer(ConstantBuffer* pBuffer, const std::size_t& offset) const;
 
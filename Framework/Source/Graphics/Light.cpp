@@ -381,7 +381,7 @@ namespace Falcor
 // 			// Store the mesh CDF buffer id
 // 			mData.meshCDFPtr.ptr = mMeshCDFBuf->makeResident();
 // 		}
- 		mData.numIndices = uint32_t(mIndexBuf->getSize() / sizeof(glm::ivec3));
+ 		mData.numIndices = mpMeshInstance ? mpMeshInstance->getObject()->getPrimitiveCount() : 0; // The buffers may be shared with other meshes, see Mesh::getStartIndex()
  
  		// Get the surface area of the geometry mesh
  		mData.surfaceArea = mSurfaceArea;
@@ -429,7 +429,7 @@ namespace Falcor
             bool hasUv = uvIdx != Vao::ElementDesc::kInvalidIndex;
             if (hasUv)
             {
-                setTexCoordBuffer(vao->getVertexBuffer(VERTEX_TEXCOORD_LOC));
+                setTexCoordBuffer(vao->getVertexBuffer(uvIdx));
             }
 
             // Compute surface area of the mesh and generate probability
@@ -453,6 +453,81 @@ namespace Falcor
         }
     }
 
+    // Read the triangles of a mesh from its buffers. The mesh may be a range of buffers shared through a GeometryPool, with 16-bit indices or quantized positions.
+    // The returned indices are relative to the mesh's first vertex.
+    static bool readMeshTriangles(const Mesh* pMesh, std::vector<glm::uvec3>& triangles, std::vector<glm::vec3>& positions)
+    {
+        triangles.clear();
+        positions.clear();
+
+        // The CPU copy is already decoded
+        if (pMesh->hasCpuGeometry())
+        {
+            const auto& indices = pMesh->getCpuIndices();
+            for (size_t i = 0; i + 2 < indices.size(); i += 3)
+            {
+                triangles.push_back(glm::uvec3(indices[i], indices[i + 1], indices[i + 2]));
+            }
+            positions = pMesh->getCpuPositions();
+            return true;
+        }
+
+        const Vao* pVao = pMesh->getVao().get();
+        const Vao::ElementDesc posDesc = pVao->getElementIndexByLocation(VERTEX_POSITION_LOC);
+        if (posDesc.vbIndex == Vao::ElementDesc::kInvalidIndex || pVao->getIndexBuffer() == nullptr)
+        {
+            return false;
+        }
+
+        const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(posDesc.vbIndex).get();
+        const ResourceFormat posFormat = pLayout->getElementFormat(posDesc.elementIndex);
+        if (posFormat != ResourceFormat::RGB32Float && posFormat != ResourceFormat::RGBA32Float && posFormat != ResourceFormat::RGBA16Unorm)
+        {
+            logWarning("AreaLight: unsupported vertex position format " + to_string(posFormat));
+            return false;
+        }
+
+        const Buffer* pIB = pVao->getIndexBuffer().get();
+        const Buffer* pVB = pVao->getVertexBuffer(posDesc.vbIndex).get();
+        const bool is16Bit = (pVao->getIndexBufferFormat() == ResourceFormat::R16Uint);
+
+        const uint8_t* pIndexData = (const uint8_t*)pIB->map(Buffer::MapType::Read);
+        const uint8_t* pVertexData = (const uint8_t*)pVB->map(Buffer::MapType::Read);
+
+        const uint32_t startIndex = pMesh->getStartIndex();
+        for (uint32_t i = 0; i + 2 < pMesh->getIndexCount(); i += 3)
+        {
+            glm::uvec3 triangle;
+            for (uint32_t j = 0; j < 3; j++)
+            {
+                triangle[j] = is16Bit ? ((const uint16_t*)pIndexData)[startIndex + i + j] : ((const uint32_t*)pIndexData)[startIndex + i + j];
+            }
+            triangles.push_back(triangle);
+        }
+
+        const uint32_t stride = pLayout->getStride();
+        const uint8_t* pPositions = pVertexData + (size_t)pMesh->getBaseVertex() * stride + pLayout->getElementOffset(posDesc.elementIndex);
+        positions.resize(pMesh->getVertexCount());
+        for (uint32_t v = 0; v < pMesh->getVertexCount(); v++)
+        {
+            const uint8_t* pValue = pPositions + (size_t)v * stride;
+            if (posFormat == ResourceFormat::RGBA16Unorm)
+            {
+                const uint16_t* pQuantized = (const uint16_t*)pValue;
+                const glm::vec3 unorm = glm::vec3(pQuantized[0], pQuantized[1], pQuantized[2]) / 65535.0f;
+                positions[v] = unorm * pMesh->getPositionScale() + pMesh->getPositionBias();
+            }
+            else
+            {
+                positions[v] = *(const glm::vec3*)pValue;
+            }
+        }
+
+        pIB->unmap();
+        pVB->unmap();
+        return true;
+    }
+
     void AreaLight::computeSurfaceArea()
     {
         if (mpMeshInstance && mVertexBuf && mIndexBuf)
@@ -460,22 +535,28 @@ namespace Falcor
             const auto& pMesh = mpMeshInstance->getObject();
             assert(pMesh != nullptr);
 
-			if (mpMeshInstance->getObject()->getPrimitiveCount() != 2 || mpMeshInstance->getObject()->getVertexCount() != 4)
+            if (pMesh->getPrimitiveCount() != 2 || pMesh->getVertexCount() != 4)
             {
                 logWarning("Only support sampling of rectangular light sources made of 2 triangles.");
                 return;
             }
 
             // Read data from the buffers
-            const glm::ivec3* indices = (const glm::ivec3*)mIndexBuf->map(Buffer::MapType::Read);
-            const glm::vec3* vertices = (const glm::vec3*)mVertexBuf->map(Buffer::MapType::Read);
+            std::vector<glm::uvec3> indices;
+            std::vector<glm::vec3> vertices;
+            if (readMeshTriangles(pMesh.get(), indices, vertices) == false || indices.size() != pMesh->getPrimitiveCount())
+            {
+                logWarning("AreaLight: can't read the geometry of the light's mesh.");
+                return;
+            }
 
             // Calculate surface area of the mesh
             mSurfaceArea = 0.f;
+            mMeshCDF.clear();
             mMeshCDF.push_back(0.f);
             for (uint32_t i = 0; i < pMesh->getPrimitiveCount(); ++i)
             {
-                glm::ivec3 pId = indices[i];
+                glm::uvec3 pId = indices[i];
                 const vec3 p0(vertices[pId.x]), p1(vertices[pId.y]), p2(vertices[pId.z]);
 
                 mSurfaceArea += 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
@@ -496,45 +577,34 @@ namespace Falcor
                 mMeshCDF[mMeshCDF.size() - 1] = 1.f;
             }
 
-			// Calculate basis tangent vectors and their lengths
-			ivec3 pId = indices[0];
-			const vec3 p0(vertices[pId.x]), p1(vertices[pId.y]), p2(vertices[pId.z]);
+            // Calculate basis tangent vectors and their lengths
+            glm::uvec3 pId = indices[0];
+            const vec3 p0(vertices[pId.x]), p1(vertices[pId.y]), p2(vertices[pId.z]);
 
-			mTangent = p0 - p1;
-			mBitangent = p2 - p1;
+            mTangent = p0 - p1;
+            mBitangent = p2 - p1;
 
             // Create a CDF buffer
             mMeshCDFBuf.reset();
             mMeshCDFBuf = Buffer::create(sizeof(mMeshCDF[0])*mMeshCDF.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, mMeshCDF.data());
 
             // Set the world position and world direction of this light
-            if (mIndexBuf->getSize() != 0 && mVertexBuf->getSize() != 0)
+            glm::vec3 boxMin = vertices[0];
+            glm::vec3 boxMax = vertices[0];
+            for (uint32_t id = 1; id < (uint32_t)vertices.size(); ++id)
             {
-                glm::vec3 boxMin = vertices[0];
-                glm::vec3 boxMax = vertices[0];
-                for (uint32_t id = 1; id < mpMeshInstance->getObject()->getVertexCount(); ++id)
-                {
-                    boxMin = glm::min(boxMin, vertices[id]);
-                    boxMax = glm::max(boxMax, vertices[id]);
-                }
-
-                mData.worldPos = BoundingBox::fromMinMax(boxMin, boxMax).center;
-
-                // This holds only for planar light sources
-                const glm::vec3& p0 = vertices[indices[0].x];
-                const glm::vec3& p1 = vertices[indices[0].y];
-                const glm::vec3& p2 = vertices[indices[0].z];
+                boxMin = glm::min(boxMin, vertices[id]);
+                boxMax = glm::max(boxMax, vertices[id]);
+            }
 
-                // Take the normal of the first triangle as a light normal
-                mData.worldDir = normalize(cross(p1 - p0, p2 - p0));
+            mData.worldPos = BoundingBox::fromMinMax(boxMin, boxMax).center;
 
-                // Save the axis-aligned bounding box
-                mData.aabbMin = boxMin;
-                mData.aabbMax = boxMax;
-            }
+            // Take the normal of the first triangle as a light normal. This holds only for planar light sources.
+            mData.worldDir = normalize(cross(p1 - p0, p2 - p0));
 
-            mIndexBuf->unmap();
-            mVertexBuf->unmap();
+            // Save the axis-aligned bounding box
+            mData.aabbMin = boxMin;
+            mData.aabbMax = boxMax;
         }
     }
 
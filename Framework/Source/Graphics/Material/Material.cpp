@@ -37,13 +37,13 @@
 
 namespace Falcor
 {
-    uint32_t Material::sMaterialCounter = 0;
+    std::atomic<uint32_t> Material::sMaterialCounter(0);
+    std::mutex Material::sDescMutex;
     std::vector<Material::DescId> Material::sDescIdentifier;
 
     Material::Material(const std::string& name) : mName(name)
     {
-        mData.values.id = sMaterialCounter;
-        sMaterialCounter++;
+        mData.values.id = sMaterialCounter++;
     }
 
     Material::SharedPtr Material::create(const std::string& name)
@@ -409,6 +409,12 @@ namespace Falcor
     }
 
     void Material::removeDescIdentifier() const
+    {
+        std::lock_guard<std::mutex> lock(sDescMutex);
+        removeDescIdentifierLocked();
+    }
+
+    void Material::removeDescIdentifierLocked() const
     {
         for(size_t i = 0 ; i < sDescIdentifier.size() ; i++)
         {
@@ -428,7 +434,8 @@ namespace Falcor
     {
         static uint64_t identifier = 0;
 
-        removeDescIdentifier();
+        std::lock_guard<std::mutex> lock(sDescMutex);
+        removeDescIdentifierLocked();
         mDescDirty = false;
         for(auto& a : sDescIdentifier)
         {
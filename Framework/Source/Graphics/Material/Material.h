@@ -29,6 +29,8 @@
 #include "glm/vec3.hpp"
 #include <map>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include "glm/common.hpp"
 #include "glm/geometric.hpp"
 #include "API/Texture.h"
@@ -323,10 +325,13 @@ namespace Falcor
             uint32_t refCount;
         };
         mutable bool mDescDirty = false;
-        mutable size_t mDescIdentifier;
+        mutable size_t mDescIdentifier = (size_t)-1;
         void updateDescIdentifier() const;
         void removeDescIdentifier() const;
-        static uint32_t sMaterialCounter;
+        void removeDescIdentifierLocked() const;
+        // Materials are created and released by the async loaders too, so the counter is atomic and the identifiers are guarded by sDescMutex
+        static std::atomic<uint32_t> sMaterialCounter;
+        static std::mutex sDescMutex;
         static std::vector<DescId> sDescIdentifier; // vector is slower then map, but map requires 'less' operator. This vector is only being used when the material is dirty, which shouldn't happen often
     };
 }
\ No newline at end of file
@@ -0,0 +1,189 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "GeometryPool.h"
+#include "Utils/AsyncLoadTask.h"
+
+namespace Falcor
+{
+    static const uint32_t kMax16BitVertexCount = 0x10000;
+
+    // Layouts describing the same elements get the same key
+    static std::string getGroupKey(const VertexLayout* pLayout, Vao::Topology topology, bool use16BitIndices)
+    {
+        std::string key = std::to_string((uint32_t)topology) + (use16BitIndices ? "/16" : "/32");
+        for(size_t i = 0; i < pLayout->getBufferCount(); i++)
+        {
+            key += "|";
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+            if(pBufferLayout)
+            {
+                key += std::to_string((uint32_t)pBufferLayout->getInputClass()) + "," + std::to_string(pBufferLayout->getInstanceStepRate());
+                for(uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+                {
+                    key += ";" + pBufferLayout->getElementName(e) + "," + std::to_string(pBufferLayout->getElementOffset(e)) + "," + std::to_string((uint32_t)pBufferLayout->getElementFormat(e)) +
+                        "," + std::to_string(pBufferLayout->getElementArraySize(e)) + "," + std::to_string(pBufferLayout->getElementShaderLocation(e));
+                }
+            }
+        }
+        return key;
+    }
+
+    GeometryPool::SharedPtr GeometryPool::create(Buffer::BindFlags bindFlags)
+    {
+        return SharedPtr(new GeometryPool(bindFlags));
+    }
+
+    uint32_t GeometryPool::addVertices(const VertexLayout::SharedPtr& pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, Vao::Topology topology)
+    {
+        assert(mBuffersCreated == false);
+        const bool use16BitIndices = vertexCount <= kMax16BitVertexCount;
+        const std::string key = getGroupKey(pLayout.get(), topology, use16BitIndices);
+
+        // Start a new group if there is none for the key yet, or if the block doesn't fit into the current one
+        auto it = mOpenGroups.find(key);
+        bool fits = (it != mOpenGroups.end());
+        if(fits)
+        {
+            const Group& group = mGroups[it->second];
+            for(size_t i = 0; i < pLayout->getBufferCount(); i++)
+            {
+                const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+                const size_t blockSize = pBufferLayout ? (size_t)pBufferLayout->getStride() * vertexCount : 0;
+                fits = fits && (group.vertexData[i].size() + blockSize <= kMaxBufferSize);
+            }
+        }
+
+        if(fits == false)
+        {
+            Group group;
+            group.pLayout = pLayout;
+            group.topology = topology;
+            group.use16BitIndices = use16BitIndices;
+            group.vertexData.resize(pLayout->getBufferCount());
+            mGroups.push_back(std::move(group));
+            mOpenGroups[key] = (uint32_t)mGroups.size() - 1;
+            it = mOpenGroups.find(key);
+        }
+
+        Group& group = mGroups[it->second];
+        for(size_t i = 0; i < pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+            if(pBufferLayout && buffers[i])
+            {
+                group.vertexData[i].insert(group.vertexData[i].end(), buffers[i], buffers[i] + (size_t)pBufferLayout->getStride() * vertexCount);
+            }
+        }
+
+        VertexBlock block;
+        block.group = it->second;
+        block.baseVertex = group.vertexCount;
+        group.vertexCount += vertexCount;
+        mBlocks.push_back(block);
+        return (uint32_t)mBlocks.size() - 1;
+    }
+
+    uint32_t GeometryPool::addIndices(uint32_t vertexBlock, const uint32_t* pIndices, uint32_t indexCount)
+    {
+        assert(mBuffersCreated == false);
+        const VertexBlock& block = mBlocks[vertexBlock];
+        Group& group = mGroups[block.group];
+
+        Range range;
+        range.startIndex = (uint32_t)group.indices.size();
+        range.indexCount = indexCount;
+        range.baseVertex = (int32_t)block.baseVertex;
+        group.indices.insert(group.indices.end(), pIndices, pIndices + indexCount);
+
+        mRanges.push_back(range);
+        mRangeGroups.push_back(block.group);
+        return (uint32_t)mRanges.size() - 1;
+    }
+
+    void GeometryPool::createBuffers()
+    {
+        assert(mBuffersCreated == false);
+        mBuffersCreated = true;
+
+        std::vector<Vao::SharedPtr> vaos(mGroups.size());
+        for(size_t groupIndex = 0; groupIndex < mGroups.size(); groupIndex++)
+        {
+            Group& group = mGroups[groupIndex];
+            Vao::BufferVec pVBs(group.vertexData.size());
+            for(size_t i = 0; i < group.vertexData.size(); i++)
+            {
+                if(group.vertexData[i].size())
+                {
+                    const std::vector<uint8_t>& data = group.vertexData[i];
+                    pVBs[i] = AsyncLoadTask::runOnMainThread([&]() { return Buffer::create(data.size(), Buffer::BindFlags::Vertex | mBindFlags, Buffer::CpuAccess::None, data.data()); });
+                    mStatistics.vertexBytes += data.size();
+                }
+            }
+
+            // The indices are relative to their block, so 16-bit groups only need a narrowing copy
+            std::vector<uint16_t> indices16;
+            const void* pIndexData = group.indices.data();
+            size_t indexSize = group.indices.size() * sizeof(uint32_t);
+            if(group.use16BitIndices)
+            {
+                indices16.assign(group.indices.begin(), group.indices.end());
+                pIndexData = indices16.data();
+                indexSize = indices16.size() * sizeof(uint16_t);
+                mStatistics.indexBytesSaved += indexSize;
+            }
+            mStatistics.indexBytes += indexSize;
+
+            const ResourceFormat indexFormat = group.use16BitIndices ? ResourceFormat::R16Uint : ResourceFormat::R32Uint;
+            vaos[groupIndex] = AsyncLoadTask::runOnMainThread([&]()
+            {
+                Buffer::SharedPtr pIB = indexSize ? Buffer::create(indexSize, Buffer::BindFlags::Index | mBindFlags, Buffer::CpuAccess::None, pIndexData) : nullptr;
+                return Vao::create(pVBs, group.pLayout, pIB, indexFormat, group.topology);
+            });
+
+            // Free the CPU copies as soon as they are uploaded
+            group.vertexData = std::vector<std::vector<uint8_t>>();
+            group.indices = std::vector<uint32_t>();
+        }
+
+        for(size_t i = 0; i < mRanges.size(); i++)
+        {
+            mRanges[i].pVao = vaos[mRangeGroups[i]];
+        }
+
+        mStatistics.rangeCount = (uint32_t)mRanges.size();
+        mStatistics.vaoCount = (uint32_t)mGroups.size();
+    }
+
+    void GeometryPool::logStatistics(const std::string& modelName, const Statistics& stats)
+    {
+        const float kMB = 1024.0f * 1024.0f;
+        logInfo("Pooled the geometry of model " + modelName + ": " + std::to_string(stats.rangeCount) + " meshes in " + std::to_string(stats.vaoCount) + " vertex arrays, " +
+            std::to_string(stats.vertexBytes / kMB) + "MB of vertices, " + std::to_string(stats.indexBytes / kMB) + "MB of indices (" + std::to_string(stats.indexBytesSaved / kMB) + "MB saved by 16-bit indices).");
+    }
+}
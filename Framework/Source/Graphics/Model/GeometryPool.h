@@ -0,0 +1,135 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include "API/VAO.h"
+
+namespace Falcor
+{
+    /** Suballocates the vertex and index data of many meshes from a few large buffers.\n
+        Vertex blocks with the same layout and topology are packed into the same vertex buffers and share a Vao. Each index range is drawn with a start index and a base vertex, so switching between the meshes of a Vao doesn't rebind it.
+        Indices stay relative to their vertex block, so blocks of up to 65536 vertices are packed into Vaos with 16-bit indices, and only larger blocks need 32-bit indices.\n
+        Usage: add all the data with addVertices() and addIndices(), call createBuffers() once, then create the meshes from getRange().
+    */
+    class GeometryPool
+    {
+    public:
+        using SharedPtr = std::shared_ptr<GeometryPool>;
+
+        /** A Vao's vertex buffers are split before they grow past this size
+        */
+        static const size_t kMaxBufferSize = 256 * 1024 * 1024;
+
+        /** Where an index range ended up. Valid after createBuffers().
+        */
+        struct Range
+        {
+            Vao::SharedPtr pVao;
+            uint32_t startIndex = 0;
+            uint32_t indexCount = 0;
+            int32_t baseVertex = 0;
+        };
+
+        struct Statistics
+        {
+            uint32_t rangeCount = 0;
+            uint32_t vaoCount = 0;
+            size_t vertexBytes = 0;
+            size_t indexBytes = 0;
+            size_t indexBytesSaved = 0;     ///< Bytes saved by 16-bit indices
+        };
+
+        /** Create a pool
+            \param[in] bindFlags Bind flags added to the vertex and index buffers, for example Buffer::BindFlags::ShaderResource
+        */
+        static SharedPtr create(Buffer::BindFlags bindFlags = Buffer::BindFlags::None);
+
+        /** Add the vertices of a mesh. Several index ranges can share them.
+            \param[in] pLayout The vertex layout. Blocks are packed together if their layouts describe the same elements, even if they are different objects.
+            \param[in] buffers Pointer to the data of each buffer in the layout. Can be nullptr for buffers without elements.
+            \param[in] vertexCount Number of vertices
+            \param[in] topology The primitive topology of the index ranges using these vertices
+            \return The ID of the vertex block, for addIndices()
+        */
+        uint32_t addVertices(const VertexLayout::SharedPtr& pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, Vao::Topology topology);
+
+        /** Add an index range
+            \param[in] vertexBlock The vertices the indices refer to, as returned by addVertices()
+            \param[in] pIndices The indices, relative to the first vertex of the block
+            \param[in] indexCount Number of indices
+            \return The ID of the range, for getRange()
+        */
+        uint32_t addIndices(uint32_t vertexBlock, const uint32_t* pIndices, uint32_t indexCount);
+
+        /** Create the buffers and Vaos of everything added so far. Can only be called once.
+        */
+        void createBuffers();
+
+        /** Get an index range. Call createBuffers() first.
+        */
+        const Range& getRange(uint32_t range) const { return mRanges[range]; }
+
+        /** Get the memory used by the pool
+        */
+        const Statistics& getStatistics() const { return mStatistics; }
+
+        /** Log the statistics of a model's pool
+        */
+        static void logStatistics(const std::string& modelName, const Statistics& stats);
+
+    private:
+        GeometryPool(Buffer::BindFlags bindFlags) : mBindFlags(bindFlags) {}
+
+        struct Group
+        {
+            VertexLayout::SharedPtr pLayout;
+            Vao::Topology topology;
+            bool use16BitIndices;
+            std::vector<std::vector<uint8_t>> vertexData;
+            std::vector<uint32_t> indices;
+            uint32_t vertexCount = 0;
+        };
+
+        struct VertexBlock
+        {
+            uint32_t group;
+            uint32_t baseVertex;
+        };
+
+        Buffer::BindFlags mBindFlags;
+        std::vector<Group> mGroups;
+        std::unordered_map<std::string, uint32_t> mOpenGroups;     // The group new blocks of a layout, topology and index size go to
+        std::vector<VertexBlock> mBlocks;
+        std::vector<Range> mRanges;
+        std::vector<uint32_t> mRangeGroups;                         // The group of each range, until the Vaos exist
+        Statistics mStatistics;
+        bool mBuffersCreated = false;
+    };
+}
@@ -0,0 +1,181 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AssimpImportCache.h"
+#include "Importer.hpp"
+#include "Exporter.hpp"
+#include "scene.h"
+#include "version.h"
+#include "Utils/OS.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/HashUtils.h"
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <cstdio>
+#include <cstring>
+
+namespace Falcor
+{
+    // Bump this when AssimpModelImporter starts depending on something the cached scenes don't have
+    static const uint32_t kCacheVersion = 1;
+    static const char* kCacheFormatID = "assbin";
+
+    static std::mutex sMutex;
+    static bool sEnabled = true;
+    static std::string sDirectory;
+    static AssimpImportCache::Statistics sStatistics;
+
+    // Get the cache file of a model. Returns an empty string if the model file can't be read.
+    static std::string getCacheFilename(const std::string& fullpath, uint32_t assimpFlags, Model::LoadFlags loadFlags, const std::string& directory)
+    {
+        MemoryMappedFile::UniquePtr pFile = MemoryMappedFile::create(fullpath);
+        if(pFile == nullptr)
+        {
+            return "";
+        }
+
+        const uint32_t key[] = { kCacheVersion, aiGetVersionMajor(), aiGetVersionMinor(), aiGetVersionRevision(), assimpFlags, (uint32_t)loadFlags };
+        uint64_t hash = hashBytes(key, sizeof(key));
+        hash = hashBytes(pFile->getData(), pFile->getSize(), hash);
+
+        char hashString[17];
+        snprintf(hashString, sizeof(hashString), "%016llx", (unsigned long long)hash);
+        return directory + '\\' + getFilenameFromPath(fullpath) + '.' + hashString + '.' + kCacheFormatID;
+    }
+
+    static bool storeScene(const aiScene* pScene, const std::string& directory, const std::string& cacheFile)
+    {
+        // Another thread may create the directory between the two calls
+        if(isDirectoryExists(directory) == false && createDirectory(directory) == false && isDirectoryExists(directory) == false)
+        {
+            logWarning("Can't create the model import cache directory " + directory);
+            return false;
+        }
+
+        // Write to a file of our own first, so that concurrent loads never read a partial file
+        const std::string tempFile = cacheFile + '.' + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+        Assimp::Exporter exporter;
+        if(exporter.Export(pScene, kCacheFormatID, tempFile) != aiReturn_SUCCESS)
+        {
+            logWarning("Can't write cached model " + cacheFile + ".\n" + exporter.GetErrorString());
+            std::remove(tempFile.c_str());
+            return false;
+        }
+
+        std::remove(cacheFile.c_str());
+        if(std::rename(tempFile.c_str(), cacheFile.c_str()) != 0)
+        {
+            std::remove(tempFile.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    void AssimpImportCache::setEnabled(bool enabled)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sEnabled = enabled;
+    }
+
+    bool AssimpImportCache::isEnabled()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sEnabled;
+    }
+
+    void AssimpImportCache::setDirectory(const std::string& directory)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sDirectory = directory;
+    }
+
+    std::string AssimpImportCache::getDirectory()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sDirectory.empty() ? getExecutableDirectory() + "\\ModelCache" : sDirectory;
+    }
+
+    AssimpImportCache::Statistics AssimpImportCache::getStatistics()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sStatistics;
+    }
+
+    void AssimpImportCache::resetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sStatistics = Statistics();
+    }
+
+    const aiScene* AssimpImportCache::readFile(Assimp::Importer& importer, const std::string& fullpath, uint32_t assimpFlags, Model::LoadFlags loadFlags)
+    {
+        if(isEnabled() == false)
+        {
+            return importer.ReadFile(fullpath, assimpFlags);
+        }
+
+        const std::string directory = getDirectory();
+        CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+        const std::string cacheFile = getCacheFilename(fullpath, assimpFlags, loadFlags, directory);
+        const float hashTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+
+        start = CpuTimer::getCurrentTimePoint();
+        if(cacheFile.size() && doesFileExist(cacheFile))
+        {
+            // The cached scene is already post-processed
+            const aiScene* pScene = importer.ReadFile(cacheFile, 0);
+            if(pScene)
+            {
+                const float loadTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+                {
+                    std::lock_guard<std::mutex> lock(sMutex);
+                    sStatistics.hitCount++;
+                    sStatistics.hashTime += hashTime;
+                    sStatistics.hitLoadTime += loadTime;
+                }
+                logInfo("Loaded " + fullpath + " from the import cache in " + std::to_string(hashTime + loadTime) + "ms");
+                return pScene;
+            }
+            logWarning("Can't read cached model " + cacheFile + ". Importing the original file.\n" + importer.GetErrorString());
+            start = CpuTimer::getCurrentTimePoint();
+        }
+
+        const aiScene* pScene = importer.ReadFile(fullpath, assimpFlags);
+        const float loadTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        const bool stored = (pScene == nullptr) || cacheFile.empty() || storeScene(pScene, directory, cacheFile);
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        sStatistics.missCount++;
+        sStatistics.storeFailureCount += stored ? 0 : 1;
+        sStatistics.hashTime += hashTime;
+        sStatistics.missLoadTime += loadTime;
+        return pScene;
+    }
+}
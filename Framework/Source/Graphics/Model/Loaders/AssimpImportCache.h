@@ -0,0 +1,82 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "../Model.h"
+
+struct aiScene;
+namespace Assimp
+{
+    class Importer;
+}
+
+namespace Falcor
+{
+    /** On-disk cache of scenes post-processed by Assimp.\n
+        Assimp's post-processing is much slower than parsing, so AssimpModelImporter stores the processed aiScene in Assimp's binary format (assbin) and reads it back on the next load of the same file.
+        The cache key is a hash of the file's content, the Assimp post-processing flags, the model load flags and the Assimp version, so editing the file or changing the flags never returns a stale scene.
+        Only the model file itself is hashed. Textures are loaded from their own files either way, but material libraries referenced by OBJ files aren't part of the key, so the cache needs to be cleared after editing them.
+    */
+    class AssimpImportCache
+    {
+    public:
+        struct Statistics
+        {
+            uint32_t hitCount = 0;          ///< Loads which read a cached scene
+            uint32_t missCount = 0;         ///< Loads which had to run Assimp's post-processing
+            uint32_t storeFailureCount = 0; ///< Processed scenes which couldn't be written to the cache
+            float hashTime = 0;             ///< Total time spent hashing source files, in milliseconds
+            float hitLoadTime = 0;          ///< Total time spent reading cached scenes, in milliseconds
+            float missLoadTime = 0;         ///< Total time spent importing and post-processing source files, in milliseconds
+        };
+
+        /** Enable or disable the cache. It's enabled by default.
+        */
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+
+        /** Set the directory holding the cached scenes. The directory is created on first use. Defaults to 'ModelCache' in the executable directory.
+        */
+        static void setDirectory(const std::string& directory);
+        static std::string getDirectory();
+
+        /** Get the hit and miss statistics since startup or the last resetStatistics() call
+        */
+        static Statistics getStatistics();
+        static void resetStatistics();
+
+        /** Import a file with Assimp, using the cache when possible.
+            \param[in] importer The importer which owns the returned scene
+            \param[in] fullpath The full path of the model file
+            \param[in] assimpFlags Assimp post-processing flags
+            \param[in] loadFlags The flags the model is being loaded with
+            \return The scene, or nullptr if Assimp failed to import the file
+        */
+        static const aiScene* readFile(Assimp::Importer& importer, const std::string& fullpath, uint32_t assimpFlags, Model::LoadFlags loadFlags);
+    };
+}
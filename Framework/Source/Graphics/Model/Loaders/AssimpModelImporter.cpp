@@ -27,12 +27,16 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "AssimpModelImporter.h"
+#include "AssimpImportCache.h"
 #include "../Model.h"
 #include "Importer.hpp"
+#include "cexport.h"
 #include "postprocess.h"
 #include "scene.h"
 #include "../Animation.h"
 #include "../Mesh.h"
+#include "../VertexCompression.h"
+#include "../TangentSpaceGenerator.h"
 #include "../AnimationController.h"
 #include "glm/common.hpp"
 #include "glm/geometric.hpp"
@@ -41,9 +45,13 @@
 #include "glm/matrix.hpp"
 #include "Utils/OS.h"
 #include "Graphics/TextureHelper.h"
+#include "Graphics/TextureCache.h"
 #include "API/VertexLayout.h"
 #include "Data/VertexAttrib.h"
 #include "Utils/StringUtils.h"
+#include "Utils/AsyncLoadTask.h"
+#include <fstream>
+#include <memory>
 
 namespace Falcor
 {
@@ -57,15 +65,6 @@ namespace Falcor
 
     using VertexIdsVec = std::vector<uvec8_4>;
 
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* bitangentData);
-
 
     void loadBones(const aiMesh* pAiMesh, VertexWeightsVec& weights, VertexIdsVec& ids, uint32_t vertexCount, const std::map<std::string, uint32_t>& boneNameToIdMap)
     {
@@ -147,32 +146,91 @@ namespace Falcor
         return indices;
     }
 
-    void genTangentSpace(const aiMesh* pAiMesh)
+    template<typename T>
+    void remapAiArray(T* pArray, uint32_t vertexCount, const std::vector<uint32_t>& remap)
     {
-        if (pAiMesh->mFaces[0].mNumIndices == 3)
+        if(pArray)
         {
-            aiMesh* pMesh = const_cast<aiMesh*>(pAiMesh);
-            pMesh->mBitangents = new aiVector3D[pMesh->mNumVertices];
+            MeshOptimizer::remapVertices((uint8_t*)pArray, sizeof(T), vertexCount, remap);
+        }
+    }
+
+    void optimizeAiMesh(aiMesh* pMesh, MeshOptimizer::Statistics& stats)
+    {
+        if(pMesh->mFaces[0].mNumIndices != 3)
+        {
+            return;
+        }
 
-            const glm::vec3* pPos = (glm::vec3*)pMesh->mVertices;
-            glm::vec3* pBi = (glm::vec3*)pMesh->mBitangents;
-            glm::vec3* pNormals = (glm::vec3*)pMesh->mNormals;
-            std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
+        std::vector<uint32_t> indices = createIndexBufferData(pMesh);
+        const uint32_t vertexCount = pMesh->mNumVertices;
+        std::vector<uint32_t> remap = MeshOptimizer::optimizeMesh(indices, { (uint32_t)indices.size() }, vertexCount, &pMesh->mVertices[0].x, sizeof(aiVector3D), stats);
+        if(remap.empty())
+        {
+            return;
+        }
 
-            uint32_t texCrdCount = 0;
-            std::vector<glm::vec2> texCrd;
-            if (pMesh->mTextureCoords[0] != nullptr)
+        // Write the result back into the aiMesh, so the rest of the importer doesn't need to know about it
+        for(uint32_t i = 0; i < pMesh->mNumFaces; i++)
+        {
+            for(uint32_t j = 0; j < 3; j++)
             {
-                texCrdCount = 1;
-                texCrd.resize(pMesh->mNumVertices);
-                for (size_t i = 0; i < pMesh->mNumVertices; ++i)
-                {
-                    texCrd[i] = glm::vec2(pMesh->mTextureCoords[0][i].x, pMesh->mTextureCoords[0][i].y);
-                }
+                pMesh->mFaces[i].mIndices[j] = indices[i * 3 + j];
             }
+        }
 
-            generateSubmeshTangentData<glm::vec3>(indices, pPos, pNormals, (texCrdCount > 0 ? texCrd.data() : nullptr), texCrdCount, pBi);
+        remapAiArray(pMesh->mVertices, vertexCount, remap);
+        remapAiArray(pMesh->mNormals, vertexCount, remap);
+        remapAiArray(pMesh->mTangents, vertexCount, remap);
+        remapAiArray(pMesh->mBitangents, vertexCount, remap);
+        for(uint32_t i = 0; i < AI_MAX_NUMBER_OF_TEXTURECOORDS; i++)
+        {
+            remapAiArray(pMesh->mTextureCoords[i], vertexCount, remap);
         }
+        for(uint32_t i = 0; i < AI_MAX_NUMBER_OF_COLOR_SETS; i++)
+        {
+            remapAiArray(pMesh->mColors[i], vertexCount, remap);
+        }
+        for(uint32_t i = 0; i < pMesh->mNumBones; i++)
+        {
+            const aiBone* pBone = pMesh->mBones[i];
+            for(uint32_t j = 0; j < pBone->mNumWeights; j++)
+            {
+                pBone->mWeights[j].mVertexId = remap[pBone->mWeights[j].mVertexId];
+            }
+        }
+    }
+
+    // Generate the bitangents of all the triangle meshes at once, so that the meshes are processed in parallel
+    void genTangentSpace(const aiScene* pScene)
+    {
+        std::vector<std::vector<uint32_t>> indices(pScene->mNumMeshes);
+        std::vector<TangentSpaceGenerator::MeshDesc> meshes;
+        for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+        {
+            aiMesh* pMesh = pScene->mMeshes[i];
+            if (pMesh->mFaces[0].mNumIndices != 3 || pMesh->mNormals == nullptr)
+            {
+                continue;
+            }
+            pMesh->mBitangents = new aiVector3D[pMesh->mNumVertices];
+            indices[i] = createIndexBufferData(pMesh);
+
+            TangentSpaceGenerator::MeshDesc desc;
+            desc.pPositions = (const uint8_t*)pMesh->mVertices;
+            desc.positionStride = sizeof(aiVector3D);
+            desc.pNormals = (const uint8_t*)pMesh->mNormals;
+            desc.normalStride = sizeof(aiVector3D);
+            desc.pTexCrds = (const uint8_t*)pMesh->mTextureCoords[0];
+            desc.texCrdStride = sizeof(aiVector3D);
+            desc.vertexCount = pMesh->mNumVertices;
+            desc.submeshIndices.push_back(indices[i].data());
+            desc.submeshIndexCounts.push_back((uint32_t)indices[i].size());
+            desc.pBitangents = (uint8_t*)pMesh->mBitangents;
+            desc.bitangentStride = sizeof(aiVector3D);
+            meshes.push_back(desc);
+        }
+        TangentSpaceGenerator::generateBitangents(meshes);
     }
 
     struct layoutsData
@@ -295,7 +353,7 @@ namespace Falcor
                 {
                     // create a new texture
                     std::string fullpath = folder + '\\' + s;
-                    pTex = createTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
+                    pTex = TextureCache::getTextureFromFile(fullpath, true, isSrgbRequired(aiType, useSrgb));
                     if (pTex)
                     {
                         mTextureCache[s] = pTex;
@@ -410,12 +468,21 @@ namespace Falcor
 
     AssimpModelImporter::AssimpModelImporter(Model& model, Model::LoadFlags flags) : mFlags(flags), mModel(model)
     {
+        if(is_set(flags, Model::LoadFlags::PoolGeometry))
+        {
+            mpGeometryPool = GeometryPool::create(is_set(flags, Model::LoadFlags::BuffersAsShaderResource) ? Buffer::BindFlags::ShaderResource : Buffer::BindFlags::None);
+        }
     }
 
     bool AssimpModelImporter::createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb)
     {
         for (uint32_t i = 0; i < pScene->mNumMaterials; i++)
         {
+            if (AsyncLoadTask::isCancelled())
+            {
+                return false;
+            }
+
             const aiMaterial* pAiMaterial = pScene->mMaterials[i];
             auto pMaterial = createMaterial(pAiMaterial, modelFolder, isObjFile, useSrgb);
             if (pMaterial == nullptr)
@@ -456,6 +523,10 @@ namespace Falcor
                 // New mesh
                 if (aiToFalcorMesh.find(aiId) == aiToFalcorMesh.end())
                 {
+                    if (AsyncLoadTask::isCancelled())
+                    {
+                        return false;
+                    }
                     // Cache mesh
                     aiToFalcorMesh[aiId] = createMesh(pScene->mMeshes[aiId]);
                 }
@@ -464,19 +535,62 @@ namespace Falcor
             }
         }
 
-        bool b = true;
         // visit the children
         for (uint32_t i = 0; i < pCurrent->mNumChildren; i++)
         {
-            b |= parseAiSceneNode(pCurrent->mChildren[i], pScene, aiToFalcorMesh);
+            if (parseAiSceneNode(pCurrent->mChildren[i], pScene, aiToFalcorMesh) == false)
+            {
+                return false;
+            }
         }
-        return b;
+        return true;
     }
 
-    bool AssimpModelImporter::createDrawList(const aiScene* pScene)
+    bool AssimpModelImporter::createDrawList(aiScene* pScene)
     {
         createAnimationController(pScene);
         IdToMesh aiToFalcorMeshId;
+
+        // The tangents depend on the triangle order, so the meshes are optimized first
+        if (is_set(mFlags, Model::LoadFlags::OptimizeMeshes))
+        {
+            for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+            {
+                if (AsyncLoadTask::isCancelled())
+                {
+                    return false;
+                }
+                optimizeAiMesh(pScene->mMeshes[i], mOptimizerStats);
+            }
+        }
+        if (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false)
+        {
+            genTangentSpace(pScene);
+        }
+
+        // Pooled meshes are all added to the pool first, then created from it once its buffers exist
+        if (mpGeometryPool)
+        {
+            std::vector<MeshData> meshData(pScene->mNumMeshes);
+            for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+            {
+                if (AsyncLoadTask::isCancelled() || initMeshData(pScene->mMeshes[i], meshData[i]) == false)
+                {
+                    return false;
+                }
+                if (meshData[i].pGeometry == nullptr)
+                {
+                    addToGeometryPool(meshData[i]);
+                }
+            }
+            mpGeometryPool->createBuffers();
+
+            for (uint32_t i = 0; i < pScene->mNumMeshes; i++)
+            {
+                aiToFalcorMeshId[i] = createMesh(pScene->mMeshes[i], meshData[i]);
+            }
+        }
+
         aiNode* pRoot = pScene->mRootNode;
         return parseAiSceneNode(pRoot, pScene, aiToFalcorMeshId);
     }
@@ -511,8 +625,13 @@ namespace Falcor
         // Never use Assimp's tangent gen code
         AssimpFlags &= ~(aiProcess_CalcTangentSpace);
 
+        // Assimp parses the whole file at once, so the progress only advances when it's done
+        const uint64_t fileSize = (uint64_t)std::ifstream(fullpath, std::ios::binary | std::ios::ate).tellg();
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TotalBytes, fileSize);
+
         Assimp::Importer importer;
-        const aiScene* pScene = importer.ReadFile(fullpath, AssimpFlags);
+        const aiScene* pScene = AssimpImportCache::readFile(importer, fullpath, AssimpFlags, mFlags);
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::BytesRead, fileSize);
 
         if((pScene == nullptr) || (verifyScene(pScene) == false))
         {
@@ -522,6 +641,14 @@ namespace Falcor
             return false;
         }
 
+        // The optimizer and the tangent generation rewrite the meshes, so they work on our own copy instead of the scene Assimp returned.
+        // Assimp's scene is freed right away, so only one copy stays alive.
+        aiScene* pCopy = nullptr;
+        aiCopyScene(pScene, &pCopy);
+        std::unique_ptr<aiScene, void(*)(const aiScene*)> pMutableScene(pCopy, aiFreeScene);
+        importer.FreeScene();
+        pScene = pMutableScene.get();
+
         // Extract the folder name
         auto last = fullpath.find_last_of("/\\");
         std::string modelFolder = fullpath.substr(0, last);
@@ -529,18 +656,33 @@ namespace Falcor
         // Order of initialization matters, materials, bones and animations need to loaded before mesh initialization
         bool isObjFile = hasSuffix(filename, ".obj", false);
         bool useSrgbTextures = !is_set(mFlags, Model::LoadFlags::AssumeLinearSpaceTextures);
+        // Cancelled async loads return early without an error
         if(createAllMaterials(pScene, modelFolder, isObjFile, useSrgbTextures) == false)
         {
-            logError(std::string("Can't create materials for model ") + filename, true);
+            if(AsyncLoadTask::isCancelled() == false)
+            {
+                logError(std::string("Can't create materials for model ") + filename, true);
+            }
             return false;
         }
 
-        if (createDrawList(pScene) == false)
+        if (createDrawList(pMutableScene.get()) == false)
         {
-            logError(std::string("Can't create draw lists for model ") + filename, true);
+            if(AsyncLoadTask::isCancelled() == false)
+            {
+                logError(std::string("Can't create draw lists for model ") + filename, true);
+            }
             return false;
         }
 
+        if(is_set(mFlags, Model::LoadFlags::OptimizeMeshes))
+        {
+            MeshOptimizer::logStatistics(filename, mOptimizerStats);
+        }
+        if (mpGeometryPool)
+        {
+            GeometryPool::logStatistics(filename, mpGeometryPool->getStatistics());
+        }
         return true;
     }
 
@@ -720,83 +862,215 @@ namespace Falcor
         return BoundingBox::fromMinMax(boxMin, boxMax);
     }
 
-    Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh)
+    bool AssimpModelImporter::initMeshData(const aiMesh* pAiMesh, MeshData& data)
     {
-        uint32_t vertexCount = pAiMesh->mNumVertices;
-        uint32_t indexCount = pAiMesh->mNumFaces * pAiMesh->mFaces[0].mNumIndices;
-        auto pIB = createIndexBuffer(pAiMesh);
-        BoundingBox boundingBox = createMeshBbox(pAiMesh);
-
-        if(is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false)
-        {
-            genTangentSpace(pAiMesh);
-        }
+        data.vertexCount = pAiMesh->mNumVertices;
+        data.indices = createIndexBufferData(pAiMesh);
+        data.indexCount = (uint32_t)data.indices.size();
+        data.box = createMeshBbox(pAiMesh);
 
-        VertexLayout::SharedPtr pLayout = createVertexLayout(pAiMesh);
-        if (pLayout == nullptr)
+        data.pLayout = createVertexLayout(pAiMesh);
+        if (data.pLayout == nullptr)
         {
             assert(0);
-            return nullptr;
+            return false;
         }
 
-        std::vector<Buffer::SharedPtr> pVBs(pLayout->getBufferCount());
-
         // Initialize the bones data
         VertexWeightsVec weights;
         VertexIdsVec ids;
         if (pAiMesh->HasBones())
         {
-            loadBones(pAiMesh, weights, ids, vertexCount, mBoneNameToIdMap);
+            loadBones(pAiMesh, weights, ids, data.vertexCount, mBoneNameToIdMap);
+        }
+
+        // Create the vertex buffer data
+        data.vertexData.resize(data.pLayout->getBufferCount());
+        for (uint32_t i = 0; i < data.pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pVbLayout = data.pLayout->getBufferLayout(i).get();
+            data.vertexData[i] = createVertexBufferData(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+        }
+
+        if (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false)
+        {
+            aiMesh* pM = const_cast<aiMesh*>(pAiMesh);
+            safe_delete_array(pM->mBitangents);
+        }
+
+        // The LODs reuse the vertices, so their indices go into the same index buffer
+        if (is_set(mFlags, Model::LoadFlags::GenerateLods) && pAiMesh->mFaces[0].mNumIndices == 3)
+        {
+            std::vector<const uint8_t*> pData(data.vertexData.size());
+            for (uint32_t i = 0; i < (uint32_t)data.vertexData.size(); i++)
+            {
+                pData[i] = data.vertexData[i].data();
+            }
+            std::vector<MeshSimplifier::Lod> lods = MeshSimplifier::generateLodChain(data.pLayout.get(), pData, data.vertexCount, data.indices.data(), data.indexCount);
+            for (const MeshSimplifier::Lod& lod : lods)
+            {
+                data.lods.push_back({ (uint32_t)data.indices.size(), (uint32_t)lod.indices.size(), lod.error });
+                data.indices.insert(data.indices.end(), lod.indices.begin(), lod.indices.end());
+            }
         }
 
-        // Create corresponding vertex buffers
-        for (uint32_t i = 0; i < pLayout->getBufferCount(); i++)
+        // Skinned meshes move away from the meshlet bounds, so they aren't split
+        if (is_set(mFlags, Model::LoadFlags::BuildMeshlets) && pAiMesh->mFaces[0].mNumIndices == 3 && pAiMesh->HasBones() == false)
         {
-            const VertexBufferLayout* pVbLayout = pLayout->getBufferLayout(i).get();
-            pVBs[i] = createVertexBuffer(pAiMesh, pVbLayout, (uint8_t*)ids.data(), weights.data());
+            std::vector<const uint8_t*> pData(data.vertexData.size());
+            for (uint32_t i = 0; i < (uint32_t)data.vertexData.size(); i++)
+            {
+                pData[i] = data.vertexData[i].data();
+            }
+            data.meshlets = MeshletBuilder::build(data.pLayout.get(), pData, data.vertexCount, data.indices.data(), data.indexCount);
+        }
+
+        if (is_set(mFlags, Model::LoadFlags::CompressVertices))
+        {
+            std::vector<const uint8_t*> pData(data.vertexData.size());
+            for (uint32_t i = 0; i < (uint32_t)data.vertexData.size(); i++)
+            {
+                pData[i] = data.vertexData[i].data();
+            }
+            VertexCompression::Result compressed = VertexCompression::compressVertices(data.pLayout.get(), pData, data.vertexCount, is_set(mFlags, Model::LoadFlags::QuantizePositions));
+            data.vertexData = std::move(compressed.buffers);
+            data.pLayout = compressed.pLayout;
+            data.positionScale = compressed.positionScale;
+            data.positionBias = compressed.positionBias;
         }
 
-        Vao::Topology topology;
         switch (pAiMesh->mFaces[0].mNumIndices)
         {
         case 1:
-            topology = Vao::Topology::PointList;
+            data.topology = Vao::Topology::PointList;
             break;
         case 2:
-            topology = Vao::Topology::LineList;
+            data.topology = Vao::Topology::LineList;
             break;
         case 3:
-            topology = Vao::Topology::TriangleList;
+            data.topology = Vao::Topology::TriangleList;
             break;
         default:
             logError(std::string("Error when creating mesh. Unknown topology with " + std::to_string(pAiMesh->mFaces[0].mNumIndices) + " indices."));
             assert(0);
+            return false;
+        }
+
+        // Assimp already welds the vertices and merges the identical meshes of a scene, so only the meshes of models loaded before are looked up.
+        // The bone IDs of skinned meshes belong to their model, so those are never shared.
+        if (is_set(mFlags, Model::LoadFlags::DeduplicateGeometry) && pAiMesh->HasBones() == false)
+        {
+            MeshDeduplicator::Hasher hasher;
+            hasher.add(mFlags);
+            hasher.add(data.pLayout.get());
+            for (const std::vector<uint8_t>& vertexData : data.vertexData)
+            {
+                hasher.add(vertexData.data(), vertexData.size());
+            }
+            hasher.add(data.indices.data(), data.indices.size() * sizeof(uint32_t));
+            hasher.add(data.lods.data(), data.lods.size() * sizeof(Mesh::Lod));
+            hasher.add(&data.positionScale, sizeof(data.positionScale));
+            hasher.add(&data.positionBias, sizeof(data.positionBias));
+            hasher.add(&data.topology, sizeof(data.topology));
+            data.deduplicate = true;
+            data.geometryKey = hasher.getKey();
+            data.pGeometry = MeshDeduplicator::findGeometry(data.geometryKey);
+        }
+        return true;
+    }
+
+    void AssimpModelImporter::addToGeometryPool(MeshData& data)
+    {
+        std::vector<const uint8_t*> pData(data.vertexData.size());
+        for (uint32_t i = 0; i < (uint32_t)data.vertexData.size(); i++)
+        {
+            pData[i] = data.vertexData[i].size() ? data.vertexData[i].data() : nullptr;
         }
+        uint32_t vertexBlock = mpGeometryPool->addVertices(data.pLayout, pData, data.vertexCount, data.topology);
+        data.poolRange = mpGeometryPool->addIndices(vertexBlock, data.indices.data(), (uint32_t)data.indices.size());
 
+        // The pool keeps its own copy
+        data.vertexData = std::vector<std::vector<uint8_t>>();
+    }
+
+    Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh, MeshData& data)
+    {
         auto pMaterial = mAiMaterialToFalcor[pAiMesh->mMaterialIndex];
         assert(pMaterial);
 
-        Mesh::SharedPtr pMesh = Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, topology, pMaterial, boundingBox, pAiMesh->HasBones());
+        if (data.pGeometry)
+        {
+            AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::MeshesCreated);
+            return MeshDeduplicator::instantiate(data.pGeometry, data.geometryKey, pMaterial, mModelMeshes);
+        }
 
-        if (is_set(mFlags, Model::LoadFlags::DontGenerateTangentSpace) == false)
+        Mesh::SharedPtr pMesh;
+        uint32_t startIndex = 0;
+        if (mpGeometryPool)
         {
-            aiMesh* pM = const_cast<aiMesh*>(pAiMesh);
-            safe_delete_array(pM->mBitangents);
+            const GeometryPool::Range& range = mpGeometryPool->getRange(data.poolRange);
+            startIndex = range.startIndex;
+            pMesh = AsyncLoadTask::runOnMainThread([&]() { return Mesh::create(range.pVao, data.vertexCount, range.startIndex, data.indexCount, range.baseVertex, pMaterial, data.box, pAiMesh->HasBones()); });
+        }
+        else
+        {
+            std::vector<Buffer::SharedPtr> pVBs(data.pLayout->getBufferCount());
+            for (uint32_t i = 0; i < data.pLayout->getBufferCount(); i++)
+            {
+                pVBs[i] = createVertexBuffer(data.vertexData[i]);
+            }
+            auto pIB = createIndexBuffer(data.indices);
+            pMesh = AsyncLoadTask::runOnMainThread([&]() { return Mesh::create(pVBs, data.vertexCount, pIB, data.indexCount, data.pLayout, data.topology, pMaterial, data.box, pAiMesh->HasBones()); });
+        }
+        pMesh->setPositionDequantization(data.positionScale, data.positionBias);
+        for (const Mesh::Lod& lod : data.lods)
+        {
+            pMesh->addLod(startIndex + lod.startIndex, lod.indexCount, lod.error);
+        }
+        for (Meshlet& meshlet : data.meshlets)
+        {
+            meshlet.startIndex += startIndex;
+        }
+        pMesh->setMeshlets(std::move(data.meshlets));
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::MeshesCreated);
+
+        if (is_set(mFlags, Model::LoadFlags::KeepCpuGeometry) && data.topology == Vao::Topology::TriangleList)
+        {
+            std::vector<glm::vec3> positions(data.vertexCount);
+            for (uint32_t i = 0; i < data.vertexCount; i++)
+            {
+                positions[i] = glm::vec3(pAiMesh->mVertices[i].x, pAiMesh->mVertices[i].y, pAiMesh->mVertices[i].z);
+            }
+            data.indices.resize(data.indexCount);
+            pMesh->setCpuGeometry(std::move(positions), std::move(data.indices));
         }
 
+        if (data.deduplicate)
+        {
+            MeshDeduplicator::registerMesh(data.geometryKey, pMesh, mModelMeshes);
+        }
         return pMesh;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const aiMesh* pAiMesh)
+    Mesh::SharedPtr AssimpModelImporter::createMesh(const aiMesh* pAiMesh)
+    {
+        MeshData data;
+        if (initMeshData(pAiMesh, data) == false)
+        {
+            return nullptr;
+        }
+        return createMesh(pAiMesh, data);
+    }
+
+    Buffer::SharedPtr AssimpModelImporter::createIndexBuffer(const std::vector<uint32_t>& indices)
     {
-        std::vector<uint32_t> indices = createIndexBufferData(pAiMesh);
         const uint32_t size = (uint32_t)(sizeof(uint32_t) * indices.size());
         Buffer::BindFlags bindFlags = Buffer::BindFlags::Index;
         if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
         {
             bindFlags |= Buffer::BindFlags::ShaderResource;
         }
-        return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices.data());;
+        return AsyncLoadTask::runOnMainThread([&]() { return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, indices.data()); });
     }
 
 
@@ -866,7 +1140,7 @@ namespace Falcor
         return pLayout;
     }
 
-    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
+    std::vector<uint8_t> AssimpModelImporter::createVertexBufferData(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights)
     {
         const uint32_t vertexStride = pLayout->getStride();
         std::vector<uint8_t> initData(vertexStride * pAiMesh->mNumVertices, 0);
@@ -925,12 +1199,17 @@ namespace Falcor
                 memcpy(pDst, pSrc, size);
             }
         }
+        return initData;
+    }
+
+    Buffer::SharedPtr AssimpModelImporter::createVertexBuffer(const std::vector<uint8_t>& data)
+    {
         Buffer::BindFlags bindFlags = Buffer::BindFlags::Vertex;
         if (is_set(mFlags, Model::LoadFlags::BuffersAsShaderResource))
         {
             bindFlags |= Buffer::BindFlags::ShaderResource;
         }
 
-        return Buffer::create(vertexStride * pAiMesh->mNumVertices, bindFlags, Buffer::CpuAccess::None, initData.data());;
+        return AsyncLoadTask::runOnMainThread([&]() { return Buffer::create((uint32_t)data.size(), bindFlags, Buffer::CpuAccess::None, data.data()); });
     }
 }
\ No newline at end of file
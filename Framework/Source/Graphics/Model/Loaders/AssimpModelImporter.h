@@ -32,6 +32,11 @@
 #include "../AnimationController.h"
 #include "../Mesh.h"
 #include "../Model.h"
+#include "../MeshOptimizer.h"
+#include "../GeometryPool.h"
+#include "../MeshSimplifier.h"
+#include "../MeshletBuilder.h"
+#include "../MeshDeduplicator.h"
 
 struct aiScene;
 struct aiNode;
@@ -60,12 +65,32 @@ namespace Falcor
 
         using IdToMesh = std::unordered_map<uint32_t, Mesh::SharedPtr>;
 
+        // The data of a mesh, between reading it from the scene and creating the Mesh
+        struct MeshData
+        {
+            VertexLayout::SharedPtr pLayout;
+            std::vector<std::vector<uint8_t>> vertexData;
+            std::vector<uint32_t> indices;          // The full detail triangle list, followed by the LODs
+            uint32_t indexCount = 0;                // Number of full detail indices
+            std::vector<Mesh::Lod> lods;            // The coarser LODs, located in the indices
+            std::vector<Meshlet> meshlets;          // Located in the full detail indices
+            uint32_t vertexCount = 0;
+            Vao::Topology topology = Vao::Topology::TriangleList;
+            BoundingBox box;
+            glm::vec3 positionScale = glm::vec3(1);
+            glm::vec3 positionBias = glm::vec3(0);
+            uint32_t poolRange = 0;
+            bool deduplicate = false;               // Whether the geometry key is valid
+            MeshDeduplicator::Key geometryKey;
+            Mesh::SharedPtr pGeometry;              // An identical mesh loaded before, whose buffers are reused
+        };
+
         AssimpModelImporter(Model& model, Model::LoadFlags flags);
         AssimpModelImporter(const AssimpModelImporter&) = delete;
         void operator=(const AssimpModelImporter&) = delete;
 
         bool initModel(const std::string& filename);
-        bool createDrawList(const aiScene* pScene);
+        bool createDrawList(aiScene* pScene);
         bool parseAiSceneNode(const aiNode* pCurrent, const aiScene* pScene, IdToMesh& aiToFalcorMesh);
         bool createAllMaterials(const aiScene* pScene, const std::string& modelFolder, bool isObjFile, bool useSrgb);
 
@@ -77,9 +102,13 @@ namespace Falcor
         Animation::UniquePtr createAnimation(const aiAnimation* pAiAnim);
 
         Mesh::SharedPtr createMesh(const aiMesh* pAiMesh);
+        bool initMeshData(const aiMesh* pAiMesh, MeshData& data);
+        void addToGeometryPool(MeshData& data);
+        Mesh::SharedPtr createMesh(const aiMesh* pAiMesh, MeshData& data);
         VertexLayout::SharedPtr createVertexLayout(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createIndexBuffer(const aiMesh* pAiMesh);
-        Buffer::SharedPtr createVertexBuffer(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+        Buffer::SharedPtr createIndexBuffer(const std::vector<uint32_t>& indices);
+        std::vector<uint8_t> createVertexBufferData(const aiMesh* pAiMesh, const VertexBufferLayout* pLayout, const uint8_t* pBoneIds, const vec4* pBoneWeights);
+        Buffer::SharedPtr createVertexBuffer(const std::vector<uint8_t>& data);
         void loadTextures(const aiMaterial* pAiMaterial, const std::string& folder, BasicMaterial* pMaterial, bool isObjFile, bool useSrgb);
         Material::SharedPtr createMaterial(const aiMaterial* pAiMaterial, const std::string& folder, bool isObjFile, bool useSrgb);
 
@@ -91,5 +120,8 @@ namespace Falcor
         std::vector<Bone> mBones;
         Model::LoadFlags mFlags;
         std::map<const std::string, Texture::SharedPtr> mTextureCache;
+        MeshOptimizer::Statistics mOptimizerStats;
+        GeometryPool::SharedPtr mpGeometryPool;
+        MeshDeduplicator::ModelMeshes mModelMeshes;
     };
 }
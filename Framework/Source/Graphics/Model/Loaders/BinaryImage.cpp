@@ -27,6 +27,7 @@
 ***************************************************************************/
 #include "Framework.h"
 #include "BinaryImage.hpp"
+#include <emmintrin.h>
 //#include "gpu/CudaModule.hpp"
 
 using namespace FW;
@@ -53,8 +54,8 @@ const ImageFormat::StaticFormat ImageFormat::s_staticFormats[] =
     /* RGBA_Vec4f */    { 16, 4, { CF32(R,0), CF32(G,4), CF32(B,8), CF32(A,12) },       /*GL_RGBA32F, GL_RGBA, GL_FLOAT, false */},
     /* A_F32 */         { 4,  1, { CF32(A,0) },                                         /*GL_ALPHA32F_ARB, GL_ALPHA, GL_FLOAT, false */},
 
-    /*BGRA_8888*/       { 4,  4, { C8(R,0), C8(G,1), C8(B,2), C8(A, 3) },               /*GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, false */},
-    /*BGR_888*/         { 3,  3, { C8(R,0), C8(G,1), C8(B,2) },                         /*GL_RGB8, GL_BGR, GL_UNSIGNED_BYTE, false */},
+    /*BGRA_8888*/       { 4,  4, { C8(B,0), C8(G,1), C8(R,2), C8(A, 3) },               /*GL_RGBA8, GL_BGRA, GL_UNSIGNED_BYTE, false */},
+    /*BGR_888*/         { 3,  3, { C8(B,0), C8(G,1), C8(R,2) },                         /*GL_RGB8, GL_BGR, GL_UNSIGNED_BYTE, false */},
     /*RG_88*/           { 2,  2, { C8(R,0), C8(G,1), },                                 /*GL_RG8,  GL_RG,  GL_UNSIGNED_BYTE, false */},
     /*R8*/              { 1,  1, { C8(R,0)},                                            /*GL_R,    GL_RED, GL_UNSIGNED_BYTE, false */},
 
@@ -190,6 +191,354 @@ void ImageFormat::addChannel(const Channel& channel)
 
 //------------------------------------------------------------------------
 
+// Pixel conversion kernels. Each converts one row and handles the pixels that don't fill a whole SIMD step itself.
+
+typedef void (*RowKernel)(U8* dstPtr, const U8* srcPtr, int width);
+
+// 3 bytes per pixel to 4, with the fourth byte set to 0xFF. The channel order is kept, so this does both R8_G8_B8 and BGR_888.
+static void expandRGB8Row(U8* dstPtr, const U8* srcPtr, int width)
+{
+    // Every 32-bit lane takes its 3 bytes from a copy of the register shifted by the lane index
+    const __m128i alpha = _mm_set1_epi32(0xFF000000);
+    const __m128i lane0 = _mm_set_epi32(0, 0, 0, 0x00FFFFFF);
+    const __m128i lane1 = _mm_set_epi32(0, 0, 0x00FFFFFF, 0);
+    const __m128i lane2 = _mm_set_epi32(0, 0x00FFFFFF, 0, 0);
+    const __m128i lane3 = _mm_set_epi32(0x00FFFFFF, 0, 0, 0);
+
+    auto expand4 = [&](__m128i v)
+    {
+        __m128i r = _mm_and_si128(v, lane0);
+        r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 1), lane1));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 2), lane2));
+        r = _mm_or_si128(r, _mm_and_si128(_mm_slli_si128(v, 3), lane3));
+        return _mm_or_si128(r, alpha);
+    };
+
+    int x = 0;
+    for (; x + 16 <= width; x += 16, srcPtr += 48, dstPtr += 64)
+    {
+        const __m128i a = _mm_loadu_si128((const __m128i*)srcPtr);
+        const __m128i b = _mm_loadu_si128((const __m128i*)(srcPtr + 16));
+        const __m128i c = _mm_loadu_si128((const __m128i*)(srcPtr + 32));
+        _mm_storeu_si128((__m128i*)dstPtr, expand4(a));
+        _mm_storeu_si128((__m128i*)(dstPtr + 16), expand4(_mm_or_si128(_mm_srli_si128(a, 12), _mm_slli_si128(b, 4))));
+        _mm_storeu_si128((__m128i*)(dstPtr + 32), expand4(_mm_or_si128(_mm_srli_si128(b, 8), _mm_slli_si128(c, 8))));
+        _mm_storeu_si128((__m128i*)(dstPtr + 48), expand4(_mm_srli_si128(c, 4)));
+    }
+
+    for (; x < width; x++, srcPtr += 3, dstPtr += 4)
+    {
+        dstPtr[0] = srcPtr[0];
+        dstPtr[1] = srcPtr[1];
+        dstPtr[2] = srcPtr[2];
+        dstPtr[3] = 0xFF;
+    }
+}
+
+//------------------------------------------------------------------------
+
+// Swaps the first and third byte of every pixel, converting BGRA_8888 to RGBA and back
+static void swapRB8Row(U8* dstPtr, const U8* srcPtr, int width)
+{
+    const __m128i greenAlpha = _mm_set1_epi32(0xFF00FF00);
+    const __m128i blue = _mm_set1_epi32(0x000000FF);
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4, srcPtr += 16, dstPtr += 16)
+    {
+        const __m128i v = _mm_loadu_si128((const __m128i*)srcPtr);
+        __m128i r = _mm_and_si128(v, greenAlpha);
+        r = _mm_or_si128(r, _mm_and_si128(_mm_srli_epi32(v, 16), blue));
+        r = _mm_or_si128(r, _mm_slli_epi32(_mm_and_si128(v, blue), 16));
+        _mm_storeu_si128((__m128i*)dstPtr, r);
+    }
+
+    for (; x < width; x++, srcPtr += 4, dstPtr += 4)
+    {
+        const U8 b = srcPtr[0];
+        dstPtr[0] = srcPtr[2];
+        dstPtr[1] = srcPtr[1];
+        dstPtr[2] = b;
+        dstPtr[3] = srcPtr[3];
+    }
+}
+
+//------------------------------------------------------------------------
+
+// Loads 4 RGB_Vec3f pixels (12 floats in 3 registers) as 4 RGBA registers with alpha 1
+static void loadRGB32FQuad(const F32* srcPtr, __m128 rgba[4])
+{
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 a = _mm_loadu_ps(srcPtr);          // r0 g0 b0 r1
+    const __m128 b = _mm_loadu_ps(srcPtr + 4);      // g1 b1 r2 g2
+    const __m128 c = _mm_loadu_ps(srcPtr + 8);      // b2 r3 g3 b3
+
+    rgba[0] = _mm_shuffle_ps(a, _mm_shuffle_ps(a, one, _MM_SHUFFLE(0, 0, 3, 2)), _MM_SHUFFLE(2, 0, 1, 0));
+    rgba[1] = _mm_shuffle_ps(_mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 3, 3)), _mm_shuffle_ps(b, one, _MM_SHUFFLE(0, 0, 1, 1)), _MM_SHUFFLE(2, 0, 2, 0));
+    rgba[2] = _mm_shuffle_ps(b, _mm_shuffle_ps(c, one, _MM_SHUFFLE(0, 0, 0, 0)), _MM_SHUFFLE(2, 0, 3, 2));
+    rgba[3] = _mm_shuffle_ps(c, _mm_shuffle_ps(c, one, _MM_SHUFFLE(0, 0, 3, 3)), _MM_SHUFFLE(2, 0, 2, 1));
+}
+
+//------------------------------------------------------------------------
+
+static void expandRGB32FRow(U8* dstPtr, const U8* srcPtr, int width)
+{
+    const F32* src = (const F32*)srcPtr;
+    F32* dst = (F32*)dstPtr;
+
+    int x = 0;
+    for (; x + 4 <= width; x += 4, src += 12, dst += 16)
+    {
+        __m128 rgba[4];
+        loadRGB32FQuad(src, rgba);
+        for (int i = 0; i < 4; i++)
+            _mm_storeu_ps(dst + i * 4, rgba[i]);
+    }
+
+    for (; x < width; x++, src += 3, dst += 4)
+    {
+        dst[0] = src[0];
+        dst[1] = src[1];
+        dst[2] = src[2];
+        dst[3] = 1.0f;
+    }
+}
+
+//------------------------------------------------------------------------
+
+// 4 floats to halves, rounding to nearest even. Overflows become infinity and NaNs stay NaNs.
+// The halves are returned sign-extended in 32-bit lanes, ready for _mm_packs_epi32().
+static __m128i floatToHalf4(__m128 f)
+{
+    const __m128i halfMaxPlusOne = _mm_set1_epi32((127 + 16) << 23);   // Everything above rounds to infinity
+    const __m128i minNormal = _mm_set1_epi32((127 - 14) << 23);         // Smallest float giving a normalized half
+    const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+    const __m128i normalBias = _mm_set1_epi32(0xFFF - ((127 - 15) << 23));
+
+    const __m128 sign = _mm_and_ps(f, _mm_castsi128_ps(_mm_set1_epi32(0x80000000)));
+    const __m128 absF = _mm_xor_ps(f, sign);
+    const __m128i absBits = _mm_castps_si128(absF);
+
+    // Infinity, or a quiet NaN
+    const __m128i isNaN = _mm_castps_si128(_mm_cmpunord_ps(absF, absF));
+    const __m128i special = _mm_or_si128(_mm_and_si128(isNaN, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+    // Subnormal halves: adding the magic number makes the FPU round the mantissa
+    const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absF, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+    // Normal halves: rebias the exponent and round, adding one more when the mantissa LSB is odd
+    const __m128i oddMantissa = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+    const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), oddMantissa), 13);
+
+    const __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+    const __m128i isRegular = _mm_cmpgt_epi32(halfMaxPlusOne, absBits);
+    const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+    const __m128i half = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, special));
+    return _mm_or_si128(half, _mm_srai_epi32(_mm_castps_si128(sign), 16));
+}
+
+//------------------------------------------------------------------------
+
+static void convertRGB32FToHalfRow(U16* dstPtr, const U8* srcPtr, int width)
+{
+    const F32* src = (const F32*)srcPtr;
+    int x = 0;
+    for (; x + 4 <= width; x += 4, src += 12, dstPtr += 16)
+    {
+        __m128 rgba[4];
+        loadRGB32FQuad(src, rgba);
+        _mm_storeu_si128((__m128i*)dstPtr, _mm_packs_epi32(floatToHalf4(rgba[0]), floatToHalf4(rgba[1])));
+        _mm_storeu_si128((__m128i*)(dstPtr + 8), _mm_packs_epi32(floatToHalf4(rgba[2]), floatToHalf4(rgba[3])));
+    }
+
+    for (; x < width; x++, src += 3, dstPtr += 4)
+    {
+        const __m128i half = floatToHalf4(_mm_set_ps(1.0f, src[2], src[1], src[0]));
+        _mm_storel_epi64((__m128i*)dstPtr, _mm_packs_epi32(half, half));
+    }
+}
+
+//------------------------------------------------------------------------
+
+static void convertRGBA32FToHalfRow(U16* dstPtr, const U8* srcPtr, int width)
+{
+    const F32* src = (const F32*)srcPtr;
+    int x = 0;
+    for (; x + 2 <= width; x += 2, src += 8, dstPtr += 8)
+        _mm_storeu_si128((__m128i*)dstPtr, _mm_packs_epi32(floatToHalf4(_mm_loadu_ps(src)), floatToHalf4(_mm_loadu_ps(src + 4))));
+
+    if (x < width)
+    {
+        const __m128i half = floatToHalf4(_mm_loadu_ps(src));
+        _mm_storel_epi64((__m128i*)dstPtr, _mm_packs_epi32(half, half));
+    }
+}
+
+//------------------------------------------------------------------------
+
+static RowKernel findRowKernel(ImageFormat::ID dstID, ImageFormat::ID srcID)
+{
+    // ABGR_8888 and XBGR_8888 store R, G, B, A/X in memory order on little-endian machines, like R8_G8_B8_A8
+    const bool dstIsRGBA8 = (dstID == ImageFormat::R8_G8_B8_A8 || dstID == ImageFormat::ABGR_8888);
+    if (srcID == ImageFormat::R8_G8_B8 && (dstIsRGBA8 || dstID == ImageFormat::XBGR_8888))
+        return expandRGB8Row;
+    if (srcID == ImageFormat::BGR_888 && dstID == ImageFormat::BGRA_8888)
+        return expandRGB8Row;
+    if ((srcID == ImageFormat::BGRA_8888 && dstIsRGBA8) || (dstID == ImageFormat::BGRA_8888 && (srcID == ImageFormat::R8_G8_B8_A8 || srcID == ImageFormat::ABGR_8888)))
+        return swapRB8Row;
+    if (srcID == ImageFormat::RGB_Vec3f && dstID == ImageFormat::RGBA_Vec4f)
+        return expandRGB32FRow;
+    return NULL;
+}
+
+//------------------------------------------------------------------------
+
+// The generic path, one pixel and channel at a time
+static void getPixelChannels(F32* values, const U8* pixelPtr, const ImageFormat& format)
+{
+    for (int i = 0; i < format.getNumChannels(); i++)
+    {
+        const ImageFormat::Channel& c = format.getChannel(i);
+        const U8* wordPtr = pixelPtr + c.wordOfs;
+        U32 field = 0;
+        switch (c.wordSize)
+        {
+        case 1:     field = *wordPtr; break;
+        case 2:     field = *(const U16*)wordPtr; break;
+        case 4:     field = *(const U32*)wordPtr; break;
+        default:    FW_ASSERT(false); break;
+        }
+        field >>= c.fieldOfs;
+
+        U32 mask = (c.fieldSize >= 32) ? 0xFFFFFFFF : (1u << c.fieldSize) - 1;
+        switch (c.format)
+        {
+        case ImageFormat::ChannelFormat_Clamp:  values[i] = (F32)(field & mask) / (F32)mask; break;
+        case ImageFormat::ChannelFormat_Int:    values[i] = (F32)(field & mask); break;
+        case ImageFormat::ChannelFormat_Float:  memcpy(&values[i], &field, sizeof(F32)); break;
+        default:                                FW_ASSERT(false); break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+
+static void setPixelChannels(U8* pixelPtr, const F32* values, const ImageFormat& format)
+{
+    memset(pixelPtr, 0, format.getBPP());
+    for (int i = 0; i < format.getNumChannels(); i++)
+    {
+        const ImageFormat::Channel& c = format.getChannel(i);
+        U32 mask = (c.fieldSize >= 32) ? 0xFFFFFFFF : (1u << c.fieldSize) - 1;
+        U32 field = 0;
+        switch (c.format)
+        {
+        case ImageFormat::ChannelFormat_Clamp:  field = min((U32)max(values[i] * (F32)mask + 0.5f, 0.0f), mask); break;
+        case ImageFormat::ChannelFormat_Int:    field = min((U32)max(values[i] + 0.5f, 0.0f), mask); break;
+        case ImageFormat::ChannelFormat_Float:  memcpy(&field, &values[i], sizeof(U32)); break;
+        default:                                FW_ASSERT(false); break;
+        }
+        field <<= c.fieldOfs;
+
+        U8* wordPtr = pixelPtr + c.wordOfs;
+        switch (c.wordSize)
+        {
+        case 1:     *wordPtr |= (U8)field; break;
+        case 2:     *(U16*)wordPtr |= (U16)field; break;
+        case 4:     *(U32*)wordPtr |= field; break;
+        default:    FW_ASSERT(false); break;
+        }
+    }
+}
+
+//------------------------------------------------------------------------
+
+bool FW::blitPixels(
+    const ImageFormat& dstFormat, U8* dstPtr, S64 dstStride,
+    const ImageFormat& srcFormat, const U8* srcPtr, S64 srcStride, int width, int height)
+{
+    const int dstChannelCount = dstFormat.getNumChannels();
+    const int srcChannelCount = srcFormat.getNumChannels();
+    if (dstChannelCount == 0 || srcChannelCount == 0 || dstChannelCount > 4 || srcChannelCount > 4)
+        return false;
+    if (width <= 0 || height <= 0)
+        return true;
+
+    // Same format?
+
+    const ImageFormat::ID dstID = dstFormat.getID();
+    const ImageFormat::ID srcID = srcFormat.getID();
+    if (dstID == srcID && dstID < ImageFormat::ID_Generic)
+    {
+        const size_t scanBytes = (size_t)width * dstFormat.getBPP();
+        for (int y = 0; y < height; y++)
+            memcpy(dstPtr + dstStride * y, srcPtr + srcStride * y, scanBytes);
+        return true;
+    }
+
+    // SIMD kernel?
+
+    RowKernel kernel = findRowKernel(dstID, srcID);
+    if (kernel)
+    {
+        for (int y = 0; y < height; y++)
+            kernel(dstPtr + dstStride * y, srcPtr + srcStride * y, width);
+        return true;
+    }
+
+    // General case.
+
+    F32 dv[4];
+    F32 sv[4];
+    int map[4];
+    for (int i = 0; i < dstChannelCount; i++)
+    {
+        ImageFormat::ChannelType t = dstFormat.getChannel(i).Type;
+        map[i] = srcFormat.findChannel(t);
+        dv[i] = (t == ImageFormat::ChannelType_A) ? 1.0f : 0.0f;
+    }
+
+    const int dstBPP = dstFormat.getBPP();
+    const int srcBPP = srcFormat.getBPP();
+    for (int y = 0; y < height; y++)
+    {
+        U8* dstPixel = dstPtr + dstStride * y;
+        const U8* srcPixel = srcPtr + srcStride * y;
+        for (int x = 0; x < width; x++, dstPixel += dstBPP, srcPixel += srcBPP)
+        {
+            getPixelChannels(sv, srcPixel, srcFormat);
+            for (int i = 0; i < dstChannelCount; i++)
+            {
+                if (map[i] != -1)
+                    dv[i] = sv[map[i]];
+            }
+            setPixelChannels(dstPixel, dv, dstFormat);
+        }
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+
+bool FW::blitToRGBAHalf(U16* dstPtr, S64 dstStride, const ImageFormat& srcFormat, const U8* srcPtr, S64 srcStride, int width, int height)
+{
+    const ImageFormat::ID srcID = srcFormat.getID();
+    if (srcID != ImageFormat::RGB_Vec3f && srcID != ImageFormat::RGBA_Vec4f)
+        return false;
+
+    for (int y = 0; y < height; y++)
+    {
+        U16* dstRow = (U16*)((U8*)dstPtr + dstStride * y);
+        if (srcID == ImageFormat::RGB_Vec3f)
+            convertRGB32FToHalfRow(dstRow, srcPtr + srcStride * y, width);
+        else
+            convertRGBA32FToHalfRow(dstRow, srcPtr + srcStride * y, width);
+    }
+    return true;
+}
+
+//------------------------------------------------------------------------
+
 #if 0
 ImageFormat::ID ImageFormat::getGLFormat(void) const
 {
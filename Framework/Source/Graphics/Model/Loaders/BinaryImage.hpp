@@ -37,6 +37,9 @@ namespace FW
     using S32 = int32_t;
     using U32 = uint32_t;
     using U8 = uint8_t;
+    using U16 = uint16_t;
+    using S64 = int64_t;
+    using F32 = float;
 #define FW_ASSERT assert
 #define FW_ARRAY_SIZE arraysize
 
@@ -147,6 +150,18 @@ private:
     std::vector<Channel>      m_genericChannels; // only if m_id >= ID_Generic
 };
 
+//------------------------------------------------------------------------
+// Pixel conversion used by the loaders. The Image class below isn't compiled, so these stand in for its blit().
+// Pairs the loaders hit often (R8_G8_B8 and BGR_888 to 4 channels, BGRA_8888 <-> RGBA, RGB_Vec3f to RGBA_Vec4f) have SSE2 kernels,
+// other uncompressed pairs go through the generic per-channel path. Channels missing from the source become 0, or 1 for alpha.
+// Both return false if a format has no channels, e.g. the compressed formats.
+
+bool                blitPixels      (const ImageFormat& dstFormat, U8* dstPtr, S64 dstStride,
+                                     const ImageFormat& srcFormat, const U8* srcPtr, S64 srcStride, int width, int height);
+
+// Converts RGB_Vec3f or RGBA_Vec4f pixels to 4 half floats per pixel, rounding to nearest even.
+bool                blitToRGBAHalf  (U16* dstPtr, S64 dstStride, const ImageFormat& srcFormat, const U8* srcPtr, S64 srcStride, int width, int height);
+
 //------------------------------------------------------------------------
 #if 0
 class Image
@@ -36,6 +36,9 @@
 #include "BinaryImage.hpp"
 #include "Data/VertexAttrib.h"
 #include "API/Device.h"
+#include "Graphics/Model/VertexCompression.h"
+#include <algorithm>
+#include <cstring>
 
 namespace Falcor
 {
@@ -146,15 +149,98 @@ namespace Falcor
         }
     }
 
+    // A vertex attribute as it is written to the file. The binary format only has 8-bit, 32-bit integer and float attributes, so the attributes stored by Model::LoadFlags::CompressVertices are decoded to floats.
+    struct ExportedElement
+    {
+        AttribType type;
+        AttribFormat format;
+        uint32_t channelCount;
+        uint32_t offset;            // Offset in the exported vertex
+        ResourceFormat srcFormat;
+        uint32_t srcOffset;         // Offset in the vertex buffer
+        uint32_t srcSize;
+        bool decode;
+    };
+
+    // Get the attributes of a vertex buffer as they are written to the file. Returns false with the name of the attribute if one can't be exported.
+    static bool getExportedElements(const VertexBufferLayout* pLayout, std::vector<ExportedElement>& elements, uint32_t& stride, std::string& unsupportedName)
+    {
+        elements.resize(pLayout->getElementCount());
+        bool decode = false;
+        for(uint32_t e = 0; e < pLayout->getElementCount(); e++)
+        {
+            ExportedElement& element = elements[e];
+            element.srcFormat = pLayout->getElementFormat(e);
+            element.srcOffset = pLayout->getElementOffset(e);
+            element.srcSize = getFormatBytesPerBlock(element.srcFormat) * pLayout->getElementArraySize(e);
+            element.type = getBinaryAttribType(pLayout->getElementName(e));
+
+            const uint32_t decodedCount = VertexCompression::getDecodedComponentCount(element.srcFormat);
+            element.decode = (decodedCount != 0);
+            element.format = element.decode ? AttribFormat_F32 : GetBinaryAttribFormat(element.srcFormat);
+            element.channelCount = element.decode ? decodedCount : getFormatChannelCount(element.srcFormat);
+            if(element.type == AttribType_Max || element.format == AttribFormat_Max)
+            {
+                unsupportedName = pLayout->getElementName(e);
+                return false;
+            }
+            decode = decode || element.decode;
+        }
+
+        // Buffers without compressed attributes are written as they are. The others are repacked without padding.
+        stride = decode ? 0 : pLayout->getStride();
+        for(ExportedElement& element : elements)
+        {
+            element.offset = decode ? stride : element.srcOffset;
+            stride += decode ? (element.decode ? element.channelCount * (uint32_t)sizeof(float) : element.srcSize) : 0;
+        }
+        return true;
+    }
+
+    // Get the vertices of a buffer as they are written to the file. Returns pSrc if nothing needs to be decoded, otherwise decodes into scratch.
+    static const uint8_t* getExportedVertices(const std::vector<ExportedElement>& elements, uint32_t stride, const uint8_t* pSrc, uint32_t srcStride, uint32_t vertexCount, const Mesh* pMesh, std::vector<uint8_t>& scratch)
+    {
+        if(std::none_of(elements.begin(), elements.end(), [](const ExportedElement& element) { return element.decode; }))
+        {
+            return pSrc;
+        }
+
+        scratch.assign((size_t)stride * vertexCount, 0);
+        for(uint32_t i = 0; i < vertexCount; i++)
+        {
+            const uint8_t* pSrcVertex = pSrc + (size_t)srcStride * i;
+            uint8_t* pDstVertex = scratch.data() + (size_t)stride * i;
+            for(const ExportedElement& element : elements)
+            {
+                if(element.decode)
+                {
+                    float decoded[3];
+                    VertexCompression::decodeValue(element.srcFormat, pSrcVertex + element.srcOffset, pMesh->getPositionScale(), pMesh->getPositionBias(), decoded);
+                    std::memcpy(pDstVertex + element.offset, decoded, element.channelCount * sizeof(float));
+                }
+                else
+                {
+                    std::memcpy(pDstVertex + element.offset, pSrcVertex + element.srcOffset, element.srcSize);
+                }
+            }
+        }
+        return scratch.data();
+    }
+
     void writeString(BinaryFileStream& stream, const std::string& str)
     {
         stream << (int32_t)str.size();
         stream.write(str.c_str(), str.size());;
     }
 
-    void BinaryModelExporter::exportToFile(const std::string& filename, const Model* pModel)
+    void BinaryModelExporter::exportToFile(const std::string& filename, const Model* pModel, uint32_t version)
     {
-        BinaryModelExporter(filename, pModel);
+        if(version < 8 || version > 10)
+        {
+            logError("Error when exporting model \"" + filename + "\".\nUnsupported binary format version " + std::to_string(version));
+            return;
+        }
+        BinaryModelExporter(filename, pModel, version);
     }
 
     void BinaryModelExporter::error(const std::string& msg)
@@ -168,7 +254,7 @@ namespace Falcor
         logError("Warning when exporting model \"" + mFilename + "\".\n" + Msg);
     }
 
-    BinaryModelExporter::BinaryModelExporter(const std::string& filename, const Model* pModel) : mFilename(filename)
+    BinaryModelExporter::BinaryModelExporter(const std::string& filename, const Model* pModel, uint32_t version) : mFilename(filename), mVersion(version)
     {
         mStream.open(filename.c_str(), BinaryFileStream::Mode::Write);
         mpModel = pModel;
@@ -186,10 +272,26 @@ namespace Falcor
         }
 
         if(prepareSubmeshes() == false) return;
-        if(writeHeader()      == false) return;
-        if(writeTextures()    == false) return;
-        if(writeMeshes()      == false) return;
-        if(writeInstances()   == false) return;
+        collectTextures();
+
+        if(mVersion >= 9)
+        {
+            if(prepareDirectory() == false) return;
+            if(writeHeader()      == false) return;
+            const size_t directoryOffset = mStream.getPosition();
+            if(writeDirectory()   == false) return;
+            if(writeInstances()   == false) return;
+            if(writeBlobs()       == false) return;
+            mStream.setPosition(directoryOffset);
+            if(writeDirectory()   == false) return;
+        }
+        else
+        {
+            if(writeHeader()      == false) return;
+            if(writeTextures()    == false) return;
+            if(writeMeshes()      == false) return;
+            if(writeInstances()   == false) return;
+        }
     }
 
     bool BinaryModelExporter::prepareSubmeshes()
@@ -206,6 +308,17 @@ namespace Falcor
             }
 
             const auto& pVao = pMesh->getVao();
+            if(pMesh->getStartIndex() != 0 || pMesh->getBaseVertex() != 0 || pVao->getIndexBufferFormat() != ResourceFormat::R32Uint)
+            {
+                error("Binary format doesn't support meshes loaded with Model::LoadFlags::PoolGeometry");
+                return false;
+            }
+
+            if(mVersion < 10 && pMesh->getLodCount() > 1)
+            {
+                warning("Binary format version " + std::to_string(mVersion) + " doesn't store LODs. Only the full detail meshes are exported.");
+            }
+
             auto& submesh = mMeshes[pVao.get()];
             submesh.push_back(i);
         }
@@ -222,32 +335,42 @@ namespace Falcor
     bool BinaryModelExporter::writeHeader()
     {
         mStream.write("BinScene", 8);
-        mStream << (int32_t)8 << (int32_t)mpModel->getTextureCount() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
+        if(mVersion >= 9)
+        {
+            mStream << (int32_t)mVersion << (int32_t)mTextures.size() << (int32_t)mMaterials.size() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
+        }
+        else
+        {
+            mStream << (int32_t)8 << (int32_t)mTextures.size() << (int32_t)mMeshes.size() << (int32_t)mInstanceCount;
+        }
         return true;
     }
 
-    bool BinaryModelExporter::writeTextures()
+    void BinaryModelExporter::collectTextures()
     {
         mTextureHash[nullptr] = -1;
 
-        uint32_t texID = 0;
         for (uint32_t meshID = 0; meshID < mpModel->getMeshCount(); meshID++)
         {
-            bool succeeded = true;
-
-            // Write all material textures
+            // Assign IDs to all material textures
             const auto& pMaterial = mpModel->getMesh(meshID)->getMaterial();
             for (uint32_t i = 0; i < pMaterial->getNumLayers(); i++)
             {
-                succeeded &= writeMaterialTexture(texID, pMaterial->getLayer(i).pTexture);
+                addMaterialTexture(pMaterial->getLayer(i).pTexture);
             }
 
-            succeeded &= writeMaterialTexture(texID, pMaterial->getNormalMap());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getAlphaMap());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getAmbientOcclusionMap());
-            succeeded &= writeMaterialTexture(texID, pMaterial->getHeightMap());
+            addMaterialTexture(pMaterial->getNormalMap());
+            addMaterialTexture(pMaterial->getAlphaMap());
+            addMaterialTexture(pMaterial->getAmbientOcclusionMap());
+            addMaterialTexture(pMaterial->getHeightMap());
+        }
+    }
 
-            if (succeeded == false)
+    bool BinaryModelExporter::writeTextures()
+    {
+        for(const Texture* pTexture : mTextures)
+        {
+            if(exportBinaryImage(pTexture) == false)
             {
                 return false;
             }
@@ -265,36 +388,33 @@ namespace Falcor
         struct vertexBufferInfo 
         {
             Buffer::SharedPtr pBuffer;
-            size_t            pData; //this had the p flag because it represents the pointer to the vertex buffers data
+            const uint8_t*    pData;
             uint32_t          stride;
+            std::vector<uint8_t> decoded;
         };
             
         std::vector<vertexBufferInfo> vbInfo(vertexBufferCount);
+        std::vector<ExportedElement> elements;
 
         for (uint32_t i = 0; i < vertexBufferCount; i++)
         {
             const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(i).get();
             assert(pLayout->getElementCount() == 1);
-            AttribType type = getBinaryAttribType(pLayout->getElementName(0));
-            AttribFormat format = GetBinaryAttribFormat(pLayout->getElementFormat(0));
-            uint32_t channels = getFormatChannelCount(pLayout->getElementFormat(0));
-
-            if(type == AttribType_Max)
+            std::string unsupportedName;
+            if(getExportedElements(pLayout, elements, vbInfo[i].stride, unsupportedName) == false)
             {
-                error("Unsupported attribute Type");
-                return false;
-            }
-
-            if(format == AttribFormat_Max)
-            {
-                error("Unsupported attribute format");
+                error("Unsupported vertex attribute " + unsupportedName);
+                for (uint32_t j = 0; j < i; j++)
+                {
+                    vbInfo[j].pBuffer->unmap();
+                }
                 return false;
             }
-            mStream << (int32_t)type << (int32_t)format << (int32_t)channels;
+            mStream << (int32_t)elements[0].type << (int32_t)elements[0].format << (int32_t)elements[0].channelCount;
 
             vbInfo[i].pBuffer = pVao->getVertexBuffer(i);
-            vbInfo[i].stride = pLayout->getStride();
-            vbInfo[i].pData = (size_t)vbInfo[i].pBuffer->map(Buffer::MapType::Read);
+            const uint8_t* pSrc = (const uint8_t*)vbInfo[i].pBuffer->map(Buffer::MapType::Read);
+            vbInfo[i].pData = getExportedVertices(elements, vbInfo[i].stride, pSrc, pLayout->getStride(), pMesh->getVertexCount(), pMesh.get(), vbInfo[i].decoded);
         }
 
         // Write the vertex buffer
@@ -302,7 +422,7 @@ namespace Falcor
         {
             for (auto& a : vbInfo)
             { 			
-                mStream.write((void*)a.pData, a.stride);
+                mStream.write(a.pData, a.stride);
                 a.pData += a.stride;
             }
         }
@@ -412,19 +532,13 @@ namespace Falcor
         return true;
     }
 
-    bool BinaryModelExporter::writeMaterialTexture(uint32_t& texID, const Texture::SharedPtr& pTexture)
+    void BinaryModelExporter::addMaterialTexture(const Texture::SharedPtr& pTexture)
     {
-        if (pTexture != nullptr)
+        if (pTexture != nullptr && mTextureHash.find(pTexture.get()) == mTextureHash.end())
         {
-            // If not exported yet
-            if (mTextureHash.find(pTexture.get()) == mTextureHash.end())
-            {
-                mTextureHash[pTexture.get()] = texID++;
-                return exportBinaryImage(pTexture.get());
-            }
+            mTextureHash[pTexture.get()] = (int32_t)mTextures.size();
+            mTextures.push_back(pTexture.get());
         }
-
-        return true;
     }
 
     bool BinaryModelExporter::exportBinaryImage(const Texture* pTexture)
@@ -459,4 +573,178 @@ namespace Falcor
         mStream.write(data.data(), dataSize);
         return true;
     }
-}
\ No newline at end of file
+
+    bool BinaryModelExporter::prepareDirectory()
+    {
+        uint32_t vertexBufferCount = 0;
+        for(const auto& mesh : mMeshes)
+        {
+            for(uint32_t meshID : mesh.second)
+            {
+                const Material* pMaterial = mpModel->getMesh(meshID)->getMaterial().get();
+                if(mMaterialHash.find(pMaterial) == mMaterialHash.end())
+                {
+                    mMaterialHash[pMaterial] = (int32_t)mMaterials.size();
+                    mMaterials.push_back(pMaterial);
+                }
+            }
+            vertexBufferCount += mpModel->getMesh(mesh.second[0])->getVao()->getVertexBuffersCount();
+        }
+
+        mTextureBlobs.resize(mTextures.size());
+        mVertexBufferOffsets.resize(vertexBufferCount);
+        return true;
+    }
+
+    bool BinaryModelExporter::writeDirectory()
+    {
+        for(const BlobRef& blob : mTextureBlobs)
+        {
+            mStream << blob.offset << blob.size;
+        }
+
+        for(const Material* pMaterial : mMaterials)
+        {
+            BasicMaterial basicMaterial;
+            basicMaterial.initializeFromMaterial(pMaterial);
+            mStream << glm::vec4(basicMaterial.diffuseColor, basicMaterial.opacity) << basicMaterial.specularColor << basicMaterial.shininess << basicMaterial.bumpScale << basicMaterial.bumpOffset;
+
+            for(uint32_t i = 0; i < TextureType_Max; i++)
+            {
+                BasicMaterial::MapType falcorType = getFalcorMapType(TextureType(i));
+                int32_t index = -1;
+                if(BasicMaterial::MapType::Count != falcorType)
+                {
+                    index = mTextureHash[basicMaterial.pTextures[falcorType].get()];
+                }
+                mStream << index;
+            }
+        }
+
+        uint32_t vertexBufferIndex = 0;
+        for(const auto& mesh : mMeshes)
+        {
+            const auto& submeshes = mesh.second;
+            const Mesh::SharedPtr& pMesh = mpModel->getMesh(submeshes[0]);
+            const auto& pVao = pMesh->getVao();
+            const uint32_t bufferCount = pVao->getVertexBuffersCount();
+            mStream << (int32_t)bufferCount << (int32_t)pMesh->getVertexCount() << (int32_t)submeshes.size();
+
+            for(uint32_t i = 0; i < bufferCount; i++)
+            {
+                const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(i).get();
+                std::vector<ExportedElement> elements;
+                uint32_t stride;
+                std::string unsupportedName;
+                if(getExportedElements(pLayout, elements, stride, unsupportedName) == false)
+                {
+                    error("Unsupported vertex attribute " + unsupportedName);
+                    return false;
+                }
+                mStream << (int32_t)elements.size() << (int32_t)stride << mVertexBufferOffsets[vertexBufferIndex++];
+
+                for(const ExportedElement& element : elements)
+                {
+                    mStream << (int32_t)element.type << (int32_t)element.format << (int32_t)element.channelCount << (int32_t)element.offset;
+                }
+            }
+
+            for(uint32_t meshID : submeshes)
+            {
+                const Mesh::SharedPtr& pSubmesh = mpModel->getMesh(meshID);
+                const BoundingBox& box = pSubmesh->getBoundingBox();
+                mStream << mMaterialHash[pSubmesh->getMaterial().get()] << (int32_t)pSubmesh->getIndexCount() << mIndexBufferOffsets[meshID] << box.getMinPos() << box.getMaxPos();
+
+                if(mVersion >= 10)
+                {
+                    const std::vector<uint64_t>& lodOffsets = mLodIndexOffsets[meshID];
+                    mStream << (int32_t)(pSubmesh->getLodCount() - 1);
+                    for(uint32_t lod = 1; lod < pSubmesh->getLodCount(); lod++)
+                    {
+                        mStream << (int32_t)pSubmesh->getLod(lod).indexCount << (lodOffsets.size() ? lodOffsets[lod - 1] : 0) << pSubmesh->getLod(lod).error;
+                    }
+                }
+            }
+        }
+
+        return true;
+    }
+
+    bool BinaryModelExporter::writeBlobs()
+    {
+        for(size_t i = 0; i < mTextures.size(); i++)
+        {
+            alignStream();
+            mTextureBlobs[i].offset = mStream.getPosition();
+            if(exportBinaryImage(mTextures[i]) == false)
+            {
+                return false;
+            }
+            mTextureBlobs[i].size = mStream.getPosition() - mTextureBlobs[i].offset;
+        }
+
+        uint32_t vertexBufferIndex = 0;
+        std::vector<ExportedElement> elements;
+        std::vector<uint8_t> decoded;
+        for(const auto& mesh : mMeshes)
+        {
+            const Mesh::SharedPtr& pMesh = mpModel->getMesh(mesh.second[0]);
+            const auto& pVao = pMesh->getVao();
+            for(uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+            {
+                alignStream();
+                mVertexBufferOffsets[vertexBufferIndex++] = mStream.getPosition();
+
+                const VertexBufferLayout* pLayout = pVao->getVertexLayout()->getBufferLayout(i).get();
+                uint32_t stride;
+                std::string unsupportedName;
+                if(getExportedElements(pLayout, elements, stride, unsupportedName) == false)
+                {
+                    error("Unsupported vertex attribute " + unsupportedName);
+                    return false;
+                }
+
+                const Buffer::SharedPtr& pBuffer = pVao->getVertexBuffer(i);
+                const uint8_t* pSrc = (const uint8_t*)pBuffer->map(Buffer::MapType::Read);
+                mStream.write(getExportedVertices(elements, stride, pSrc, pLayout->getStride(), pMesh->getVertexCount(), pMesh.get(), decoded), (size_t)stride * pMesh->getVertexCount());
+                pBuffer->unmap();
+            }
+
+            for(uint32_t meshID : mesh.second)
+            {
+                alignStream();
+                mIndexBufferOffsets[meshID] = mStream.getPosition();
+
+                const Mesh::SharedPtr& pSubmesh = mpModel->getMesh(meshID);
+                const Buffer::SharedPtr& pIndexBuffer = pSubmesh->getVao()->getIndexBuffer();
+                const uint32_t* pIndices = (const uint32_t*)pIndexBuffer->map(Buffer::MapType::Read);
+                mStream.write(pIndices, pSubmesh->getIndexCount() * sizeof(uint32_t));
+
+                // The LODs follow the full detail indices in the index buffer
+                if(mVersion >= 10)
+                {
+                    std::vector<uint64_t>& lodOffsets = mLodIndexOffsets[meshID];
+                    lodOffsets.clear();
+                    for(uint32_t lod = 1; lod < pSubmesh->getLodCount(); lod++)
+                    {
+                        alignStream();
+                        lodOffsets.push_back(mStream.getPosition());
+                        mStream.write(pIndices + pSubmesh->getLod(lod).startIndex, pSubmesh->getLod(lod).indexCount * sizeof(uint32_t));
+                    }
+                }
+                pIndexBuffer->unmap();
+            }
+        }
+
+        return true;
+    }
+
+    void BinaryModelExporter::alignStream()
+    {
+        static const size_t kBlobAlignment = 16;
+        static const uint8_t kPadding[kBlobAlignment] = {};
+        const size_t position = mStream.getPosition();
+        const size_t alignedPosition = (position + kBlobAlignment - 1) & ~(kBlobAlignment - 1);
+        mStream.write(kPadding, alignedPosition - position);
+    }
+}
@@ -38,22 +38,29 @@ namespace Falcor
     class Mesh;
     class Vao;
     class Texture;
+    class Material;
 
     class BinaryModelExporter
     {
     public:
+        /** The newest version of the binary format. See BinaryModelSpec.h.
+        */
+        static const uint32_t kLatestVersion = 10;
+
         /** Export a model into a binary file
             \param[in] filename Model's filename. Loader will look for it in the data directories.
             \param[in] pModel The model to export
+            \param[in] version The format version to write. Can be 10, which adds the meshes' LODs to version 9, 9, which stores the meshes ready to be uploaded, or 8 for tools which only read the older format.
             returns nullptr if loading failed, otherwise a new Model object
         */
-        static void exportToFile(const std::string& filename, const Model* pModel);
+        static void exportToFile(const std::string& filename, const Model* pModel, uint32_t version = kLatestVersion);
 
     private:
-        BinaryModelExporter(const std::string& filename, const Model* pModel);
+        BinaryModelExporter(const std::string& filename, const Model* pModel, uint32_t version);
         const Model* mpModel = nullptr;
         BinaryFileStream mStream;
         const std::string& mFilename;
+        uint32_t mVersion;
 
         bool writeHeader();
         bool writeTextures();
@@ -62,7 +69,8 @@ namespace Falcor
         bool writeSubmesh(const Mesh::SharedPtr& pMesh);
         bool writeInstances();
 
-        bool writeMaterialTexture(uint32_t& texID, const Texture::SharedPtr& pTexture);
+        void collectTextures();
+        void addMaterialTexture(const Texture::SharedPtr& pTexture);
         
         bool exportBinaryImage(const Texture* pTexture);
 
@@ -73,5 +81,24 @@ namespace Falcor
         std::map<const Vao*, std::vector<uint32_t>> mMeshes; // Maps to meshID in model
         std::map<const Texture*, int32_t> mTextureHash;
         uint32_t mInstanceCount = 0; // Not the same as Model::Instance count. Model keeps the total instance count, while the binary format has a concept of meshes and submeshes, and the instance count there is the mesh instance count.
+        std::vector<const Texture*> mTextures; // Ordered by texture ID
+
+        // Version 9 and 10. The directory is written twice, first as a placeholder and again once the blob offsets are known.
+        bool prepareDirectory();
+        bool writeDirectory();
+        bool writeBlobs();
+        void alignStream();
+
+        struct BlobRef
+        {
+            uint64_t offset = 0;
+            uint64_t size = 0;
+        };
+        std::map<const Material*, int32_t> mMaterialHash;
+        std::vector<const Material*> mMaterials;
+        std::vector<BlobRef> mTextureBlobs;
+        std::vector<uint64_t> mVertexBufferOffsets;    // The vertex buffers of all the meshes, in the order they are written
+        std::map<uint32_t, uint64_t> mIndexBufferOffsets; // Maps meshID in model to the offset of its index data
+        std::map<uint32_t, std::vector<uint64_t>> mLodIndexOffsets; // Maps meshID in model to the offsets of the index data of its LODs, from LOD 1
     };
 }
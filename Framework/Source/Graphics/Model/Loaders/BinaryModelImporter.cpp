@@ -30,7 +30,19 @@
 #include "BinaryModelSpec.h"
 #include "../Model.h"
 #include "../Mesh.h"
+#include "../MeshOptimizer.h"
+#include "../VertexCompression.h"
+#include "../GeometryPool.h"
+#include "../MeshSimplifier.h"
+#include "../MeshletBuilder.h"
+#include "../MeshDeduplicator.h"
+#include "../TangentSpaceGenerator.h"
 #include "Utils/OS.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/BinaryMemoryStream.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/AsyncLoadTask.h"
 #include "API/VertexLayout.h"
 #include "Data/VertexAttrib.h"
 #include "API/Buffer.h"
@@ -38,8 +50,12 @@
 #include "BinaryImage.hpp"
 #include "API/Formats.h"
 #include "API/Texture.h"
+#include "Graphics/TextureCache.h"
 #include "Graphics/Material/Material.h"
 #include "glm/geometric.hpp"
+#include <future>
+#include <algorithm>
+#include <unordered_set>
 
 namespace Falcor
 {
@@ -48,122 +64,158 @@ namespace Falcor
         uint32_t width  = 0;
         uint32_t height = 0;
         ResourceFormat format = ResourceFormat::Unknown;
+        const uint8_t* pData = nullptr; // Points either into 'data' or into the memory-mapped file
+        bool isPackedRgb = false;       // pData holds 3 bytes per texel until decodeTextureData() pads it
         std::vector<uint8_t> data;
         std::string name;
     };
 
-    bool isSpecialFloat(float f)
+    // Time spent in each stage of an import, in milliseconds
+    struct ImportTimings
     {
-        uint32_t d = *(uint32_t*)&f;
-        // Check the exponent
-        d = (d >> 23) & 0xff;
-        return d == 0xff;
+        float textureRead = 0;      // Reading the texture headers and data on the loading thread
+        float textureDecode = 0;    // Decoding the textures on the thread pool, in the background
+        float decodeWait = 0;       // Time the loading thread waited for the decoding to finish
+        float meshData = 0;         // Reading the mesh data, generating tangents and creating the buffers
+        float objectCreation = 0;   // Creating the textures, materials and meshes
+    };
+
+    static void logImportTimings(const std::string& modelName, const ImportTimings& timings)
+    {
+        logInfo("Loaded model " + modelName + ". Texture read " + std::to_string(timings.textureRead) + "ms, texture decode " + std::to_string(timings.textureDecode) +
+            "ms (waited " + std::to_string(timings.decodeWait) + "ms), mesh data " + std::to_string(timings.meshData) + "ms, object creation " + std::to_string(timings.objectCreation) + "ms");
     }
 
-    template<typename posType>
-    void generateSubmeshTangentData(
-        const std::vector<uint32_t>& indices,
-        const posType* vertexPosData,
-        const glm::vec3* vertexNormalData,
-        const glm::vec2* texCrdData,
-        uint32_t texCrdCount,
-        glm::vec3* bitangentData)
+    // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding
+    static void decodeTextureData(TextureData& data)
     {
-        // calculate the tangent and bitangent for every face
-        size_t primCount = indices.size() / 3;
-        for(size_t primID = 0; primID < primCount; primID++)
+        if(data.isPackedRgb == false)
         {
-            struct Data
-            {
-                posType position;
-                glm::vec3 normal;
-                glm::vec2 uv;
-            };
-            Data V[3];
-
-            // Get the data
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                uint32_t index = indices[primID * 3 + i];
-                V[i].position = vertexPosData[index];
-                V[i].normal = vertexNormalData[index];
+            return;
+        }
 
-                if(texCrdData)
-                {
-                    V[i].uv = texCrdData[index * texCrdCount];
-                }
-                else
-                {
-                    V[i].uv = glm::vec2(0.f, 0.f);
-                }
-            }
+        // BGR_888 pads the same way, so the R8_G8_B8 kernel covers both
+        std::vector<uint8_t> rgba(data.width * data.height * 4);
+        FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, rgba.data(), data.width * 4, FW::ImageFormat::R8_G8_B8, data.pData, data.width * 3, data.width, data.height);
+        data.data.swap(rgba);
+        data.pData = data.data.data();
+        data.isPackedRgb = false;
+    }
 
-            // Position delta
-            posType posDelta[2];
-            posDelta[0] = V[1].position - V[0].position;
-            posDelta[1] = V[2].position - V[0].position;
+    /** Decodes textures on the global thread pool while the loading thread goes on parsing the file.
+        The loading thread must call wait() before using the textures. The textures vector must outlive the decoder.
+    */
+    class TextureDecoder
+    {
+    public:
+        ~TextureDecoder() { wait(); }
 
-            // Texture offset
-            glm::vec2 s = V[1].uv - V[0].uv;
-            glm::vec2 t = V[2].uv - V[0].uv;
-            s.y = -s.y;
-            t.y = -t.y;
+        void start(std::vector<TextureData>& textures, ImportTimings& timings)
+        {
+            // Textures which don't need decoding are ready right away
+            const uint32_t packedCount = (uint32_t)std::count_if(textures.begin(), textures.end(), [](const TextureData& data) { return data.isPackedRgb; });
+            AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TexturesDecoded, textures.size() - packedCount);
+            if(packedCount == 0)
+            {
+                return;
+            }
 
-            glm::vec3 tangent;
-            glm::vec3 bitangent;
+            mpTimings = &timings;
+            AsyncLoadTask* pTask = AsyncLoadTask::getCurrent();
+            mFuture = std::async(std::launch::async, [&textures, &timings, pTask]()
+            {
+                CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+                ThreadPool::getGlobalPool()->parallelFor((uint32_t)textures.size(), 1, [&textures, pTask](uint32_t first, uint32_t last)
+                {
+                    for(uint32_t i = first; i < last; i++)
+                    {
+                        if(textures[i].isPackedRgb)
+                        {
+                            decodeTextureData(textures[i]);
+                            if(pTask)
+                            {
+                                pTask->addProgress(AsyncLoadTask::ProgressCounter::TexturesDecoded, 1);
+                            }
+                        }
+                    }
+                });
+                timings.textureDecode = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            });
+        }
 
-            // when t1, t2, t3 in same position in UV space, just use default UV direction.
-            if((s == glm::vec2(0, 0)) || (t == glm::vec2(0, 0)))
+        void wait()
+        {
+            if(mFuture.valid())
             {
-				const glm::vec3 &normal = V[0].normal;
-				if(abs(normal.x) > abs(normal.y))
-					bitangent = v3(normal.z, 0.f, -normal.x) / length(v2(normal.x, normal.z));
-				else
-					bitangent = v3(0.f, normal.z, -normal.y) / length(v2(normal.y, normal.z));
-				tangent = cross(bitangent, normal);
+                CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+                mFuture.get();
+                mpTimings->decodeWait = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
             }
-			else
-			{
-				float dirCorrection = (t.x * s.y - t.y * s.x) < 0.0f ? -1.0f : 1.0f;
-
-				// tangent points in the direction where to positive X axis of the texture coord's would point in model space
-				// bitangent's points along the positive Y axis of the texture coord's, respectively
-				tangent.x = (posDelta[1].x * s.y - posDelta[0].x * t.y) * dirCorrection;
-				tangent.y = (posDelta[1].y * s.y - posDelta[0].y * t.y) * dirCorrection;
-				tangent.z = (posDelta[1].z * s.y - posDelta[0].z * t.y) * dirCorrection;
+        }
 
-				bitangent.x = (posDelta[1].x * s.x - posDelta[0].x * t.x) * dirCorrection;
-				bitangent.y = (posDelta[1].y * s.x - posDelta[0].y * t.x) * dirCorrection;
-				bitangent.z = (posDelta[1].z * s.x - posDelta[0].z * t.x) * dirCorrection;
-			}
+    private:
+        std::future<void> mFuture;
+        ImportTimings* mpTimings = nullptr;
+    };
 
-            // store for every vertex of that face
-            for(uint32_t i = 0; i < 3; i++)
-            {
-                // project tangent and bitangent into the plane formed by the vertex' normal
-                glm::vec3 localTangent = tangent - V[i].normal * (glm::dot(tangent, V[i].normal));
-                localTangent = glm::normalize(localTangent);
-                glm::vec3 localBitangent = bitangent - V[i].normal * (glm::dot(bitangent, V[i].normal));
-                localBitangent = glm::normalize(localBitangent);
-                localBitangent = localBitangent - localTangent * (glm::dot(localBitangent, localTangent));
-                localBitangent = glm::normalize(localBitangent);
+    // Read count bytes which must stay valid until the import is done.
+    // File streams copy the data into 'storage'. Memory streams return a pointer into the mapped file and leave 'storage' untouched.
+    // Both return nullptr if the stream ends before count bytes were read.
+    static const uint8_t* readPersistent(BinaryFileStream& stream, size_t count, std::vector<uint8_t>& storage)
+    {
+        storage.resize(count);
+        stream.read(storage.data(), count);
+        return stream.isFail() ? nullptr : storage.data();
+    }
 
-                // reconstruct tangent/bitangent according to normal and bitangent/tangent when it's infinite or NaN.
-                bool isInvalidBitangent = isSpecialFloat(localBitangent.x) || isSpecialFloat(localBitangent.y) || isSpecialFloat(localBitangent.z);
+    static const uint8_t* readPersistent(BinaryMemoryStream& stream, size_t count, std::vector<uint8_t>& storage)
+    {
+        return stream.readView(count);
+    }
 
-                if (isInvalidBitangent)
-                {
-                    localBitangent = glm::cross(localTangent, V[i].normal);
-                    localBitangent = glm::normalize(localBitangent);
-                }
+    // Check that 'count' elements of 'elementSize' bytes starting at 'offset' lie inside a stream of 'streamSize' bytes, without overflowing
+    static bool isRangeInStream(uint64_t offset, uint64_t count, uint64_t elementSize, size_t streamSize)
+    {
+        if(elementSize && count > UINT64_MAX / elementSize)
+        {
+            return false;
+        }
+        return offset <= streamSize && count * elementSize <= streamSize - offset;
+    }
 
-                // and write it into the mesh
-                uint32_t index = indices[primID * 3 + i];
-                bitangentData[index] = localBitangent;
-            }
+    // Report the bytes parsed since the last call to the async load running on this thread, if there is one
+    template<typename StreamType>
+    static void reportReadProgress(StreamType& stream, size_t& reportedPosition)
+    {
+        const size_t position = stream.getPosition();
+        if(position > reportedPosition)
+        {
+            AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::BytesRead, position - reportedPosition);
+            reportedPosition = position;
         }
     }
 
+    // GPU resources are created on the main thread when the model is loaded asynchronously
+    static Buffer::SharedPtr createBuffer(size_t size, Buffer::BindFlags bindFlags, const void* pData)
+    {
+        return AsyncLoadTask::runOnMainThread([=]() { return Buffer::create(size, bindFlags, Buffer::CpuAccess::None, pData); });
+    }
+
+    static Mesh::SharedPtr createMesh(const Vao::BufferVec& pVBs, uint32_t vertexCount, const Buffer::SharedPtr& pIB, uint32_t indexCount, const VertexLayout::SharedPtr& pLayout, const Material::SharedPtr& pMaterial, const BoundingBox& box)
+    {
+        auto pMesh = AsyncLoadTask::runOnMainThread([&]() { return Mesh::create(pVBs, vertexCount, pIB, indexCount, pLayout, Vao::Topology::TriangleList, pMaterial, box, false); });
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::MeshesCreated);
+        return pMesh;
+    }
+
+    // The range can hold more indices than the mesh draws, when the LODs follow it
+    static Mesh::SharedPtr createMesh(const GeometryPool::Range& range, uint32_t vertexCount, uint32_t indexCount, const Material::SharedPtr& pMaterial, const BoundingBox& box)
+    {
+        auto pMesh = AsyncLoadTask::runOnMainThread([&]() { return Mesh::create(range.pVao, vertexCount, range.startIndex, indexCount, range.baseVertex, pMaterial, box, false); });
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::MeshesCreated);
+        return pMesh;
+    }
+
     static BasicMaterial::MapType getFalcorMapType(TextureType map)
     {
         switch(map)
@@ -254,6 +306,7 @@ namespace Falcor
     }
 
     static const uint32_t kUnusedShaderElement = -1;
+    static const int32_t kMaxLodCount = 16;        // Sanity check for the LOD count of version 10 submeshes
     static uint32_t getShaderLocation(AttribType type)
     {
         switch(type)
@@ -341,7 +394,8 @@ namespace Falcor
         }
     }
 
-    std::string readString(BinaryFileStream& stream)
+    template<typename StreamType>
+    std::string readString(StreamType& stream)
     {
         int32_t length;
         stream >> length;
@@ -351,7 +405,8 @@ namespace Falcor
         return std::string(charVec.data());
     }
 
-    bool loadBinaryTextureData(BinaryFileStream& stream, const std::string& modelName, TextureData& data)
+    template<typename StreamType>
+    bool loadBinaryTextureData(StreamType& stream, const std::string& modelName, TextureData& data)
     {
         // ImageHeader.
         char tag[9];
@@ -437,29 +492,21 @@ namespace Falcor
         {
             dataSize = bpp * texelCount;
         }
-        size_t storageSize = dataSize;
-        if(bpp == 3)
-            storageSize = 4 * texelCount;
-
-        data.data.resize(storageSize);
-        stream.read(data.data.data(), dataSize);
-
-        // Convert 3-channel 8-bits RGB formats to 4-channel RGBX by adding padding
-        if(bpp == 3)
+        // 3-channel formats are padded later by decodeTextureData()
+        data.pData = readPersistent(stream, dataSize, data.data);
+        data.isPackedRgb = (bpp == 3);
+        if(data.pData == nullptr || (data.isPackedRgb && dataSize < 3 * texelCount))
         {
-            for(int32_t i=texelCount-1;i>=0;--i)
-            {
-                data.data[i * 4 + 0] = data.data[i * 3 + 0];
-                data.data[i * 4 + 1] = data.data[i * 3 + 1];
-                data.data[i * 4 + 2] = data.data[i * 3 + 2];
-                data.data[i * 4 + 3] = 0xff;
-            }
+            std::string msg = "Error when loading model " + modelName + ".\nCorrupt binary image data (truncated file).";
+            logError(msg);
+            return false;
         }
 
         return true;
     }
 
-    bool importTextures(std::vector<TextureData>& textures, uint32_t textureCount, BinaryFileStream& stream, const std::string& modelName)
+    template<typename StreamType>
+    bool importTextures(std::vector<TextureData>& textures, uint32_t textureCount, StreamType& stream, const std::string& modelName)
     {
         textures.assign(textureCount, TextureData());
 
@@ -475,11 +522,11 @@ namespace Falcor
         return true;
     }
 
-    BinaryModelImporter::BinaryModelImporter(const std::string& fullpath) : mModelName(fullpath), mStream(fullpath.c_str(), BinaryFileStream::Mode::Read)
+    BinaryModelImporter::BinaryModelImporter(const std::string& fullpath) : mModelName(fullpath)
     {
     }
 
-    bool BinaryModelImporter::import(Model& model, const std::string& filename, Model::LoadFlags flags)
+    bool BinaryModelImporter::import(Model& model, const std::string& filename, Model::LoadFlags flags, InputMode inputMode)
     {
         std::string fullpath;
         if(findFileInDataDirectories(filename, fullpath) == false)
@@ -489,14 +536,26 @@ namespace Falcor
         }
 
         BinaryModelImporter loader(fullpath);
-        return loader.importModel(model, flags);
+        if(inputMode == InputMode::MemoryMapped)
+        {
+            MemoryMappedFile::UniquePtr pFile = MemoryMappedFile::create(fullpath);
+            if(pFile)
+            {
+                BinaryMemoryStream stream(pFile->getData(), pFile->getSize());
+                return loader.importModel(stream, model, flags);
+            }
+            logWarning("Can't memory-map model file " + fullpath + ". Reading it as a stream.");
+        }
+
+        BinaryFileStream stream(fullpath, BinaryFileStream::Mode::Read);
+        return loader.importModel(stream, model, flags);
     }
 
     static bool checkVersion(const std::string& formatID, uint32_t version, const std::string& modelName)
     {
         if(std::string(formatID) == "BinScene")
         {
-            if(version < 6 || version > 8)
+            if(version < 6 || version > 10)
             {
                 std::string Msg = "Error when loading model " + modelName + ".\nUnsupported binary scene version " + std::to_string(version);
                 logError(Msg);
@@ -544,15 +603,51 @@ namespace Falcor
         }
     }
     
-    bool BinaryModelImporter::importModel(Model& model, Model::LoadFlags flags)
+    struct TexSignature
+    {
+        const uint8_t* pData;
+        ResourceFormat format;
+        bool operator<(const TexSignature& other) const 
+        { 
+            if(pData < other.pData) return true;
+            if(pData == other.pData) return format < other.format;
+            return false;
+        }
+        bool operator==(const TexSignature& other) const { return pData == other.pData || format == other.format; }
+    };
+    using MaterialTextureMap = std::map<TexSignature, Texture::SharedPtr>;
+
+    // Get the texture for a material map. Maps which use the same image with the same format share a texture.
+    static Texture::SharedPtr getMaterialTexture(const TextureData& data, BasicMaterial::MapType mapType, bool loadAsSrgb, MaterialTextureMap& cache)
+    {
+        TexSignature texSig;
+        texSig.format = getFormatFromMapType(loadAsSrgb, data.format, mapType);
+        texSig.pData = data.pData;
+
+        auto existingTex = cache.find(texSig);
+        if(existingTex != cache.end())
+        {
+            return existingTex->second;
+        }
+
+        // Other models may have loaded the same image already
+        auto pTexture = TextureCache::getTexture2D(data.width, data.height, texSig.format, texSig.pData, data.name);
+        cache[texSig] = pTexture;
+        return pTexture;
+    }
+
+    template<typename StreamType>
+    bool BinaryModelImporter::importModel(StreamType& stream, Model& model, Model::LoadFlags flags)
     {
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TotalBytes, stream.getRemainingStreamSize());
+
         // Format ID and version.
         char formatID[9];
-        mStream.read(formatID, 8);
+        stream.read(formatID, 8);
         formatID[8] = '\0';
 
         uint32_t version;
-        mStream >> version;
+        stream >> version;
 
         // Check if the version matches
         if(checkVersion(formatID, version, mModelName) == false)
@@ -560,6 +655,11 @@ namespace Falcor
             return false;
         }
 
+        if(version >= 9)
+        {
+            return importModelV9(stream, model, flags, version);
+        }
+
         int numTextureSlots;
         int numAttributesType = AttribType_AORadius + 1;
 
@@ -589,16 +689,16 @@ namespace Falcor
 
         if(version >= 6)
         {
-            mStream >> numTextures >> numMeshes >> numInstances;
+            stream >> numTextures >> numMeshes >> numInstances;
         }
         else
         {
             numMeshes = 1;
             numInstances = 1;
-            mStream >> numAttribs_v5 >> numVertices_v5 >> numSubmeshes_v5;
+            stream >> numAttribs_v5 >> numVertices_v5 >> numSubmeshes_v5;
             if(version >= 2)
             {
-                mStream >> numTextures;
+                stream >> numTextures;
             }
         }
 
@@ -611,12 +711,30 @@ namespace Falcor
 
         // create objects
         bool shouldGenerateTangents = is_set(flags, Model::LoadFlags::DontGenerateTangentSpace) == false;
-
+        const bool optimizeMeshes = is_set(flags, Model::LoadFlags::OptimizeMeshes);
+        const bool compressVertices = is_set(flags, Model::LoadFlags::CompressVertices);
+        const bool quantizePositions = is_set(flags, Model::LoadFlags::QuantizePositions);
+        MeshOptimizer::Statistics optimizerStats;
+        const bool generateLods = is_set(flags, Model::LoadFlags::GenerateLods);
+        const bool buildMeshlets = is_set(flags, Model::LoadFlags::BuildMeshlets);
+        const bool deduplicate = is_set(flags, Model::LoadFlags::DeduplicateGeometry);
+        std::unordered_set<MeshDeduplicator::Key, MeshDeduplicator::KeyHash> importedKeys;
+        MeshDeduplicator::ModelMeshes modelMeshes;
+        GeometryPool::SharedPtr pGeometryPool = is_set(flags, Model::LoadFlags::PoolGeometry) ? GeometryPool::create() : nullptr;
+
+        ImportTimings timings;
+        CpuTimer::TimePoint stageStart = CpuTimer::getCurrentTimePoint();
         std::vector<TextureData> texData;
+        TextureDecoder textureDecoder;
 
         if(version >= 6)
         {
-            importTextures(texData, numTextures, mStream, mModelName);
+            if(importTextures(texData, numTextures, stream, mModelName) == false)
+            {
+                return false;
+            }
+            textureDecoder.start(texData, timings);
+            timings.textureRead = CpuTimer::calcDuration(stageStart, CpuTimer::getCurrentTimePoint());
         }
 
         // This file format has a concept of sub-meshes, which Falcor model doesn't have - Falcor creates a new mesh for each sub-mesh
@@ -625,25 +743,43 @@ namespace Falcor
 
         // This importer loads mesh/submesh data before instance data, so the meshes are cached here.
         std::vector<Mesh::SharedPtr> falcorMeshCache;
-        
-        struct TexSignature
-        {
-            const uint8_t* pData;
-            ResourceFormat format;
-            bool operator<(const TexSignature& other) const 
-            { 
-                if(pData < other.pData) return true;
-                if(pData == other.pData) return format < other.format;
-                return false;
-            }
-            bool operator==(const TexSignature& other) const { return pData == other.pData || format == other.format; }
+
+        // The meshes are created once all the mesh data is read, so that the textures can be decoded in the meantime. Until then, the submeshes wait here.
+        struct PendingSubmesh
+        {
+            int32_t meshIdx;
+            Vao::BufferVec pVBs;
+            uint32_t vertexCount;
+            Buffer::SharedPtr pIB;
+            uint32_t indexCount;
+            VertexLayout::SharedPtr pLayout;
+            BasicMaterial material;
+            int32_t textureIDs[BasicMaterial::MapType::Count];
+            BoundingBox box;
+            std::vector<glm::vec3> cpuPositions;
+            std::vector<uint32_t> cpuIndices;
+            glm::vec3 positionScale;
+            glm::vec3 positionBias;
+            uint32_t poolRange = 0;
+            std::vector<Mesh::Lod> lods;        // Located relative to the submesh's first index
+            std::vector<Meshlet> meshlets;      // Located relative to the submesh's first index
+            MeshDeduplicator::Key geometryKey;
+            bool isDuplicate = false;           // An identical submesh was loaded before. Its mesh is reused instead of creating buffers.
+            Mesh::SharedPtr pGeometry;          // The identical mesh, if it belongs to another model
         };
-        std::map<TexSignature, Texture::SharedPtr> textures;
-        bool loadTexAsSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+        std::vector<PendingSubmesh> pendingSubmeshes;
+        stageStart = CpuTimer::getCurrentTimePoint();
+        size_t reportedPosition = 0;
 
         // Load the meshes
         for(int meshIdx = 0; meshIdx < numMeshes; meshIdx++)
         {
+            reportReadProgress(stream, reportedPosition);
+            if(AsyncLoadTask::isCancelled())
+            {
+                return false;
+            }
+
             // Mesh header
             int32_t numAttribs = 0;
             int32_t numVertices = 0;
@@ -651,7 +787,7 @@ namespace Falcor
 
             if(version >= 6)
             {
-                mStream >> numAttribs >> numVertices >> numSubmeshes;
+                stream >> numAttribs >> numVertices >> numSubmeshes;
             }
             else
             {
@@ -692,7 +828,7 @@ namespace Falcor
                 VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
                 pLayout->addBufferLayout(i, pBufferLayout);
                 int32_t type, format, length;
-                mStream >> type >> format >> length;
+                stream >> type >> format >> length;
 
                 if(type < 0 || type >= numAttributesType || format < 0 || format >= AttribFormat::AttribFormat_Max || length < 1 || length > 4)
                 {
@@ -759,56 +895,79 @@ namespace Falcor
                     auto pBitangentLayout = VertexBufferLayout::create();
                     pLayout->addBufferLayout(bitangentBufferIndex, pBitangentLayout);
                     pBitangentLayout->addElement(VERTEX_BITANGENT_NAME, 0, ResourceFormat::RGB32Float, 1, VERTEX_BITANGENT_LOC);
+                    buffers[bitangentBufferIndex].elementSize = sizeof(glm::vec3);
                     buffers[bitangentBufferIndex].vec.resize(sizeof(glm::vec3) * numVertices);
                 }
             }
             
 
-            // Read the data, one vertex at a time
-            for(int32_t i = 0; i < numVertices; i++)
+            // The vertices are interleaved in the file. Read the whole block at once and split it into a buffer per attribute.
+            uint32_t vertexSize = 0;
+            for(int32_t i = 0; i < numAttribs; i++)
             {
-                for (int32_t attributes = 0; attributes < numAttribs; ++attributes)
-                {
-                    if (buffers[attributes].shouldSkip)
-                    {
-                        mStream.skip(buffers[attributes].elementSize);
-                    }
-                    else
-                    {
-                        uint32_t stride = pLayout->getBufferLayout(attributes)->getStride();
-                        uint8_t* pDest = buffers[attributes].vec.data() + stride * i;
-                        mStream.read(pDest, stride);
-                    }
-                }
+                vertexSize += buffers[i].elementSize;
+            }
+
+            std::vector<uint8_t> vertexStorage;
+            const uint8_t* pVertexData = readPersistent(stream, (size_t)vertexSize * numVertices, vertexStorage);
+            if(pVertexData == nullptr)
+            {
+                std::string msg = "Error when loading model " + mModelName + ".\nFile is truncated.";
+                logError(msg);
+                return false;
             }
 
-            for (int32_t i = 0; i < numAttribs; ++i)
+            uint32_t attribOffset = 0;
+            for(int32_t attrib = 0; attrib < numAttribs; attrib++)
             {
-                if(buffers[i].shouldSkip == false)
+                const uint32_t elementSize = buffers[attrib].elementSize;
+                if(buffers[attrib].shouldSkip == false)
                 {
-                    pVBs[i] = Buffer::create(buffers[i].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[i].vec.data());
+                    const uint8_t* pSrc = pVertexData + attribOffset;
+                    uint8_t* pDest = buffers[attrib].vec.data();
+                    for(int32_t i = 0; i < numVertices; i++)
+                    {
+                        memcpy(pDest, pSrc, elementSize);
+                        pDest += elementSize;
+                        pSrc += vertexSize;
+                    }
                 }
+                attribOffset += elementSize;
             }
+            vertexStorage = std::vector<uint8_t>();
 
+            // Older versions have a single mesh, with the textures following the vertices
             if(version <= 5)
             {
-                importTextures(texData, numTextures, mStream, mModelName);
-                textures.clear();
+                CpuTimer::TimePoint textureStart = CpuTimer::getCurrentTimePoint();
+                if(importTextures(texData, numTextures, stream, mModelName) == false)
+                {
+                    return false;
+                }
+                textureDecoder.start(texData, timings);
+                timings.textureRead = CpuTimer::calcDuration(textureStart, CpuTimer::getCurrentTimePoint());
             }
 
             // Array of Submesh.
             // Falcor doesn't have a concept of submeshes, just create a new mesh for each submesh
+            // The buffers are created once all the submeshes are read, since the mesh optimizer reorders the vertices they share
+            std::vector<const uint32_t*> submeshIndices;
+            std::vector<uint32_t> submeshIndexCounts;
+            std::vector<std::vector<uint8_t>> submeshIndexStorage;
             for(int submesh = 0; submesh < numSubmeshes; submesh++)
             {
-                // create the material
-                BasicMaterial basicMaterial;
+                // create the material. The textures are assigned once they are decoded.
+                PendingSubmesh pending;
+                pending.meshIdx = meshIdx;
+                std::fill_n(pending.textureIDs, arraysize(pending.textureIDs), -1);
+                BasicMaterial& basicMaterial = pending.material;
 
                 glm::vec3 ambient;
                 glm::vec4 diffuse;
                 glm::vec3 specular;
                 float glossiness;
 
-                mStream >> ambient >> diffuse >> specular >> glossiness;
+                stream >> ambient >> diffuse >> specular >> glossiness;
                 basicMaterial.diffuseColor = glm::vec3(diffuse);
                 basicMaterial.opacity = 1 - diffuse.w;
                 basicMaterial.specularColor = specular;
@@ -818,7 +977,7 @@ namespace Falcor
                 {
                     float displacementCoeff;
                     float displacementBias;
-                    mStream >> displacementCoeff >> displacementBias;
+                    stream >> displacementCoeff >> displacementBias;
                     basicMaterial.bumpScale = displacementCoeff;
                     basicMaterial.bumpOffset = displacementBias;
                 }
@@ -826,7 +985,7 @@ namespace Falcor
                 for(int i = 0; i < numTextureSlots; i++)
                 {
                     int32_t texID;
-                    mStream >> texID;
+                    stream >> texID;
                     if(texID < -1 || texID >= numTextures)
                     {
                         std::string msg = "Error when loading model " + mModelName + ".\nCorrupt binary mesh data!";
@@ -842,31 +1001,12 @@ namespace Falcor
                             continue;
                         }
 
-                        // Load the texture
-                        TexSignature texSig;
-                        texSig.format = getFormatFromMapType(loadTexAsSrgb, texData[texID].format, falcorType);
-                        texSig.pData = texData[texID].data.data();
-                        // Check if we already created a matching texture
-                        auto existingTex = textures.find(texSig);
-                        if(existingTex != textures.end())
-                        {
-                            basicMaterial.pTextures[falcorType] = existingTex->second;
-                        }
-                        else
-                        {
-                            auto pTexture = Texture::create2D(texData[texID].width, texData[texID].height, texSig.format, 1, Texture::kMaxPossible, texSig.pData);
-                            pTexture->setSourceFilename(texData[texID].name);
-                            textures[texSig] = pTexture;
-                            basicMaterial.pTextures[falcorType] = pTexture;
-                        }
+                        pending.textureIDs[falcorType] = texID;
                     }
                 }
 
-                // Create material and check if it already exists
-                auto pMaterial = checkForExistingMaterial(basicMaterial.convertToMaterial());
-
                 int32_t numTriangles;
-                mStream >> numTriangles;
+                stream >> numTriangles;
                 if(numTriangles < 0)
                 {
                     std::string Msg = "Error when loading model " + mModelName + ".\nMesh has negative number of triangles!";
@@ -876,92 +1016,1112 @@ namespace Falcor
 
                 // create the index buffer
                 uint32_t numIndices = numTriangles * 3;
-                std::vector<uint32_t> indices(numIndices);
                 uint32_t ibSize = 3 * numTriangles * sizeof(uint32_t);
-                mStream.read(&indices[0], ibSize);
+                std::vector<uint8_t> indexStorage;
+                const uint32_t* indices = (const uint32_t*)readPersistent(stream, ibSize, indexStorage);
+                if(indices == nullptr)
+                {
+                    std::string msg = "Error when loading model " + mModelName + ".\nFile is truncated.";
+                    logError(msg);
+                    return false;
+                }
+
+                submeshIndices.push_back(indices);
+                submeshIndexCounts.push_back(numIndices);
+                submeshIndexStorage.push_back(std::move(indexStorage));
+
+                // Calculate the bounding-box
+                glm::vec3 max, min;
+                for(uint32_t i = 0; i < numIndices; i++)
+                {
+                    uint32_t vertexID = indices[i];
+                    uint8_t* pVertex = (pLayout->getBufferLayout(positionBufferIndex)->getStride() * vertexID) + buffers[positionBufferIndex].vec.data();
+
+                    float* pPosition = (float*)pVertex;
+
+                    glm::vec3 xyz(pPosition[0], pPosition[1], pPosition[2]);
+                    min = glm::min(min, xyz);
+                    max = glm::max(max, xyz);
+                }
 
-                auto pIB = Buffer::create(ibSize, Buffer::BindFlags::Index, Buffer::CpuAccess::None, indices.data());
+                pending.box = BoundingBox::fromMinMax(min, max);
+                pending.vertexCount = numVertices;
+                pending.indexCount = numIndices;
+                pendingSubmeshes.push_back(std::move(pending));
+            }
 
-                // Generate tangent space data if needed
-                if(genTangentForMesh)
+            // Generate tangent space data if needed. Later submeshes overwrite the vertices they share with earlier ones.
+            if(genTangentForMesh)
+            {
+                ResourceFormat posFormat = pLayout->getBufferLayout(positionBufferIndex)->getElementFormat(0);
+                if(posFormat == ResourceFormat::RGB32Float || posFormat == ResourceFormat::RGBA32Float)
                 {
-                    uint32_t texCrdCount = 0;
-                    glm::vec2* texCrd = nullptr;
+                    TangentSpaceGenerator::MeshDesc desc;
+                    desc.pPositions = buffers[positionBufferIndex].vec.data();
+                    desc.positionStride = (posFormat == ResourceFormat::RGB32Float) ? sizeof(glm::vec3) : sizeof(glm::vec4);
+                    desc.pNormals = buffers[normalBufferIndex].vec.data();
+                    desc.normalStride = sizeof(glm::vec3);
                     if(texCoordBufferIndex != kInvalidBufferIndex)
                     {
-                        texCrdCount = pLayout->getBufferLayout(texCoordBufferIndex)->getStride() / sizeof(glm::vec2);
-                        texCrd = (glm::vec2*)buffers[texCoordBufferIndex].vec.data();
+                        desc.pTexCrds = buffers[texCoordBufferIndex].vec.data();
+                        desc.texCrdStride = (pLayout->getBufferLayout(texCoordBufferIndex)->getStride() / sizeof(glm::vec2)) * sizeof(glm::vec2);
                     }
+                    desc.vertexCount = numVertices;
+                    desc.submeshIndices = submeshIndices;
+                    desc.submeshIndexCounts = submeshIndexCounts;
+                    desc.pBitangents = buffers[bitangentBufferIndex].vec.data();
+                    desc.bitangentStride = sizeof(glm::vec3);
+                    TangentSpaceGenerator::generateBitangents(desc);
+                }
+            }
 
-                    ResourceFormat posFormat = pLayout->getBufferLayout(positionBufferIndex)->getElementFormat(0);
+            const size_t firstPending = pendingSubmeshes.size() - submeshIndices.size();
 
-                    if (posFormat == ResourceFormat::RGB32Float)
+            // Weld before the optimizer, so that it orders the merged vertices
+            std::vector<uint32_t> weldedIndices;
+            if(deduplicate)
+            {
+                std::vector<uint8_t*> vbData(buffers.size(), nullptr);
+                std::vector<uint32_t> strides(buffers.size());
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
+                {
+                    if(buffers[i].shouldSkip == false)
                     {
-                        generateSubmeshTangentData<glm::vec3>(indices, (glm::vec3*)buffers[positionBufferIndex].vec.data(), (glm::vec3*)buffers[normalBufferIndex].vec.data(), texCrd, texCrdCount, (glm::vec3*)buffers[bitangentBufferIndex].vec.data());
+                        vbData[i] = buffers[i].vec.data();
                     }
-                    else if (posFormat == ResourceFormat::RGBA32Float)
+                    strides[i] = buffers[i].elementSize;
+                }
+                for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+                {
+                    weldedIndices.insert(weldedIndices.end(), submeshIndices[i], submeshIndices[i] + submeshIndexCounts[i]);
+                }
+
+                uint32_t weldedVertexCount;
+                if(MeshDeduplicator::weldVertices(vbData, strides, numVertices, weldedIndices.data(), (uint32_t)weldedIndices.size(), weldedVertexCount).size())
+                {
+                    numVertices = (int32_t)weldedVertexCount;
+                    for(BufferData& buffer : buffers)
                     {
-                        generateSubmeshTangentData<glm::vec4>(indices, (glm::vec4*)buffers[positionBufferIndex].vec.data(), (glm::vec3*)buffers[normalBufferIndex].vec.data(), texCrd, texCrdCount, (glm::vec3*)buffers[bitangentBufferIndex].vec.data());
+                        if(buffer.shouldSkip == false)
+                        {
+                            buffer.vec.resize((size_t)buffer.elementSize * numVertices);
+                        }
                     }
 
-                    pVBs[bitangentBufferIndex] = Buffer::create(buffers[bitangentBufferIndex].vec.size(), Buffer::BindFlags::Vertex, Buffer::CpuAccess::None, buffers[bitangentBufferIndex].vec.data());
+                    uint32_t offset = 0;
+                    for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+                    {
+                        submeshIndices[i] = weldedIndices.data() + offset;
+                        offset += submeshIndexCounts[i];
+                        pendingSubmeshes[firstPending + i].vertexCount = numVertices;
+                    }
                 }
-                
+            }
 
-                // Calculate the bounding-box
-                glm::vec3 max, min;
-                for(uint32_t i = 0; i < numIndices; i++)
+            std::vector<uint32_t> optimizedIndices;
+            if(optimizeMeshes && positionBufferIndex != kInvalidBufferIndex)
+            {
+                for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
                 {
-                    uint32_t vertexID = indices[i];
-                    uint8_t* pVertex = (pLayout->getBufferLayout(positionBufferIndex)->getStride() * vertexID) + buffers[positionBufferIndex].vec.data();
+                    optimizedIndices.insert(optimizedIndices.end(), submeshIndices[i], submeshIndices[i] + submeshIndexCounts[i]);
+                }
 
-                    float* pPosition = (float*)pVertex;
+                const uint32_t positionStride = pLayout->getBufferLayout(positionBufferIndex)->getStride();
+                std::vector<uint32_t> remap = MeshOptimizer::optimizeMesh(optimizedIndices, submeshIndexCounts, numVertices, (const float*)buffers[positionBufferIndex].vec.data(), positionStride, optimizerStats);
+                if(remap.size())
+                {
+                    for(BufferData& buffer : buffers)
+                    {
+                        if(buffer.vec.size())
+                        {
+                            MeshOptimizer::remapVertices(buffer.vec.data(), buffer.elementSize, numVertices, remap);
+                        }
+                    }
 
-                    glm::vec3 xyz(pPosition[0], pPosition[1], pPosition[2]);
-                    min = glm::min(min, xyz);
-                    max = glm::max(max, xyz);
+                    uint32_t offset = 0;
+                    for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+                    {
+                        submeshIndices[i] = optimizedIndices.data() + offset;
+                        offset += submeshIndexCounts[i];
+                    }
+                }
+            }
+
+            std::vector<glm::vec3> cpuPositions;
+            if (is_set(flags, Model::LoadFlags::KeepCpuGeometry))
+            {
+                const uint32_t positionStride = pLayout->getBufferLayout(positionBufferIndex)->getStride();
+                cpuPositions.resize(numVertices);
+                for (int32_t i = 0; i < numVertices; i++)
+                {
+                    cpuPositions[i] = *(glm::vec3*)(buffers[positionBufferIndex].vec.data() + positionStride * i);
                 }
+            }
 
-                BoundingBox box = BoundingBox::fromMinMax(min, max);
+            // The LODs go into each submesh's index buffer, after the full detail indices. They are generated before the compression changes the positions.
+            std::vector<std::vector<uint32_t>> lodIndices(submeshIndices.size());
+            if(generateLods)
+            {
+                std::vector<const uint8_t*> vbData(buffers.size(), nullptr);
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
+                {
+                    if(buffers[i].shouldSkip == false)
+                    {
+                        vbData[i] = buffers[i].vec.data();
+                    }
+                }
+                for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+                {
+                    std::vector<MeshSimplifier::Lod> lods = MeshSimplifier::generateLodChain(pLayout.get(), vbData, numVertices, submeshIndices[i], submeshIndexCounts[i]);
+                    if(lods.size())
+                    {
+                        lodIndices[i].assign(submeshIndices[i], submeshIndices[i] + submeshIndexCounts[i]);
+                    }
+                    for(const MeshSimplifier::Lod& lod : lods)
+                    {
+                        pendingSubmeshes[firstPending + i].lods.push_back({ (uint32_t)lodIndices[i].size(), (uint32_t)lod.indices.size(), lod.error });
+                        lodIndices[i].insert(lodIndices[i].end(), lod.indices.begin(), lod.indices.end());
+                    }
+                }
+            }
 
-                // create the mesh
-                auto pMesh = Mesh::create(pVBs, numVertices, pIB, numIndices, pLayout, Vao::Topology::TriangleList, pMaterial, box, false);
+            if(buildMeshlets)
+            {
+                std::vector<const uint8_t*> vbData(buffers.size(), nullptr);
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
+                {
+                    if(buffers[i].shouldSkip == false)
+                    {
+                        vbData[i] = buffers[i].vec.data();
+                    }
+                }
+                for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+                {
+                    pendingSubmeshes[firstPending + i].meshlets = MeshletBuilder::build(pLayout.get(), vbData, numVertices, submeshIndices[i], submeshIndexCounts[i]);
+                }
+            }
 
-                if (version >= 6)
+            VertexCompression::Result compressed;
+            if(compressVertices)
+            {
+                std::vector<const uint8_t*> vbData(buffers.size(), nullptr);
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
                 {
-                    falcorMeshCache.push_back(pMesh);
-                    meshToSubmeshesID[meshIdx].push_back((uint32_t)(falcorMeshCache.size() - 1));
+                    if(buffers[i].shouldSkip == false)
+                    {
+                        vbData[i] = buffers[i].vec.data();
+                    }
                 }
-                else
+                compressed = VertexCompression::compressVertices(pLayout.get(), vbData, numVertices, quantizePositions);
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
                 {
-                    model.addMeshInstance(pMesh, glm::mat4());
+                    buffers[i].vec = std::move(compressed.buffers[i]);
                 }
+                pLayout = compressed.pLayout;
             }
-        }
 
-        if(version >= 6)
-        {
-            for(int32_t instanceID = 0; instanceID < numInstances; instanceID++)
+            // Submeshes identical to earlier ones, of this model or of another, are created from the earlier mesh. The key covers the final data and the load flags which only change how the buffers are created.
+            bool allDuplicates = false;
+            if(deduplicate)
             {
-                int32_t meshIdx = 0;
-                int32_t enabled = 1;
-                glm::mat4 transformation;
+                MeshDeduplicator::Hasher vertexHasher;
+                vertexHasher.add(flags);
+                vertexHasher.add(pLayout.get());
+                for(const BufferData& buffer : buffers)
+                {
+                    if(buffer.shouldSkip == false)
+                    {
+                        vertexHasher.add(buffer.vec.data(), buffer.vec.size());
+                    }
+                }
+                vertexHasher.add(&compressed.positionScale, sizeof(compressed.positionScale));
+                vertexHasher.add(&compressed.positionBias, sizeof(compressed.positionBias));
 
-                mStream >> meshIdx >> enabled >> transformation;
-                //m_Stream >> inst.name >> inst.metadata;
-                readString(mStream);   // Name
-                readString(mStream);   // Meta-data
+                allDuplicates = true;
+                for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+                {
+                    PendingSubmesh& pending = pendingSubmeshes[firstPending + i];
+                    MeshDeduplicator::Hasher hasher = vertexHasher;
+                    if(lodIndices[i].size())
+                    {
+                        hasher.add(lodIndices[i].data(), lodIndices[i].size() * sizeof(uint32_t));
+                    }
+                    else
+                    {
+                        hasher.add(submeshIndices[i], submeshIndexCounts[i] * sizeof(uint32_t));
+                    }
+                    hasher.add(pending.lods.data(), pending.lods.size() * sizeof(Mesh::Lod));
+                    pending.geometryKey = hasher.getKey();
+                    pending.pGeometry = MeshDeduplicator::findGeometry(pending.geometryKey);
+                    const bool importedBefore = importedKeys.insert(pending.geometryKey).second == false;
+                    pending.isDuplicate = importedBefore || pending.pGeometry;
+                    allDuplicates = allDuplicates && pending.isDuplicate;
+                }
+            }
 
-                if(enabled)
+            uint32_t vertexBlock = 0;
+            if(pGeometryPool && allDuplicates == false)
+            {
+                std::vector<const uint8_t*> vbData(buffers.size(), nullptr);
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
                 {
-                    for(uint32_t i : meshToSubmeshesID[meshIdx])
+                    if(buffers[i].shouldSkip == false)
                     {
-                        model.addMeshInstance(falcorMeshCache[i], transformation);
+                        vbData[i] = buffers[i].vec.data();
+                    }
+                }
+                vertexBlock = pGeometryPool->addVertices(pLayout, vbData, numVertices, Vao::Topology::TriangleList);
+            }
+            else if(allDuplicates == false)
+            {
+                for(uint32_t i = 0; i < (uint32_t)buffers.size(); i++)
+                {
+                    if(buffers[i].shouldSkip == false)
+                    {
+                        pVBs[i] = createBuffer(buffers[i].vec.size(), Buffer::BindFlags::Vertex, buffers[i].vec.data());
                     }
                 }
             }
+
+            for(uint32_t i = 0; i < (uint32_t)submeshIndices.size(); i++)
+            {
+                PendingSubmesh& pending = pendingSubmeshes[firstPending + i];
+                if(pending.isDuplicate)
+                {
+                    continue;
+                }
+                const uint32_t* indices = lodIndices[i].size() ? lodIndices[i].data() : submeshIndices[i];
+                const uint32_t indexCount = lodIndices[i].size() ? (uint32_t)lodIndices[i].size() : submeshIndexCounts[i];
+                if(pGeometryPool)
+                {
+                    pending.poolRange = pGeometryPool->addIndices(vertexBlock, indices, indexCount);
+                }
+                else
+                {
+                    pending.pVBs = pVBs;
+                    pending.pIB = createBuffer(indexCount * sizeof(uint32_t), Buffer::BindFlags::Index, indices);
+                }
+                pending.pLayout = pLayout;
+                pending.positionScale = compressed.positionScale;
+                pending.positionBias = compressed.positionBias;
+
+                if (cpuPositions.size())
+                {
+                    pending.cpuPositions = cpuPositions;
+                    pending.cpuIndices.assign(submeshIndices[i], submeshIndices[i] + submeshIndexCounts[i]);
+                }
+            }
+        }
+        if(pGeometryPool)
+        {
+            pGeometryPool->createBuffers();
+        }
+        timings.meshData = CpuTimer::calcDuration(stageStart, CpuTimer::getCurrentTimePoint());
+        if(version <= 5)
+        {
+            // The textures were read in the middle of the mesh data
+            timings.meshData -= timings.textureRead;
+        }
+
+        // Create the textures, materials and meshes. The decoder threads never create resources; async loads hand them to the main thread.
+        textureDecoder.wait();
+        stageStart = CpuTimer::getCurrentTimePoint();
+        MaterialTextureMap textures;
+        bool loadTexAsSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+        for(PendingSubmesh& pending : pendingSubmeshes)
+        {
+            if(AsyncLoadTask::isCancelled())
+            {
+                return false;
+            }
+
+            for(uint32_t i = 0; i < BasicMaterial::MapType::Count; i++)
+            {
+                if(pending.textureIDs[i] != -1)
+                {
+                    pending.material.pTextures[i] = getMaterialTexture(texData[pending.textureIDs[i]], BasicMaterial::MapType(i), loadTexAsSrgb, textures);
+                }
+            }
+
+            // Create material and check if it already exists
+            auto pMaterial = checkForExistingMaterial(pending.material.convertToMaterial());
+            Mesh::SharedPtr pMesh;
+            if(pending.isDuplicate)
+            {
+                // Identical submeshes of this model were created earlier in this loop, otherwise pGeometry is another model's mesh
+                pMesh = MeshDeduplicator::instantiate(pending.pGeometry, pending.geometryKey, pMaterial, modelMeshes);
+            }
+            else
+            {
+                uint32_t startIndex = 0;
+                if(pGeometryPool)
+                {
+                    const GeometryPool::Range& range = pGeometryPool->getRange(pending.poolRange);
+                    startIndex = range.startIndex;
+                    pMesh = createMesh(range, pending.vertexCount, pending.indexCount, pMaterial, pending.box);
+                }
+                else
+                {
+                    pMesh = createMesh(pending.pVBs, pending.vertexCount, pending.pIB, pending.indexCount, pending.pLayout, pMaterial, pending.box);
+                }
+                for(const Mesh::Lod& lod : pending.lods)
+                {
+                    pMesh->addLod(startIndex + lod.startIndex, lod.indexCount, lod.error);
+                }
+                for(Meshlet& meshlet : pending.meshlets)
+                {
+                    meshlet.startIndex += startIndex;
+                }
+                pMesh->setMeshlets(std::move(pending.meshlets));
+                pMesh->setPositionDequantization(pending.positionScale, pending.positionBias);
+                if(pending.cpuPositions.size())
+                {
+                    pMesh->setCpuGeometry(std::move(pending.cpuPositions), std::move(pending.cpuIndices));
+                }
+                if(deduplicate)
+                {
+                    MeshDeduplicator::registerMesh(pending.geometryKey, pMesh, modelMeshes);
+                }
+            }
+
+            if (version >= 6)
+            {
+                falcorMeshCache.push_back(pMesh);
+                meshToSubmeshesID[pending.meshIdx].push_back((uint32_t)(falcorMeshCache.size() - 1));
+            }
+            else
+            {
+                model.addMeshInstance(pMesh, glm::mat4());
+            }
+        }
+        timings.objectCreation = CpuTimer::calcDuration(stageStart, CpuTimer::getCurrentTimePoint());
+
+        if(version >= 6)
+        {
+            for(int32_t instanceID = 0; instanceID < numInstances; instanceID++)
+            {
+                int32_t meshIdx = 0;
+                int32_t enabled = 1;
+                glm::mat4 transformation;
+
+                stream >> meshIdx >> enabled >> transformation;
+                //m_Stream >> inst.name >> inst.metadata;
+                readString(stream);   // Name
+                readString(stream);   // Meta-data
+
+                if(enabled)
+                {
+                    for(uint32_t i : meshToSubmeshesID[meshIdx])
+                    {
+                        model.addMeshInstance(falcorMeshCache[i], transformation);
+                    }
+                }
+            }
+        }
+
+        reportReadProgress(stream, reportedPosition);
+        logImportTimings(mModelName, timings);
+        if(optimizeMeshes)
+        {
+            MeshOptimizer::logStatistics(mModelName, optimizerStats);
+        }
+        if(pGeometryPool)
+        {
+            GeometryPool::logStatistics(mModelName, pGeometryPool->getStatistics());
+        }
+        return true;
+    }
+
+    template<typename StreamType>
+    bool BinaryModelImporter::importModelV9(StreamType& stream, Model& model, Model::LoadFlags flags, uint32_t version)
+    {
+        const std::string corruptMsg = "Error when loading model " + mModelName + ".\nFile is corrupted.";
+
+        int32_t numTextures, numMaterials, numMeshes, numInstances;
+        stream >> numTextures >> numMaterials >> numMeshes >> numInstances;
+        // The counts size the allocations below. Every entry takes at least a byte, which bounds them by the file size.
+        const size_t streamSize = stream.getStreamSize();
+        if(numTextures < 0 || numMaterials < 0 || numMeshes < 0 || numInstances < 0 ||
+            isRangeInStream(stream.getPosition(), (uint64_t)numTextures + numMaterials + numMeshes + numInstances, 1, streamSize) == false)
+        {
+            logError(corruptMsg);
+            return false;
+        }
+
+        // Read the directory. The data it points to is loaded once the whole directory is known, so every range it references is checked against the file size first.
+        std::vector<uint64_t> textureOffsets(numTextures);
+        for(uint64_t& offset : textureOffsets)
+        {
+            uint64_t size;
+            stream >> offset >> size;
+            if(isRangeInStream(offset, size, 1, streamSize) == false)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+        }
+
+        struct MaterialEntry
+        {
+            glm::vec4 diffuse;
+            glm::vec3 specular;
+            float glossiness;
+            float displacementCoeff;
+            float displacementBias;
+            int32_t textures[TextureType_Max];
+        };
+        std::vector<MaterialEntry> materialEntries(numMaterials);
+        for(MaterialEntry& entry : materialEntries)
+        {
+            stream >> entry.diffuse >> entry.specular >> entry.glossiness >> entry.displacementCoeff >> entry.displacementBias;
+            stream.read(entry.textures, sizeof(entry.textures));
+            for(int32_t texID : entry.textures)
+            {
+                if(texID < -1 || texID >= numTextures)
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+            }
+        }
+
+        struct VertexBufferEntry
+        {
+            uint32_t stride;
+            uint64_t dataOffset;
+        };
+
+        struct LodEntry
+        {
+            int32_t indexCount;
+            uint64_t indexDataOffset;
+            float error;
+        };
+
+        struct SubmeshEntry
+        {
+            int32_t materialID;
+            int32_t indexCount;
+            uint64_t indexDataOffset;
+            glm::vec3 aabbMin;
+            glm::vec3 aabbMax;
+            std::vector<LodEntry> lods;
+        };
+
+        struct MeshEntry
+        {
+            int32_t vertexCount;
+            VertexLayout::SharedPtr pLayout;
+            std::vector<VertexBufferEntry> vertexBuffers;
+            std::vector<SubmeshEntry> submeshes;
+            uint32_t positionBufferIndex = kInvalidOffset;
+            uint32_t positionOffset = 0;
+            glm::vec3 positionScale = glm::vec3(1);
+            glm::vec3 positionBias = glm::vec3(0);
+        };
+
+        std::vector<MeshEntry> meshEntries(numMeshes);
+        for(MeshEntry& mesh : meshEntries)
+        {
+            int32_t numVertexBuffers, numSubmeshes;
+            stream >> numVertexBuffers >> mesh.vertexCount >> numSubmeshes;
+            if(numVertexBuffers < 0 || mesh.vertexCount < 0 || numSubmeshes < 0 || isRangeInStream(stream.getPosition(), (uint64_t)numVertexBuffers + numSubmeshes, 1, streamSize) == false)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+
+            mesh.pLayout = VertexLayout::create();
+            mesh.vertexBuffers.resize(numVertexBuffers);
+            for(int32_t vbIndex = 0; vbIndex < numVertexBuffers; vbIndex++)
+            {
+                VertexBufferEntry& vb = mesh.vertexBuffers[vbIndex];
+                int32_t numElements;
+                stream >> numElements >> vb.stride >> vb.dataOffset;
+
+                VertexBufferLayout::SharedPtr pBufferLayout = VertexBufferLayout::create();
+                mesh.pLayout->addBufferLayout(vbIndex, pBufferLayout);
+                for(int32_t i = 0; i < numElements; i++)
+                {
+                    int32_t type, format, length, offset;
+                    stream >> type >> format >> length >> offset;
+                    // The exporter only writes attributes the shaders use
+                    if(type < 0 || type >= AttribType_Max || type == AttribType_AORadius || type == AttribType_Tangent || format < 0 || format >= AttribFormat_Max || length < 1 || length > 4 || offset < 0)
+                    {
+                        logError(corruptMsg);
+                        return false;
+                    }
+
+                    ResourceFormat falcorFormat = getFalcorFormat(AttribFormat(format), length);
+                    uint32_t shaderLocation = getShaderLocation(AttribType(type));
+                    pBufferLayout->addElement(getSemanticName(AttribType(type)), offset, falcorFormat, 1, shaderLocation);
+
+                    if(shaderLocation == VERTEX_POSITION_LOC && format == AttribFormat_F32 && length >= 3)
+                    {
+                        mesh.positionBufferIndex = vbIndex;
+                        mesh.positionOffset = offset;
+                    }
+                }
+
+                // The elements must cover the whole vertex, since the layout's stride is used when binding the buffer
+                if(pBufferLayout->getStride() != vb.stride || isRangeInStream(vb.dataOffset, mesh.vertexCount, vb.stride, streamSize) == false)
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+            }
+
+            mesh.submeshes.resize(numSubmeshes);
+            for(SubmeshEntry& submesh : mesh.submeshes)
+            {
+                stream >> submesh.materialID >> submesh.indexCount >> submesh.indexDataOffset >> submesh.aabbMin >> submesh.aabbMax;
+                if(submesh.materialID < 0 || submesh.materialID >= numMaterials || submesh.indexCount < 0 || isRangeInStream(submesh.indexDataOffset, submesh.indexCount, sizeof(uint32_t), streamSize) == false)
+                {
+                    logError(corruptMsg);
+                    return false;
+                }
+
+                if(version >= 10)
+                {
+                    int32_t numLods;
+                    stream >> numLods;
+                    if(numLods < 0 || numLods > kMaxLodCount)
+                    {
+                        logError(corruptMsg);
+                        return false;
+                    }
+                    submesh.lods.resize(numLods);
+                    for(LodEntry& lod : submesh.lods)
+                    {
+                        stream >> lod.indexCount >> lod.indexDataOffset >> lod.error;
+                        if(lod.indexCount < 0 || lod.indexCount % 3 != 0 || isRangeInStream(lod.indexDataOffset, lod.indexCount, sizeof(uint32_t), streamSize) == false)
+                        {
+                            logError(corruptMsg);
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+
+        struct InstanceEntry
+        {
+            int32_t meshIdx;
+            int32_t enabled;
+            glm::mat4 transformation;
+        };
+        std::vector<InstanceEntry> instanceEntries(numInstances);
+        for(InstanceEntry& instance : instanceEntries)
+        {
+            stream >> instance.meshIdx >> instance.enabled >> instance.transformation;
+            readString(stream);   // Name
+            readString(stream);   // Meta-data
+            if(instance.meshIdx < -1 || instance.meshIdx >= numMeshes)
+            {
+                logError(corruptMsg);
+                return false;
+            }
+        }
+
+        if(stream.isFail())
+        {
+            logError(corruptMsg);
+            return false;
+        }
+
+        // Textures. They are decoded in the background while the mesh buffers are created.
+        ImportTimings timings;
+        CpuTimer::TimePoint stageStart = CpuTimer::getCurrentTimePoint();
+        std::vector<TextureData> texData(numTextures);
+        TextureDecoder textureDecoder;
+        for(int32_t i = 0; i < numTextures; i++)
+        {
+            stream.setPosition((size_t)textureOffsets[i]);
+            texData[i].name = readString(stream);
+            if(loadBinaryTextureData(stream, mModelName, texData[i]) == false)
+            {
+                return false;
+            }
+        }
+        textureDecoder.start(texData, timings);
+        timings.textureRead = CpuTimer::calcDuration(stageStart, CpuTimer::getCurrentTimePoint());
+
+        // Mesh buffers. The file stores them in their final layout, so they are created straight from the file data.
+        stageStart = CpuTimer::getCurrentTimePoint();
+        struct PendingSubmesh
+        {
+            Buffer::SharedPtr pIB;
+            uint32_t poolRange = 0;
+            std::vector<Mesh::Lod> lods;        // Located relative to the submesh's first index
+            std::vector<Meshlet> meshlets;      // Located relative to the submesh's first index
+            MeshDeduplicator::Key geometryKey;
+            bool isDuplicate = false;           // An identical submesh was loaded before. Its mesh is reused instead of creating buffers.
+            Mesh::SharedPtr pGeometry;          // The identical mesh, if it belongs to another model
+            std::vector<uint32_t> cpuIndices;
+        };
+        const std::string truncatedMsg = "Error when loading model " + mModelName + ".\nFile is truncated.";
+        const bool keepCpuGeometry = is_set(flags, Model::LoadFlags::KeepCpuGeometry);
+        const bool optimizeMeshes = is_set(flags, Model::LoadFlags::OptimizeMeshes);
+        const bool compressVertices = is_set(flags, Model::LoadFlags::CompressVertices);
+        const bool quantizePositions = is_set(flags, Model::LoadFlags::QuantizePositions);
+        MeshOptimizer::Statistics optimizerStats;
+        const bool generateLods = is_set(flags, Model::LoadFlags::GenerateLods);
+        const bool buildMeshlets = is_set(flags, Model::LoadFlags::BuildMeshlets);
+        const bool deduplicate = is_set(flags, Model::LoadFlags::DeduplicateGeometry);
+        std::unordered_set<MeshDeduplicator::Key, MeshDeduplicator::KeyHash> importedKeys;
+        MeshDeduplicator::ModelMeshes modelMeshes;
+        GeometryPool::SharedPtr pGeometryPool = is_set(flags, Model::LoadFlags::PoolGeometry) ? GeometryPool::create() : nullptr;
+        std::vector<Vao::BufferVec> meshVBs(numMeshes);
+        std::vector<std::vector<glm::vec3>> meshPositions(numMeshes);
+        std::vector<std::vector<PendingSubmesh>> pendingSubmeshes(numMeshes);
+        std::vector<uint8_t> storage;
+        size_t reportedPosition = 0;
+        for(int32_t meshIdx = 0; meshIdx < numMeshes; meshIdx++)
+        {
+            reportReadProgress(stream, reportedPosition);
+            if(AsyncLoadTask::isCancelled())
+            {
+                return false;
+            }
+
+            MeshEntry& mesh = meshEntries[meshIdx];
+            Vao::BufferVec& pVBs = meshVBs[meshIdx];
+            pVBs.resize(mesh.vertexBuffers.size());
+
+            // LODs are only generated for meshes which have none in the file
+            bool fileHasLods = false;
+            for(const SubmeshEntry& submesh : mesh.submeshes)
+            {
+                fileHasLods = fileHasLods || submesh.lods.size();
+            }
+            const bool generateMeshLods = generateLods && fileHasLods == false && mesh.positionBufferIndex != kInvalidOffset;
+            std::vector<std::vector<MeshSimplifier::Lod>> generatedLods(mesh.submeshes.size());
+            const bool buildMeshMeshlets = buildMeshlets && mesh.positionBufferIndex != kInvalidOffset;
+            std::vector<std::vector<Meshlet>> generatedMeshlets(mesh.submeshes.size());
+
+            // The welding, the optimizer, the simplifier, the meshlet builder and the compression read or rewrite the data, and the pool needs all of it at once, so those meshes are copied out of the file instead of being created straight from it
+            const bool optimizeMesh = optimizeMeshes && mesh.positionBufferIndex != kInvalidOffset;
+            const bool copyMesh = optimizeMesh || generateMeshLods || buildMeshMeshlets || compressVertices || pGeometryPool || deduplicate;
+            std::vector<std::vector<uint8_t>> vbCopies(mesh.vertexBuffers.size());
+            std::vector<uint32_t> meshIndices;
+            std::vector<uint32_t> vertexRemap;
+            if(copyMesh)
+            {
+                std::vector<uint32_t> submeshIndexCounts;
+                for(uint32_t vbIndex = 0; vbIndex < (uint32_t)mesh.vertexBuffers.size(); vbIndex++)
+                {
+                    const VertexBufferEntry& vb = mesh.vertexBuffers[vbIndex];
+                    const size_t size = (size_t)vb.stride * mesh.vertexCount;
+                    stream.setPosition((size_t)vb.dataOffset);
+                    const uint8_t* pData = readPersistent(stream, size, storage);
+                    if(pData == nullptr)
+                    {
+                        logError(truncatedMsg);
+                        return false;
+                    }
+                    vbCopies[vbIndex].assign(pData, pData + size);
+                }
+
+                for(const SubmeshEntry& submesh : mesh.submeshes)
+                {
+                    stream.setPosition((size_t)submesh.indexDataOffset);
+                    const uint32_t* indices = (const uint32_t*)readPersistent(stream, submesh.indexCount * sizeof(uint32_t), storage);
+                    if(indices == nullptr)
+                    {
+                        logError(truncatedMsg);
+                        return false;
+                    }
+                    meshIndices.insert(meshIndices.end(), indices, indices + submesh.indexCount);
+                    submeshIndexCounts.push_back(submesh.indexCount);
+                }
+
+                // Weld before the optimizer, so that it orders the merged vertices
+                if(deduplicate)
+                {
+                    std::vector<uint8_t*> vbData(vbCopies.size());
+                    std::vector<uint32_t> strides(vbCopies.size());
+                    for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                    {
+                        vbData[vbIndex] = vbCopies[vbIndex].data();
+                        strides[vbIndex] = mesh.vertexBuffers[vbIndex].stride;
+                    }
+                    uint32_t weldedVertexCount;
+                    vertexRemap = MeshDeduplicator::weldVertices(vbData, strides, mesh.vertexCount, meshIndices.data(), (uint32_t)meshIndices.size(), weldedVertexCount);
+                    if(vertexRemap.size())
+                    {
+                        mesh.vertexCount = (int32_t)weldedVertexCount;
+                        for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                        {
+                            vbCopies[vbIndex].resize((size_t)strides[vbIndex] * mesh.vertexCount);
+                        }
+                    }
+                }
+
+                if(optimizeMesh)
+                {
+                    const VertexBufferEntry& positionVB = mesh.vertexBuffers[mesh.positionBufferIndex];
+                    const float* pPositions = (const float*)(vbCopies[mesh.positionBufferIndex].data() + mesh.positionOffset);
+                    std::vector<uint32_t> optimizerRemap = MeshOptimizer::optimizeMesh(meshIndices, submeshIndexCounts, mesh.vertexCount, pPositions, positionVB.stride, optimizerStats);
+                    if(optimizerRemap.size())
+                    {
+                        for(uint32_t vbIndex = 0; vbIndex < (uint32_t)mesh.vertexBuffers.size(); vbIndex++)
+                        {
+                            MeshOptimizer::remapVertices(vbCopies[vbIndex].data(), mesh.vertexBuffers[vbIndex].stride, mesh.vertexCount, optimizerRemap);
+                        }
+
+                        // The file's vertex numbers go through the welding first
+                        if(vertexRemap.size())
+                        {
+                            for(uint32_t& v : vertexRemap)
+                            {
+                                v = optimizerRemap[v];
+                            }
+                        }
+                        else
+                        {
+                            vertexRemap = std::move(optimizerRemap);
+                        }
+                    }
+                }
+
+                // The LODs index the optimized vertices, and are generated before the compression changes the positions
+                if(generateMeshLods)
+                {
+                    std::vector<const uint8_t*> vbData(vbCopies.size());
+                    for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                    {
+                        vbData[vbIndex] = vbCopies[vbIndex].data();
+                    }
+                    uint32_t offset = 0;
+                    for(size_t i = 0; i < mesh.submeshes.size(); i++)
+                    {
+                        generatedLods[i] = MeshSimplifier::generateLodChain(mesh.pLayout.get(), vbData, mesh.vertexCount, meshIndices.data() + offset, mesh.submeshes[i].indexCount);
+                        offset += mesh.submeshes[i].indexCount;
+                    }
+                }
+
+                if(buildMeshMeshlets)
+                {
+                    std::vector<const uint8_t*> vbData(vbCopies.size());
+                    for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                    {
+                        vbData[vbIndex] = vbCopies[vbIndex].data();
+                    }
+                    uint32_t offset = 0;
+                    for(size_t i = 0; i < mesh.submeshes.size(); i++)
+                    {
+                        generatedMeshlets[i] = MeshletBuilder::build(mesh.pLayout.get(), vbData, mesh.vertexCount, meshIndices.data() + offset, mesh.submeshes[i].indexCount);
+                        offset += mesh.submeshes[i].indexCount;
+                    }
+                }
+            }
+
+            for(uint32_t vbIndex = 0; vbIndex < (uint32_t)mesh.vertexBuffers.size(); vbIndex++)
+            {
+                const VertexBufferEntry& vb = mesh.vertexBuffers[vbIndex];
+                const size_t size = (size_t)vb.stride * mesh.vertexCount;
+                const uint8_t* pData = vbCopies[vbIndex].data();
+                if(copyMesh == false)
+                {
+                    stream.setPosition((size_t)vb.dataOffset);
+                    pData = readPersistent(stream, size, storage);
+                    if(pData == nullptr)
+                    {
+                        logError(truncatedMsg);
+                        return false;
+                    }
+                    pVBs[vbIndex] = createBuffer(size, Buffer::BindFlags::Vertex, pData);
+                }
+
+                if(keepCpuGeometry && vbIndex == mesh.positionBufferIndex)
+                {
+                    std::vector<glm::vec3>& positions = meshPositions[meshIdx];
+                    positions.resize(mesh.vertexCount);
+                    for(int32_t i = 0; i < mesh.vertexCount; i++)
+                    {
+                        positions[i] = *(const glm::vec3*)(pData + (size_t)vb.stride * i + mesh.positionOffset);
+                    }
+                }
+            }
+
+            if(copyMesh)
+            {
+                if(compressVertices)
+                {
+                    std::vector<const uint8_t*> vbData(vbCopies.size());
+                    for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                    {
+                        vbData[vbIndex] = vbCopies[vbIndex].data();
+                    }
+                    VertexCompression::Result compressed = VertexCompression::compressVertices(mesh.pLayout.get(), vbData, mesh.vertexCount, quantizePositions);
+                    vbCopies = std::move(compressed.buffers);
+                    mesh.pLayout = compressed.pLayout;
+                    mesh.positionScale = compressed.positionScale;
+                    mesh.positionBias = compressed.positionBias;
+                }
+            }
+
+            // Meshes read straight from the file create their index buffers right away. The others keep the final indices until the vertex buffers exist.
+            std::vector<std::vector<uint32_t>> finalIndices(mesh.submeshes.size());
+            uint32_t indexOffset = 0;
+            for(size_t submeshIdx = 0; submeshIdx < mesh.submeshes.size(); submeshIdx++)
+            {
+                const SubmeshEntry& submesh = mesh.submeshes[submeshIdx];
+                const uint32_t* indices = meshIndices.data() + indexOffset;
+                indexOffset += submesh.indexCount;
+                if(copyMesh == false)
+                {
+                    stream.setPosition((size_t)submesh.indexDataOffset);
+                    indices = (const uint32_t*)readPersistent(stream, submesh.indexCount * sizeof(uint32_t), storage);
+                }
+                if(indices == nullptr)
+                {
+                    logError(truncatedMsg);
+                    return false;
+                }
+
+                PendingSubmesh pending;
+                pending.meshlets = std::move(generatedMeshlets[submeshIdx]);
+                if(meshPositions[meshIdx].size())
+                {
+                    pending.cpuIndices.assign(indices, indices + submesh.indexCount);
+                }
+
+                // The LODs go into the submesh's index buffer, after the full detail indices
+                uint32_t indexCount = submesh.indexCount;
+                std::vector<uint32_t> lodIndices;
+                if(submesh.lods.size() || generatedLods[submeshIdx].size())
+                {
+                    lodIndices.assign(indices, indices + submesh.indexCount);
+                    for(const LodEntry& lod : submesh.lods)
+                    {
+                        stream.setPosition((size_t)lod.indexDataOffset);
+                        const uint32_t* pLodIndices = (const uint32_t*)readPersistent(stream, lod.indexCount * sizeof(uint32_t), storage);
+                        if(pLodIndices == nullptr)
+                        {
+                            logError(truncatedMsg);
+                            return false;
+                        }
+                        pending.lods.push_back({ (uint32_t)lodIndices.size(), (uint32_t)lod.indexCount, lod.error });
+                        lodIndices.insert(lodIndices.end(), pLodIndices, pLodIndices + lod.indexCount);
+
+                        // The file's LODs index the vertices before the optimizer renumbered them
+                        if(vertexRemap.size())
+                        {
+                            for(size_t i = lodIndices.size() - lod.indexCount; i < lodIndices.size(); i++)
+                            {
+                                lodIndices[i] = lodIndices[i] < vertexRemap.size() ? vertexRemap[lodIndices[i]] : lodIndices[i];
+                            }
+                        }
+                    }
+                    for(const MeshSimplifier::Lod& lod : generatedLods[submeshIdx])
+                    {
+                        pending.lods.push_back({ (uint32_t)lodIndices.size(), (uint32_t)lod.indices.size(), lod.error });
+                        lodIndices.insert(lodIndices.end(), lod.indices.begin(), lod.indices.end());
+                    }
+                    indices = lodIndices.data();
+                    indexCount = (uint32_t)lodIndices.size();
+                }
+
+                if(copyMesh)
+                {
+                    finalIndices[submeshIdx] = lodIndices.size() ? std::move(lodIndices) : std::vector<uint32_t>(indices, indices + indexCount);
+                }
+                else
+                {
+                    pending.pIB = createBuffer(indexCount * sizeof(uint32_t), Buffer::BindFlags::Index, indices);
+                }
+                pendingSubmeshes[meshIdx].push_back(std::move(pending));
+            }
+
+            if(copyMesh == false)
+            {
+                continue;
+            }
+
+            // Submeshes identical to earlier ones, of this model or of another, are created from the earlier mesh. The key covers the final data and the load flags which only change how the buffers are created.
+            bool allDuplicates = false;
+            if(deduplicate)
+            {
+                MeshDeduplicator::Hasher vertexHasher;
+                vertexHasher.add(flags);
+                vertexHasher.add(mesh.pLayout.get());
+                for(const std::vector<uint8_t>& vbCopy : vbCopies)
+                {
+                    vertexHasher.add(vbCopy.data(), vbCopy.size());
+                }
+                vertexHasher.add(&mesh.positionScale, sizeof(mesh.positionScale));
+                vertexHasher.add(&mesh.positionBias, sizeof(mesh.positionBias));
+
+                allDuplicates = true;
+                for(size_t submeshIdx = 0; submeshIdx < mesh.submeshes.size(); submeshIdx++)
+                {
+                    PendingSubmesh& pending = pendingSubmeshes[meshIdx][submeshIdx];
+                    MeshDeduplicator::Hasher hasher = vertexHasher;
+                    hasher.add(finalIndices[submeshIdx].data(), finalIndices[submeshIdx].size() * sizeof(uint32_t));
+                    hasher.add(pending.lods.data(), pending.lods.size() * sizeof(Mesh::Lod));
+                    pending.geometryKey = hasher.getKey();
+                    pending.pGeometry = MeshDeduplicator::findGeometry(pending.geometryKey);
+                    const bool importedBefore = importedKeys.insert(pending.geometryKey).second == false;
+                    pending.isDuplicate = importedBefore || pending.pGeometry;
+                    allDuplicates = allDuplicates && pending.isDuplicate;
+                }
+            }
+
+            if(allDuplicates)
+            {
+                continue;
+            }
+
+            uint32_t vertexBlock = 0;
+            if(pGeometryPool)
+            {
+                std::vector<const uint8_t*> vbData(vbCopies.size());
+                for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                {
+                    vbData[vbIndex] = vbCopies[vbIndex].size() ? vbCopies[vbIndex].data() : nullptr;
+                }
+                vertexBlock = pGeometryPool->addVertices(mesh.pLayout, vbData, mesh.vertexCount, Vao::Topology::TriangleList);
+            }
+            else
+            {
+                for(uint32_t vbIndex = 0; vbIndex < (uint32_t)vbCopies.size(); vbIndex++)
+                {
+                    pVBs[vbIndex] = createBuffer(vbCopies[vbIndex].size(), Buffer::BindFlags::Vertex, vbCopies[vbIndex].data());
+                }
+            }
+
+            for(size_t submeshIdx = 0; submeshIdx < mesh.submeshes.size(); submeshIdx++)
+            {
+                PendingSubmesh& pending = pendingSubmeshes[meshIdx][submeshIdx];
+                if(pending.isDuplicate)
+                {
+                    continue;
+                }
+                const std::vector<uint32_t>& indices = finalIndices[submeshIdx];
+                if(pGeometryPool)
+                {
+                    pending.poolRange = pGeometryPool->addIndices(vertexBlock, indices.data(), (uint32_t)indices.size());
+                }
+                else
+                {
+                    pending.pIB = createBuffer(indices.size() * sizeof(uint32_t), Buffer::BindFlags::Index, indices.data());
+                }
+            }
+        }
+        if(pGeometryPool)
+        {
+            pGeometryPool->createBuffers();
+        }
+        timings.meshData = CpuTimer::calcDuration(stageStart, CpuTimer::getCurrentTimePoint());
+
+        // Create the textures, materials and meshes. The decoder threads never create resources; async loads hand them to the main thread.
+        textureDecoder.wait();
+        stageStart = CpuTimer::getCurrentTimePoint();
+        MaterialTextureMap textures;
+        bool loadTexAsSrgb = !is_set(flags, Model::LoadFlags::AssumeLinearSpaceTextures);
+        std::vector<Material::SharedPtr> materials(numMaterials);
+        for(int32_t materialID = 0; materialID < numMaterials; materialID++)
+        {
+            const MaterialEntry& entry = materialEntries[materialID];
+            BasicMaterial basicMaterial;
+            basicMaterial.diffuseColor = glm::vec3(entry.diffuse);
+            basicMaterial.opacity = entry.diffuse.w;
+            basicMaterial.specularColor = entry.specular;
+            basicMaterial.shininess = entry.glossiness;
+            basicMaterial.bumpScale = entry.displacementCoeff;
+            basicMaterial.bumpOffset = entry.displacementBias;
+
+            for(int32_t i = 0; i < TextureType_Max; i++)
+            {
+                BasicMaterial::MapType falcorType = getFalcorMapType(TextureType(i));
+                if(entry.textures[i] != -1 && falcorType != BasicMaterial::MapType::Count)
+                {
+                    basicMaterial.pTextures[falcorType] = getMaterialTexture(texData[entry.textures[i]], falcorType, loadTexAsSrgb, textures);
+                }
+            }
+            materials[materialID] = checkForExistingMaterial(basicMaterial.convertToMaterial());
+        }
+
+        std::vector<std::vector<Mesh::SharedPtr>> meshes(numMeshes);
+        for(int32_t meshIdx = 0; meshIdx < numMeshes; meshIdx++)
+        {
+            if(AsyncLoadTask::isCancelled())
+            {
+                return false;
+            }
+
+            const MeshEntry& mesh = meshEntries[meshIdx];
+            for(size_t i = 0; i < mesh.submeshes.size(); i++)
+            {
+                const SubmeshEntry& submesh = mesh.submeshes[i];
+                PendingSubmesh& pending = pendingSubmeshes[meshIdx][i];
+                BoundingBox box = BoundingBox::fromMinMax(submesh.aabbMin, submesh.aabbMax);
+                Mesh::SharedPtr pMesh;
+                if(pending.isDuplicate)
+                {
+                    // Identical submeshes of this model were created earlier in this loop, otherwise pGeometry is another model's mesh
+                    pMesh = MeshDeduplicator::instantiate(pending.pGeometry, pending.geometryKey, materials[submesh.materialID], modelMeshes);
+                    meshes[meshIdx].push_back(pMesh);
+                    continue;
+                }
+
+                uint32_t startIndex = 0;
+                if(pGeometryPool)
+                {
+                    const GeometryPool::Range& range = pGeometryPool->getRange(pending.poolRange);
+                    startIndex = range.startIndex;
+                    pMesh = createMesh(range, mesh.vertexCount, submesh.indexCount, materials[submesh.materialID], box);
+                }
+                else
+                {
+                    pMesh = createMesh(meshVBs[meshIdx], mesh.vertexCount, pending.pIB, submesh.indexCount, mesh.pLayout, materials[submesh.materialID], box);
+                }
+                for(const Mesh::Lod& lod : pending.lods)
+                {
+                    pMesh->addLod(startIndex + lod.startIndex, lod.indexCount, lod.error);
+                }
+                for(Meshlet& meshlet : pending.meshlets)
+                {
+                    meshlet.startIndex += startIndex;
+                }
+                pMesh->setMeshlets(std::move(pending.meshlets));
+                pMesh->setPositionDequantization(mesh.positionScale, mesh.positionBias);
+
+                if(pending.cpuIndices.size())
+                {
+                    pMesh->setCpuGeometry(meshPositions[meshIdx], std::move(pending.cpuIndices));
+                }
+                if(deduplicate)
+                {
+                    MeshDeduplicator::registerMesh(pending.geometryKey, pMesh, modelMeshes);
+                }
+                meshes[meshIdx].push_back(pMesh);
+            }
+        }
+        timings.objectCreation = CpuTimer::calcDuration(stageStart, CpuTimer::getCurrentTimePoint());
+
+        for(const InstanceEntry& instance : instanceEntries)
+        {
+            if(instance.enabled && instance.meshIdx != -1)
+            {
+                for(const auto& pMesh : meshes[instance.meshIdx])
+                {
+                    model.addMeshInstance(pMesh, instance.transformation);
+                }
+            }
+        }
+
+        reportReadProgress(stream, reportedPosition);
+        logImportTimings(mModelName, timings);
+        if(optimizeMeshes)
+        {
+            MeshOptimizer::logStatistics(mModelName, optimizerStats);
+        }
+        if(pGeometryPool)
+        {
+            GeometryPool::logStatistics(mModelName, pGeometryPool->getStatistics());
         }
-        
         return true;
     }
 }
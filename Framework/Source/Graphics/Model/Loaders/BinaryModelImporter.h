@@ -39,19 +39,30 @@ namespace Falcor
     class BinaryModelImporter : public ModelImporter
     {
     public:
+        /** How the importer reads the file
+        */
+        enum class InputMode
+        {
+            MemoryMapped,   ///< Map the file into memory. Index and texture data is uploaded straight from the mapping. Falls back to Stream if the file can't be mapped.
+            Stream          ///< Read the file through a BinaryFileStream, copying the data into intermediate buffers
+        };
+
         /** import a new model from internal binary format
             \param[in] filename Model's filename. Loader will look for it in the data directories.
             \param[in] flags Flags controlling model creation
+            \param[in] inputMode How to read the file
             returns nullptr if loading failed, otherwise a new Model object
         */
-        static bool import(Model& model, const std::string& filename, Model::LoadFlags flags);
+        static bool import(Model& model, const std::string& filename, Model::LoadFlags flags, InputMode inputMode = InputMode::MemoryMapped);
 
     private:
         BinaryModelImporter(const std::string& fullpath);
-        bool importModel(Model& model, Model::LoadFlags flags);
+        template<typename StreamType>
+        bool importModel(StreamType& stream, Model& model, Model::LoadFlags flags);
+        template<typename StreamType>
+        bool importModelV9(StreamType& stream, Model& model, Model::LoadFlags flags, uint32_t version);   // Versions 9 and 10
 
         std::string mModelName;
-        BinaryFileStream mStream;
 
         struct TangentSpace
         {
@@ -30,8 +30,8 @@
 //------------------------------------------------------------------------
 /*
 
-Binary scene file format v8
----------------------------
+Binary scene file format v10
+----------------------------
 
 - The basic units of data are 32-bit little-endian ints and floats.
 - In addition to the latest version, the below specification also describes previous versions of the file format.
@@ -40,13 +40,32 @@ Binary scene file format v8
 - Each line describes: <ofs_dwords> <size_dwords> <Type> <version> <name> (<comments>)
 
 File
+0       2       string8 v9  formatID            ("BinScene")
+2       1       int     v9  formatVersion       (9 .. 10)
+3       1       int     v9  numTextures
+4       1       int     v9  numMaterials
+5       1       int     v9  numMeshes
+6       1       int     v9  numInstances
+7       n*4     array   v9  TextureEntry        (numTextures)
+?       n*17    array   v9  Material            (numMaterials)
+?       n*?     array   v9  MeshEntry           (numMeshes)
+?       n*?     array   v9  Instance            (numInstances)
+?       ?       bytes   v9  blobs               (texture, vertex and index data, referenced by offset from the entries above)
+?
+
+- v9 stores meshes the way they are uploaded to the GPU. The importer creates the buffers straight from the blobs.
+  It doesn't generate tangents or compute bounding boxes. The exporter writes the mesh's bitangent buffer, if it has one.
+- Offsets are 64-bit and count from the start of the file. Every blob starts at a multiple of 16 bytes.
+- v10 adds levels of detail to the submeshes. A LOD is a simplified triangle list using the submesh's vertices.
+
+File_v8
 0       2       string8 v6  formatID            ("BinScene")
-2       1       int     v6  formatVersion       (6)
+2       1       int     v6  formatVersion       (6 .. 8)
 3       1       int     v6  numTextures
 4       1       int     v6  numMeshes
 5       1       int     v6  numInstances
 6       n*?     array   v6  Texture             (numTextures)
-?       n*?     array   v6  Mesh                (numMeshes)
+?       n*?     array   v6  Mesh_v8             (numMeshes)
 ?       n*?     array   v6  Instance            (numInstances)
 ?
 
@@ -57,10 +76,10 @@ File_v5
 4       1       int     v1  numVertices
 5       1       int     v2  numTextures
 6       1       int     v1  numSubmeshes
-7       n*3     array   v1  AttribSpec          (numAttribs)
-?       n*?     array   v1  Vertex              (numVertices)
+7       n*3     array   v1  AttribSpec_v8       (numAttribs)
+?       n*?     array   v1  Vertex_v8           (numVertices)
 ?       n*?     array   v2  Texture             (numTextures)
-?       n*?     array   v1  Submesh             (numSubmeshes)
+?       n*?     array   v1  Submesh_v8          (numSubmeshes)
 ?
 
 Texture
@@ -69,26 +88,78 @@ Texture
 ?       ?       struct  v2  BinaryImage         (see ImageBinaryIO.hpp)
 ?
 
-Mesh
+TextureEntry
+0       2       int64   v9  offset              (a Texture struct)
+2       2       int64   v9  size
+4
+
+Material
+0       4       float   v9  diffuse             (rgb, opacity)
+4       3       float   v9  specular
+7       1       float   v9  glossiness
+8       1       float   v9  displacementCoef
+9       1       float   v9  displacementBias
+10      7       int     v9  textures            (TextureType_Max, -1 if none)
+17
+
+MeshEntry
+0       1       int     v9  numVertexBuffers
+1       1       int     v9  numVertices
+2       1       int     v9  numSubmeshes
+3       n*?     array   v9  VertexBuffer        (numVertexBuffers)
+?       n*?     array   v9  Submesh             (numSubmeshes)
+?
+
+VertexBuffer
+0       1       int     v9  numElements
+1       1       int     v9  stride              (bytes)
+2       2       int64   v9  dataOffset          (numVertices * stride bytes)
+4       n*4     array   v9  Element             (numElements)
+?
+
+Element
+0       1       int     v9  Type                (see AttribType)
+1       1       int     v9  format              (see AttribFormat)
+2       1       int     v9  length
+3       1       int     v9  offset              (bytes from the start of the vertex)
+4
+
+Submesh
+0       1       int     v9  materialIdx
+1       1       int     v9  numIndices
+2       2       int64   v9  indexDataOffset     (numIndices 32-bit indices)
+4       3       float   v9  aabbMin
+7       3       float   v9  aabbMax
+10      1       int     v10 numLods             (not counting the full detail triangle list)
+11      n*4     array   v10 Lod                 (numLods, coarsest last)
+?
+
+Lod
+0       1       int     v10 numIndices
+1       2       int64   v10 indexDataOffset     (numIndices 32-bit indices)
+3       1       float   v10 error               (estimated distance to the full detail surface, in object space)
+4
+
+Mesh_v8
 0       1       int     v6  numAttribs
 1       1       int     v6  numVertices
 2       1       int     v6  numSubmeshes
-3       n*3     array   v6  AttribSpec          (numAttribs)
-?       n*?     array   v6  Vertex              (numVertices)
-?       n*?     array   v6  Submesh             (numSubmeshes)
+3       n*3     array   v6  AttribSpec_v8       (numAttribs)
+?       n*?     array   v6  Vertex_v8           (numVertices)
+?       n*?     array   v6  Submesh_v8          (numSubmeshes)
 ?
 
-AttribSpec
+AttribSpec_v8
 0       1       int     v1  Type                (see MeshBase::AttribType)
 1       1       int     v1  format              (see MeshBase::AttribFormat)
 2       1       int     v1  length
 3
 
-Vertex
+Vertex_v8
 0       ?       bytes   v1  vertex data         (dictated by the AttribSpecs)
 ?
 
-Submesh
+Submesh_v8
 0       3       float   v1  ambient             (ignored)
 3       4       float   v1  diffuse
 7       3       float   v1  specular
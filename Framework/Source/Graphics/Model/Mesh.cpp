@@ -28,6 +28,7 @@
 #include "Framework.h"
 #include "Mesh.h"
 #include "Model.h"
+#include "MeshDeduplicator.h"
 #include "Externals/Assimp/Include/mesh.h"
 #include "glm/common.hpp"
 #include "glm/glm.hpp"
@@ -39,7 +40,7 @@
 
 namespace Falcor
 { 
-    uint32_t Mesh::sMeshCounter = 0;
+    std::atomic<uint32_t> Mesh::sMeshCounter(0);
     Mesh::~Mesh() = default;
 
     Mesh::SharedPtr Mesh::create(const Vao::BufferVec& vertexBuffers,
@@ -52,27 +53,50 @@ namespace Falcor
         const BoundingBox& boundingBox,
         bool hasBones)
     {
-        return SharedPtr(new Mesh(vertexBuffers, vertexCount, pIndexBuffer, indexCount, pLayout, topology, pMaterial, boundingBox, hasBones));
+        Vao::SharedPtr pVao = Vao::create(vertexBuffers, pLayout, pIndexBuffer, ResourceFormat::R32Uint, topology);
+        return SharedPtr(new Mesh(pVao, vertexCount, 0, indexCount, 0, pMaterial, boundingBox, hasBones));
     }
 
-    Mesh::Mesh(const Vao::BufferVec& vertexBuffers,
+    Mesh::SharedPtr Mesh::create(const Vao::SharedPtr& pVao,
         uint32_t vertexCount,
-        const Buffer::SharedPtr& pIndexBuffer,
+        uint32_t startIndex,
         uint32_t indexCount,
-        const VertexLayout::SharedPtr& pLayout,
-        Vao::Topology topology,
+        int32_t baseVertex,
+        const Material::SharedPtr& pMaterial,
+        const BoundingBox& boundingBox,
+        bool hasBones)
+    {
+        return SharedPtr(new Mesh(pVao, vertexCount, startIndex, indexCount, baseVertex, pMaterial, boundingBox, hasBones));
+    }
+
+    Mesh::SharedPtr Mesh::create(const SharedPtr& pGeometry, const Material::SharedPtr& pMaterial)
+    {
+        SharedPtr pMesh = SharedPtr(new Mesh(*pGeometry));
+        pMesh->mId = sMeshCounter++;
+        pMesh->mpMaterial = pMaterial;
+        return pMesh;
+    }
+
+    Mesh::Mesh(const Vao::SharedPtr& pVao,
+        uint32_t vertexCount,
+        uint32_t startIndex,
+        uint32_t indexCount,
+        int32_t baseVertex,
         const Material::SharedPtr& pMaterial,
         const BoundingBox& boundingBox,
         bool hasBones) 
         : mId(sMeshCounter++)
         , mIndexCount(indexCount)
+        , mStartIndex(startIndex)
+        , mBaseVertex(baseVertex)
         , mVertexCount(vertexCount)
         , mpMaterial(pMaterial)
         , mBoundingBox(boundingBox)
         , mHasBones(hasBones)
+        , mpVao(pVao)
     {
         uint32_t VertsPerPrim;
-        switch(topology)
+        switch(pVao->getPrimitiveTopology())
         {
         case Vao::Topology::PointList:
             VertsPerPrim = 1;
@@ -88,13 +112,35 @@ namespace Falcor
         }
 
         mPrimitiveCount = mIndexCount / VertsPerPrim;
+        mLods.push_back({ startIndex, indexCount, 0 });
 
-        mpVao = Vao::create(vertexBuffers, pLayout, pIndexBuffer, ResourceFormat::R32Uint, topology);
+        // The layout is complete once the Vao is created, so the variant is computed once instead of when sorting the draws
+        mProgramVariant = pVao->getVertexLayout()->getProgramVariant();
     }
 
     void Mesh::resetGlobalIdCounter()
     {
         sMeshCounter = 0;
         Material::resetGlobalIdCounter();
+
+        // The meshes of earlier scenes are never reused once the IDs restart
+        MeshDeduplicator::clearRegistry();
+    }
+
+    const BoundingVolumeHierarchy* Mesh::getTriangleBvh() const
+    {
+        if (mpTriangleBvh == nullptr && hasCpuGeometry())
+        {
+            std::vector<BoundingBox> triangleBoxes(mCpuIndices.size() / 3);
+            for (size_t i = 0; i < triangleBoxes.size(); i++)
+            {
+                const glm::vec3& p0 = mCpuPositions[mCpuIndices[i * 3 + 0]];
+                const glm::vec3& p1 = mCpuPositions[mCpuIndices[i * 3 + 1]];
+                const glm::vec3& p2 = mCpuPositions[mCpuIndices[i * 3 + 2]];
+                triangleBoxes[i] = BoundingBox::fromMinMax(glm::min(p0, glm::min(p1, p2)), glm::max(p0, glm::max(p1, p2)));
+            }
+            mpTriangleBvh = BoundingVolumeHierarchy::create(triangleBoxes);
+        }
+        return mpTriangleBvh.get();
     }
 }
@@ -33,8 +33,10 @@
 #include "API/VAO.h"
 #include "API/RenderContext.h"
 #include "utils/AABB.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
 #include "Graphics/Material/Material.h"
 #include "Graphics/Paths/MovableObject.h"
+#include "Graphics/Model/MeshletBuilder.h"
 
 namespace Falcor
 {
@@ -76,6 +78,31 @@ namespace Falcor
             const BoundingBox& boundingBox,
             bool hasBones);
 
+        /** create a mesh drawing a range of a shared Vao, as allocated by GeometryPool
+            \param[in] pVao The Vao holding the mesh's vertices and indices
+            \param[in] vertexCount Number of vertices used by the mesh
+            \param[in] startIndex Location of the mesh's first index in the index buffer
+            \param[in] indexCount Number of indices of the mesh
+            \param[in] baseVertex Value added to each index before reading the vertex buffers
+            \param[in] pMaterial The material of the mesh
+            \param[in] boundingBox The mesh's axis-aligned bounding-box
+            \param[in] hasBones Indicates the the mesh uses bones for animation
+        */
+        static SharedPtr create(const Vao::SharedPtr& pVao,
+            uint32_t vertexCount,
+            uint32_t startIndex,
+            uint32_t indexCount,
+            int32_t baseVertex,
+            const Material::SharedPtr& pMaterial,
+            const BoundingBox& boundingBox,
+            bool hasBones);
+
+        /** create a mesh drawing the geometry of another mesh with a different material. The meshes share their Vao, and the new one copies the LODs, meshlets and CPU geometry.
+            \param[in] pGeometry The mesh whose geometry to draw
+            \param[in] pMaterial The material of the new mesh
+        */
+        static SharedPtr create(const SharedPtr& pGeometry, const Material::SharedPtr& pMaterial);
+
         /** Destructor
         */
         ~Mesh();
@@ -96,6 +123,14 @@ namespace Falcor
         */
         uint32_t getIndexCount() const { return mIndexCount; }
 
+        /** Get the location of the first index in the index buffer. Non-zero only for meshes sharing their Vao.
+        */
+        uint32_t getStartIndex() const { return mStartIndex; }
+
+        /** Get the value added to each index before reading the vertex buffers. Non-zero only for meshes sharing their Vao.
+        */
+        int32_t getBaseVertex() const { return mBaseVertex; }
+
         /** Get a pointer to the mesh's material
         */
         const Material::SharedPtr& getMaterial() const { return mpMaterial; }
@@ -112,6 +147,79 @@ namespace Falcor
         */
         const Vao::SharedPtr& getVao() const { return mpVao; }
 
+        /** Get the program variant of the mesh's vertex layout, see VertexLayout::getProgramVariant()
+        */
+        uint32_t getProgramVariant() const { return mProgramVariant; }
+
+        /** Attach a CPU copy of the mesh's triangles. Importers do this when loading a model with Model::LoadFlags::KeepCpuGeometry.
+            \param[in] positions Object-space vertex positions
+            \param[in] indices Triangle list indices
+        */
+        void setCpuGeometry(std::vector<glm::vec3> positions, std::vector<uint32_t> indices) { mCpuPositions = std::move(positions); mCpuIndices = std::move(indices); mpTriangleBvh = nullptr; }
+
+        /** Set how the shaders decode the vertex positions. Importers do this when loading a model with Model::LoadFlags::QuantizePositions.
+            \param[in] scale Scale applied to the positions stored in the vertex buffer
+            \param[in] bias Bias added to the positions after scaling
+        */
+        void setPositionDequantization(const glm::vec3& scale, const glm::vec3& bias) { mPositionScale = scale; mPositionBias = bias; }
+
+        /** Get the scale applied to the vertex buffer positions. One unless the positions are quantized.
+        */
+        const glm::vec3& getPositionScale() const { return mPositionScale; }
+
+        /** Get the bias added to the vertex buffer positions after scaling. Zero unless the positions are quantized.
+        */
+        const glm::vec3& getPositionBias() const { return mPositionBias; }
+
+        /** A level of detail. The LODs of a mesh share its Vao and base vertex, and draw different ranges of its index buffer.
+        */
+        struct Lod
+        {
+            uint32_t startIndex;
+            uint32_t indexCount;
+            float error;            ///< Estimated distance between the LOD's surface and the full detail mesh, in object space
+        };
+
+        /** Add a coarser level of detail. Importers do this when the model has LODs, see Model::LoadFlags::GenerateLods.
+            \param[in] startIndex Location of the LOD's first index in the mesh's index buffer
+            \param[in] indexCount Number of indices of the LOD
+            \param[in] error Estimated distance between the LOD's surface and the full detail mesh, in object space. Must not be smaller than the error of the previous LOD.
+        */
+        void addLod(uint32_t startIndex, uint32_t indexCount, float error) { mLods.push_back({ startIndex, indexCount, error }); }
+
+        /** Get the number of levels of detail, including the full detail mesh
+        */
+        uint32_t getLodCount() const { return (uint32_t)mLods.size(); }
+
+        /** Get a level of detail. LOD 0 is the full detail mesh, and the error grows with the LOD.
+        */
+        const Lod& getLod(uint32_t lod) const { return mLods[lod]; }
+
+        /** Set the meshlets of the full detail LOD. They must cover its index range in order. See Model::LoadFlags::BuildMeshlets.
+        */
+        void setMeshlets(std::vector<Meshlet> meshlets) { mMeshlets = std::move(meshlets); }
+
+        /** Get the meshlets of the full detail LOD. Their start indices are locations in the mesh's index buffer. Empty if the mesh wasn't split.
+        */
+        const std::vector<Meshlet>& getMeshlets() const { return mMeshlets; }
+
+        /** Check if the mesh has a CPU copy of its triangles
+        */
+        bool hasCpuGeometry() const { return mCpuIndices.empty() == false; }
+
+        /** Get the CPU copy of the vertex positions. Empty unless setCpuGeometry() was called.
+        */
+        const std::vector<glm::vec3>& getCpuPositions() const { return mCpuPositions; }
+
+        /** Get the CPU copy of the triangle list indices. Empty unless setCpuGeometry() was called.
+        */
+        const std::vector<uint32_t>& getCpuIndices() const { return mCpuIndices; }
+
+        /** Get a bounding volume hierarchy over the CPU copy of the mesh's triangles, in object space. Primitive IDs are triangle indices.\n
+            The hierarchy is built on first use. Returns nullptr if the mesh has no CPU geometry.
+        */
+        const BoundingVolumeHierarchy* getTriangleBvh() const;
+
         /** Get global mesh ID
         */
         const uint32_t getId() const { return mId; }
@@ -128,25 +236,34 @@ namespace Falcor
         friend SimpleModelImporter;
 
     private:
-        Mesh(const Vao::BufferVec& vertexBuffers,
+        Mesh(const Vao::SharedPtr& pVao,
             uint32_t vertexCount,
-            const Buffer::SharedPtr& pIndexBuffer,
+            uint32_t startIndex,
             uint32_t indexCount,
-            const VertexLayout::SharedPtr& pLayout,
-            Vao::Topology topology,
+            int32_t baseVertex,
             const Material::SharedPtr& pMaterial,
             const BoundingBox& boundingBox,
             bool hasBones);
 
-        static uint32_t sMeshCounter;
+        static std::atomic<uint32_t> sMeshCounter;
 
         uint32_t mId;
         uint32_t mIndexCount = 0;
+        uint32_t mStartIndex = 0;
+        int32_t mBaseVertex = 0;
         uint32_t mVertexCount = 0;
         uint32_t mPrimitiveCount = 0;
         bool mHasBones = false;
         Material::SharedPtr mpMaterial;
         BoundingBox mBoundingBox;
         Vao::SharedPtr mpVao;
+        uint32_t mProgramVariant = 0;
+        std::vector<Lod> mLods;
+        std::vector<Meshlet> mMeshlets;
+        glm::vec3 mPositionScale = glm::vec3(1);
+        glm::vec3 mPositionBias = glm::vec3(0);
+        std::vector<glm::vec3> mCpuPositions;
+        std::vector<uint32_t> mCpuIndices;
+        mutable BoundingVolumeHierarchy::SharedPtr mpTriangleBvh;
     };
 }
\ No newline at end of file
@@ -0,0 +1,265 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshDeduplicator.h"
+#include <unordered_map>
+#include <mutex>
+#include <cstring>
+
+namespace Falcor
+{
+    // Meshes are held weakly, so that the registry never keeps a released model's buffers alive
+    struct MeshRegistry
+    {
+        std::mutex mutex;
+        std::unordered_map<MeshDeduplicator::Key, std::vector<std::weak_ptr<Mesh>>, MeshDeduplicator::KeyHash> meshes;
+    };
+
+    static MeshRegistry& getRegistry()
+    {
+        static MeshRegistry registry;
+        return registry;
+    }
+
+    // Two independent 64-bit hashes, one FNV-1a-like and one multiply-rotate, consuming 8 bytes per step
+    static const uint64_t kPrime0 = 0x100000001b3ull;
+    static const uint64_t kPrime1 = 0x9e3779b97f4a7c15ull;
+
+    static void mixWord(MeshDeduplicator::Key& key, uint64_t word)
+    {
+        key.hash[0] = (key.hash[0] ^ word) * kPrime0;
+        key.hash[0] ^= key.hash[0] >> 32;
+        key.hash[1] = (key.hash[1] + word) * kPrime1;
+        key.hash[1] = (key.hash[1] << 31) | (key.hash[1] >> 33);
+    }
+
+    static void mixBytes(MeshDeduplicator::Key& key, const uint8_t* pBytes, size_t size)
+    {
+        size_t i = 0;
+        for(; i + 8 <= size; i += 8)
+        {
+            uint64_t word;
+            std::memcpy(&word, pBytes + i, sizeof(word));
+            mixWord(key, word);
+        }
+        for(; i < size; i++)
+        {
+            mixWord(key, pBytes[i]);
+        }
+    }
+
+    MeshDeduplicator::Hasher::Hasher()
+    {
+        mKey.hash[0] = 0xcbf29ce484222325ull;
+        mKey.hash[1] = 0x27d4eb2f165667c5ull;
+    }
+
+    void MeshDeduplicator::Hasher::add(const void* pData, size_t size)
+    {
+        // The size goes first, so that the boundaries between the parts of the data matter
+        mixWord(mKey, (uint64_t)size);
+        mixBytes(mKey, (const uint8_t*)pData, size);
+    }
+
+    void MeshDeduplicator::Hasher::add(const VertexLayout* pLayout)
+    {
+        mixWord(mKey, pLayout->getBufferCount());
+        for(size_t i = 0; i < pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+            if(pBufferLayout == nullptr)
+            {
+                mixWord(mKey, UINT64_MAX);
+                continue;
+            }
+            const uint32_t header[] = { pBufferLayout->getStride(), (uint32_t)pBufferLayout->getInputClass(), pBufferLayout->getInstanceStepRate(), pBufferLayout->getElementCount() };
+            add(header, sizeof(header));
+            for(uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+            {
+                const std::string& name = pBufferLayout->getElementName(e);
+                add(name.data(), name.size());
+                const uint32_t element[] = { pBufferLayout->getElementOffset(e), (uint32_t)pBufferLayout->getElementFormat(e), pBufferLayout->getElementArraySize(e), pBufferLayout->getElementShaderLocation(e) };
+                add(element, sizeof(element));
+            }
+        }
+    }
+
+    void MeshDeduplicator::Hasher::add(Model::LoadFlags flags)
+    {
+        const Model::LoadFlags kBufferFlags = Model::LoadFlags::BuffersAsShaderResource | Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::PoolGeometry | Model::LoadFlags::BuildMeshlets;
+        mixWord(mKey, (uint64_t)(flags & kBufferFlags));
+    }
+
+    std::vector<uint32_t> MeshDeduplicator::weldVertices(const std::vector<uint8_t*>& buffers, const std::vector<uint32_t>& strides, uint32_t vertexCount, uint32_t* pIndices, uint32_t indexCount, uint32_t& newVertexCount)
+    {
+        newVertexCount = vertexCount;
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            if(pIndices[i] >= vertexCount)
+            {
+                return std::vector<uint32_t>();
+            }
+        }
+
+        auto hashVertex = [&](uint32_t v)
+        {
+            Key key;
+            for(size_t b = 0; b < buffers.size(); b++)
+            {
+                if(buffers[b])
+                {
+                    mixBytes(key, buffers[b] + (size_t)strides[b] * v, strides[b]);
+                }
+            }
+            return key.hash[0];
+        };
+        auto isEqual = [&](uint32_t a, uint32_t b)
+        {
+            for(size_t i = 0; i < buffers.size(); i++)
+            {
+                if(buffers[i] && std::memcmp(buffers[i] + (size_t)strides[i] * a, buffers[i] + (size_t)strides[i] * b, strides[i]) != 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        };
+
+        // Open addressing table of the first vertex with each value, at least half empty
+        uint32_t tableSize = 1;
+        while(tableSize < vertexCount * 2)
+        {
+            tableSize *= 2;
+        }
+        std::vector<uint32_t> table(tableSize, UINT32_MAX);
+        std::vector<uint32_t> remap(vertexCount);
+        uint32_t uniqueCount = 0;
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            uint32_t slot = (uint32_t)hashVertex(v) & (tableSize - 1);
+            while(table[slot] != UINT32_MAX && isEqual(table[slot], v) == false)
+            {
+                slot = (slot + 1) & (tableSize - 1);
+            }
+
+            if(table[slot] == UINT32_MAX)
+            {
+                table[slot] = v;
+                remap[v] = uniqueCount++;
+            }
+            else
+            {
+                remap[v] = remap[table[slot]];
+            }
+        }
+
+        if(uniqueCount == vertexCount)
+        {
+            return std::vector<uint32_t>();
+        }
+
+        // The first vertex with each value gets the next new number. New numbers are never larger than the old ones, so compacting in order doesn't overwrite a vertex which is still needed.
+        uint32_t written = 0;
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            if(remap[v] == written)
+            {
+                for(size_t b = 0; b < buffers.size(); b++)
+                {
+                    if(buffers[b] && written != v)
+                    {
+                        std::memcpy(buffers[b] + (size_t)strides[b] * written, buffers[b] + (size_t)strides[b] * v, strides[b]);
+                    }
+                }
+                written++;
+            }
+        }
+
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            pIndices[i] = remap[pIndices[i]];
+        }
+        newVertexCount = uniqueCount;
+        return remap;
+    }
+
+    Mesh::SharedPtr MeshDeduplicator::findGeometry(const Key& key)
+    {
+        MeshRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        auto it = registry.meshes.find(key);
+        if(it == registry.meshes.end())
+        {
+            return nullptr;
+        }
+        for(const std::weak_ptr<Mesh>& pWeak : it->second)
+        {
+            Mesh::SharedPtr pMesh = pWeak.lock();
+            if(pMesh)
+            {
+                return pMesh;
+            }
+        }
+        registry.meshes.erase(it);
+        return nullptr;
+    }
+
+    Mesh::SharedPtr MeshDeduplicator::instantiate(const Mesh::SharedPtr& pGeometry, const Key& key, const Material::SharedPtr& pMaterial, ModelMeshes& modelMeshes)
+    {
+        // Only the meshes of the same model become instances of each other
+        const std::vector<Mesh::SharedPtr>& meshes = modelMeshes[key];
+        for(const Mesh::SharedPtr& pMesh : meshes)
+        {
+            const Material::SharedPtr& pMeshMaterial = pMesh->getMaterial();
+            if(pMeshMaterial == pMaterial || (pMeshMaterial && pMaterial && *pMeshMaterial == *pMaterial))
+            {
+                return pMesh;
+            }
+        }
+
+        assert(meshes.size() || pGeometry);
+        Mesh::SharedPtr pMesh = Mesh::create(meshes.size() ? meshes[0] : pGeometry, pMaterial);
+        registerMesh(key, pMesh, modelMeshes);
+        return pMesh;
+    }
+
+    void MeshDeduplicator::registerMesh(const Key& key, const Mesh::SharedPtr& pMesh, ModelMeshes& modelMeshes)
+    {
+        modelMeshes[key].push_back(pMesh);
+        MeshRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.meshes[key].push_back(pMesh);
+    }
+
+    void MeshDeduplicator::clearRegistry()
+    {
+        MeshRegistry& registry = getRegistry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.meshes.clear();
+    }
+}
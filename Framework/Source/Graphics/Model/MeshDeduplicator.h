@@ -0,0 +1,115 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <stdint.h>
+#include "API/VertexLayout.h"
+#include "Mesh.h"
+#include "Model.h"
+
+namespace Falcor
+{
+    /** Removes duplicated geometry at import time.\n
+        weldVertices() merges the vertices of a mesh whose attributes are identical byte for byte.
+        The mesh registry finds meshes identical to ones loaded earlier, by the same model or by any other model which is still alive. The importers then create a mesh sharing the earlier mesh's buffers instead of owning separate ones. Identical meshes of one model with equal materials become instances of one mesh.
+        Meshes are identified by a 128-bit hash of their final vertex and index data and of the load flags which change how their buffers are created.
+    */
+    class MeshDeduplicator
+    {
+    public:
+        /** Identifies the data of a mesh
+        */
+        struct Key
+        {
+            uint64_t hash[2] = { 0, 0 };
+            bool operator==(const Key& other) const { return hash[0] == other.hash[0] && hash[1] == other.hash[1]; }
+        };
+
+        struct KeyHash
+        {
+            size_t operator()(const Key& key) const { return (size_t)(key.hash[0] ^ key.hash[1]); }
+        };
+
+        /** The meshes created by the model being imported, by key
+        */
+        using ModelMeshes = std::unordered_map<Key, std::vector<Mesh::SharedPtr>, KeyHash>;
+
+        /** Incrementally hashes the data of a mesh into a Key
+        */
+        class Hasher
+        {
+        public:
+            Hasher();
+            void add(const void* pData, size_t size);
+            void add(const VertexLayout* pLayout);
+
+            /** Add the load flags which change how the buffers of a mesh are created but not their data, such as KeepCpuGeometry or BuildMeshlets.
+                Meshes loaded with different such flags don't match, so a model never gets a mesh lacking what its flags asked for.
+            */
+            void add(Model::LoadFlags flags);
+            const Key& getKey() const { return mKey; }
+        private:
+            Key mKey;
+        };
+
+        /** Merge identical vertices
+            \param[in,out] buffers Pointer to the data of each vertex buffer, or nullptr for unused buffers. The welded vertices are compacted to the start of the buffers.
+            \param[in] strides Distance between two vertices in each buffer, in bytes
+            \param[in] vertexCount Number of vertices
+            \param[in,out] pIndices The triangle lists of all the submeshes using the buffers, rewritten to use the new vertex numbers
+            \param[in] indexCount Number of indices
+            \param[out] newVertexCount Number of vertices after welding
+            \return For each old vertex, its new number. Empty if no vertices were merged or an index is out of range, in which case nothing was changed.
+        */
+        static std::vector<uint32_t> weldVertices(const std::vector<uint8_t*>& buffers, const std::vector<uint32_t>& strides, uint32_t vertexCount, uint32_t* pIndices, uint32_t indexCount, uint32_t& newVertexCount);
+
+        /** Find a live mesh with the given data
+            \return The mesh, or nullptr if no mesh with the key was registered or all of them were released
+        */
+        static Mesh::SharedPtr findGeometry(const Key& key);
+
+        /** Get a mesh drawing the geometry of an identical mesh with a material
+            \param[in] pGeometry A mesh with the key, as returned by findGeometry(). May be nullptr if modelMeshes has a mesh with the key.
+            \param[in] key The key of the mesh's data
+            \param[in] pMaterial The material
+            \param[in,out] modelMeshes The meshes the model being imported created so far
+            \return A mesh of the same model with the key and an equal material if there is one, so that the caller creates another instance of it. Otherwise a new mesh which shares the buffers of pGeometry.
+            Meshes of other models are never returned, since models change the materials and number the IDs of their meshes independently.
+        */
+        static Mesh::SharedPtr instantiate(const Mesh::SharedPtr& pGeometry, const Key& key, const Material::SharedPtr& pMaterial, ModelMeshes& modelMeshes);
+
+        /** Register a newly created mesh, so that later meshes with the same data reuse its buffers, and later submeshes of the same model become instances of it
+        */
+        static void registerMesh(const Key& key, const Mesh::SharedPtr& pMesh, ModelMeshes& modelMeshes);
+
+        /** Forget all the registered meshes. Meshes loaded afterwards never reuse earlier meshes. Called when Mesh::resetGlobalIdCounter() restarts the mesh IDs.
+        */
+        static void clearRegistry();
+    };
+}
@@ -0,0 +1,363 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshOptimizer.h"
+#include "glm/vec3.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cstring>
+
+namespace Falcor
+{
+    static const uint32_t kInvalidVertex = (uint32_t)-1;
+
+    // A FIFO post-transform cache. A vertex is in the cache if less than cacheSize vertices missed since it was last loaded.
+    class VertexCacheSimulator
+    {
+    public:
+        VertexCacheSimulator(uint32_t vertexCount, uint32_t cacheSize) : mLoadTime(vertexCount, 0), mCacheSize(cacheSize), mTime(cacheSize + 1) {}
+
+        // Returns true on a miss
+        bool access(uint32_t vertex)
+        {
+            if(mTime - mLoadTime[vertex] > mCacheSize)
+            {
+                mLoadTime[vertex] = mTime++;
+                return true;
+            }
+            return false;
+        }
+
+        uint32_t accessTriangle(const uint32_t* pTriangle)
+        {
+            return (access(pTriangle[0]) ? 1 : 0) + (access(pTriangle[1]) ? 1 : 0) + (access(pTriangle[2]) ? 1 : 0);
+        }
+
+        void flush() { mTime += mCacheSize + 1; }
+
+    private:
+        std::vector<uint32_t> mLoadTime;
+        uint32_t mCacheSize;
+        uint32_t mTime;
+    };
+
+    void MeshOptimizer::optimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        const uint32_t triangleCount = indexCount / 3;
+        if(triangleCount < 2)
+        {
+            return;
+        }
+
+        // Triangles using each vertex, in compressed rows
+        std::vector<uint32_t> liveCount(vertexCount, 0);
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            liveCount[pIndices[i]]++;
+        }
+
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+        }
+
+        std::vector<uint32_t> adjacency(indexCount);
+        std::vector<uint32_t> fillOffset(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            for(uint32_t k = 0; k < 3; k++)
+            {
+                adjacency[fillOffset[pIndices[t * 3 + k]]++] = t;
+            }
+        }
+
+        std::vector<uint32_t> cacheTime(vertexCount, 0);
+        std::vector<uint8_t> emitted(triangleCount, 0);
+        std::vector<uint32_t> deadEnd;
+        std::vector<uint32_t> candidates;
+        std::vector<uint32_t> output;
+        deadEnd.reserve(indexCount);
+        output.reserve(indexCount);
+
+        uint32_t time = cacheSize + 1;
+        uint32_t cursor = 0;
+        uint32_t fanning = pIndices[0];
+        while(fanning != kInvalidVertex)
+        {
+            // Emit all the remaining triangles around the fanning vertex
+            candidates.clear();
+            for(uint32_t a = adjacencyOffset[fanning]; a < adjacencyOffset[fanning + 1]; a++)
+            {
+                const uint32_t t = adjacency[a];
+                if(emitted[t])
+                {
+                    continue;
+                }
+
+                for(uint32_t k = 0; k < 3; k++)
+                {
+                    const uint32_t v = pIndices[t * 3 + k];
+                    output.push_back(v);
+                    deadEnd.push_back(v);
+                    candidates.push_back(v);
+                    liveCount[v]--;
+                    if(time - cacheTime[v] > cacheSize)
+                    {
+                        cacheTime[v] = time++;
+                    }
+                }
+                emitted[t] = 1;
+            }
+
+            // Continue from the candidate which stays longest in the cache while its triangles are emitted
+            fanning = kInvalidVertex;
+            int64_t bestPriority = -1;
+            for(uint32_t v : candidates)
+            {
+                if(liveCount[v] > 0)
+                {
+                    int64_t priority = 0;
+                    if(time - cacheTime[v] + 2 * liveCount[v] <= cacheSize)
+                    {
+                        priority = time - cacheTime[v];
+                    }
+                    if(priority > bestPriority)
+                    {
+                        bestPriority = priority;
+                        fanning = v;
+                    }
+                }
+            }
+
+            // Dead end. Go back to a recently used vertex, or to the next vertex with triangles left.
+            while(fanning == kInvalidVertex && deadEnd.empty() == false)
+            {
+                const uint32_t v = deadEnd.back();
+                deadEnd.pop_back();
+                if(liveCount[v] > 0)
+                {
+                    fanning = v;
+                }
+            }
+            while(fanning == kInvalidVertex && cursor < vertexCount)
+            {
+                if(liveCount[cursor] > 0)
+                {
+                    fanning = cursor;
+                }
+                cursor++;
+            }
+        }
+
+        assert(output.size() == indexCount);
+        memcpy(pIndices, output.data(), indexCount * sizeof(uint32_t));
+    }
+
+    void MeshOptimizer::optimizeOverdraw(uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold, uint32_t cacheSize)
+    {
+        const uint32_t triangleCount = indexCount / 3;
+        if(triangleCount < 2)
+        {
+            return;
+        }
+
+        // Hard boundaries are where the vertex cache order jumps to a new area, and all three vertices miss
+        VertexCacheSimulator cache(vertexCount, cacheSize);
+        std::vector<uint32_t> hardBoundaries;
+        for(uint32_t t = 0; t < triangleCount; t++)
+        {
+            if(cache.accessTriangle(pIndices + t * 3) == 3 || t == 0)
+            {
+                hardBoundaries.push_back(t);
+            }
+        }
+        hardBoundaries.push_back(triangleCount);
+
+        // Soft boundaries split the hard clusters wherever the ACMR so far is within the threshold of the whole cluster's ACMR
+        std::vector<uint32_t> clusterStart;
+        for(size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+        {
+            const uint32_t first = hardBoundaries[c];
+            const uint32_t last = hardBoundaries[c + 1];
+
+            cache.flush();
+            uint32_t clusterMisses = 0;
+            for(uint32_t t = first; t < last; t++)
+            {
+                clusterMisses += cache.accessTriangle(pIndices + t * 3);
+            }
+            const float clusterThreshold = threshold * float(clusterMisses) / float(last - first);
+
+            cache.flush();
+            clusterStart.push_back(first);
+            uint32_t runningMisses = 0;
+            uint32_t runningTriangles = 0;
+            for(uint32_t t = first; t < last; t++)
+            {
+                runningMisses += cache.accessTriangle(pIndices + t * 3);
+                runningTriangles++;
+                if(t + 1 < last && float(runningMisses) / float(runningTriangles) <= clusterThreshold)
+                {
+                    clusterStart.push_back(t + 1);
+                    cache.flush();
+                    runningMisses = 0;
+                    runningTriangles = 0;
+                }
+            }
+        }
+        const uint32_t clusterCount = (uint32_t)clusterStart.size();
+        clusterStart.push_back(triangleCount);
+
+        // Sort key of a cluster: how much it faces away from the center of the mesh. Outward facing clusters are likely to occlude the rest, so they go first.
+        auto getPosition = [pPositions, positionStride](uint32_t v) { return *(const glm::vec3*)((const uint8_t*)pPositions + (size_t)v * positionStride); };
+        std::vector<glm::vec3> clusterCentroid(clusterCount);
+        std::vector<glm::vec3> clusterNormal(clusterCount);
+        glm::vec3 meshCentroid;
+        float meshArea = 0;
+        for(uint32_t c = 0; c < clusterCount; c++)
+        {
+            glm::vec3 centroid;
+            glm::vec3 normal;
+            float area = 0;
+            for(uint32_t t = clusterStart[c]; t < clusterStart[c + 1]; t++)
+            {
+                const glm::vec3 p0 = getPosition(pIndices[t * 3]);
+                const glm::vec3 p1 = getPosition(pIndices[t * 3 + 1]);
+                const glm::vec3 p2 = getPosition(pIndices[t * 3 + 2]);
+                const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+                const float triangleArea = glm::length(n);
+                centroid += (p0 + p1 + p2) * (triangleArea / 3.0f);
+                normal += n;
+                area += triangleArea;
+            }
+            meshCentroid += centroid;
+            meshArea += area;
+            clusterCentroid[c] = (area > 0) ? centroid / area : centroid;
+            const float normalLength = glm::length(normal);
+            clusterNormal[c] = (normalLength > 0) ? normal / normalLength : normal;
+        }
+        meshCentroid = (meshArea > 0) ? meshCentroid / meshArea : meshCentroid;
+
+        std::vector<float> sortKey(clusterCount);
+        std::vector<uint32_t> clusterOrder(clusterCount);
+        for(uint32_t c = 0; c < clusterCount; c++)
+        {
+            sortKey[c] = glm::dot(clusterCentroid[c] - meshCentroid, clusterNormal[c]);
+            clusterOrder[c] = c;
+        }
+        std::stable_sort(clusterOrder.begin(), clusterOrder.end(), [&sortKey](uint32_t a, uint32_t b) { return sortKey[a] > sortKey[b]; });
+
+        std::vector<uint32_t> output;
+        output.reserve(indexCount);
+        for(uint32_t c : clusterOrder)
+        {
+            output.insert(output.end(), pIndices + clusterStart[c] * 3, pIndices + clusterStart[c + 1] * 3);
+        }
+        memcpy(pIndices, output.data(), indexCount * sizeof(uint32_t));
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeVertexFetch(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount)
+    {
+        std::vector<uint32_t> remap(vertexCount, kInvalidVertex);
+        uint32_t nextVertex = 0;
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            uint32_t& newVertex = remap[pIndices[i]];
+            if(newVertex == kInvalidVertex)
+            {
+                newVertex = nextVertex++;
+            }
+            pIndices[i] = newVertex;
+        }
+
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            if(remap[v] == kInvalidVertex)
+            {
+                remap[v] = nextVertex++;
+            }
+        }
+        return remap;
+    }
+
+    void MeshOptimizer::remapVertices(uint8_t* pVertices, uint32_t stride, uint32_t vertexCount, const std::vector<uint32_t>& remap)
+    {
+        assert(remap.size() == vertexCount);
+        const std::vector<uint8_t> source(pVertices, pVertices + (size_t)stride * vertexCount);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            memcpy(pVertices + (size_t)remap[v] * stride, source.data() + (size_t)v * stride, stride);
+        }
+    }
+
+    std::vector<uint32_t> MeshOptimizer::optimizeMesh(std::vector<uint32_t>& indices, const std::vector<uint32_t>& submeshIndexCounts, uint32_t vertexCount, const float* pPositions, uint32_t positionStride, Statistics& stats)
+    {
+        if(std::any_of(indices.begin(), indices.end(), [vertexCount](uint32_t i) { return i >= vertexCount; }))
+        {
+            return std::vector<uint32_t>();
+        }
+
+        uint32_t offset = 0;
+        for(uint32_t count : submeshIndexCounts)
+        {
+            uint32_t* pSubmesh = indices.data() + offset;
+            stats.triangleCount += count / 3;
+            stats.missesBefore += countCacheMisses(pSubmesh, count, vertexCount, kDefaultCacheSize);
+            optimizeVertexCache(pSubmesh, count, vertexCount);
+            optimizeOverdraw(pSubmesh, count, pPositions, positionStride, vertexCount);
+            stats.missesAfter += countCacheMisses(pSubmesh, count, vertexCount, kDefaultCacheSize);
+            offset += count;
+        }
+        assert(offset == indices.size());
+
+        return optimizeVertexFetch(indices.data(), (uint32_t)indices.size(), vertexCount);
+    }
+
+    uint32_t MeshOptimizer::countCacheMisses(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheSimulator cache(vertexCount, cacheSize);
+        uint32_t misses = 0;
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            misses += cache.access(pIndices[i]) ? 1 : 0;
+        }
+        return misses;
+    }
+
+    float MeshOptimizer::calculateACMR(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize)
+    {
+        const uint32_t triangleCount = indexCount / 3;
+        return triangleCount ? float(countCacheMisses(pIndices, indexCount, vertexCount, cacheSize)) / float(triangleCount) : 0;
+    }
+
+    void MeshOptimizer::logStatistics(const std::string& modelName, const Statistics& stats)
+    {
+        logInfo("Optimized the meshes of model " + modelName + " for a " + std::to_string(kDefaultCacheSize) + " entry vertex cache. ACMR " + std::to_string(stats.getAcmrBefore()) + " -> " + std::to_string(stats.getAcmrAfter()) + " over " + std::to_string(stats.triangleCount) + " triangles.");
+    }
+}
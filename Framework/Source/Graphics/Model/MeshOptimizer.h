@@ -0,0 +1,120 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** CPU optimizations of triangle lists for the GPU's vertex processing.\n
+        optimizeVertexCache() reorders the triangles for the post-transform vertex cache using Tipsify (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw", 2007).
+        optimizeOverdraw() then splits that order into clusters and draws the clusters most likely to occlude the rest first, giving up only a bounded amount of cache efficiency.
+        optimizeVertexFetch() finally renumbers the vertices in the order they are first used, so that vertex fetches walk the vertex buffers linearly.
+        All functions work in place on 32-bit triangle lists, and keep the winding of each triangle.
+    */
+    class MeshOptimizer
+    {
+    public:
+        /** Number of vertices in the simulated FIFO cache. Matches the effective post-transform cache size of current GPUs.
+        */
+        static const uint32_t kDefaultCacheSize = 16;
+
+        /** Cache efficiency of a set of meshes. ACMR (average cache miss ratio) is the number of vertices transformed per triangle, between 0.5 for an ideal order of a large grid and 3.
+        */
+        struct Statistics
+        {
+            uint64_t triangleCount = 0;
+            uint64_t missesBefore = 0;      ///< Simulated cache misses before optimization
+            uint64_t missesAfter = 0;       ///< Simulated cache misses after optimization
+            float getAcmrBefore() const { return triangleCount ? float(missesBefore) / float(triangleCount) : 0; }
+            float getAcmrAfter() const { return triangleCount ? float(missesAfter) / float(triangleCount) : 0; }
+        };
+
+        /** Reorder triangles to reduce post-transform vertex cache misses
+            \param[in,out] pIndices The triangle list
+            \param[in] indexCount Number of indices. Must be a multiple of 3.
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \param[in] cacheSize Size of the vertex cache to optimize for
+        */
+        static void optimizeVertexCache(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Reorder clusters of triangles to reduce overdraw. Call it after optimizeVertexCache().
+            \param[in,out] pIndices The triangle list
+            \param[in] indexCount Number of indices. Must be a multiple of 3.
+            \param[in] pPositions Pointer to the first vertex position. Positions are 3 floats.
+            \param[in] positionStride Distance between two positions in bytes
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \param[in] threshold How much the ACMR may grow, as a factor. Smaller clusters sort better, but start with a cold cache.
+            \param[in] cacheSize Size of the vertex cache used to find the cluster boundaries
+        */
+        static void optimizeOverdraw(uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, float threshold = 1.05f, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Renumber the vertices in the order the triangle list first uses them. Unused vertices move to the end.
+            \param[in,out] pIndices The triangle list, rewritten to use the new vertex numbers
+            \param[in] indexCount Number of indices
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \return For each old vertex, its new number. Pass it to remapVertices() for every vertex buffer.
+        */
+        static std::vector<uint32_t> optimizeVertexFetch(uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount);
+
+        /** Move the vertices of a buffer to their new positions
+            \param[in,out] pVertices The vertex data
+            \param[in] stride Distance between two vertices in bytes
+            \param[in] vertexCount Number of vertices
+            \param[in] remap The result of optimizeVertexFetch()
+        */
+        static void remapVertices(uint8_t* pVertices, uint32_t stride, uint32_t vertexCount, const std::vector<uint32_t>& remap);
+
+        /** Run all the optimizations on a mesh whose submeshes share the vertex buffers. Each submesh is reordered on its own, and the vertices are renumbered for all of them.
+            \param[in,out] indices The triangle lists of all the submeshes, one after the other
+            \param[in] submeshIndexCounts Number of indices of each submesh
+            \param[in] vertexCount Number of vertices
+            \param[in] pPositions Pointer to the first vertex position. Positions are 3 floats.
+            \param[in] positionStride Distance between two positions in bytes
+            \param[in,out] stats The cache misses before and after are added to this
+            \return The vertex remap for remapVertices(), or an empty vector if the mesh wasn't changed because an index is out of range
+        */
+        static std::vector<uint32_t> optimizeMesh(std::vector<uint32_t>& indices, const std::vector<uint32_t>& submeshIndexCounts, uint32_t vertexCount, const float* pPositions, uint32_t positionStride, Statistics& stats);
+
+        /** Get the average number of simulated FIFO cache misses per triangle
+            \param[in] pIndices The triangle list
+            \param[in] indexCount Number of indices
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \param[in] cacheSize Size of the simulated cache
+        */
+        static float calculateACMR(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize = kDefaultCacheSize);
+
+        /** Log the ACMR before and after the optimization of a model
+        */
+        static void logStatistics(const std::string& modelName, const Statistics& stats);
+
+    private:
+        static uint32_t countCacheMisses(const uint32_t* pIndices, uint32_t indexCount, uint32_t vertexCount, uint32_t cacheSize);
+    };
+}
@@ -0,0 +1,481 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshSimplifier.h"
+#include "Data/VertexAttrib.h"
+#include "glm/vec3.hpp"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <unordered_map>
+#include <cstring>
+#include <cfloat>
+
+namespace Falcor
+{
+    static const float kBorderWeight = 10.0f;           // Relative to the triangles, how strongly the planes through the border edges hold a border in place
+    static const float kFlipThreshold = 0.25f;          // A collapse is rejected if it turns the normal of a triangle by more than ~75 degrees
+    static const float kNormalWeight = 0.02f;
+    static const float kTexCoordWeight = 0.02f;
+    static const float kLodReduction = 0.5f;            // Triangle count of each LOD relative to the previous one
+    static const float kMinLodReduction = 0.8f;         // The chain ends once a LOD keeps more than this fraction of the previous one's triangles
+    static const uint32_t kMinLodTriangleCount = 16;
+
+    // A plane quadric, stored as the upper triangle of a symmetric 4x4 matrix. evaluate() returns the weighted sum of the squared distances to the planes.
+    struct Quadric
+    {
+        double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+        double b0 = 0, b1 = 0, b2 = 0;
+        double c = 0;
+        double weight = 0;
+
+        static Quadric fromPlane(const glm::vec3& n, float d, float weight)
+        {
+            Quadric q;
+            q.a00 = weight * n.x * n.x; q.a11 = weight * n.y * n.y; q.a22 = weight * n.z * n.z;
+            q.a01 = weight * n.x * n.y; q.a02 = weight * n.x * n.z; q.a12 = weight * n.y * n.z;
+            q.b0 = weight * n.x * d; q.b1 = weight * n.y * d; q.b2 = weight * n.z * d;
+            q.c = weight * d * d;
+            q.weight = weight;
+            return q;
+        }
+
+        void operator+=(const Quadric& q)
+        {
+            a00 += q.a00; a11 += q.a11; a22 += q.a22; a01 += q.a01; a02 += q.a02; a12 += q.a12;
+            b0 += q.b0; b1 += q.b1; b2 += q.b2;
+            c += q.c;
+            weight += q.weight;
+        }
+
+        double evaluate(const glm::vec3& p) const
+        {
+            const double x = p.x, y = p.y, z = p.z;
+            const double r = x * x * a00 + y * y * a11 + z * z * a22 + 2 * (x * y * a01 + x * z * a02 + y * z * a12) + 2 * (x * b0 + y * b1 + z * b2) + c;
+            return std::max(r, 0.0);
+        }
+    };
+
+    enum class VertexKind : uint8_t
+    {
+        Manifold,   // Can collapse onto any neighbor
+        Border,     // Can only collapse along its border edges
+        Locked,     // Never moves
+    };
+
+    struct Collapse
+    {
+        uint32_t from;
+        uint32_t to;
+        float error;            // Geometric plus attribute error, used for sorting
+        float geometricError;   // Squared distance
+    };
+
+    static glm::vec3 getPosition(const float* pPositions, uint32_t stride, uint32_t vertex)
+    {
+        const float* p = (const float*)((const uint8_t*)pPositions + (size_t)stride * vertex);
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+
+    // Vertices at the same position get the same representative, so that attribute seams aren't mistaken for borders
+    static std::vector<uint32_t> findPositionRepresentatives(const float* pPositions, uint32_t stride, uint32_t vertexCount, std::vector<uint8_t>& isSeam)
+    {
+        struct PositionHash
+        {
+            size_t operator()(const glm::vec3& p) const
+            {
+                uint32_t bits[3];
+                std::memcpy(bits, &p, sizeof(bits));
+                return (size_t)(bits[0] * 73856093u ^ bits[1] * 19349663u ^ bits[2] * 83492791u);
+            }
+        };
+
+        std::unordered_map<glm::vec3, uint32_t, PositionHash> firstVertex;
+        std::vector<uint32_t> representative(vertexCount);
+        isSeam.assign(vertexCount, 0);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            auto it = firstVertex.emplace(getPosition(pPositions, stride, v), v).first;
+            representative[v] = it->second;
+            if(it->second != v)
+            {
+                isSeam[v] = 1;
+                isSeam[it->second] = 1;
+            }
+        }
+        return representative;
+    }
+
+    std::vector<uint32_t> MeshSimplifier::simplify(const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, const std::vector<Attribute>& attributes, uint32_t targetIndexCount, float& error)
+    {
+        std::vector<uint32_t> indices(pIndices, pIndices + indexCount);
+        error = 0;
+        if(indexCount <= targetIndexCount)
+        {
+            return indices;
+        }
+
+        std::vector<glm::vec3> positions(vertexCount);
+        glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+        for(uint32_t v = 0; v < vertexCount; v++)
+        {
+            positions[v] = getPosition(pPositions, positionStride, v);
+            boxMin = glm::min(boxMin, positions[v]);
+            boxMax = glm::max(boxMax, positions[v]);
+        }
+        const float extent = glm::length(boxMax - boxMin);
+
+        std::vector<uint8_t> isSeam;
+        const std::vector<uint32_t> representative = findPositionRepresentatives(pPositions, positionStride, vertexCount, isSeam);
+
+        // The quadrics of the source triangles. Collapses add them up, so the error is always measured against the source surface.
+        std::vector<Quadric> quadrics(vertexCount);
+        for(uint32_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            const glm::vec3& p0 = positions[indices[i]];
+            const glm::vec3 cross = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+            const float area = glm::length(cross);
+            if(area > 0)
+            {
+                const glm::vec3 n = cross / area;
+                const Quadric q = Quadric::fromPlane(n, -glm::dot(n, p0), area);
+                for(uint32_t j = 0; j < 3; j++)
+                {
+                    quadrics[indices[i + j]] += q;
+                }
+            }
+        }
+
+        std::vector<VertexKind> kinds(vertexCount);
+        std::vector<uint32_t> edgeOffsets(vertexCount + 1);
+        std::vector<uint32_t> edgeTargets;
+        std::vector<uint32_t> triangleOffsets(vertexCount + 1);
+        std::vector<uint32_t> vertexTriangles;
+        std::vector<uint32_t> fillOffsets;
+        std::vector<uint8_t> borderOut(vertexCount), borderIn(vertexCount);
+        std::vector<uint8_t> collapseLocked(vertexCount);
+        std::vector<uint32_t> remap(vertexCount);
+        std::vector<Collapse> collapses;
+        bool borderQuadricsAdded = false;
+        double maxErrorSq = 0;
+
+        while(indices.size() > targetIndexCount)
+        {
+            const uint32_t triangleCount = (uint32_t)indices.size() / 3;
+            auto nextIndex = [](uint32_t i) { return i - i % 3 + (i + 1) % 3; };
+
+            // Directed edges between position representatives, and the triangles using each vertex, in compressed rows
+            std::fill(edgeOffsets.begin(), edgeOffsets.end(), 0);
+            std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                edgeOffsets[representative[indices[i]] + 1]++;
+                triangleOffsets[indices[i] + 1]++;
+            }
+            for(uint32_t v = 0; v < vertexCount; v++)
+            {
+                edgeOffsets[v + 1] += edgeOffsets[v];
+                triangleOffsets[v + 1] += triangleOffsets[v];
+            }
+            edgeTargets.resize(indices.size());
+            vertexTriangles.resize(indices.size());
+            fillOffsets.assign(edgeOffsets.begin(), edgeOffsets.end() - 1);
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                edgeTargets[fillOffsets[representative[indices[i]]]++] = representative[indices[nextIndex(i)]];
+            }
+            fillOffsets.assign(triangleOffsets.begin(), triangleOffsets.end() - 1);
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                vertexTriangles[fillOffsets[indices[i]]++] = i / 3;
+            }
+
+            auto countEdges = [&](uint32_t a, uint32_t b)
+            {
+                return (uint32_t)std::count(edgeTargets.begin() + edgeOffsets[a], edgeTargets.begin() + edgeOffsets[a + 1], b);
+            };
+            // An edge without its reverse is on a border
+            auto isBorderEdge = [&](uint32_t a, uint32_t b)
+            {
+                return countEdges(b, a) == 0;
+            };
+
+            // Classify the vertices. A border vertex must have exactly one outgoing and one incoming border edge.
+            std::fill(borderOut.begin(), borderOut.end(), 0);
+            std::fill(borderIn.begin(), borderIn.end(), 0);
+            std::fill(kinds.begin(), kinds.end(), VertexKind::Manifold);
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                const uint32_t a = indices[i];
+                const uint32_t b = indices[nextIndex(i)];
+                const uint32_t ra = representative[a];
+                const uint32_t rb = representative[b];
+                if(countEdges(ra, rb) > 1)
+                {
+                    kinds[a] = VertexKind::Locked;
+                    kinds[b] = VertexKind::Locked;
+                }
+                else if(isBorderEdge(ra, rb))
+                {
+                    borderOut[a] = std::min(borderOut[a] + 1, 2);
+                    borderIn[b] = std::min(borderIn[b] + 1, 2);
+
+                    // Hold the border in place with a plane through the edge, perpendicular to the triangle
+                    if(borderQuadricsAdded == false)
+                    {
+                        const glm::vec3 edge = positions[b] - positions[a];
+                        const glm::vec3 n = glm::cross(edge, positions[indices[nextIndex(nextIndex(i))]] - positions[a]);
+                        const glm::vec3 planeNormal = glm::cross(edge, n);
+                        const float length = glm::length(planeNormal);
+                        if(length > 0)
+                        {
+                            const glm::vec3 pn = planeNormal / length;
+                            const Quadric q = Quadric::fromPlane(pn, -glm::dot(pn, positions[a]), glm::dot(edge, edge) * kBorderWeight);
+                            quadrics[a] += q;
+                            quadrics[b] += q;
+                        }
+                    }
+                }
+            }
+            borderQuadricsAdded = true;
+
+            for(uint32_t v = 0; v < vertexCount; v++)
+            {
+                if(isSeam[v] || borderOut[v] > 1 || borderOut[v] != borderIn[v])
+                {
+                    kinds[v] = VertexKind::Locked;
+                }
+                else if(kinds[v] == VertexKind::Manifold && borderOut[v] == 1)
+                {
+                    kinds[v] = VertexKind::Border;
+                }
+            }
+
+            // Evaluate every edge in both directions. Interior edges are seen from both of their triangles, but only evaluated once.
+            collapses.clear();
+            auto addCollapse = [&](uint32_t from, uint32_t to, bool isBorder)
+            {
+                if(kinds[from] == VertexKind::Locked || (kinds[from] == VertexKind::Border && isBorder == false))
+                {
+                    return;
+                }
+
+                Quadric q = quadrics[from];
+                q += quadrics[to];
+                const double geometricError = q.weight > 0 ? q.evaluate(positions[to]) / q.weight : 0;
+                double attributeError = 0;
+                for(const Attribute& attrib : attributes)
+                {
+                    const float* pFrom = (const float*)((const uint8_t*)attrib.pData + (size_t)attrib.stride * from);
+                    const float* pTo = (const float*)((const uint8_t*)attrib.pData + (size_t)attrib.stride * to);
+                    double diff = 0;
+                    for(uint32_t c = 0; c < attrib.components; c++)
+                    {
+                        diff += (pFrom[c] - pTo[c]) * (pFrom[c] - pTo[c]);
+                    }
+                    const double scale = attrib.weight * extent;
+                    attributeError += scale * scale * diff;
+                }
+                collapses.push_back({ from, to, (float)(geometricError + attributeError), (float)geometricError });
+            };
+
+            for(uint32_t i = 0; i < triangleCount * 3; i++)
+            {
+                const uint32_t a = indices[i];
+                const uint32_t b = indices[nextIndex(i)];
+                const bool isBorder = isBorderEdge(representative[a], representative[b]);
+                if(isBorder || representative[a] < representative[b])
+                {
+                    addCollapse(a, b, isBorder);
+                    addCollapse(b, a, isBorder);
+                }
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) { return a.error < b.error; });
+
+            // Apply the cheapest collapses. A collapse locks the neighborhood of its vertex for the rest of the pass, so that the flip test stays valid.
+            // Each collapse removes about two triangles.
+            const uint32_t collapseGoal = std::max((triangleCount - targetIndexCount / 3 + 1) / 2, 1u);
+            uint32_t collapseCount = 0;
+            std::fill(collapseLocked.begin(), collapseLocked.end(), 0);
+            for(uint32_t v = 0; v < vertexCount; v++)
+            {
+                remap[v] = v;
+            }
+
+            for(const Collapse& collapse : collapses)
+            {
+                if(collapseCount >= collapseGoal)
+                {
+                    break;
+                }
+                if(collapseLocked[collapse.from] || collapseLocked[collapse.to])
+                {
+                    continue;
+                }
+
+                // Reject collapses which fold a triangle over
+                bool flips = false;
+                for(uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1] && flips == false; t++)
+                {
+                    const uint32_t* pTriangle = &indices[vertexTriangles[t] * 3];
+                    if(pTriangle[0] == collapse.to || pTriangle[1] == collapse.to || pTriangle[2] == collapse.to)
+                    {
+                        continue;
+                    }
+                    glm::vec3 before[3], after[3];
+                    for(uint32_t j = 0; j < 3; j++)
+                    {
+                        before[j] = positions[pTriangle[j]];
+                        after[j] = (pTriangle[j] == collapse.from) ? positions[collapse.to] : before[j];
+                    }
+                    const glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+                    const glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+                    flips = glm::dot(n0, n1) <= kFlipThreshold * glm::length(n0) * glm::length(n1);
+                }
+                if(flips)
+                {
+                    continue;
+                }
+
+                for(uint32_t t = triangleOffsets[collapse.from]; t < triangleOffsets[collapse.from + 1]; t++)
+                {
+                    const uint32_t* pTriangle = &indices[vertexTriangles[t] * 3];
+                    collapseLocked[pTriangle[0]] = collapseLocked[pTriangle[1]] = collapseLocked[pTriangle[2]] = 1;
+                }
+                collapseLocked[collapse.to] = 1;
+                remap[collapse.from] = collapse.to;
+                quadrics[collapse.to] += quadrics[collapse.from];
+                maxErrorSq = std::max(maxErrorSq, (double)collapse.geometricError);
+                collapseCount++;
+            }
+
+            if(collapseCount == 0)
+            {
+                break;
+            }
+
+            // Drop the triangles which lost a vertex
+            uint32_t writeIndex = 0;
+            for(uint32_t i = 0; i < triangleCount * 3; i += 3)
+            {
+                const uint32_t a = remap[indices[i]];
+                const uint32_t b = remap[indices[i + 1]];
+                const uint32_t c = remap[indices[i + 2]];
+                if(a != b && b != c && a != c)
+                {
+                    indices[writeIndex++] = a;
+                    indices[writeIndex++] = b;
+                    indices[writeIndex++] = c;
+                }
+            }
+            indices.resize(writeIndex);
+        }
+
+        error = (float)std::sqrt(maxErrorSq);
+        return indices;
+    }
+
+    std::vector<MeshSimplifier::Lod> MeshSimplifier::generateLodChain(const VertexLayout* pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount, uint32_t maxLodCount)
+    {
+        std::vector<Lod> lods;
+        const float* pPositions = nullptr;
+        uint32_t positionStride = 0;
+        std::vector<Attribute> attributes;
+        for(uint32_t i = 0; i < (uint32_t)pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+            if(pBufferLayout == nullptr || buffers[i] == nullptr)
+            {
+                continue;
+            }
+            for(uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+            {
+                const std::string& name = pBufferLayout->getElementName(e);
+                const ResourceFormat format = pBufferLayout->getElementFormat(e);
+                const float* pData = (const float*)(buffers[i] + pBufferLayout->getElementOffset(e));
+                Attribute attrib;
+                attrib.pData = pData;
+                attrib.stride = pBufferLayout->getStride();
+                if(name == VERTEX_POSITION_NAME && format == ResourceFormat::RGB32Float)
+                {
+                    pPositions = pData;
+                    positionStride = attrib.stride;
+                }
+                else if(name == VERTEX_NORMAL_NAME && format == ResourceFormat::RGB32Float)
+                {
+                    attrib.components = 3;
+                    attrib.weight = kNormalWeight;
+                    attributes.push_back(attrib);
+                }
+                else if(name == VERTEX_TEXCOORD_NAME && (format == ResourceFormat::RG32Float || format == ResourceFormat::RGB32Float))
+                {
+                    attrib.components = 2;
+                    attrib.weight = kTexCoordWeight;
+                    attributes.push_back(attrib);
+                }
+            }
+        }
+
+        if(pPositions == nullptr || indexCount % 3 != 0)
+        {
+            return lods;
+        }
+        for(uint32_t i = 0; i < indexCount; i++)
+        {
+            if(pIndices[i] >= vertexCount)
+            {
+                return lods;
+            }
+        }
+
+        // Each LOD is simplified from the previous one. The errors add up, which bounds the distance to the full detail mesh.
+        const uint32_t* pSource = pIndices;
+        uint32_t sourceIndexCount = indexCount;
+        float sourceError = 0;
+        while((uint32_t)lods.size() < maxLodCount)
+        {
+            const uint32_t targetIndexCount = (uint32_t)(sourceIndexCount / 3 * kLodReduction) * 3;
+            if(targetIndexCount < kMinLodTriangleCount * 3)
+            {
+                break;
+            }
+
+            Lod lod;
+            lod.indices = simplify(pSource, sourceIndexCount, pPositions, positionStride, vertexCount, attributes, targetIndexCount, lod.error);
+            if(lod.indices.empty() || lod.indices.size() > sourceIndexCount * kMinLodReduction)
+            {
+                break;
+            }
+            lod.error += sourceError;
+            lods.push_back(std::move(lod));
+            pSource = lods.back().indices.data();
+            sourceIndexCount = (uint32_t)lods.back().indices.size();
+            sourceError = lods.back().error;
+        }
+        return lods;
+    }
+}
@@ -0,0 +1,90 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "API/VertexLayout.h"
+
+namespace Falcor
+{
+    /** Generates simplified versions of triangle meshes for levels of detail.\n
+        simplify() collapses edges in the order of their quadric error (Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics", 1997).
+        Every collapse moves a vertex onto one of its neighbors, so the result only uses vertices of the source mesh and a LOD can share the mesh's vertex buffers.
+        The differences of the vertex attributes across a collapsed edge are added to its error, so detail in the normals and texture coordinates is removed last.
+        Open borders only collapse along themselves. Vertices on attribute seams, and vertices whose neighborhood isn't a manifold, are kept.
+    */
+    class MeshSimplifier
+    {
+    public:
+        /** Maximal number of LODs generateLodChain() creates in addition to the full detail mesh
+        */
+        static const uint32_t kDefaultMaxLodCount = 4;
+
+        /** A vertex attribute whose changes should count as error
+        */
+        struct Attribute
+        {
+            const float* pData = nullptr;   ///< Pointer to the attribute of the first vertex
+            uint32_t stride = 0;            ///< Distance between two vertices in bytes
+            uint32_t components = 0;        ///< Number of floats
+            float weight = 0;               ///< A difference of 1 costs as much as moving the surface by this fraction of the mesh's size
+        };
+
+        /** A level of detail of a mesh
+        */
+        struct Lod
+        {
+            std::vector<uint32_t> indices;  ///< The triangle list, using the vertices of the full detail mesh
+            float error = 0;                ///< Estimated distance between the surface of the LOD and the full detail mesh, in object space
+        };
+
+        /** Simplify a triangle list
+            \param[in] pIndices The triangle list
+            \param[in] indexCount Number of indices. Must be a multiple of 3.
+            \param[in] pPositions Pointer to the first vertex position. Positions are 3 floats.
+            \param[in] positionStride Distance between two positions in bytes
+            \param[in] vertexCount Number of vertices. All indices must be smaller than this.
+            \param[in] attributes Vertex attributes to preserve
+            \param[in] targetIndexCount Stop once the triangle list has this many indices or less
+            \param[out] error The estimated distance between the result and the source surface, in object space
+            \return The simplified triangle list. It has more than targetIndexCount indices if the mesh couldn't be simplified any further.
+        */
+        static std::vector<uint32_t> simplify(const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, const std::vector<Attribute>& attributes, uint32_t targetIndexCount, float& error);
+
+        /** Generate a chain of LODs for a mesh, each with about half the triangles of the previous one. The chain ends early once a mesh doesn't get much simpler.
+            \param[in] pLayout The vertex layout. The positions must be RGB32Float. Float normals and texture coordinates are preserved.
+            \param[in] buffers Pointer to the data of each buffer in the layout. Can be nullptr for buffers the layout doesn't define.
+            \param[in] vertexCount Number of vertices
+            \param[in] pIndices The full detail triangle list
+            \param[in] indexCount Number of indices
+            \param[in] maxLodCount Maximal number of LODs to generate
+            \return The LODs, coarsest last. Empty if the mesh has no float positions, an index is out of range, or the mesh is too small to simplify.
+        */
+        static std::vector<Lod> generateLodChain(const VertexLayout* pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount, uint32_t maxLodCount = kDefaultMaxLodCount);
+    };
+}
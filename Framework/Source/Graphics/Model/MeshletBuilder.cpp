@@ -0,0 +1,197 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MeshletBuilder.h"
+#include "Data/VertexAttrib.h"
+#include "glm/geometric.hpp"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+namespace Falcor
+{
+    static const float kMinConeDot = 0.1f;  // Clusters whose normals spread wider than ~84 degrees from the axis get no cone. It would only cull them from a sliver of directions.
+
+    static glm::vec3 getPosition(const float* pPositions, uint32_t stride, uint32_t vertex)
+    {
+        const float* p = (const float*)((const uint8_t*)pPositions + (size_t)stride * vertex);
+        return glm::vec3(p[0], p[1], p[2]);
+    }
+
+    bool Meshlet::isBackfacing(const glm::vec3& eyePos) const
+    {
+        if(coneCutoff > 1)
+        {
+            return false;
+        }
+        const glm::vec3 dir = coneApex - eyePos;
+        const float length = glm::length(dir);
+        return length > 0 && glm::dot(dir, coneAxis) >= coneCutoff * length;
+    }
+
+    std::vector<Meshlet> MeshletBuilder::build(const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t maxVertices, uint32_t maxTriangles)
+    {
+        std::vector<Meshlet> meshlets;
+        if(maxVertices < 3 || maxTriangles == 0)
+        {
+            return meshlets;
+        }
+
+        // The meshlet which last used each vertex, so that shared vertices are only counted once
+        std::vector<uint32_t> vertexMeshlet(vertexCount, UINT32_MAX);
+        Meshlet current;
+        uint32_t meshletID = 0;
+        for(uint32_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            const uint32_t* pTriangle = pIndices + i;
+            if(pTriangle[0] >= vertexCount || pTriangle[1] >= vertexCount || pTriangle[2] >= vertexCount)
+            {
+                return std::vector<Meshlet>();
+            }
+
+            uint32_t newVertices = 0;
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                const bool repeated = (j > 0 && pTriangle[j] == pTriangle[0]) || (j > 1 && pTriangle[j] == pTriangle[1]);
+                newVertices += (vertexMeshlet[pTriangle[j]] != meshletID && repeated == false) ? 1 : 0;
+            }
+
+            // Start a new meshlet once the triangle doesn't fit. Its vertices are all new there.
+            if(current.vertexCount + newVertices > maxVertices || current.indexCount == maxTriangles * 3)
+            {
+                computeBounds(current, pIndices, pPositions, positionStride);
+                meshlets.push_back(current);
+                current = Meshlet();
+                current.startIndex = i;
+                meshletID++;
+                newVertices = 1 + (pTriangle[1] != pTriangle[0] ? 1 : 0) + ((pTriangle[2] != pTriangle[0] && pTriangle[2] != pTriangle[1]) ? 1 : 0);
+            }
+
+            for(uint32_t j = 0; j < 3; j++)
+            {
+                vertexMeshlet[pTriangle[j]] = meshletID;
+            }
+            current.vertexCount += newVertices;
+            current.indexCount += 3;
+        }
+
+        if(current.indexCount)
+        {
+            computeBounds(current, pIndices, pPositions, positionStride);
+            meshlets.push_back(current);
+        }
+        return meshlets;
+    }
+
+    void MeshletBuilder::computeBounds(Meshlet& meshlet, const uint32_t* pIndices, const float* pPositions, uint32_t positionStride)
+    {
+        const uint32_t* pFirst = pIndices + meshlet.startIndex;
+
+        glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+        glm::vec3 normalSum(0);
+        for(uint32_t i = 0; i < meshlet.indexCount; i += 3)
+        {
+            const glm::vec3 p0 = getPosition(pPositions, positionStride, pFirst[i]);
+            const glm::vec3 p1 = getPosition(pPositions, positionStride, pFirst[i + 1]);
+            const glm::vec3 p2 = getPosition(pPositions, positionStride, pFirst[i + 2]);
+            boxMin = glm::min(boxMin, glm::min(p0, glm::min(p1, p2)));
+            boxMax = glm::max(boxMax, glm::max(p0, glm::max(p1, p2)));
+
+            const glm::vec3 n = glm::cross(p1 - p0, p2 - p0);
+            const float area = glm::length(n);
+            if(area > 0)
+            {
+                normalSum += n / area;
+            }
+        }
+        meshlet.box = BoundingBox::fromMinMax(boxMin, boxMax);
+
+        // The cone axis is the average normal, and its angle covers all the normals
+        const float axisLength = glm::length(normalSum);
+        if(axisLength == 0)
+        {
+            return;
+        }
+        const glm::vec3 axis = normalSum / axisLength;
+        float minDot = 1;
+        for(uint32_t i = 0; i < meshlet.indexCount; i += 3)
+        {
+            const glm::vec3 p0 = getPosition(pPositions, positionStride, pFirst[i]);
+            const glm::vec3 n = glm::cross(getPosition(pPositions, positionStride, pFirst[i + 1]) - p0, getPosition(pPositions, positionStride, pFirst[i + 2]) - p0);
+            const float area = glm::length(n);
+            if(area > 0)
+            {
+                minDot = std::min(minDot, glm::dot(n / area, axis));
+            }
+        }
+        if(minDot < kMinConeDot)
+        {
+            return;
+        }
+
+        // Move the apex back along the axis until it is behind the planes of all the triangles. An eye inside the cone behind it then sees only back faces.
+        const glm::vec3 center = meshlet.box.center;
+        float maxT = 0;
+        for(uint32_t i = 0; i < meshlet.indexCount; i += 3)
+        {
+            const glm::vec3 p0 = getPosition(pPositions, positionStride, pFirst[i]);
+            const glm::vec3 n = glm::cross(getPosition(pPositions, positionStride, pFirst[i + 1]) - p0, getPosition(pPositions, positionStride, pFirst[i + 2]) - p0);
+            const float area = glm::length(n);
+            if(area > 0)
+            {
+                const glm::vec3 unitN = n / area;
+                maxT = std::max(maxT, glm::dot(center - p0, unitN) / glm::dot(axis, unitN));
+            }
+        }
+
+        meshlet.coneApex = center - axis * maxT;
+        meshlet.coneAxis = axis;
+        meshlet.coneCutoff = std::sqrt(1 - minDot * minDot);
+    }
+
+    std::vector<Meshlet> MeshletBuilder::build(const VertexLayout* pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount)
+    {
+        for(uint32_t i = 0; i < (uint32_t)pLayout->getBufferCount(); i++)
+        {
+            const VertexBufferLayout* pBufferLayout = pLayout->getBufferLayout(i).get();
+            if(pBufferLayout == nullptr || buffers[i] == nullptr)
+            {
+                continue;
+            }
+            for(uint32_t e = 0; e < pBufferLayout->getElementCount(); e++)
+            {
+                if(pBufferLayout->getElementName(e) == VERTEX_POSITION_NAME && pBufferLayout->getElementFormat(e) == ResourceFormat::RGB32Float)
+                {
+                    const float* pPositions = (const float*)(buffers[i] + pBufferLayout->getElementOffset(e));
+                    return build(pIndices, indexCount, pPositions, pBufferLayout->getStride(), vertexCount);
+                }
+            }
+        }
+        return std::vector<Meshlet>();
+    }
+}
@@ -0,0 +1,91 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "glm/vec3.hpp"
+#include "Utils/AABB.h"
+#include "API/VertexLayout.h"
+
+namespace Falcor
+{
+    /** A cluster of a mesh's triangles, which can be culled on its own
+    */
+    struct Meshlet
+    {
+        uint32_t startIndex = 0;    ///< Location of the first index. MeshletBuilder returns it relative to the triangle list, a Mesh stores it in its index buffer.
+        uint32_t indexCount = 0;
+        uint32_t vertexCount = 0;   ///< Number of distinct vertices the triangles use
+        BoundingBox box;            ///< Object space bounds
+        glm::vec3 coneApex;         ///< The normal cone. All the triangles face away from any eye position inside the cone behind the apex, see isBackfacing().
+        glm::vec3 coneAxis;
+        float coneCutoff = 2;       ///< Sine of the cone's half angle. Larger than 1 if the triangles face too many directions for the cone to cull them.
+
+        /** Check if all the triangles face away from an eye position in object space
+        */
+        bool isBackfacing(const glm::vec3& eyePos) const;
+    };
+
+    /** Splits triangle lists into meshlets of a bounded size, and computes their bounds and normal cones.\n
+        The meshlets are consecutive runs of the triangle list, so a mesh keeps its index buffer and draws any set of meshlets as a few index ranges.
+        The triangles are taken in order, so the meshlets are only as compact as the order; the importers optimize the vertex cache order first (see MeshOptimizer).
+    */
+    class MeshletBuilder
+    {
+    public:
+        /** Default size limits. They match the sizes mesh shaders handle well, so the same meshlets can later be drawn on the GPU.
+        */
+        static const uint32_t kDefaultMaxVertices = 64;
+        static const uint32_t kDefaultMaxTriangles = 124;
+
+        /** Split a triangle list into meshlets
+            \param[in] pIndices The triangle list
+            \param[in] indexCount Number of indices. Must be a multiple of 3.
+            \param[in] pPositions Pointer to the first vertex position. Positions are 3 floats.
+            \param[in] positionStride Distance between two positions in bytes
+            \param[in] vertexCount Number of vertices
+            \param[in] maxVertices Maximal number of distinct vertices per meshlet. Must be at least 3.
+            \param[in] maxTriangles Maximal number of triangles per meshlet
+            \return The meshlets in the order of the triangle list. Empty if an index is out of range.
+        */
+        static std::vector<Meshlet> build(const uint32_t* pIndices, uint32_t indexCount, const float* pPositions, uint32_t positionStride, uint32_t vertexCount, uint32_t maxVertices = kDefaultMaxVertices, uint32_t maxTriangles = kDefaultMaxTriangles);
+
+        /** Split the triangle list of a mesh into meshlets
+            \param[in] pLayout The vertex layout. The positions must be RGB32Float.
+            \param[in] buffers Pointer to the data of each buffer in the layout. Can be nullptr for buffers the layout doesn't define.
+            \param[in] vertexCount Number of vertices
+            \param[in] pIndices The triangle list
+            \param[in] indexCount Number of indices
+            \return The meshlets, or an empty vector if the mesh has no float positions or an index is out of range
+        */
+        static std::vector<Meshlet> build(const VertexLayout* pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, const uint32_t* pIndices, uint32_t indexCount);
+
+    private:
+        static void computeBounds(Meshlet& meshlet, const uint32_t* pIndices, const float* pPositions, uint32_t positionStride);
+    };
+}
@@ -46,7 +46,8 @@
 namespace Falcor
 {
 
-    uint32_t Model::sModelCounter = 0;
+    std::atomic<uint32_t> Model::sModelCounter(0);
+    std::atomic<uint32_t> Model::sMeshLayoutVersion(0);
     const char* Model::kSupportedFileFormatsStr = "Supported Formats\0*.obj;*.bin;*.dae;*.x;*.md5mesh;*.ply;*.fbx;*.3ds;*.blend;*.ase;*.ifc;*.xgl;*.zgl;*.dxf;*.lwo;*.lws;*.lxo;*.stl;*.x;*.ac;*.ms3d;*.cob;*.scn;*.3d;*.mdl;*.mdl2;*.pk3;*.smd;*.vta;*.raw;*.ter\0\0";
 
     // Method to sort meshes
@@ -73,6 +74,7 @@ namespace Falcor
         mBufferCount = other.mBufferCount;
         mMaterialCount = other.mMaterialCount;
         mTextureCount = other.mTextureCount;
+        mIsOccluder = other.mIsOccluder;
 
         mMeshes = other.mMeshes;
         if(other.mpAnimationController)
@@ -117,6 +119,12 @@ namespace Falcor
         return pModel;
     }
 
+    Model::AsyncLoad::SharedPtr Model::createFromFileAsync(const char* filename, LoadFlags flags)
+    {
+        std::string file(filename);
+        return AsyncLoad::create([file, flags]() { return createFromFile(file.c_str(), flags); });
+    }
+
     Model::SharedPtr Model::create()
     {
         return SharedPtr(new Model());
@@ -317,6 +325,7 @@ namespace Falcor
         }
 
         mMeshes[meshID].push_back(MeshInstance::create(pMesh, baseTransform));
+        sMeshLayoutVersion++;
     }
 
     void Model::sortMeshes()
@@ -328,6 +337,7 @@ namespace Falcor
         };
         
         std::sort(mMeshes.begin(), mMeshes.end(), matSortPred);
+        sMeshLayoutVersion++;
     }
 
     template<typename T>
@@ -383,6 +393,7 @@ namespace Falcor
         auto pred = [](MeshInstanceList& meshInstances) { return meshInstances.size() == 0; };
         auto& meshesEnd = std::remove_if(mMeshes.begin(), mMeshes.end(), pred);
         mMeshes.erase(meshesEnd, mMeshes.end());
+        sMeshLayoutVersion++;
 
         calculateModelProperties();
     }
@@ -35,6 +35,7 @@
 #include "Graphics/Model/ObjectInstance.h"
 #include "API/Sampler.h"
 #include "Graphics/Model/AnimationController.h"
+#include "Utils/AsyncLoadTask.h"
 
 namespace Falcor
 {
@@ -65,12 +66,27 @@ namespace Falcor
             AssumeLinearSpaceTextures   = 0x4,    ///< By default, textures representing colors (diffuse/specular) are interpreted as sRGB data. Use this flag to force linear space for color textures.
             DontMergeMeshes             = 0x8,    ///< Preserve the original list of meshes in the scene, don't merge meshes with the same material
             BuffersAsShaderResource     = 0x10,   ///< Generate the VBs and IB with the shader-resource-view bind flag
+            KeepCpuGeometry             = 0x20,   ///< Keep a CPU copy of the triangle meshes' positions and indices, for CPU-side algorithms such as occlusion culling. See Mesh::getCpuPositions().
+            OptimizeMeshes              = 0x40,   ///< Reorder the triangles for the post-transform vertex cache and overdraw, and the vertices for fetch locality. See MeshOptimizer. The ACMR before and after is logged.
+            CompressVertices            = 0x80,   ///< Store normals and bitangents octahedral-encoded in 16 bits per component, and texture coordinates in 16 bits when they fit. See VertexCompression.
+            QuantizePositions           = 0x100,  ///< Together with CompressVertices, store the positions in 16 bits per component relative to each mesh's bounding box. Adjacent meshes may show small cracks.
+            PoolGeometry                = 0x200,  ///< Suballocate the meshes from a few shared vertex and index buffers, with 16-bit indices where possible. See GeometryPool. Code reading a mesh's buffers directly must use Mesh::getStartIndex() and Mesh::getBaseVertex().
+            GenerateLods                = 0x400,  ///< Generate a chain of simplified LODs for each mesh which doesn't have LODs yet. See MeshSimplifier. The binary format stores them, so convert the model once and load the result.
+            BuildMeshlets               = 0x800,  ///< Split each mesh into meshlets with bounds and normal cones, so that SceneRenderer can cull parts of large meshes. See MeshletBuilder.
+            DeduplicateGeometry         = 0x1000, ///< Weld identical vertices, and reuse the buffers of meshes identical to ones loaded earlier by this or another model. Identical meshes of one model with equal materials become instances of one mesh. See MeshDeduplicator.
         };
 
+        using AsyncLoad = AsyncObjectLoad<Model>;
+
         /** create a new model from file
         */
         static SharedPtr createFromFile(const char* filename, LoadFlags flags = LoadFlags::None);
 
+        /** Start loading a model from file on a background thread.\n
+            The file is parsed on the background thread, and the GPU resources are created inside AsyncLoad::update(), which the main thread should call once per frame. Once update() returns true, AsyncLoad::getObject() returns the model, or nullptr if the load failed or was cancelled.
+        */
+        static AsyncLoad::SharedPtr createFromFileAsync(const char* filename, LoadFlags flags = LoadFlags::None);
+
         static SharedPtr create();
 
         static const char* kSupportedFileFormatsStr;
@@ -221,6 +237,14 @@ namespace Falcor
         */
         const std::string& getFilename() const { return mFilename; }
 
+        /** Mark the model as an occluder. The instances of occluder models are rasterized by SceneRenderer's occlusion culling pass, if the model's meshes have CPU geometry.
+        */
+        void setOccluder(bool occluder) { mIsOccluder = occluder; }
+
+        /** Check if the model was marked as an occluder
+        */
+        bool isOccluder() const { return mIsOccluder; }
+
         /** Get global ID of the model
         */
         const uint32_t getId() const { return mId; }
@@ -229,6 +253,11 @@ namespace Falcor
         */
         static void resetGlobalIdCounter();
 
+        /** Get a counter which changes whenever any model adds, removes or reorders its meshes or mesh instances.\n
+            Scenes compare it against the value they last saw, instead of checking the mesh instance counts of all their models every frame.
+        */
+        static uint32_t getMeshLayoutVersion() { return sMeshLayoutVersion; }
+
     protected:
         friend class SimpleModelImporter;
 
@@ -249,6 +278,7 @@ namespace Falcor
         uint32_t mTextureCount;
 
         uint32_t mId;
+        bool mIsOccluder = false;
 
         std::vector<MeshInstanceList> mMeshes; // [Mesh][Instance]
 
@@ -257,7 +287,8 @@ namespace Falcor
         std::string mName;
         std::string mFilename;
 
-        static uint32_t sModelCounter;
+        static std::atomic<uint32_t> sModelCounter;
+        static std::atomic<uint32_t> sMeshLayoutVersion;
 
         void calculateModelProperties();
     };
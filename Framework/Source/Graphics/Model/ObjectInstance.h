@@ -125,6 +125,7 @@ namespace Falcor
 
             mBase.translation = translation;
             mBase.matrixDirty = true;
+            mTransformVersion++;
         };
 
         /** Gets the position/translation of the instance
@@ -135,7 +136,7 @@ namespace Falcor
         /** Sets scale of the instance
             \param[in] scaling Instance scale
         */
-        void setScaling(const glm::vec3& scaling) { mBase.scale = scaling; mBase.matrixDirty = true; }
+        void setScaling(const glm::vec3& scaling) { mBase.scale = scaling; mBase.matrixDirty = true; mTransformVersion++; }
 
         /** Gets scale of the instance
             \return Scale of the instance
@@ -155,6 +156,7 @@ namespace Falcor
             mBase.target = mBase.translation + rotMtx[2]; // position + forward
 
             mBase.matrixDirty = true;
+            mTransformVersion++;
         }
 
         /** Gets rotation for the instance
@@ -171,9 +173,9 @@ namespace Falcor
         }
 
 // #toodo comments
-        void setUpVector(const glm::vec3& up) { mBase.up = glm::normalize(up); mBase.matrixDirty = true; }
+        void setUpVector(const glm::vec3& up) { mBase.up = glm::normalize(up); mBase.matrixDirty = true; mTransformVersion++; }
 
-        void setTarget(const glm::vec3& target) { mBase.target = target; mBase.matrixDirty = true; }
+        void setTarget(const glm::vec3& target) { mBase.target = target; mBase.matrixDirty = true; mTransformVersion++; }
 
         /** Gets the up vector of the instance
             \return Up vector
@@ -203,6 +205,11 @@ namespace Falcor
             return mBoundingBox;
         }
 
+        /** Gets a counter which is incremented whenever the instance's transform changes.
+            Can be used to detect moved instances without recalculating their transform.
+        */
+        uint32_t getTransformVersion() const { return mTransformVersion; }
+
         /** IMovableObject interface
         */
         virtual void move(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up) override
@@ -212,6 +219,7 @@ namespace Falcor
             mMovable.up = up;
             mMovable.scale = glm::vec3(1.0f);
             mMovable.matrixDirty = true;
+            mTransformVersion++;
         }
 
         SharedPtr shared_from_this()
@@ -314,6 +322,7 @@ namespace Falcor
 
         mutable Transform mBase;
         mutable Transform mMovable;
+        uint32_t mTransformVersion = 0;
 
         mutable glm::mat4 mFinalTransformMatrix;
         mutable BoundingBox mBoundingBox;
@@ -0,0 +1,297 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TangentSpaceGenerator.h"
+#include "Utils/ThreadPool.h"
+#include <algorithm>
+#include <emmintrin.h>
+
+namespace Falcor
+{
+    static const uint32_t kVertexGrainSize = 16384;  // Vertices per task
+    static const uint32_t kUnused = UINT32_MAX;
+
+    // The values of 4 vertices, one per lane
+    struct Vec3x4
+    {
+        __m128 x, y, z;
+    };
+
+    static inline __m128 negate(__m128 v)
+    {
+        return _mm_xor_ps(v, _mm_set1_ps(-0.0f));
+    }
+
+    static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+    {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+    }
+
+    // Every operation matches the order of the scalar glm code, so that the results are bit-identical to it
+    static inline __m128 dot(const Vec3x4& a, const Vec3x4& b)
+    {
+        return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+    }
+
+    static inline Vec3x4 cross(const Vec3x4& a, const Vec3x4& b)
+    {
+        Vec3x4 r;
+        r.x = _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(b.y, a.z));
+        r.y = _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(b.z, a.x));
+        r.z = _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(b.x, a.y));
+        return r;
+    }
+
+    static inline Vec3x4 normalize(const Vec3x4& v)
+    {
+        const __m128 invLength = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(dot(v, v)));
+        return { _mm_mul_ps(v.x, invLength), _mm_mul_ps(v.y, invLength), _mm_mul_ps(v.z, invLength) };
+    }
+
+    // a - b * s
+    static inline Vec3x4 subtractScaled(const Vec3x4& a, const Vec3x4& b, __m128 s)
+    {
+        return { _mm_sub_ps(a.x, _mm_mul_ps(b.x, s)), _mm_sub_ps(a.y, _mm_mul_ps(b.y, s)), _mm_sub_ps(a.z, _mm_mul_ps(b.z, s)) };
+    }
+
+    static inline Vec3x4 select(__m128 mask, const Vec3x4& a, const Vec3x4& b)
+    {
+        return { select(mask, a.x, b.x), select(mask, a.y, b.y), select(mask, a.z, b.z) };
+    }
+
+    // Lanes with an infinite or NaN component
+    static inline __m128 isSpecial(const Vec3x4& v)
+    {
+        const __m128i exponent = _mm_set1_epi32(0x7f800000);
+        const __m128i x = _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(v.x), exponent), exponent);
+        const __m128i y = _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(v.y), exponent), exponent);
+        const __m128i z = _mm_cmpeq_epi32(_mm_and_si128(_mm_castps_si128(v.z), exponent), exponent);
+        return _mm_castsi128_ps(_mm_or_si128(_mm_or_si128(x, y), z));
+    }
+
+    static inline const float* getVertex(const uint8_t* pData, uint32_t stride, uint32_t vertex)
+    {
+        return (const float*)(pData + (size_t)stride * vertex);
+    }
+
+    // Generate the bitangents of up to 4 vertices. lastCorners holds the location of each vertex's last use in the concatenated triangle lists.
+    static void generateVertices(const TangentSpaceGenerator::MeshDesc& mesh, const std::vector<uint32_t>& listStarts, const uint32_t* pVertices, const uint32_t* pLastCorners, uint32_t count)
+    {
+        // Gather the triangle using each vertex, one per lane. Unused lanes repeat the first vertex.
+        alignas(16) float p[3][3][4];
+        alignas(16) float uv[3][2][4];
+        alignas(16) float triangleNormal[3][4];
+        alignas(16) float normal[3][4];
+        for(uint32_t lane = 0; lane < 4; lane++)
+        {
+            const uint32_t src = lane < count ? lane : 0;
+            const uint32_t corner = pLastCorners[src];
+            const size_t list = std::upper_bound(listStarts.begin(), listStarts.end(), corner) - listStarts.begin() - 1;
+            const uint32_t first = corner - (corner - listStarts[list]) % 3 - listStarts[list];
+            const uint32_t* pTriangle = mesh.submeshIndices[list] + first;
+            for(uint32_t i = 0; i < 3; i++)
+            {
+                const float* pPos = getVertex(mesh.pPositions, mesh.positionStride, pTriangle[i]);
+                p[i][0][lane] = pPos[0];
+                p[i][1][lane] = pPos[1];
+                p[i][2][lane] = pPos[2];
+                const float* pUv = mesh.pTexCrds ? getVertex(mesh.pTexCrds, mesh.texCrdStride, pTriangle[i]) : nullptr;
+                uv[i][0][lane] = pUv ? pUv[0] : 0.0f;
+                uv[i][1][lane] = pUv ? pUv[1] : 0.0f;
+            }
+            const float* pTriangleNormal = getVertex(mesh.pNormals, mesh.normalStride, pTriangle[0]);
+            const float* pNormal = getVertex(mesh.pNormals, mesh.normalStride, pVertices[src]);
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                triangleNormal[c][lane] = pTriangleNormal[c];
+                normal[c][lane] = pNormal[c];
+            }
+        }
+
+        // Position and texture coordinate deltas. The texture V axis points down.
+        Vec3x4 posDelta[2];
+        for(uint32_t i = 0; i < 2; i++)
+        {
+            posDelta[i].x = _mm_sub_ps(_mm_load_ps(p[i + 1][0]), _mm_load_ps(p[0][0]));
+            posDelta[i].y = _mm_sub_ps(_mm_load_ps(p[i + 1][1]), _mm_load_ps(p[0][1]));
+            posDelta[i].z = _mm_sub_ps(_mm_load_ps(p[i + 1][2]), _mm_load_ps(p[0][2]));
+        }
+        const __m128 sx = _mm_sub_ps(_mm_load_ps(uv[1][0]), _mm_load_ps(uv[0][0]));
+        const __m128 sy = negate(_mm_sub_ps(_mm_load_ps(uv[1][1]), _mm_load_ps(uv[0][1])));
+        const __m128 tx = _mm_sub_ps(_mm_load_ps(uv[2][0]), _mm_load_ps(uv[0][0]));
+        const __m128 ty = negate(_mm_sub_ps(_mm_load_ps(uv[2][1]), _mm_load_ps(uv[0][1])));
+
+        // The tangent points along the texture's X axis in model space, the bitangent along its Y axis
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+        const __m128 dirCorrection = select(_mm_cmplt_ps(_mm_sub_ps(_mm_mul_ps(tx, sy), _mm_mul_ps(ty, sx)), zero), _mm_set1_ps(-1.0f), one);
+        Vec3x4 tangent;
+        tangent.x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(posDelta[1].x, sy), _mm_mul_ps(posDelta[0].x, ty)), dirCorrection);
+        tangent.y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(posDelta[1].y, sy), _mm_mul_ps(posDelta[0].y, ty)), dirCorrection);
+        tangent.z = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(posDelta[1].z, sy), _mm_mul_ps(posDelta[0].z, ty)), dirCorrection);
+        Vec3x4 bitangent;
+        bitangent.x = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(posDelta[1].x, sx), _mm_mul_ps(posDelta[0].x, tx)), dirCorrection);
+        bitangent.y = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(posDelta[1].y, sx), _mm_mul_ps(posDelta[0].y, tx)), dirCorrection);
+        bitangent.z = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(posDelta[1].z, sx), _mm_mul_ps(posDelta[0].z, tx)), dirCorrection);
+
+        // When two corners share their texture coordinates, the frame is built around the first corner's normal instead
+        const __m128 degenerate = _mm_or_ps(_mm_and_ps(_mm_cmpeq_ps(sx, zero), _mm_cmpeq_ps(sy, zero)), _mm_and_ps(_mm_cmpeq_ps(tx, zero), _mm_cmpeq_ps(ty, zero)));
+        if(_mm_movemask_ps(degenerate))
+        {
+            const Vec3x4 n = { _mm_load_ps(triangleNormal[0]), _mm_load_ps(triangleNormal[1]), _mm_load_ps(triangleNormal[2]) };
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+            const __m128 useX = _mm_cmpgt_ps(_mm_and_ps(n.x, absMask), _mm_and_ps(n.y, absMask));
+            const __m128 lengthX = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(n.x, n.x), _mm_mul_ps(n.z, n.z)));
+            const __m128 lengthY = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(n.y, n.y), _mm_mul_ps(n.z, n.z)));
+            Vec3x4 fallbackBitangent;
+            fallbackBitangent.x = select(useX, _mm_div_ps(n.z, lengthX), _mm_div_ps(zero, lengthY));
+            fallbackBitangent.y = select(useX, _mm_div_ps(zero, lengthX), _mm_div_ps(n.z, lengthY));
+            fallbackBitangent.z = select(useX, _mm_div_ps(negate(n.x), lengthX), _mm_div_ps(negate(n.y), lengthY));
+            tangent = select(degenerate, cross(fallbackBitangent, n), tangent);
+            bitangent = select(degenerate, fallbackBitangent, bitangent);
+        }
+
+        // Project the tangent and bitangent into the plane of the vertex's normal. Rebuild the bitangent from the normal and tangent if it's infinite or NaN.
+        const Vec3x4 n = { _mm_load_ps(normal[0]), _mm_load_ps(normal[1]), _mm_load_ps(normal[2]) };
+        const Vec3x4 localTangent = normalize(subtractScaled(tangent, n, dot(tangent, n)));
+        Vec3x4 localBitangent = normalize(subtractScaled(bitangent, n, dot(bitangent, n)));
+        localBitangent = normalize(subtractScaled(localBitangent, localTangent, dot(localBitangent, localTangent)));
+        const __m128 invalid = isSpecial(localBitangent);
+        if(_mm_movemask_ps(invalid))
+        {
+            localBitangent = select(invalid, normalize(cross(localTangent, n)), localBitangent);
+        }
+
+        alignas(16) float result[3][4];
+        _mm_store_ps(result[0], localBitangent.x);
+        _mm_store_ps(result[1], localBitangent.y);
+        _mm_store_ps(result[2], localBitangent.z);
+        for(uint32_t lane = 0; lane < count; lane++)
+        {
+            float* pBitangent = (float*)(mesh.pBitangents + (size_t)mesh.bitangentStride * pVertices[lane]);
+            pBitangent[0] = result[0][lane];
+            pBitangent[1] = result[1][lane];
+            pBitangent[2] = result[2][lane];
+        }
+    }
+
+    bool TangentSpaceGenerator::generateBitangents(const std::vector<MeshDesc>& meshes)
+    {
+        // Find the last corner using each vertex. This is what makes the parallel result match the sequential one.
+        struct MeshState
+        {
+            std::vector<uint32_t> listStarts;
+            std::vector<uint32_t> lastCorners;
+            bool valid = true;
+        };
+        std::vector<MeshState> states(meshes.size());
+        ThreadPool* pPool = ThreadPool::getGlobalPool();
+        pPool->parallelFor((uint32_t)meshes.size(), 1, [&meshes, &states](uint32_t first, uint32_t last)
+        {
+            for(uint32_t meshID = first; meshID < last; meshID++)
+            {
+                const MeshDesc& mesh = meshes[meshID];
+                MeshState& state = states[meshID];
+                state.lastCorners.assign(mesh.vertexCount, kUnused);
+                uint32_t corner = 0;
+                for(size_t list = 0; list < mesh.submeshIndices.size() && state.valid; list++)
+                {
+                    state.listStarts.push_back(corner);
+                    const uint32_t* pIndices = mesh.submeshIndices[list];
+                    const uint32_t indexCount = mesh.submeshIndexCounts[list] - mesh.submeshIndexCounts[list] % 3;
+                    for(uint32_t i = 0; i < indexCount; i++)
+                    {
+                        if(pIndices[i] >= mesh.vertexCount)
+                        {
+                            state.valid = false;
+                            break;
+                        }
+                        state.lastCorners[pIndices[i]] = corner + i;
+                    }
+                    corner += mesh.submeshIndexCounts[list];
+                }
+            }
+        });
+
+        // Split the vertices of all the meshes into ranges
+        struct VertexRange
+        {
+            uint32_t meshID;
+            uint32_t first;
+            uint32_t last;
+        };
+        std::vector<VertexRange> ranges;
+        bool valid = true;
+        for(uint32_t meshID = 0; meshID < (uint32_t)meshes.size(); meshID++)
+        {
+            valid = valid && states[meshID].valid;
+            if(states[meshID].valid == false || meshes[meshID].pNormals == nullptr || meshes[meshID].pBitangents == nullptr)
+            {
+                continue;
+            }
+            for(uint32_t first = 0; first < meshes[meshID].vertexCount; first += kVertexGrainSize)
+            {
+                ranges.push_back({ meshID, first, std::min(first + kVertexGrainSize, meshes[meshID].vertexCount) });
+            }
+        }
+
+        pPool->parallelFor((uint32_t)ranges.size(), 1, [&meshes, &states, &ranges](uint32_t first, uint32_t last)
+        {
+            for(uint32_t rangeID = first; rangeID < last; rangeID++)
+            {
+                const VertexRange& range = ranges[rangeID];
+                const MeshDesc& mesh = meshes[range.meshID];
+                const MeshState& state = states[range.meshID];
+
+                // Collect the used vertices into groups of 4
+                uint32_t vertices[4];
+                uint32_t lastCorners[4];
+                uint32_t count = 0;
+                for(uint32_t v = range.first; v < range.last; v++)
+                {
+                    if(state.lastCorners[v] == kUnused)
+                    {
+                        continue;
+                    }
+                    vertices[count] = v;
+                    lastCorners[count] = state.lastCorners[v];
+                    if(++count == 4)
+                    {
+                        generateVertices(mesh, state.listStarts, vertices, lastCorners, count);
+                        count = 0;
+                    }
+                }
+                if(count)
+                {
+                    generateVertices(mesh, state.listStarts, vertices, lastCorners, count);
+                }
+            }
+        });
+        return valid;
+    }
+}
@@ -0,0 +1,70 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** Generates the per-vertex bitangents the shaders use to reconstruct the tangent frame.\n
+        Each triangle computes a tangent and a bitangent from its positions and texture coordinates, and each vertex takes the ones of the last triangle using it, orthogonalized against its normal.
+        The vertices are processed in parallel, 4 at a time with SSE, and the result is bit-identical to processing the triangles one after the other.
+    */
+    class TangentSpaceGenerator
+    {
+    public:
+        /** The vertex data of a mesh. All the vertex data pointers address the first vertex, with a byte stride between vertices.
+        */
+        struct MeshDesc
+        {
+            const uint8_t* pPositions = nullptr;            ///< 3 floats per vertex
+            uint32_t positionStride = 0;
+            const uint8_t* pNormals = nullptr;              ///< 3 floats per vertex
+            uint32_t normalStride = 0;
+            const uint8_t* pTexCrds = nullptr;              ///< 2 floats per vertex. If this is nullptr, the frame is built around the normals.
+            uint32_t texCrdStride = 0;
+            uint32_t vertexCount = 0;
+            std::vector<const uint32_t*> submeshIndices;    ///< The triangle lists using the vertices. When several triangles share a vertex, the last one in the last list wins.
+            std::vector<uint32_t> submeshIndexCounts;
+            uint8_t* pBitangents = nullptr;                 ///< Output, 3 floats per vertex. Vertices no triangle uses are left unchanged.
+            uint32_t bitangentStride = 0;
+        };
+
+        /** Generate the bitangents of several meshes. The meshes and the vertex ranges within them are processed in parallel.
+            \param[in] meshes The meshes
+            \return false if an index of a mesh is out of range. That mesh's bitangents are left unchanged, the other meshes are processed.
+        */
+        static bool generateBitangents(const std::vector<MeshDesc>& meshes);
+
+        /** Generate the bitangents of a mesh
+            \param[in] mesh The mesh
+            \return false if an index is out of range, in which case the bitangents are left unchanged
+        */
+        static bool generateBitangents(const MeshDesc& mesh) { return generateBitangents(std::vector<MeshDesc>(1, mesh)); }
+    };
+}
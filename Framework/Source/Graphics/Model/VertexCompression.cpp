@@ -0,0 +1,303 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "VertexCompression.h"
+#include "glm/geometric.hpp"
+#include "glm/packing.hpp"
+#include "glm/gtc/packing.hpp"
+#include <cfloat>
+#include <cstring>
+
+namespace Falcor
+{
+    // Texture coordinates larger than this are kept as floats, since half floats would be off by more than 1/1024
+    static const float kMaxHalfTexCrd = 2.0f;
+
+    static glm::vec2 signNotZero(const glm::vec2& v)
+    {
+        return glm::vec2(v.x >= 0 ? 1.0f : -1.0f, v.y >= 0 ? 1.0f : -1.0f);
+    }
+
+    uint32_t VertexCompression::encodeOctahedral(const glm::vec3& v)
+    {
+        const float sum = glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+        if(sum == 0)
+        {
+            return glm::packSnorm2x16(glm::vec2(0));
+        }
+
+        // Project onto the octahedron, then fold the lower hemisphere over the upper one
+        glm::vec2 p = glm::vec2(v.x, v.y) / sum;
+        if(v.z < 0)
+        {
+            p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * signNotZero(p);
+        }
+        return glm::packSnorm2x16(p);
+    }
+
+    glm::vec3 VertexCompression::decodeOctahedral(uint32_t packed)
+    {
+        const glm::vec2 p = glm::unpackSnorm2x16(packed);
+        glm::vec3 v(p.x, p.y, 1.0f - glm::abs(p.x) - glm::abs(p.y));
+        if(v.z < 0)
+        {
+            const glm::vec2 xy = (1.0f - glm::abs(glm::vec2(v.y, v.x))) * signNotZero(glm::vec2(v.x, v.y));
+            v.x = xy.x;
+            v.y = xy.y;
+        }
+        return glm::normalize(v);
+    }
+
+    uint32_t VertexCompression::getDecodedComponentCount(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::RGBA16Unorm:   // Quantized positions
+        case ResourceFormat::RG16Snorm:     // Octahedral normals and bitangents
+            return 3;
+        case ResourceFormat::RG16Unorm:     // Texture coordinates
+        case ResourceFormat::RG16Float:
+            return 2;
+        default:
+            return 0;
+        }
+    }
+
+    void VertexCompression::decodeValue(ResourceFormat format, const uint8_t* pValue, const glm::vec3& positionScale, const glm::vec3& positionBias, float* pDecoded)
+    {
+        uint64_t packed = 0;
+        std::memcpy(&packed, pValue, getFormatBytesPerBlock(format));
+
+        glm::vec3 value;
+        switch(format)
+        {
+        case ResourceFormat::RGBA16Unorm:
+            value = glm::vec3(glm::unpackUnorm4x16(packed)) * positionScale + positionBias;
+            break;
+        case ResourceFormat::RG16Snorm:
+            value = decodeOctahedral((uint32_t)packed);
+            break;
+        case ResourceFormat::RG16Unorm:
+            value = glm::vec3(glm::unpackUnorm2x16((uint32_t)packed), 0);
+            break;
+        case ResourceFormat::RG16Float:
+            value = glm::vec3(glm::unpackHalf2x16((uint32_t)packed), 0);
+            break;
+        default:
+            should_not_get_here();
+            return;
+        }
+        std::memcpy(pDecoded, &value, getDecodedComponentCount(format) * sizeof(float));
+    }
+
+    enum class ElementEncoding
+    {
+        Copy,
+        Octahedral,
+        TexCrdUnorm,
+        TexCrdHalf,
+        QuantizedPosition,
+    };
+
+    static uint32_t getFloatComponentCount(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::RG32Float:
+            return 2;
+        case ResourceFormat::RGB32Float:
+            return 3;
+        case ResourceFormat::RGBA32Float:
+            return 4;
+        default:
+            return 0;
+        }
+    }
+
+    template<typename Func>
+    static void forEachElementValue(const uint8_t* pData, uint32_t stride, uint32_t offset, uint32_t vertexCount, Func func)
+    {
+        for(uint32_t i = 0; i < vertexCount; i++)
+        {
+            const float* pValue = (const float*)(pData + (size_t)stride * i + offset);
+            func(i, pValue);
+        }
+    }
+
+    static ElementEncoding chooseTexCrdEncoding(const uint8_t* pData, uint32_t stride, uint32_t offset, uint32_t vertexCount)
+    {
+        glm::vec2 minCrd(FLT_MAX);
+        glm::vec2 maxCrd(-FLT_MAX);
+        forEachElementValue(pData, stride, offset, vertexCount, [&](uint32_t, const float* pValue)
+        {
+            minCrd = glm::min(minCrd, glm::vec2(pValue[0], pValue[1]));
+            maxCrd = glm::max(maxCrd, glm::vec2(pValue[0], pValue[1]));
+        });
+
+        if(glm::all(glm::greaterThanEqual(minCrd, glm::vec2(0))) && glm::all(glm::lessThanEqual(maxCrd, glm::vec2(1))))
+        {
+            return ElementEncoding::TexCrdUnorm;
+        }
+        if(glm::all(glm::greaterThanEqual(minCrd, glm::vec2(-kMaxHalfTexCrd))) && glm::all(glm::lessThanEqual(maxCrd, glm::vec2(kMaxHalfTexCrd))))
+        {
+            return ElementEncoding::TexCrdHalf;
+        }
+        return ElementEncoding::Copy;
+    }
+
+    template<typename T>
+    static void writeValue(uint8_t* pDst, const T& value)
+    {
+        std::memcpy(pDst, &value, sizeof(T));
+    }
+
+    VertexCompression::Result VertexCompression::compressVertices(const VertexLayout* pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, bool quantizePositions)
+    {
+        Result result;
+        result.pLayout = VertexLayout::create();
+        result.buffers.resize(pLayout->getBufferCount());
+
+        for(uint32_t bufferIndex = 0; bufferIndex < (uint32_t)pLayout->getBufferCount(); bufferIndex++)
+        {
+            const VertexBufferLayout* pSrcLayout = pLayout->getBufferLayout(bufferIndex).get();
+            if(pSrcLayout == nullptr || buffers[bufferIndex] == nullptr)
+            {
+                result.pLayout->addBufferLayout(bufferIndex, pLayout->getBufferLayout(bufferIndex));
+                continue;
+            }
+
+            const uint8_t* pSrc = buffers[bufferIndex];
+            const uint32_t srcStride = pSrcLayout->getStride();
+
+            // Choose the encoding of each element and build the new layout
+            VertexBufferLayout::SharedPtr pDstLayout = VertexBufferLayout::create();
+            pDstLayout->setInputClass(pSrcLayout->getInputClass(), pSrcLayout->getInstanceStepRate());
+            std::vector<ElementEncoding> encodings(pSrcLayout->getElementCount(), ElementEncoding::Copy);
+            std::vector<uint32_t> dstOffsets(pSrcLayout->getElementCount());
+            uint32_t dstOffset = 0;
+            for(uint32_t elementID = 0; elementID < pSrcLayout->getElementCount(); elementID++)
+            {
+                const uint32_t srcOffset = pSrcLayout->getElementOffset(elementID);
+                const uint32_t componentCount = pSrcLayout->getElementArraySize(elementID) == 1 ? getFloatComponentCount(pSrcLayout->getElementFormat(elementID)) : 0;
+                ResourceFormat format = pSrcLayout->getElementFormat(elementID);
+
+                switch(pSrcLayout->getElementShaderLocation(elementID))
+                {
+                case VERTEX_POSITION_LOC:
+                    if(quantizePositions && componentCount >= 3)
+                    {
+                        glm::vec3 boxMin(FLT_MAX);
+                        glm::vec3 boxMax(-FLT_MAX);
+                        forEachElementValue(pSrc, srcStride, srcOffset, vertexCount, [&](uint32_t, const float* pValue)
+                        {
+                            boxMin = glm::min(boxMin, glm::vec3(pValue[0], pValue[1], pValue[2]));
+                            boxMax = glm::max(boxMax, glm::vec3(pValue[0], pValue[1], pValue[2]));
+                        });
+
+                        if(vertexCount)
+                        {
+                            // Flat boxes still need a scale the encoding can divide by
+                            result.positionBias = boxMin;
+                            result.positionScale = glm::max(boxMax - boxMin, glm::vec3(FLT_MIN));
+                            encodings[elementID] = ElementEncoding::QuantizedPosition;
+                            format = ResourceFormat::RGBA16Unorm;
+                        }
+                    }
+                    break;
+                case VERTEX_NORMAL_LOC:
+                case VERTEX_BITANGENT_LOC:
+                    if(componentCount >= 3)
+                    {
+                        encodings[elementID] = ElementEncoding::Octahedral;
+                        format = ResourceFormat::RG16Snorm;
+                    }
+                    break;
+                case VERTEX_TEXCOORD_LOC:
+                case VERTEX_LIGHTMAP_UV_LOC:
+                    if(componentCount >= 2)
+                    {
+                        encodings[elementID] = chooseTexCrdEncoding(pSrc, srcStride, srcOffset, vertexCount);
+                        if(encodings[elementID] != ElementEncoding::Copy)
+                        {
+                            format = (encodings[elementID] == ElementEncoding::TexCrdUnorm) ? ResourceFormat::RG16Unorm : ResourceFormat::RG16Float;
+                        }
+                    }
+                    break;
+                }
+
+                dstOffsets[elementID] = dstOffset;
+                pDstLayout->addElement(pSrcLayout->getElementName(elementID), dstOffset, format, pSrcLayout->getElementArraySize(elementID), pSrcLayout->getElementShaderLocation(elementID));
+                dstOffset = pDstLayout->getStride();
+            }
+
+            // Convert the data
+            const uint32_t dstStride = pDstLayout->getStride();
+            std::vector<uint8_t>& dst = result.buffers[bufferIndex];
+            dst.resize((size_t)dstStride * vertexCount);
+            for(uint32_t elementID = 0; elementID < pSrcLayout->getElementCount(); elementID++)
+            {
+                const uint32_t srcOffset = pSrcLayout->getElementOffset(elementID);
+                const uint32_t srcSize = getFormatBytesPerBlock(pSrcLayout->getElementFormat(elementID)) * pSrcLayout->getElementArraySize(elementID);
+                uint8_t* pDst = dst.data() + dstOffsets[elementID];
+                const ElementEncoding encoding = encodings[elementID];
+
+                forEachElementValue(pSrc, srcStride, srcOffset, vertexCount, [&](uint32_t vertex, const float* pValue)
+                {
+                    uint8_t* pDstValue = pDst + (size_t)dstStride * vertex;
+                    switch(encoding)
+                    {
+                    case ElementEncoding::Copy:
+                        std::memcpy(pDstValue, pValue, srcSize);
+                        break;
+                    case ElementEncoding::Octahedral:
+                        writeValue(pDstValue, encodeOctahedral(glm::vec3(pValue[0], pValue[1], pValue[2])));
+                        break;
+                    case ElementEncoding::TexCrdUnorm:
+                        writeValue(pDstValue, glm::packUnorm2x16(glm::vec2(pValue[0], pValue[1])));
+                        break;
+                    case ElementEncoding::TexCrdHalf:
+                        writeValue(pDstValue, glm::packHalf2x16(glm::vec2(pValue[0], pValue[1])));
+                        break;
+                    case ElementEncoding::QuantizedPosition:
+                        {
+                            const glm::vec3 p = (glm::vec3(pValue[0], pValue[1], pValue[2]) - result.positionBias) / result.positionScale;
+                            writeValue(pDstValue, glm::packUnorm4x16(glm::vec4(p, 1)));
+                        }
+                        break;
+                    default:
+                        should_not_get_here();
+                    }
+                });
+            }
+
+            result.pLayout->addBufferLayout(bufferIndex, pDstLayout);
+        }
+
+        return result;
+    }
+}
@@ -0,0 +1,85 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include "glm/vec3.hpp"
+#include "API/VertexLayout.h"
+
+namespace Falcor
+{
+    /** Converts the 32-bit float vertex attributes of a mesh into compact formats.\n
+        Normals and bitangents are stored as octahedral-encoded RG16Snorm (Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors", 2014).
+        Texture coordinates are stored as RG16Unorm if they are inside [0, 1], as RG16Float if they are small enough for half precision, and are kept as floats otherwise.
+        Positions can optionally be stored as RGBA16Unorm relative to the bounding box of the vertices. The box is passed to the shaders through the mesh, see Mesh::getPositionScale().\n
+        The shaders detect the encoding from the vertex layout, and decode the attributes with the helpers in VertexAttrib.h.
+    */
+    class VertexCompression
+    {
+    public:
+        struct Result
+        {
+            VertexLayout::SharedPtr pLayout;
+            std::vector<std::vector<uint8_t>> buffers;      ///< The vertex data of each buffer of the layout. Empty for buffers the source layout doesn't define.
+            glm::vec3 positionScale = glm::vec3(1);         ///< Decoded position = encoded position * scale + bias
+            glm::vec3 positionBias = glm::vec3(0);
+        };
+
+        /** Compress the vertex buffers of a mesh
+            \param[in] pLayout The layout of the source buffers
+            \param[in] buffers Pointer to the data of each buffer in the layout. Can be nullptr for buffers the layout doesn't define.
+            \param[in] vertexCount Number of vertices
+            \param[in] quantizePositions Store the positions with 16 bits relative to the bounding box of the vertices. Vertices shared by meshes with different boxes may no longer match exactly.
+            \return The new layout and the buffer data for it
+        */
+        static Result compressVertices(const VertexLayout* pLayout, const std::vector<const uint8_t*>& buffers, uint32_t vertexCount, bool quantizePositions);
+
+        /** Encode a unit vector as two 16-bit signed normalized values, packed like an RG16Snorm texel
+        */
+        static uint32_t encodeOctahedral(const glm::vec3& v);
+
+        /** Decode a vector encoded with encodeOctahedral()
+        */
+        static glm::vec3 decodeOctahedral(uint32_t packed);
+
+        /** Get the number of floats an attribute stored by compressVertices() decodes to
+            \param[in] format The attribute's format in the compressed layout
+            \return The number of floats, or 0 if compressVertices() doesn't store attributes in this format
+        */
+        static uint32_t getDecodedComponentCount(ResourceFormat format);
+
+        /** Decode an attribute stored by compressVertices() back to floats
+            \param[in] format The attribute's format in the compressed layout. getDecodedComponentCount() must not return 0 for it.
+            \param[in] pValue The encoded attribute
+            \param[in] positionScale The position scale of the mesh, only used for quantized positions. See Mesh::getPositionScale().
+            \param[in] positionBias The position bias of the mesh, only used for quantized positions
+            \param[out] pDecoded Receives getDecodedComponentCount() floats
+        */
+        static void decodeValue(ResourceFormat format, const uint8_t* pValue, const glm::vec3& positionScale, const glm::vec3& positionBias, float* pDecoded);
+    };
+}
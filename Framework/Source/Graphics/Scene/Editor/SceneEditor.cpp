@@ -826,6 +826,20 @@ namespace Falcor
         return name;
     }
 
+    bool SceneEditor::pickScene(RenderContext* pContext, const glm::vec2& mousePos)
+    {
+        // Picking with rays avoids rendering the scene and reading back the result, but needs the CPU copy of the geometry.
+        // Skinned meshes and meshes loaded without CPU geometry can't be hit by rays, so a miss falls back to the GPU pick.
+        if (is_set(mModelLoadFlags, Model::LoadFlags::KeepCpuGeometry))
+        {
+            if (mpScenePicker->pick(mousePos, mpEditorScene->getActiveCamera()))
+            {
+                return true;
+            }
+        }
+        return mpScenePicker->pick(pContext, mousePos, mpEditorScene->getActiveCamera());
+    }
+
     bool SceneEditor::onMouseEvent(RenderContext* pContext, const MouseEvent& mouseEvent)
     {
         // Update mouse hold timer
@@ -882,7 +896,7 @@ namespace Falcor
                     {
                         select(mpEditorPicker->getPickedModelInstance());
                     }
-                    else if (mpScenePicker->pick(pContext, mouseEvent.pos, mpEditorScene->getActiveCamera()))
+                    else if (pickScene(pContext, mouseEvent.pos))
                     {
                         select(mpScenePicker->getPickedModelInstance(), mpScenePicker->getPickedMeshInstance());
                     }
@@ -191,6 +191,9 @@ namespace Falcor
         void select(const Scene::ModelInstance::SharedPtr& pModelInstance, const Model::MeshInstance::SharedPtr& pMeshInstance = nullptr);
         void deselect();
 
+        // Pick from the master scene. Casts a ray on the CPU if the models were loaded with their CPU geometry, otherwise renders the scene.
+        bool pickScene(RenderContext* pContext, const glm::vec2& mousePos);
+
         void setActiveModelInstance(const Scene::ModelInstance::SharedPtr& pModelInstance);
 
         // ID's in master scene
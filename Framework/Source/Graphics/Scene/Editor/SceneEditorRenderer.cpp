@@ -51,6 +51,8 @@ namespace Falcor
     SceneEditorRenderer::SceneEditorRenderer(const Scene::SharedPtr& pScene)
         : SceneRenderer(pScene)
     {
+        // Gizmos change the render state per model instance
+        mBatchModelInstances = false;
         mpGraphicsState = GraphicsState::create();
 
         // Solid Rasterizer state
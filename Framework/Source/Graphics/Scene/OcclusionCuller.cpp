@@ -0,0 +1,325 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "OcclusionCuller.h"
+#include <xmmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+namespace Falcor
+{
+    // Vertices closer than this to the eye plane aren't projected. Triangles and boxes which have such vertices, or vertices in front of the near plane, are skipped or treated as visible.
+    static const float kMinW = 1e-4f;
+
+    static bool isOutsideNearPlane(const glm::vec4& clip)
+    {
+        return clip.w < kMinW || clip.z < 0;
+    }
+
+    // Relative depth tolerance. Keeps occluders from hiding themselves due to rounding, e.g. a wall whose bounding box is flat.
+    static const float kDepthTolerance = 1e-6f;
+
+    static uint32_t alignUp(uint32_t value, uint32_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    OcclusionCuller::UniquePtr OcclusionCuller::create(uint32_t width, uint32_t height)
+    {
+        return UniquePtr(new OcclusionCuller(alignUp(std::max(width, 1u), kTileSize), alignUp(std::max(height, 1u), kTileSize)));
+    }
+
+    OcclusionCuller::OcclusionCuller(uint32_t width, uint32_t height) : mWidth(width), mHeight(height), mOccluderCount(0), mOccluderTriangleCount(0), mTestedBoxCount(0), mOccludedBoxCount(0)
+    {
+        mTilesX = mWidth / kTileSize;
+        mTilesY = mHeight / kTileSize;
+        mDepth.assign(mWidth * mHeight, FLT_MAX);
+        mTileMaxDepth.assign(mTilesX * mTilesY, FLT_MAX);
+    }
+
+    void OcclusionCuller::beginFrame(const glm::mat4& viewProjMat)
+    {
+        mViewProjMat = viewProjMat;
+        std::fill(mDepth.begin(), mDepth.end(), FLT_MAX);
+        std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), FLT_MAX);
+        mOccluderCount = 0;
+        mOccluderTriangleCount = 0;
+        mTestedBoxCount = 0;
+        mOccludedBoxCount = 0;
+    }
+
+    OcclusionCuller::Statistics OcclusionCuller::getStatistics() const
+    {
+        Statistics stats;
+        stats.occluderCount = mOccluderCount;
+        stats.occluderTriangleCount = mOccluderTriangleCount;
+        stats.testedBoxCount = mTestedBoxCount;
+        stats.occludedBoxCount = mOccludedBoxCount;
+        return stats;
+    }
+
+    void OcclusionCuller::rasterizeOccluder(const glm::vec3* pPositions, const uint32_t* pIndices, uint32_t indexCount, const glm::mat4& worldMat)
+    {
+        // Project all the vertices first, they are usually shared by several triangles. Vertices outside the near plane are marked, they can't be clipped.
+        uint32_t vertexCount = 0;
+        for (uint32_t i = 0; i < indexCount; i++)
+        {
+            vertexCount = std::max(vertexCount, pIndices[i] + 1);
+        }
+
+        const glm::mat4 mat = mViewProjMat * worldMat;
+        mScreenVerts.resize(vertexCount);
+        mSkippedVerts.resize(vertexCount);
+        for (uint32_t i = 0; i < vertexCount; i++)
+        {
+            const glm::vec4 clip = mat * glm::vec4(pPositions[i], 1);
+            mSkippedVerts[i] = isOutsideNearPlane(clip) ? 1 : 0;
+            if (mSkippedVerts[i] == 0)
+            {
+                const float invW = 1 / clip.w;
+                mScreenVerts[i] = glm::vec3((clip.x * invW * 0.5f + 0.5f) * mWidth, (0.5f - clip.y * invW * 0.5f) * mHeight, clip.z * invW);
+            }
+        }
+
+        uint32_t triangleCount = 0;
+        for (uint32_t i = 0; i + 2 < indexCount; i += 3)
+        {
+            const uint32_t i0 = pIndices[i];
+            const uint32_t i1 = pIndices[i + 1];
+            const uint32_t i2 = pIndices[i + 2];
+
+            // Skipping a triangle only makes the culling less effective, never wrong
+            if (mSkippedVerts[i0] || mSkippedVerts[i1] || mSkippedVerts[i2])
+            {
+                continue;
+            }
+
+            rasterizeTriangle(mScreenVerts[i0], mScreenVerts[i1], mScreenVerts[i2]);
+            triangleCount++;
+        }
+
+        mOccluderCount++;
+        mOccluderTriangleCount += triangleCount;
+    }
+
+    void OcclusionCuller::rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1In, const glm::vec3& v2In)
+    {
+        // Make the winding counter-clockwise in screen space, so that both sides are rasterized
+        float area = (v1In.x - v0.x) * (v2In.y - v0.y) - (v1In.y - v0.y) * (v2In.x - v0.x);
+        if (area == 0)
+        {
+            return;
+        }
+        const glm::vec3& v1 = (area > 0) ? v1In : v2In;
+        const glm::vec3& v2 = (area > 0) ? v2In : v1In;
+        area = std::abs(area);
+
+        // Pixel bounds, with the left edge aligned to the SIMD width
+        const float minX = std::min(v0.x, std::min(v1.x, v2.x));
+        const float maxX = std::max(v0.x, std::max(v1.x, v2.x));
+        const float minY = std::min(v0.y, std::min(v1.y, v2.y));
+        const float maxY = std::max(v0.y, std::max(v1.y, v2.y));
+        if (maxX < 0 || maxY < 0 || minX >= mWidth || minY >= mHeight)
+        {
+            return;
+        }
+        const int32_t x0 = std::max((int32_t)std::floor(minX), 0) & ~3;
+        const int32_t x1 = std::min((int32_t)std::floor(maxX), (int32_t)mWidth - 1);
+        const int32_t y0 = std::max((int32_t)std::floor(minY), 0);
+        const int32_t y1 = std::min((int32_t)std::floor(maxY), (int32_t)mHeight - 1);
+
+        // Edge functions e(p) = a * p.x + b * p.y + c, positive inside the triangle. Edge N is opposite to vertex N.
+        const float a0 = v1.y - v2.y, b0 = v2.x - v1.x, c0 = v1.x * v2.y - v1.y * v2.x;
+        const float a1 = v2.y - v0.y, b1 = v0.x - v2.x, c1 = v2.x * v0.y - v2.y * v0.x;
+        const float a2 = v0.y - v1.y, b2 = v1.x - v0.x, c2 = v0.x * v1.y - v0.y * v1.x;
+
+        // Depth is linear in screen space
+        const float invArea = 1 / area;
+        const float za = (a0 * v0.z + a1 * v1.z + a2 * v2.z) * invArea;
+        const float zb = (b0 * v0.z + b1 * v1.z + b2 * v2.z) * invArea;
+        const float zc = (c0 * v0.z + c1 * v1.z + c2 * v2.z) * invArea;
+
+        const __m128 pixelOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+        const __m128 zero = _mm_setzero_ps();
+
+        for (int32_t y = y0; y <= y1; y++)
+        {
+            const float py = y + 0.5f;
+            const __m128 e0Row = _mm_set1_ps(b0 * py + c0);
+            const __m128 e1Row = _mm_set1_ps(b1 * py + c1);
+            const __m128 e2Row = _mm_set1_ps(b2 * py + c2);
+            const __m128 zRow = _mm_set1_ps(zb * py + zc);
+            float* pRow = &mDepth[y * mWidth];
+
+            for (int32_t x = x0; x <= x1; x += 4)
+            {
+                const __m128 px = _mm_add_ps(_mm_set1_ps((float)x), pixelOffsets);
+                const __m128 e0 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a0), px), e0Row);
+                const __m128 e1 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a1), px), e1Row);
+                const __m128 e2 = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(a2), px), e2Row);
+                const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+                if (_mm_movemask_ps(inside) == 0)
+                {
+                    continue;
+                }
+
+                const __m128 z = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), px), zRow);
+                const __m128 oldDepth = _mm_loadu_ps(pRow + x);
+                const __m128 newDepth = _mm_min_ps(oldDepth, z);
+                _mm_storeu_ps(pRow + x, _mm_or_ps(_mm_and_ps(inside, newDepth), _mm_andnot_ps(inside, oldDepth)));
+            }
+        }
+    }
+
+    void OcclusionCuller::finalizeOccluders()
+    {
+        // Coverage and depth were sampled at pixel centers, but a box can also be seen through the rest of a pixel.
+        // Replace each pixel by the farthest depth of its 3x3 neighborhood. The neighbors' centers enclose the pixel, so it now only occludes if it's fully covered, and its depth bounds the occluder's depth over the whole pixel.
+        // Pixels outside the screen count as uncovered.
+        mScratch.resize(mDepth.size());
+        for (uint32_t y = 0; y < mHeight; y++)
+        {
+            const float* pSrc = &mDepth[y * mWidth];
+            float* pDst = &mScratch[y * mWidth];
+            pDst[0] = FLT_MAX;
+            for (uint32_t x = 1; x + 4 < mWidth; x += 4)
+            {
+                const __m128 left = _mm_loadu_ps(pSrc + x - 1);
+                const __m128 center = _mm_loadu_ps(pSrc + x);
+                const __m128 right = _mm_loadu_ps(pSrc + x + 1);
+                _mm_storeu_ps(pDst + x, _mm_max_ps(_mm_max_ps(left, center), right));
+            }
+            // The row width is a multiple of the tile size, so the SIMD loop stops 3 pixels before the last one
+            for (uint32_t x = mWidth - 3; x < mWidth - 1; x++)
+            {
+                pDst[x] = std::max(std::max(pSrc[x - 1], pSrc[x]), pSrc[x + 1]);
+            }
+            pDst[mWidth - 1] = FLT_MAX;
+        }
+
+        std::fill(mDepth.begin(), mDepth.begin() + mWidth, FLT_MAX);
+        std::fill(mDepth.end() - mWidth, mDepth.end(), FLT_MAX);
+        for (uint32_t y = 1; y + 1 < mHeight; y++)
+        {
+            const float* pAbove = &mScratch[(y - 1) * mWidth];
+            const float* pRow = &mScratch[y * mWidth];
+            const float* pBelow = &mScratch[(y + 1) * mWidth];
+            float* pDst = &mDepth[y * mWidth];
+            for (uint32_t x = 0; x < mWidth; x += 4)
+            {
+                _mm_storeu_ps(pDst + x, _mm_max_ps(_mm_max_ps(_mm_loadu_ps(pAbove + x), _mm_loadu_ps(pRow + x)), _mm_loadu_ps(pBelow + x)));
+            }
+        }
+
+        // Farthest depth of each tile
+        for (uint32_t tileY = 0; tileY < mTilesY; tileY++)
+        {
+            for (uint32_t tileX = 0; tileX < mTilesX; tileX++)
+            {
+                __m128 maxDepth = _mm_set1_ps(-FLT_MAX);
+                for (uint32_t y = tileY * kTileSize; y < (tileY + 1) * kTileSize; y++)
+                {
+                    const float* pRow = &mDepth[y * mWidth + tileX * kTileSize];
+                    for (uint32_t x = 0; x < kTileSize; x += 4)
+                    {
+                        maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(pRow + x));
+                    }
+                }
+
+                float lanes[4];
+                _mm_storeu_ps(lanes, maxDepth);
+                mTileMaxDepth[tileY * mTilesX + tileX] = std::max(std::max(lanes[0], lanes[1]), std::max(lanes[2], lanes[3]));
+            }
+        }
+    }
+
+    bool OcclusionCuller::isOccluded(const BoundingBox& box) const
+    {
+        // Project the corners and find the screen rectangle and the nearest depth of the box
+        float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX;
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            const glm::vec3 sign((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+            const glm::vec4 clip = mViewProjMat * glm::vec4(box.center + box.extent * sign, 1);
+            if (isOutsideNearPlane(clip))
+            {
+                return false;
+            }
+
+            const float invW = 1 / clip.w;
+            const float x = (clip.x * invW * 0.5f + 0.5f) * mWidth;
+            const float y = (0.5f - clip.y * invW * 0.5f) * mHeight;
+            minX = std::min(minX, x);
+            maxX = std::max(maxX, x);
+            minY = std::min(minY, y);
+            maxY = std::max(maxY, y);
+            minZ = std::min(minZ, clip.z * invW);
+        }
+
+        if (maxX < 0 || maxY < 0 || minX >= mWidth || minY >= mHeight)
+        {
+            return false;
+        }
+        minZ -= std::abs(minZ) * kDepthTolerance;
+
+        const uint32_t x0 = (uint32_t)std::max((int32_t)std::floor(minX), 0);
+        const uint32_t x1 = (uint32_t)std::min((int32_t)std::floor(maxX), (int32_t)mWidth - 1);
+        const uint32_t y0 = (uint32_t)std::max((int32_t)std::floor(minY), 0);
+        const uint32_t y1 = (uint32_t)std::min((int32_t)std::floor(maxY), (int32_t)mHeight - 1);
+
+        // The box is occluded if every pixel it covers has an occluder in front of it. Check whole tiles first.
+        for (uint32_t tileY = y0 / kTileSize; tileY <= y1 / kTileSize; tileY++)
+        {
+            for (uint32_t tileX = x0 / kTileSize; tileX <= x1 / kTileSize; tileX++)
+            {
+                if (mTileMaxDepth[tileY * mTilesX + tileX] < minZ)
+                {
+                    continue;
+                }
+
+                const uint32_t px0 = std::max(x0, tileX * kTileSize);
+                const uint32_t px1 = std::min(x1, (tileX + 1) * kTileSize - 1);
+                const uint32_t py0 = std::max(y0, tileY * kTileSize);
+                const uint32_t py1 = std::min(y1, (tileY + 1) * kTileSize - 1);
+                for (uint32_t y = py0; y <= py1; y++)
+                {
+                    for (uint32_t x = px0; x <= px1; x++)
+                    {
+                        if (mDepth[y * mWidth + x] >= minZ)
+                        {
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+        return true;
+    }
+}
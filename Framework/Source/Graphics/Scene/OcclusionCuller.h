@@ -0,0 +1,118 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <memory>
+#include <atomic>
+#include "glm/vec3.hpp"
+#include "glm/mat4x4.hpp"
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    /** CPU occlusion culling against a low-resolution depth buffer.\n
+        A few large occluders are rasterized into the depth buffer on the CPU, and bounding boxes are then tested against it. The buffer keeps the farthest depth of every 8x8 pixel tile, so most boxes are resolved without touching individual pixels.\n
+        The projection must map the depth between the near and far planes to [0, 1], with larger values farther away.\n
+        Usage: call beginFrame(), rasterize the occluders, call finalizeOccluders(), then test boxes with isOccluded(). isOccluded() and recordTests() can be called from multiple threads.
+    */
+    class OcclusionCuller
+    {
+    public:
+        using UniquePtr = std::unique_ptr<OcclusionCuller>;
+
+        struct Statistics
+        {
+            uint32_t occluderCount = 0;         ///< Number of occluder meshes rasterized this frame
+            uint32_t occluderTriangleCount = 0; ///< Number of occluder triangles rasterized this frame. Triangles crossing the near plane or the eye plane are skipped.
+            uint32_t testedBoxCount = 0;        ///< Number of boxes tested this frame, as reported by recordTests()
+            uint32_t occludedBoxCount = 0;      ///< Number of boxes found to be occluded this frame, as reported by recordTests()
+        };
+
+        static const uint32_t kTileSize = 8;
+
+        /** Create a new culler
+            \param[in] width, height Depth buffer resolution. Rounded up to a multiple of the tile size.
+        */
+        static UniquePtr create(uint32_t width = 256, uint32_t height = 128);
+
+        /** Clear the depth buffer and the statistics
+            \param[in] viewProjMat The camera's view-projection matrix
+        */
+        void beginFrame(const glm::mat4& viewProjMat);
+
+        /** Rasterize an occluder. Both sides of the triangles are rasterized.
+            \param[in] pPositions Object-space vertex positions
+            \param[in] pIndices Triangle list indices
+            \param[in] indexCount Number of indices
+            \param[in] worldMat Object-to-world matrix
+        */
+        void rasterizeOccluder(const glm::vec3* pPositions, const uint32_t* pIndices, uint32_t indexCount, const glm::mat4& worldMat);
+
+        /** Build the tile depths. Call after the last occluder was rasterized.
+        */
+        void finalizeOccluders();
+
+        /** Check if a box is completely hidden by the occluders. Boxes which cross the near plane or lie outside the screen are never occluded.
+            \param[in] box World-space bounding box
+        */
+        bool isOccluded(const BoundingBox& box) const;
+
+        /** Add box test results to the statistics. isOccluded() doesn't count its results, so that callers can batch them. Thread-safe.
+        */
+        void recordTests(uint32_t testedCount, uint32_t occludedCount) { mTestedBoxCount += testedCount; mOccludedBoxCount += occludedCount; }
+
+        Statistics getStatistics() const;
+
+        uint32_t getWidth() const { return mWidth; }
+        uint32_t getHeight() const { return mHeight; }
+
+        /** Get the depth of a pixel. Pixels which no occluder covers hold FLT_MAX. After finalizeOccluders(), this is the conservative depth the box tests use.
+        */
+        float getDepth(uint32_t x, uint32_t y) const { return mDepth[y * mWidth + x]; }
+
+    private:
+        OcclusionCuller(uint32_t width, uint32_t height);
+        void rasterizeTriangle(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2);
+
+        uint32_t mWidth;
+        uint32_t mHeight;
+        uint32_t mTilesX;
+        uint32_t mTilesY;
+        glm::mat4 mViewProjMat;
+        std::vector<float> mDepth;          ///< Per pixel, nearest occluder depth
+        std::vector<float> mTileMaxDepth;   ///< Per tile, farthest pixel depth
+        std::vector<float> mScratch;
+        std::vector<glm::vec3> mScreenVerts;
+        std::vector<uint8_t> mSkippedVerts; ///< Per occluder vertex, 1 if the vertex is outside the near plane and its triangles are skipped
+
+        std::atomic<uint32_t> mOccluderCount;
+        std::atomic<uint32_t> mOccluderTriangleCount;
+        std::atomic<uint32_t> mTestedBoxCount;
+        std::atomic<uint32_t> mOccludedBoxCount;
+    };
+}
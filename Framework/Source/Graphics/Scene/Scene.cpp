@@ -30,6 +30,7 @@
 #include "SceneImporter.h"
 #include "glm/gtx/euler_angles.hpp"
 #include "glm/gtc/matrix_transform.hpp"
+#include <algorithm>
 
 namespace Falcor
 {
@@ -49,6 +50,16 @@ namespace Falcor
         return pScene;
     }
 
+    Scene::AsyncLoad::SharedPtr Scene::loadFromFileAsync(const std::string& filename, Model::LoadFlags modelLoadFlags, Scene::LoadFlags sceneLoadFlags)
+    {
+        // Creating the scene resets the global ID counters, so do it before the loading thread starts creating objects
+        Scene::SharedPtr pScene = create();
+        return AsyncLoad::create([pScene, filename, modelLoadFlags, sceneLoadFlags]()
+        {
+            return SceneImporter::loadScene(*pScene, filename, modelLoadFlags, sceneLoadFlags) ? pScene : nullptr;
+        });
+    }
+
     Scene::SharedPtr Scene::create()
     {
         return SharedPtr(new Scene());
@@ -68,55 +79,133 @@ namespace Falcor
 
     void Scene::updateExtents()
     {
+        // Refit the model instance bounds. Only the instances which moved are visited.
+        updateInstanceTransforms();
+
         if (mExtentsDirty)
         {
             mExtentsDirty = false;
- 
-            mRadius = 0.f;
-            float k = 0.f;
-            mCenter = vec3(0, 0, 0);
-            for (uint32_t i = 0; i < getModelCount(); ++i)
-            {
-                const auto& model = getModel(i);
-                const float r = model->getRadius();
-                const vec3 c = model->getCenter();
-                for (uint32_t j = 0; j < getModelInstanceCount(i); ++j)
-                {
-                    const auto& inst = getModelInstance(i, j);
-                    const vec3 instC = vec3(vec4(c, 1.f) * inst->getTransformMatrix());
-                    const vec3 scaling = inst->getScaling();
-                    const float instR = r * max(scaling.x, max(scaling.y, scaling.z));
- 
-                    if (k == 0.f)
-                    {
-                        mCenter = instC;
-                        mRadius = instR;
-                    }
-                    else
-                    {
-                        vec3 dir = instC - mCenter;
-                        if (length(dir) > 1e-6f)
-                            dir = normalize(dir);
-                        vec3 a = mCenter - dir * mRadius;
-                        vec3 b = instC + dir * instR;
- 
-                        mCenter = (a + b) * 0.5f;
-                        mRadius = length(a - b);
-                    }
-                    k++;
-                }
-            }
- 
+
+            const BoundingBox& box = mpModelInstanceBvh->getBounds();
+            mCenter = box.center;
+            mRadius = length(box.extent);
+
             // Update light extents
             for (auto& light : mpLights)
             {
                 if (light->getType() == LightDirectional)
                 {
                     auto pDirLight = std::dynamic_pointer_cast<DirectionalLight>(light);
-                    pDirLight->setWorldParams(getCenter(), getRadius());
+                    pDirLight->setWorldParams(mCenter, mRadius);
+                }
+            }
+        }
+    }
+
+    const BoundingBox& Scene::getBoundingBox()
+    {
+        updateExtents();
+        return mpModelInstanceBvh->getBounds();
+    }
+
+    void Scene::getModelInstancesInBox(const BoundingBox& box, std::vector<ModelInstanceRef>& instances)
+    {
+        updateInstanceTransforms();
+        instances.clear();
+
+        const vec3 boxMin = box.getMinPos();
+        const vec3 boxMax = box.getMaxPos();
+        auto nodeTest = [boxMin, boxMax](const BoundingBox& nodeBox)
+        {
+            const vec3 nodeMin = nodeBox.getMinPos();
+            const vec3 nodeMax = nodeBox.getMaxPos();
+            if (any(lessThan(nodeMax, boxMin)) || any(greaterThan(nodeMin, boxMax)))
+            {
+                return BoundingVolumeHierarchy::Visit::Skip;
+            }
+            if (all(lessThanEqual(boxMin, nodeMin)) && all(lessThanEqual(nodeMax, boxMax)))
+            {
+                return BoundingVolumeHierarchy::Visit::AcceptAll;
+            }
+            return BoundingVolumeHierarchy::Visit::Descend;
+        };
+
+        auto addInstance = [this, &instances](uint32_t primID, bool fullyInside)
+        {
+            instances.push_back(getModelInstanceRef(primID));
+        };
+
+        mpModelInstanceBvh->traverse(nodeTest, addInstance);
+    }
+
+    Scene::ModelInstanceRef Scene::getModelInstanceRef(uint32_t modelInstanceIndex) const
+    {
+        // The model is the last one whose first instance index is not after the requested index. Models without instances share their index with the next model.
+        const uint32_t modelID = (uint32_t)(std::upper_bound(mFirstModelInstanceIndex.begin(), mFirstModelInstanceIndex.end(), modelInstanceIndex) - mFirstModelInstanceIndex.begin()) - 1;
+        return { modelID, modelInstanceIndex - mFirstModelInstanceIndex[modelID] };
+    }
+
+    void Scene::updateInstanceTransforms()
+    {
+        // Mesh instances added to a model after the last rebuild change the slot layout too. The models are only checked after some model changed its meshes.
+        const uint32_t meshLayoutVersion = Model::getMeshLayoutVersion();
+        bool layoutChanged = mInstanceListDirty || mpTransformStore == nullptr;
+        if (layoutChanged == false && meshLayoutVersion != mMeshLayoutVersion)
+        {
+            layoutChanged = (mpTransformStore->isLayoutCurrent(mModels) == false);
+        }
+        mMeshLayoutVersion = meshLayoutVersion;
+
+        if (layoutChanged)
+        {
+            mInstanceListDirty = false;
+
+            if (mpTransformStore == nullptr)
+            {
+                mpTransformStore = TransformStore::create();
+            }
+            mpTransformStore->rebuild(mModels);
+
+            std::vector<BoundingBox> boxes;
+            mFirstModelInstanceIndex.resize(getModelCount());
+            for (uint32_t modelID = 0; modelID < getModelCount(); modelID++)
+            {
+                mFirstModelInstanceIndex[modelID] = (uint32_t)boxes.size();
+                for (const auto& pInstance : mModels[modelID])
+                {
+                    boxes.push_back(pInstance->getBoundingBox());
                 }
             }
+
+            mpModelInstanceBvh = BoundingVolumeHierarchy::create(boxes);
+            mExtentsDirty = true;
+            return;
+        }
+
+        // Only update the instances which moved since the last update
+        mpTransformStore->update(mModels, mMovedModelInstances);
+        if (mMovedModelInstances.empty())
+        {
+            return;
         }
+
+        uint32_t primID = 0;
+        uint32_t movedIndex = 0;
+        for (uint32_t modelID = 0; modelID < getModelCount() && movedIndex < mMovedModelInstances.size(); modelID++)
+        {
+            for (const auto& pInstance : mModels[modelID])
+            {
+                if (movedIndex < mMovedModelInstances.size() && mMovedModelInstances[movedIndex] == primID)
+                {
+                    mpModelInstanceBvh->setPrimitiveBounds(primID, pInstance->getBoundingBox());
+                    movedIndex++;
+                }
+                primID++;
+            }
+        }
+
+        mpModelInstanceBvh->refit();
+        mExtentsDirty = true;
     }
 
     bool Scene::update(double currentTime, CameraController* cameraController)
@@ -154,12 +243,14 @@ namespace Falcor
         mModels.erase(mModels.begin() + modelID);
 
         mExtentsDirty = true;
+        mInstanceListDirty = true;
     }
 
     void Scene::deleteAllModels()
     {
         mModels.clear();
         mExtentsDirty = true;
+        mInstanceListDirty = true;
     }
 
     uint32_t Scene::getModelInstanceCount(uint32_t modelID) const
@@ -176,6 +267,8 @@ namespace Falcor
 
     void Scene::addModelInstance(const ModelInstance::SharedPtr& pInstance)
     {
+        mInstanceListDirty = true;
+
         // Checking for existing instance list for model
         for (uint32_t modelID = 0; modelID < (uint32_t)mModels.size(); modelID++)
         {
@@ -200,6 +293,7 @@ namespace Falcor
 
         instances.erase(instances.begin() + instanceID);
         mExtentsDirty = true;
+        mInstanceListDirty = true;
 
         // If no instances are left, delete the vector
         if (instances.empty())
@@ -311,6 +405,7 @@ namespace Falcor
 #undef merge
         mUserVars.insert(pFrom->mUserVars.begin(), pFrom->mUserVars.end());
         mExtentsDirty = true;
+        mInstanceListDirty = true;
     }
 
     void Scene::createAreaLights()
@@ -37,6 +37,8 @@
 #include "Graphics/Paths/ObjectPath.h"
 #include "Graphics/Model/ObjectInstance.h"
 #include "Graphics/Material/MaterialHistory.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
+#include "Graphics/Scene/TransformStore.h"
 
 namespace Falcor
 {
@@ -102,7 +104,13 @@ namespace Falcor
             StoreMaterialHistory =  0x2     ///< Store history of overridden mesh materials
         };
 
+        using AsyncLoad = AsyncObjectLoad<Scene>;
+
         static Scene::SharedPtr loadFromFile(const std::string& filename, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None, Scene::LoadFlags sceneLoadFlags = LoadFlags::None);
+
+        /** Start loading a scene on a background thread. The models are loaded the same way as Model::createFromFileAsync(), and the progress of all of them is reported through the returned object.
+        */
+        static AsyncLoad::SharedPtr loadFromFileAsync(const std::string& filename, Model::LoadFlags modelLoadFlags = Model::LoadFlags::None, Scene::LoadFlags sceneLoadFlags = LoadFlags::None);
         static Scene::SharedPtr create();
 
         virtual ~Scene();
@@ -183,11 +191,46 @@ namespace Falcor
         void merge(const Scene* pFrom);
 
         /**
-            Return scene extents
+            Return scene extents. The bounding sphere encloses getBoundingBox().
         */
         const vec3& getCenter() { updateExtents(); return mCenter; }
         const float getRadius() { updateExtents(); return mRadius; }
 
+        /** Get the world-space bounding box of all the model instances. Only the instances which moved since the last call are refit.
+        */
+        const BoundingBox& getBoundingBox();
+
+        struct ModelInstanceRef
+        {
+            uint32_t modelID;
+            uint32_t instanceID;
+        };
+
+        /** Find the model instances whose world-space bounding boxes overlap a box
+            \param[in] box The world-space box to test against
+            \param[out] instances The overlapping model instances. The list is cleared first.
+        */
+        void getModelInstancesInBox(const BoundingBox& box, std::vector<ModelInstanceRef>& instances);
+
+        /** Get the model and instance IDs of a running model instance index, such as a primitive ID of getModelInstanceBvh()
+        */
+        ModelInstanceRef getModelInstanceRef(uint32_t modelInstanceIndex) const;
+
+        /** Get the bounding volume hierarchy over the world-space bounding boxes of the model instances.\n
+            Primitive IDs are running model instance indices, enumerating getModelInstance(modelID, instanceID) with the instance ID in the inner loop.\n
+            The hierarchy is rebuilt when model instances are added or removed, and refit when instances move.
+        */
+        const BoundingVolumeHierarchy* getModelInstanceBvh() { updateInstanceTransforms(); return mpModelInstanceBvh.get(); }
+
+        /** Get the world transforms of all the mesh instances in the scene. See TransformStore for the layout.
+        */
+        const TransformStore* getTransformStore() { updateInstanceTransforms(); return mpTransformStore.get(); }
+
+        /** Bring the transform store and the model instance BVH up to date with the instances' transforms.\n
+            Called implicitly by the getters. Only instances which moved since the last call are recalculated.
+        */
+        void updateInstanceTransforms();
+
         /**
             This routine creates area light(s) in the scene. All meshes that
             have emissive material are treated as area lights.
@@ -210,9 +253,10 @@ namespace Falcor
 
         Scene();
         /**
-            Update changed scene extents (radius and center).
+            Update changed scene extents (radius and center) from the model instance BVH.
         */
         void updateExtents();
+
         
         static uint32_t sSceneCounter;
 
@@ -237,6 +281,13 @@ namespace Falcor
 
         bool mExtentsDirty = true;
 
+        TransformStore::UniquePtr mpTransformStore;
+        BoundingVolumeHierarchy::SharedPtr mpModelInstanceBvh;
+        std::vector<uint32_t> mMovedModelInstances;     ///< Scratch list filled by TransformStore::update()
+        std::vector<uint32_t> mFirstModelInstanceIndex; ///< Per model, the BVH primitive ID of its first instance
+        bool mInstanceListDirty = true;                 ///< Set when model instances are added or removed
+        uint32_t mMeshLayoutVersion = 0;                ///< Model::getMeshLayoutVersion() at the last update of the instance transforms
+
         using string_uservar_map = std::map<const std::string, UserVariable>;
         string_uservar_map mUserVars;
         static const UserVariable kInvalidVar;
@@ -29,12 +29,14 @@
 #include "SceneImporter.h"
 #include "Scene.h"
 #include "Utils/OS.h"
+#include "Graphics/TextureCache.h"
 #include "Externals/RapidJson/include/rapidjson/error/en.h"
 #include <sstream>
 #include <fstream>
 #include "Graphics/TextureHelper.h"
 #include "glm/detail/func_trigonometric.hpp"
 #include "SceneExportImportCommon.h"
+#include "Utils/AsyncLoadTask.h"
 #include "glm/gtx/euler_angles.hpp"
 
 namespace Falcor
@@ -323,7 +325,8 @@ namespace Falcor
         // Loop over the array
         for(uint32_t i = 0; i < jsonVal.Size(); i++)
         {
-            if(createModel(jsonVal[i]) == false)
+            // Cancelled async loads stop between models
+            if(AsyncLoadTask::isCancelled() || createModel(jsonVal[i]) == false)
             {
                 return false;
             }
@@ -465,7 +468,7 @@ namespace Falcor
             filename = fullpath;
         }
 
-        pTexture = createTextureFromFile(filename, true, isSrgb);
+        pTexture = TextureCache::getTextureFromFile(filename, true, isSrgb);
         return (pTexture != nullptr);
     }
 
@@ -1171,6 +1174,8 @@ namespace Falcor
             strStream << fileStream.rdbuf();
             std::string jsonData = strStream.str();
             rapidjson::StringStream JStream(jsonData.c_str());
+            AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TotalBytes, jsonData.size());
+            AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::BytesRead, jsonData.size());
 
             // Get the file directory
             auto last = fullpath.find_last_of("/\\");
@@ -1193,7 +1198,8 @@ namespace Falcor
 
             if(is_set(mSceneLoadFlags, Scene::LoadFlags::GenerateAreaLights))
             {
-                mScene.createAreaLights();
+                // Area lights map the meshes' buffers
+                AsyncLoadTask::runOnMainThread([this]() { mScene.createAreaLights(); });
             }
 
             if (is_set(mSceneLoadFlags, Scene::LoadFlags::StoreMaterialHistory) == false)
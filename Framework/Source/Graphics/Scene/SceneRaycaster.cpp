@@ -0,0 +1,200 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "SceneRaycaster.h"
+#include "glm/geometric.hpp"
+#include "glm/matrix.hpp"
+#include <cmath>
+
+namespace Falcor
+{
+    struct Ray
+    {
+        glm::vec3 origin;
+        glm::vec3 direction;
+        glm::vec3 invDirection;
+    };
+
+    static Ray createRay(const glm::vec3& origin, const glm::vec3& direction)
+    {
+        Ray ray;
+        ray.origin = origin;
+        ray.direction = direction;
+        for (int i = 0; i < 3; i++)
+        {
+            // Avoid 0 * inf when the origin lies on a slab plane
+            ray.invDirection[i] = 1.0f / ((std::abs(direction[i]) > 1e-30f) ? direction[i] : 1e-30f);
+        }
+        return ray;
+    }
+
+    // Slab test. Returns true if the ray enters the box before maxDistance.
+    static bool intersectBox(const Ray& ray, const BoundingBox& box, float maxDistance)
+    {
+        const glm::vec3 t0 = (box.getMinPos() - ray.origin) * ray.invDirection;
+        const glm::vec3 t1 = (box.getMaxPos() - ray.origin) * ray.invDirection;
+        const glm::vec3 tNear = glm::min(t0, t1);
+        const glm::vec3 tFar = glm::max(t0, t1);
+        const float tEnter = std::max(std::max(tNear.x, tNear.y), std::max(tNear.z, 0.0f));
+        const float tExit = std::min(std::min(tFar.x, tFar.y), std::min(tFar.z, maxDistance));
+        return tEnter <= tExit;
+    }
+
+    // Moller-Trumbore. Both sides of the triangle are hit.
+    static bool intersectTriangle(const Ray& ray, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, float maxDistance, float& distance, glm::vec2& barycentrics)
+    {
+        const glm::vec3 e1 = p1 - p0;
+        const glm::vec3 e2 = p2 - p0;
+        const glm::vec3 p = glm::cross(ray.direction, e2);
+        const float det = glm::dot(e1, p);
+        if (det == 0.0f)
+        {
+            return false;
+        }
+
+        const float invDet = 1.0f / det;
+        const glm::vec3 s = ray.origin - p0;
+        const float u = glm::dot(s, p) * invDet;
+        if (u < 0.0f || u > 1.0f)
+        {
+            return false;
+        }
+
+        const glm::vec3 q = glm::cross(s, e1);
+        const float v = glm::dot(ray.direction, q) * invDet;
+        if (v < 0.0f || u + v > 1.0f)
+        {
+            return false;
+        }
+
+        const float t = glm::dot(e2, q) * invDet;
+        if (t < 0.0f || t >= maxDistance)
+        {
+            return false;
+        }
+
+        distance = t;
+        barycentrics = glm::vec2(u, v);
+        return true;
+    }
+
+    SceneRaycaster::UniquePtr SceneRaycaster::create(const Scene::SharedPtr& pScene)
+    {
+        return UniquePtr(new SceneRaycaster(pScene));
+    }
+
+    bool SceneRaycaster::raycast(const glm::vec3& origin, const glm::vec3& direction, Hit& hit, float maxDistance) const
+    {
+        const BoundingVolumeHierarchy* pBvh = mpScene->getModelInstanceBvh();
+        const TransformStore* pTransforms = mpScene->getTransformStore();
+        const Ray worldRay = createRay(origin, direction);
+
+        // Subtrees which start beyond the closest hit found so far are skipped
+        float closest = maxDistance;
+        bool found = false;
+
+        auto modelInstanceTest = [&worldRay, &closest](const BoundingBox& box)
+        {
+            return intersectBox(worldRay, box, closest) ? BoundingVolumeHierarchy::Visit::Descend : BoundingVolumeHierarchy::Visit::Skip;
+        };
+
+        auto testModelInstance = [&](uint32_t modelInstanceIndex, bool)
+        {
+            const Scene::ModelInstanceRef ref = mpScene->getModelInstanceRef(modelInstanceIndex);
+            const auto& pInstance = mpScene->getModelInstance(ref.modelID, ref.instanceID);
+            if (pInstance->isVisible() == false)
+            {
+                return;
+            }
+
+            const Model* pModel = pInstance->getObject().get();
+            const uint32_t firstSlot = pTransforms->getModelInstanceSlot(modelInstanceIndex);
+
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                // The CPU positions of skinned meshes are in bind pose, so they can't be tested
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                const BoundingVolumeHierarchy* pTriangleBvh = pMesh->hasBones() ? nullptr : pMesh->getTriangleBvh();
+                if (pTriangleBvh == nullptr)
+                {
+                    continue;
+                }
+
+                const std::vector<glm::vec3>& positions = pMesh->getCpuPositions();
+                const std::vector<uint32_t>& indices = pMesh->getCpuIndices();
+                const uint32_t meshSlotOffset = pTransforms->getMeshSlotOffset(ref.modelID, meshID);
+
+                for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++)
+                {
+                    const uint32_t slot = firstSlot + meshSlotOffset + instanceID;
+                    if (pModel->getMeshInstance(meshID, instanceID)->isVisible() == false || intersectBox(worldRay, pTransforms->getWorldBoxes().get(slot), closest) == false)
+                    {
+                        continue;
+                    }
+
+                    // Walk the triangles in object space. The direction isn't normalized, so distances stay in world units.
+                    const glm::mat4 invWorldMat = glm::inverse(pTransforms->getWorldMatrix(slot));
+                    const Ray localRay = createRay(glm::vec3(invWorldMat * glm::vec4(origin, 1.0f)), glm::vec3(invWorldMat * glm::vec4(direction, 0.0f)));
+
+                    auto triangleNodeTest = [&localRay, &closest](const BoundingBox& box)
+                    {
+                        return intersectBox(localRay, box, closest) ? BoundingVolumeHierarchy::Visit::Descend : BoundingVolumeHierarchy::Visit::Skip;
+                    };
+
+                    auto testTriangle = [&](uint32_t triangleID, bool)
+                    {
+                        const glm::vec3& p0 = positions[indices[triangleID * 3 + 0]];
+                        const glm::vec3& p1 = positions[indices[triangleID * 3 + 1]];
+                        const glm::vec3& p2 = positions[indices[triangleID * 3 + 2]];
+
+                        float distance;
+                        glm::vec2 barycentrics;
+                        if (intersectTriangle(localRay, p0, p1, p2, closest, distance, barycentrics))
+                        {
+                            closest = distance;
+                            found = true;
+
+                            hit.modelID = ref.modelID;
+                            hit.modelInstanceID = ref.instanceID;
+                            hit.meshID = meshID;
+                            hit.meshInstanceID = instanceID;
+                            hit.triangleID = triangleID;
+                            hit.distance = distance;
+                            hit.barycentrics = barycentrics;
+                        }
+                    };
+
+                    pTriangleBvh->traverse(triangleNodeTest, testTriangle);
+                }
+            }
+        };
+
+        pBvh->traverse(modelInstanceTest, testModelInstance);
+        return found;
+    }
+}
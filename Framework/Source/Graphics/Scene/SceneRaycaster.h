@@ -0,0 +1,73 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <memory>
+#include <cfloat>
+#include "glm/vec2.hpp"
+#include "glm/vec3.hpp"
+#include "Graphics/Scene/Scene.h"
+
+namespace Falcor
+{
+    /** Casts rays against a scene's triangles on the CPU.\n
+        The query descends the scene's model instance BVH, tests the world-space bounding boxes of the mesh instances, and then walks the mesh's triangle BVH in object space, see Mesh::getTriangleBvh().
+        Only meshes with CPU geometry can be hit, see Model::LoadFlags::KeepCpuGeometry. Hidden model and mesh instances are ignored, like in SceneRenderer.
+    */
+    class SceneRaycaster
+    {
+    public:
+        using UniquePtr = std::unique_ptr<SceneRaycaster>;
+
+        struct Hit
+        {
+            uint32_t modelID = 0;
+            uint32_t modelInstanceID = 0;
+            uint32_t meshID = 0;
+            uint32_t meshInstanceID = 0;
+            uint32_t triangleID = 0;        ///< Index of the triangle in Mesh::getCpuIndices(), divided by 3
+            float distance = FLT_MAX;       ///< Distance along the ray, in units of the ray direction's length
+            glm::vec2 barycentrics;         ///< Weights of the triangle's second and third vertices. The first vertex weight is 1 - x - y.
+        };
+
+        static UniquePtr create(const Scene::SharedPtr& pScene);
+
+        /** Find the closest intersection of a ray with the scene's triangles.
+            \param[in] origin World-space ray origin
+            \param[in] direction World-space ray direction
+            \param[out] hit The closest hit. Only valid if the function returned true.
+            \param[in] maxDistance Ignore hits further than this
+            \return true if the ray hit a triangle, otherwise false
+        */
+        bool raycast(const glm::vec3& origin, const glm::vec3& direction, Hit& hit, float maxDistance = FLT_MAX) const;
+
+    private:
+        SceneRaycaster(const Scene::SharedPtr& pScene) : mpScene(pScene) {}
+
+        Scene::SharedPtr mpScene;
+    };
+}
@@ -37,6 +37,10 @@
 #include "API/Device.h"
 #include "glm/matrix.hpp"
 #include "Graphics/Material/MaterialSystem.h"
+#include "Utils/ThreadPool.h"
+#include "Utils/Math/RadixSort.h"
+#include <cstring>
+#include <algorithm>
 
 namespace Falcor
 {
@@ -45,14 +49,44 @@ namespace Falcor
     size_t SceneRenderer::sWorldMatArraySize = 0;
     size_t SceneRenderer::sWorldMatOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sWorldInvTransposeMatOffset = ConstantBuffer::kInvalidOffset;
-    size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sDrawIDOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sMeshIdOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sFirstInstanceOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPositionScaleOffset = ConstantBuffer::kInvalidOffset;
+    size_t SceneRenderer::sPositionBiasOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightCountOffset = ConstantBuffer::kInvalidOffset;
     size_t SceneRenderer::sLightArrayOffset = ConstantBuffer::kInvalidOffset;
 
     const char* SceneRenderer::kPerMaterialCbName = "InternalPerMaterialCB";
     const char* SceneRenderer::kPerFrameCbName = "InternalPerFrameCB";
     const char* SceneRenderer::kPerMeshCbName = "InternalPerMeshCB";
+    const char* SceneRenderer::kMeshInstanceBufferName = "gMeshInstances";
+
+    static const uint32_t kDrawListGrainSize = 32;  // Model instances per draw list chunk
+    static const uint32_t kMeshInstanceGrainSize = 1024;  // Mesh instances per task when filling the per-instance data
+    static const size_t kDrawIdStride = 16;  // Constant buffer packing puts each array element on a 16B boundary
+
+    // Results of setPerModelInstanceData(), when batching model instances
+    static const uint8_t kModelInstanceUnknown = 0;
+    static const uint8_t kModelInstanceAccepted = 1;
+    static const uint8_t kModelInstanceRejected = 2;
+
+    // Sort key fields, from the most significant bit down
+    static const uint32_t kSortKeyProgramBits = 8;
+    static const uint32_t kSortKeyMaterialBits = 16;
+    static const uint32_t kSortKeyMeshBits = 20;
+    static const uint32_t kSortKeyDepthBits = 20;
+    static_assert(VertexLayout::kProgramVariantBits + 1 <= kSortKeyProgramBits, "The program variants must fit the sort key");
+    static_assert(kSortKeyProgramBits + kSortKeyMaterialBits + kSortKeyMeshBits + kSortKeyDepthBits == 64, "Sort key fields must fill 64 bits");
+
+    static uint64_t quantizeDepth(float depth)
+    {
+        // The bit patterns of non-negative floats sort like their values, so keep the most significant bits
+        depth = std::max(depth, 0.0f);
+        uint32_t bits;
+        std::memcpy(&bits, &depth, sizeof(bits));
+        return bits >> (32 - kSortKeyDepthBits);
+    }
 
     SceneRenderer::SharedPtr SceneRenderer::create(const Scene::SharedPtr& pScene)
     {
@@ -66,7 +100,7 @@ namespace Falcor
 
     void SceneRenderer::updateVariableOffsets(const ProgramReflection* pReflector)
     {
-        if (sWorldMatOffset == ConstantBuffer::kInvalidOffset)
+        if (sMeshIdOffset == ConstantBuffer::kInvalidOffset)
         {
             const auto pPerMeshCbData = pReflector->getBufferDesc(kPerMeshCbName, ProgramReflection::BufferReflection::Type::Constant);
 
@@ -79,8 +113,14 @@ namespace Falcor
                 sWorldMatArraySize = pPerMeshCbData->getVariableData("gWorldMat[0]")->arraySize;
                 sWorldMatOffset = pPerMeshCbData->getVariableData("gWorldMat[0]")->location;
                 sWorldInvTransposeMatOffset = pPerMeshCbData->getVariableData("gWorldInvTransposeMat[0]")->location;
+                const auto& pDrawIdData = pPerMeshCbData->getVariableData("gDrawId[0]");
+                sDrawIDOffset = pDrawIdData ? pDrawIdData->location : ConstantBuffer::kInvalidOffset;
                 sMeshIdOffset = pPerMeshCbData->getVariableData("gMeshId")->location;
-                sDrawIDOffset = pPerMeshCbData->getVariableData("gDrawId[0]")->location;
+                sFirstInstanceOffset = pPerMeshCbData->getVariableData("gFirstInstance")->location;
+                const auto& pScaleData = pPerMeshCbData->getVariableData("gPositionScale");
+                sPositionScaleOffset = pScaleData ? pScaleData->location : ConstantBuffer::kInvalidOffset;
+                const auto& pBiasData = pPerMeshCbData->getVariableData("gPositionBias");
+                sPositionBiasOffset = pBiasData ? pBiasData->location : ConstantBuffer::kInvalidOffset;
             }
         }
 
@@ -152,25 +192,36 @@ namespace Falcor
 
     bool SceneRenderer::setPerMeshData(const CurrentWorkingData& currentData, const Mesh* pMesh)
     {
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+        if (pCB && sPositionScaleOffset != ConstantBuffer::kInvalidOffset)
+        {
+            pCB->setVariable(sPositionScaleOffset, pMesh->getPositionScale());
+            pCB->setVariable(sPositionBiasOffset, pMesh->getPositionBias());
+        }
         return true;
     }
 
     bool SceneRenderer::setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID)
     {
+        // The instance's matrices were already written to the per-instance data buffer by updateMeshInstanceBuffer(), unless the program doesn't read it
         ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
         if (pCB)
         {
             const Mesh* pMesh = pMeshInstance->getObject().get();
+            assert(drawInstanceID == 0 || !pMesh->hasBones()); // Bones models use the matrices of the model, so their mesh instances are drawn one at a time
 
-            assert(drawInstanceID == 0 || !pMesh->hasBones()); // The same array is reused for bone and instance matrices, both cannot be active
-            if (pMesh->hasBones() == false)
+            if (currentData.useMeshInstanceBuffer == false && pMesh->hasBones() == false)
             {
-                glm::mat4 worldMat = pModelInstance->getTransformMatrix() * pMeshInstance->getTransformMatrix();
-                glm::mat3x4 worldInvTransposeMat = transpose(inverse(glm::mat3(worldMat)));
+                const glm::mat4& worldMat = currentData.pTransforms->getWorldMatrix(currentData.meshInstanceSlot);
+                const glm::mat3x4& worldInvTransposeMat = currentData.pTransforms->getWorldInvTransposeMatrix(currentData.meshInstanceSlot);
 
                 assert(drawInstanceID < sWorldMatArraySize);
                 pCB->setBlob(&worldMat, sWorldMatOffset + drawInstanceID * sizeof(glm::mat4), sizeof(glm::mat4));
                 pCB->setBlob(&worldInvTransposeMat, sWorldInvTransposeMatOffset + drawInstanceID * sizeof(glm::mat3x4), sizeof(glm::mat3x4)); // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
+                if (sDrawIDOffset != ConstantBuffer::kInvalidOffset)
+                {
+                    pCB->setVariable(sDrawIDOffset + drawInstanceID * kDrawIdStride, currentData.drawID);
+                }
             }
 
             // Set mesh id
@@ -191,14 +242,30 @@ namespace Falcor
         return true;
     }
 
-    void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount)
+    void SceneRenderer::executeDraw(const CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount)
     {
-        // Draw
-        currentData.pContext->drawIndexedInstanced(indexCount, instanceCount, 0, 0, 0);
+        // Meshes from a GeometryPool share their Vao, and are located by their start index and base vertex. The LODs are further ranges of the same index buffer.
+        if (currentData.indexRangeCount)
+        {
+            for (uint32_t i = 0; i < currentData.indexRangeCount; i++)
+            {
+                const IndexRange& range = currentData.pIndexRanges[i];
+                currentData.pContext->drawIndexedInstanced(range.indexCount, instanceCount, range.startIndex, pMesh->getBaseVertex(), 0);
+            }
+            return;
+        }
+        const Mesh::Lod& lod = pMesh->getLod(currentData.lod);
+        currentData.pContext->drawIndexedInstanced(lod.indexCount, instanceCount, lod.startIndex, pMesh->getBaseVertex(), 0);
     }
 
-    void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount)
+    void SceneRenderer::draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t firstInstance, uint32_t instanceCount)
     {
+        ConstantBuffer* pCB = currentData.pVars->getConstantBuffer(kPerMeshCbName).get();
+        if (pCB && sFirstInstanceOffset != ConstantBuffer::kInvalidOffset)
+        {
+            pCB->setVariable(sFirstInstanceOffset, firstInstance);
+        }
+
         currentData.pMaterial = pMesh->getMaterial().get();
         // Bind material
         if(mpLastMaterial != pMesh->getMaterial().get())
@@ -218,7 +285,7 @@ namespace Falcor
             }
         }
 
-        executeDraw(currentData, pMesh->getIndexCount(), instanceCount);
+        executeDraw(currentData, pMesh, instanceCount);
         postFlushDraw(currentData);
     }
 
@@ -227,9 +294,10 @@ namespace Falcor
 
     }
 
-    void SceneRenderer::renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID)
+    void SceneRenderer::renderMeshInstances(CurrentWorkingData& currentData, uint32_t firstItem, uint32_t itemCount)
     {
         const Model* pModel = currentData.pModel;
+        const uint32_t meshID = mSortedDrawList[firstItem].meshID;
         const Mesh* pMesh = pModel->getMesh(meshID).get();
 
         if (setPerMeshData(currentData, pMesh))
@@ -237,44 +305,67 @@ namespace Falcor
             // Bind VAO and set topology
             currentData.pState->setVao(pMesh->getVao());
 
+            // The instances of a draw must be contiguous in the per-instance data buffer. A rejected instance ends the current draw.
+            // Without the per-instance data buffer, the instances of a draw are limited by the constant buffer arrays
+            uint32_t maxInstanceCount = pMesh->hasBones() ? 1 : mMaxInstanceCount;
+            if (currentData.useMeshInstanceBuffer == false)
+            {
+                maxInstanceCount = std::min(maxInstanceCount, (uint32_t)sWorldMatArraySize);
+            }
+            uint32_t firstInstance = 0;
             uint32_t activeInstances = 0;
 
-            const uint32_t instanceCount = pModel->getMeshInstanceCount(meshID);
-            for (uint32_t instanceID = 0; instanceID < instanceCount; instanceID++)
+            for (uint32_t i = firstItem; i < firstItem + itemCount; i++)
             {
-                const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, instanceID).get();
-                BoundingBox box = pMeshInstance->getBoundingBox().transform(pModelInstance->getTransformMatrix());
+                const DrawItem& item = mSortedDrawList[i];
+
+                // Instances drawn at a different LOD end the current draw, and so do instances with culled meshlets, which are drawn alone
+                if (activeInstances != 0 && (item.lod != currentData.lod || item.indexRangeCount != 0))
+                {
+                    draw(currentData, pMesh, firstInstance, activeInstances);
+                    activeInstances = 0;
+                }
 
-                if ((mCullEnabled == false) || (currentData.pCamera->isObjectCulled(box) == false))
+                const Scene::ModelInstance* pModelInstance = mpScene->getModelInstance(item.modelID, item.modelInstanceID).get();
+                const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, item.meshInstanceID).get();
+                currentData.meshInstanceSlot = item.transformSlot;
+                currentData.drawID = i;
+
+                if (setPerMeshInstanceData(currentData, pModelInstance, pMeshInstance, activeInstances))
                 {
-                    if (pMeshInstance->isVisible())
+                    if (activeInstances == 0)
                     {
-                        if (setPerMeshInstanceData(currentData, pModelInstance, pMeshInstance, activeInstances))
-                        {
-                            currentData.drawID++;
-                            activeInstances++;
+                        firstInstance = i;
+                        currentData.lod = item.lod;
+                        currentData.pIndexRanges = item.indexRangeCount ? &mIndexRanges[item.firstIndexRange] : nullptr;
+                        currentData.indexRangeCount = item.indexRangeCount;
+                    }
+                    activeInstances++;
 
-                            if (activeInstances == mMaxInstanceCount)
-                            {
-                                // DISABLED_FOR_D3D12
-                                //pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
-                                draw(currentData, pMesh, activeInstances);
-                                activeInstances = 0;
-                            }
-                        }
+                    if (activeInstances == maxInstanceCount || item.indexRangeCount != 0)
+                    {
+                        // DISABLED_FOR_D3D12
+                        //pContext->setProgram(currentData.pProgram->getActiveProgramVersion());
+                        draw(currentData, pMesh, firstInstance, activeInstances);
+                        activeInstances = 0;
                     }
                 }
+                else if (activeInstances != 0)
+                {
+                    draw(currentData, pMesh, firstInstance, activeInstances);
+                    activeInstances = 0;
+                }
             }
             if(activeInstances != 0)
             {
-                draw(currentData, pMesh, activeInstances);
+                draw(currentData, pMesh, firstInstance, activeInstances);
             }
         }
     }
 
-    void SceneRenderer::renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance)
+    void SceneRenderer::renderModelInstances(CurrentWorkingData& currentData, uint32_t firstItem, uint32_t itemCount)
     {
-        const Model* pModel = pModelInstance->getObject().get();
+        const Model* pModel = currentData.pModel;
 
         if (setPerModelData(currentData))
         {
@@ -285,12 +376,18 @@ namespace Falcor
                 pProgram->addDefine("_VERTEX_BLENDING");
             }
 
-            mpLastMaterial = nullptr;
-
-            // Loop over the meshes
-            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            // Loop over the meshes. Consecutive items of the same mesh are drawn together.
+            uint32_t first = firstItem;
+            const uint32_t end = firstItem + itemCount;
+            while (first < end)
             {
-                renderMeshInstances(currentData, pModelInstance, meshID);
+                uint32_t last = first + 1;
+                while (last < end && mSortedDrawList[last].meshID == mSortedDrawList[first].meshID)
+                {
+                    last++;
+                }
+                renderMeshInstances(currentData, first, last - first);
+                first = last;
             }
 
             // Restore the program state
@@ -327,27 +424,512 @@ namespace Falcor
         }
     }
 
-    void SceneRenderer::renderScene(CurrentWorkingData& currentData)
+    void SceneRenderer::cullModelInstances(const Camera* pCamera)
     {
-        setupVR();
-        setPerFrameData(currentData);
+        const BoundingVolumeHierarchy* pBvh = mpScene->getModelInstanceBvh();
+        mModelInstanceContainment.assign(pBvh->getPrimitiveCount(), Camera::Containment::Outside);
+
+        // Reject or accept entire subtrees of model instances at once
+        auto nodeTest = [pCamera](const BoundingBox& box)
+        {
+            switch (pCamera->getContainment(box))
+            {
+            case Camera::Containment::Outside:
+                return BoundingVolumeHierarchy::Visit::Skip;
+            case Camera::Containment::Inside:
+                return BoundingVolumeHierarchy::Visit::AcceptAll;
+            default:
+                return BoundingVolumeHierarchy::Visit::Descend;
+            }
+        };
+
+        auto setContainment = [this](uint32_t primID, bool fullyInside)
+        {
+            mModelInstanceContainment[primID] = fullyInside ? Camera::Containment::Inside : Camera::Containment::Intersecting;
+        };
+
+        pBvh->traverse(nodeTest, setContainment);
+    }
 
+    uint64_t SceneRenderer::calculateSortKey(const Model* pModel, const Mesh* pMesh, float depth) const
+    {
+        // The vertex attributes and skinning select the program variant
+        const uint64_t program = (pMesh->getProgramVariant() << 1) | (pModel->hasBones() ? 1 : 0);
+        const uint64_t material = uint32_t(pMesh->getMaterial()->getId()) & ((1 << kSortKeyMaterialBits) - 1);
+        const uint64_t mesh = pMesh->getId() & ((1 << kSortKeyMeshBits) - 1);
+        const uint64_t state = (program << (kSortKeyMaterialBits + kSortKeyMeshBits)) | (material << kSortKeyMeshBits) | mesh;
+
+        if (mDrawOrder == DrawOrder::FrontToBack)
+        {
+            return (quantizeDepth(depth) << (64 - kSortKeyDepthBits)) | state;
+        }
+        return (state << kSortKeyDepthBits) | quantizeDepth(depth);
+    }
+
+    uint32_t SceneRenderer::selectLod(const Mesh* pMesh, const BoundingBox& worldBox, const vec3& eyePos) const
+    {
+        if (mLodPixelsPerUnit <= 0 || mLodErrorThreshold <= 0)
+        {
+            return 0;
+        }
+
+        // The LOD errors are in object space. The ratio of the boxes approximates the instance's scale.
+        const float objectSize = length(pMesh->getBoundingBox().extent);
+        const float scale = objectSize > 0 ? length(worldBox.extent) / objectSize : 1.0f;
+
+        // Measure from the nearest point of the box's bounding sphere, so that a large instance isn't simplified where it comes close to the camera.
+        // The size on screen doesn't depend on the distance with an orthographic projection.
+        float distance = 1.0f;
+        if (mLodOrthographic == false)
+        {
+            distance = length(worldBox.center - eyePos) - length(worldBox.extent);
+            if (distance <= 0)
+            {
+                return 0;
+            }
+        }
+
+        const float maxError = mLodErrorThreshold * distance / (mLodPixelsPerUnit * scale);
+        uint32_t lod = pMesh->getLodCount() - 1;
+        while (lod > 0 && pMesh->getLod(lod).error > maxError)
+        {
+            lod--;
+        }
+        return lod;
+    }
+
+    bool SceneRenderer::cullMeshlets(const Camera* pCamera, const OcclusionCuller* pOcclusionCuller, const Mesh* pMesh, const mat4& worldMat, bool testFrustum, std::vector<IndexRange>& ranges) const
+    {
+        // The normal cones are tested in object space. A mirroring transform flips the winding the rasterizer sees, so those instances are only culled by their bounds.
+        const bool testCones = mMeshletConeCullEnabled && (pMesh->getMaterial() == nullptr || pMesh->getMaterial()->isDoubleSided() == false) && determinant(mat3(worldMat)) > 0;
+        const vec3 objectEyePos = testCones ? vec3(inverse(worldMat) * vec4(pCamera->getPosition(), 1)) : vec3(0);
+
+        const size_t firstRange = ranges.size();
+        for (const Meshlet& meshlet : pMesh->getMeshlets())
+        {
+            if (testCones && meshlet.isBackfacing(objectEyePos))
+            {
+                continue;
+            }
+            if (testFrustum || pOcclusionCuller)
+            {
+                const BoundingBox worldBox = meshlet.box.transform(worldMat);
+                if ((testFrustum && pCamera->isObjectCulled(worldBox)) || (pOcclusionCuller && pOcclusionCuller->isOccluded(worldBox)))
+                {
+                    continue;
+                }
+            }
+
+            // The meshlets are consecutive in the index buffer, so visible neighbors merge into one draw
+            if (ranges.size() > firstRange && ranges.back().startIndex + ranges.back().indexCount == meshlet.startIndex)
+            {
+                ranges.back().indexCount += meshlet.indexCount;
+            }
+            else
+            {
+                ranges.push_back({ meshlet.startIndex, meshlet.indexCount });
+            }
+        }
+
+        if (ranges.size() == firstRange)
+        {
+            return false;
+        }
+
+        // Nothing was culled. Drawing the whole LOD keeps the instance batchable.
+        if (ranges.size() == firstRange + 1 && ranges.back().indexCount == pMesh->getLod(0).indexCount)
+        {
+            ranges.pop_back();
+        }
+        return true;
+    }
+
+    void SceneRenderer::buildDrawList(const Camera* pCamera)
+    {
+        const TransformStore* pTransforms = mpScene->getTransformStore();
+
+        vec3 eyePos;
+        vec3 viewDir;
+        if (pCamera)
+        {
+            eyePos = pCamera->getPosition();
+            viewDir = normalize(pCamera->getTarget() - eyePos);
+        }
+
+        // Gather the model instances which need to be drawn
+        mVisibleModelInstances.clear();
+        uint32_t modelInstanceIndex = 0;
         for (uint32_t modelID = 0; modelID < mpScene->getModelCount(); modelID++)
         {
-            currentData.pModel = mpScene->getModel(modelID).get();
+            for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++, modelInstanceIndex++)
+            {
+                const Camera::Containment containment = mCullEnabled ? mModelInstanceContainment[modelInstanceIndex] : Camera::Containment::Inside;
+                const auto& pInstance = mpScene->getModelInstance(modelID, instanceID);
+                if (containment != Camera::Containment::Outside && pInstance->isVisible())
+                {
+                    const BoundingBox& box = pInstance->getBoundingBox();
+                    const float depth = pCamera ? dot(box.center - eyePos, viewDir) : 0.0f;
+                    const float screenSize = length(box.extent) / std::max(depth, 1e-3f);
+                    mVisibleModelInstances.push_back({ modelID, instanceID, modelInstanceIndex, containment != Camera::Containment::Inside, depth, screenSize });
+                }
+            }
+        }
+
+        const OcclusionCuller* pOcclusionCuller = nullptr;
+        if (mpOcclusionCuller && pCamera)
+        {
+            rasterizeOccluders(pCamera);
+            pOcclusionCuller = mpOcclusionCuller.get();
+        }
+
+        mDrawListChunkCount = ThreadPool::getChunkCount((uint32_t)mVisibleModelInstances.size(), kDrawListGrainSize);
+        if (mDrawListChunks.size() < mDrawListChunkCount)
+        {
+            mDrawListChunks.resize(mDrawListChunkCount);
+        }
+
+        // Cull the mesh instances in parallel. Each chunk writes its own part of the list, so the result doesn't depend on scheduling.
+        // The camera's frustum planes were already updated by cullModelInstances(), so the workers only read the camera.
+        auto buildChunk = [this, pCamera, pTransforms, pOcclusionCuller, eyePos, viewDir](uint32_t first, uint32_t last)
+        {
+            DrawListChunk& chunk = mDrawListChunks[first / kDrawListGrainSize];
+            chunk.items.clear();
+            chunk.sortKeys.clear();
+            chunk.indexRanges.clear();
+            chunk.occlusionTestCount = 0;
+            chunk.occludedCount = 0;
+
+            for (uint32_t i = first; i < last; i++)
+            {
+                const VisibleModelInstance& visible = mVisibleModelInstances[i];
+                const Model* pModel = mpScene->getModel(visible.modelID).get();
+                const uint32_t firstSlot = pTransforms->getModelInstanceSlot(visible.modelInstanceIndex);
+
+                if (pOcclusionCuller)
+                {
+                    chunk.occlusionTestCount++;
+                    if (pOcclusionCuller->isOccluded(mpScene->getModelInstance(visible.modelID, visible.instanceID)->getBoundingBox()))
+                    {
+                        chunk.occludedCount++;
+                        continue;
+                    }
+                }
+
+                // Test all the model instance's mesh instances against the frustum in one batch
+                if (visible.cullMeshInstances)
+                {
+                    pCamera->cullBoundingBoxes(pTransforms->getWorldBoxes(), firstSlot, pTransforms->getModelSlotCount(visible.modelID), chunk.visibility);
+                }
+
+                for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+                {
+                    const Mesh* pMesh = pModel->getMesh(meshID).get();
+                    const uint32_t meshSlotOffset = pTransforms->getMeshSlotOffset(visible.modelID, meshID);
+                    for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++)
+                    {
+                        const uint32_t bit = meshSlotOffset + instanceID;
+                        const bool culled = visible.cullMeshInstances && ((chunk.visibility[bit / 32] & (1u << (bit % 32))) == 0);
+
+                        if (culled == false && pModel->getMeshInstance(meshID, instanceID)->isVisible())
+                        {
+                            const uint32_t slot = firstSlot + bit;
+
+                            // Model instances with a single mesh instance were already tested above
+                            if (pOcclusionCuller && pTransforms->getModelSlotCount(visible.modelID) > 1)
+                            {
+                                chunk.occlusionTestCount++;
+                                if (pOcclusionCuller->isOccluded(pTransforms->getWorldBoxes().get(slot)))
+                                {
+                                    chunk.occludedCount++;
+                                    continue;
+                                }
+                            }
+
+                            const uint32_t lod = (pMesh->getLodCount() > 1) ? selectLod(pMesh, pTransforms->getWorldBoxes().get(slot), eyePos) : 0;
+
+                            // Large meshes drawn at full detail are culled meshlet by meshlet
+                            const uint32_t firstIndexRange = (uint32_t)chunk.indexRanges.size();
+                            if (lod == 0 && mCullEnabled && mMeshletCullEnabled && pCamera && pMesh->getMeshlets().size() && pMesh->hasBones() == false)
+                            {
+                                if (cullMeshlets(pCamera, pOcclusionCuller, pMesh, pTransforms->getWorldMatrix(slot), visible.cullMeshInstances, chunk.indexRanges) == false)
+                                {
+                                    continue;
+                                }
+                            }
+                            const uint32_t indexRangeCount = (uint32_t)chunk.indexRanges.size() - firstIndexRange;
+                            chunk.items.push_back({ visible.modelID, visible.instanceID, visible.modelInstanceIndex, meshID, instanceID, slot, lod, firstIndexRange, indexRangeCount });
+
+                            if (mDrawOrder != DrawOrder::Scene)
+                            {
+                                // Front-to-back sorts each mesh instance. Otherwise all the mesh instances of a model instance share its depth, so its instanced batches stay together.
+                                float depth = visible.depth;
+                                if (mDrawOrder == DrawOrder::FrontToBack && pCamera)
+                                {
+                                    depth = dot(pTransforms->getWorldBoxes().get(slot).center - eyePos, viewDir);
+                                }
+                                chunk.sortKeys.push_back(calculateSortKey(pModel, pMesh, depth));
+                            }
+                        }
+                    }
+                }
+            }
+        };
+
+        ThreadPool::getGlobalPool()->parallelFor((uint32_t)mVisibleModelInstances.size(), kDrawListGrainSize, buildChunk);
+
+        if (pOcclusionCuller)
+        {
+            for (uint32_t chunkID = 0; chunkID < mDrawListChunkCount; chunkID++)
+            {
+                mpOcclusionCuller->recordTests(mDrawListChunks[chunkID].occlusionTestCount, mDrawListChunks[chunkID].occludedCount);
+            }
+        }
+    }
+
+    void SceneRenderer::rasterizeOccluders(const Camera* pCamera)
+    {
+        // Pick the marked occluders, then the largest of the other candidates
+        mOccluders.clear();
+        std::vector<uint32_t> candidates;
+        for (uint32_t i = 0; i < (uint32_t)mVisibleModelInstances.size(); i++)
+        {
+            const Model* pModel = mpScene->getModel(mVisibleModelInstances[i].modelID).get();
+            if (pModel->hasBones())
+            {
+                continue;
+            }
+            if (pModel->isOccluder())
+            {
+                mOccluders.push_back(i);
+            }
+            else if (mMaxAutoOccluders > 0 && pModel->getMeshCount() > 0 && pModel->getMesh(0)->hasCpuGeometry())
+            {
+                candidates.push_back(i);
+            }
+        }
+
+        const uint32_t autoCount = std::min(mMaxAutoOccluders, (uint32_t)candidates.size());
+        std::partial_sort(candidates.begin(), candidates.begin() + autoCount, candidates.end(), [this](uint32_t a, uint32_t b)
+        {
+            return mVisibleModelInstances[a].screenSize > mVisibleModelInstances[b].screenSize;
+        });
+        mOccluders.insert(mOccluders.end(), candidates.begin(), candidates.begin() + autoCount);
+
+        const TransformStore* pTransforms = mpScene->getTransformStore();
+        mpOcclusionCuller->beginFrame(pCamera->getViewProjMatrix());
+        for (uint32_t occluder : mOccluders)
+        {
+            const VisibleModelInstance& visible = mVisibleModelInstances[occluder];
+            const Model* pModel = mpScene->getModel(visible.modelID).get();
+            const uint32_t firstSlot = pTransforms->getModelInstanceSlot(visible.modelInstanceIndex);
 
-            for (uint32_t instanceID = 0; instanceID < mpScene->getModelInstanceCount(modelID); instanceID++)
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
             {
-                const auto pInstance = mpScene->getModelInstance(modelID, instanceID).get();
-                if (pInstance->isVisible())
+                const Mesh* pMesh = pModel->getMesh(meshID).get();
+                if (pMesh->hasCpuGeometry() == false)
+                {
+                    continue;
+                }
+
+                const uint32_t meshSlotOffset = pTransforms->getMeshSlotOffset(visible.modelID, meshID);
+                for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++)
                 {
-                    if (setPerModelInstanceData(currentData, pInstance, instanceID))
+                    if (pModel->getMeshInstance(meshID, instanceID)->isVisible())
                     {
-                        renderModelInstance(currentData, pInstance);
+                        const glm::mat4& worldMat = pTransforms->getWorldMatrix(firstSlot + meshSlotOffset + instanceID);
+                        mpOcclusionCuller->rasterizeOccluder(pMesh->getCpuPositions().data(), pMesh->getCpuIndices().data(), (uint32_t)pMesh->getCpuIndices().size(), worldMat);
                     }
                 }
             }
         }
+        mpOcclusionCuller->finalizeOccluders();
+    }
+
+    void SceneRenderer::sortDrawList()
+    {
+        // Concatenate the chunks in scene order
+        std::vector<DrawItem>& sceneOrder = (mDrawOrder == DrawOrder::Scene) ? mSortedDrawList : mUnsortedDrawList;
+        sceneOrder.clear();
+        mSortKeys.clear();
+        mIndexRanges.clear();
+        for (uint32_t chunkID = 0; chunkID < mDrawListChunkCount; chunkID++)
+        {
+            const DrawListChunk& chunk = mDrawListChunks[chunkID];
+            const size_t firstItem = sceneOrder.size();
+            sceneOrder.insert(sceneOrder.end(), chunk.items.begin(), chunk.items.end());
+            mSortKeys.insert(mSortKeys.end(), chunk.sortKeys.begin(), chunk.sortKeys.end());
+
+            // The items locate their index ranges in their chunk
+            for (size_t i = firstItem; i < sceneOrder.size(); i++)
+            {
+                sceneOrder[i].firstIndexRange += (uint32_t)mIndexRanges.size();
+            }
+            mIndexRanges.insert(mIndexRanges.end(), chunk.indexRanges.begin(), chunk.indexRanges.end());
+        }
+
+        if (mDrawOrder == DrawOrder::Scene)
+        {
+            return;
+        }
+
+        // The sort is stable, so draws with equal keys stay in scene order
+        mSortValues.resize(sceneOrder.size());
+        for (uint32_t i = 0; i < (uint32_t)mSortValues.size(); i++)
+        {
+            mSortValues[i] = i;
+        }
+        radixSort(mSortKeys, mSortValues, mSortKeyScratch, mSortValueScratch);
+
+        mSortedDrawList.resize(sceneOrder.size());
+        for (uint32_t i = 0; i < (uint32_t)mSortValues.size(); i++)
+        {
+            mSortedDrawList[i] = sceneOrder[mSortValues[i]];
+        }
+    }
+
+    void SceneRenderer::filterModelInstances(CurrentWorkingData& currentData)
+    {
+        // When batching, the draws of a model instance are not submitted together, so ask about each model instance up front and drop the rejected ones
+        mModelInstanceState.assign(mpScene->getModelInstanceBvh()->getPrimitiveCount(), kModelInstanceUnknown);
+
+        uint32_t acceptedCount = 0;
+        for (uint32_t i = 0; i < (uint32_t)mSortedDrawList.size(); i++)
+        {
+            const DrawItem& item = mSortedDrawList[i];
+            uint8_t& state = mModelInstanceState[item.modelInstanceIndex];
+            if (state == kModelInstanceUnknown)
+            {
+                currentData.pModel = mpScene->getModel(item.modelID).get();
+                const bool accepted = setPerModelInstanceData(currentData, mpScene->getModelInstance(item.modelID, item.modelInstanceID).get(), item.modelInstanceID);
+                state = accepted ? kModelInstanceAccepted : kModelInstanceRejected;
+            }
+
+            if (state == kModelInstanceAccepted)
+            {
+                mSortedDrawList[acceptedCount++] = item;
+            }
+        }
+        mSortedDrawList.resize(acceptedCount);
+    }
+
+    void SceneRenderer::updateMeshInstanceBuffer(CurrentWorkingData& currentData)
+    {
+        const uint32_t itemCount = (uint32_t)mSortedDrawList.size();
+        const auto pReflection = currentData.pVars->getReflection()->getBufferDesc(kMeshInstanceBufferName, ProgramReflection::BufferReflection::Type::Structured);
+        currentData.useMeshInstanceBuffer = (pReflection != nullptr);
+        if (pReflection == nullptr)
+        {
+            // setPerMeshInstanceData() falls back to the per-draw arrays of InternalPerMeshCB
+            if (mMeshInstanceBufferWarningLogged == false && sWorldMatOffset != ConstantBuffer::kInvalidOffset)
+            {
+                logWarning(std::string("SceneRenderer: the program doesn't read ") + kMeshInstanceBufferName + ". Setting the instance matrices per draw in " + kPerMeshCbName + " instead, which limits each draw to " + std::to_string(sWorldMatArraySize) + " instances.");
+                mMeshInstanceBufferWarningLogged = true;
+            }
+            return;
+        }
+        if (itemCount == 0)
+        {
+            return;
+        }
+
+        // Gather the per-instance data of the whole frame in submission order
+        mMeshInstanceData.resize(itemCount);
+        const TransformStore* pTransforms = currentData.pTransforms;
+        auto fillInstances = [this, pTransforms](uint32_t first, uint32_t last)
+        {
+            for (uint32_t i = first; i < last; i++)
+            {
+                MeshInstanceData& data = mMeshInstanceData[i];
+                data.worldMat = pTransforms->getWorldMatrix(mSortedDrawList[i].transformSlot);
+                data.worldInvTransposeMat = pTransforms->getWorldInvTransposeMatrix(mSortedDrawList[i].transformSlot);
+                data.drawID = i;
+            }
+        };
+        ThreadPool::getGlobalPool()->parallelFor(itemCount, kMeshInstanceGrainSize, fillInstances);
+
+        // Grow the buffer geometrically, so it is rarely recreated as the number of visible instances changes
+        if (mpMeshInstanceBuffer == nullptr || mpMeshInstanceBuffer->getElementCount() < itemCount)
+        {
+            assert(pReflection->getRequiredSize() == sizeof(MeshInstanceData));
+            const size_t capacity = mpMeshInstanceBuffer ? std::max(mpMeshInstanceBuffer->getElementCount() * 2, (size_t)itemCount) : itemCount;
+            mpMeshInstanceBuffer = StructuredBuffer::create(pReflection, capacity, Resource::BindFlags::ShaderResource);
+        }
+
+        // Only upload the part which is used this frame
+        const size_t size = itemCount * sizeof(MeshInstanceData);
+        mpMeshInstanceBuffer->setBlob(mMeshInstanceData.data(), 0, size);
+        mpMeshInstanceBuffer->uploadToGPU(0, size);
+        currentData.pVars->setStructuredBuffer(kMeshInstanceBufferName, mpMeshInstanceBuffer);
+    }
+
+    void SceneRenderer::submitDrawList(CurrentWorkingData& currentData)
+    {
+        // Reset once per frame. Within a frame, a material is only rebound when it changes, even between models.
+        mpLastMaterial = nullptr;
+
+        if (mBatchModelInstances)
+        {
+            filterModelInstances(currentData);
+        }
+        updateMeshInstanceBuffer(currentData);
+
+        // Consecutive items of the same model are rendered together. Unless batching, sorting can interleave the draws of different model instances, so they are also split by model instance.
+        uint32_t first = 0;
+        const uint32_t itemCount = (uint32_t)mSortedDrawList.size();
+        while (first < itemCount)
+        {
+            const DrawItem& item = mSortedDrawList[first];
+            uint32_t last = first + 1;
+            while (last < itemCount && mSortedDrawList[last].modelID == item.modelID && (mBatchModelInstances || mSortedDrawList[last].modelInstanceID == item.modelInstanceID))
+            {
+                last++;
+            }
+
+            currentData.pModel = mpScene->getModel(item.modelID).get();
+            if (mBatchModelInstances || setPerModelInstanceData(currentData, mpScene->getModelInstance(item.modelID, item.modelInstanceID).get(), item.modelInstanceID))
+            {
+                renderModelInstances(currentData, first, last - first);
+            }
+            first = last;
+        }
+    }
+
+    void SceneRenderer::renderScene(CurrentWorkingData& currentData)
+    {
+        setupVR();
+        setPerFrameData(currentData);
+
+        if (mCullEnabled)
+        {
+            cullModelInstances(currentData.pCamera);
+        }
+
+        currentData.pTransforms = mpScene->getTransformStore();
+
+        mLodPixelsPerUnit = 0;
+        mMeshletConeCullEnabled = false;
+        if (currentData.pCamera && currentData.pState)
+        {
+            const glm::mat4& projMat = currentData.pCamera->getProjMatrix();
+            const bool perspective = (projMat[3][3] == 0);
+
+            // Renderers without object culling, like the shadow maps, don't draw for a single view, so they keep the full detail.
+            // projMat[1][1] is 1/tan(fovY/2) for a perspective projection, so this maps a size at distance one to pixels. For an orthographic projection, it maps a size to pixels at any distance.
+            if (mCullEnabled)
+            {
+                mLodPixelsPerUnit = 0.5f * currentData.pState->getViewport(0).height * projMat[1][1];
+                mLodOrthographic = (perspective == false);
+            }
+
+            // The normal cones are tested from the eye position, which only works with a perspective projection. They also assume the back faces are culled.
+            const RasterizerState* pRastState = currentData.pState->getRasterizerState().get();
+            const bool cullBack = (pRastState == nullptr) || (pRastState->getCullMode() == RasterizerState::CullMode::Back);
+            mMeshletConeCullEnabled = cullBack && perspective;
+        }
+
+        buildDrawList(currentData.pCamera);
+        sortDrawList();
+        submitDrawList(currentData);
     }
 
     void SceneRenderer::renderScene(RenderContext* pContext, Camera* pCamera)
@@ -365,6 +947,18 @@ namespace Falcor
         renderScene(currentData);
     }
 
+    void SceneRenderer::setOcclusionCullState(bool enable)
+    {
+        if (enable && mpOcclusionCuller == nullptr)
+        {
+            mpOcclusionCuller = OcclusionCuller::create();
+        }
+        else if (enable == false)
+        {
+            mpOcclusionCuller = nullptr;
+        }
+    }
+
     void SceneRenderer::setCameraControllerType(CameraControllerType type)
     {
         switch(type)
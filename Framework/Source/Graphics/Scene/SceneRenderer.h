@@ -32,7 +32,9 @@
 #include "Graphics/Scene/Scene.h"
 #include "utils/CpuTimer.h"
 #include "API/ConstantBuffer.h"
+#include "API/StructuredBuffer.h"
 #include "Utils/DebugDrawer.h"
+#include "Graphics/Scene/OcclusionCuller.h"
 
 namespace Falcor
 {
@@ -80,10 +82,53 @@ namespace Falcor
         */
         void setObjectCullState(bool enable) { mCullEnabled = enable; }
 
-        /** Set the maximal number of mesh instance to dispatch in a single draw call.
+        /** Enable/disable CPU occlusion culling. Instances which pass frustum culling are tested against a low-resolution depth buffer containing the scene's largest occluders.\n
+            The occluders are the instances of models marked with Model::setOccluder(), plus the instances which appear largest on screen, see setMaxAutoOccluders().
+            Only meshes with CPU geometry can be occluders, see Model::LoadFlags::KeepCpuGeometry.
+        */
+        void setOcclusionCullState(bool enable);
+
+        /** Enable/disable meshlet culling. The meshlets of visible full detail mesh instances are tested against the frustum, the occluders and their normal cones, and only the visible ones are drawn.\n
+            Meshlets are only culled when object culling is enabled, see setObjectCullState(). The normal cones are only tested with a perspective camera and back face culling.\n
+            Only meshes split into meshlets are affected, see Model::LoadFlags::BuildMeshlets. Instances with culled meshlets are drawn one at a time, so it costs draw calls for heavily instanced meshes.
+        */
+        void setMeshletCullState(bool enable) { mMeshletCullEnabled = enable; }
+
+        /** Set the maximal number of occluders picked automatically by their size on screen, in addition to the models marked as occluders. Pass 0 to only use the marked models.
+        */
+        void setMaxAutoOccluders(uint32_t count) { mMaxAutoOccluders = count; }
+
+        /** Get the occlusion culler, for its statistics. Returns nullptr if occlusion culling is disabled.
+        */
+        const OcclusionCuller* getOcclusionCuller() const { return mpOcclusionCuller.get(); }
+
+        /** The order in which the visible mesh instances are drawn
+        */
+        enum class DrawOrder
+        {
+            Scene,          ///< Model by model, in the order they were added to the scene
+            StateFirst,     ///< Minimize state changes across the whole scene. Draws are grouped by program variant, then material, then mesh.
+            FrontToBack,    ///< Nearest first, to get the most out of early depth rejection. Draws at the same depth are grouped by state.
+        };
+
+        /** Set the draw order. The default is DrawOrder::StateFirst.
+        */
+        void setDrawOrder(DrawOrder order) { mDrawOrder = order; }
+        DrawOrder getDrawOrder() const { return mDrawOrder; }
+
+        /** Set the maximal number of mesh instance to dispatch in a single draw call. By default there is no limit.\n
+            The per-instance data of all the mesh instances drawn in a frame is stored in a single structured buffer, so instances of the same mesh are drawn together even if they belong to different model instances.
         */
         void setMaxInstanceCount(uint32_t instanceCount) { mMaxInstanceCount = instanceCount; }
 
+        /** Set the largest error allowed when picking the LOD of a mesh instance, in pixels. The coarsest LOD whose error, projected at the distance of the instance, stays below it is drawn.
+
+            Only meshes with LODs are affected, see Model::LoadFlags::GenerateLods. Pass 0 to always draw the full detail meshes. The default is 1 pixel.
+            LODs are only selected when object culling is enabled, see setObjectCullState(). Otherwise the full detail meshes are drawn.
+        */
+        void setLodErrorThreshold(float pixels) { mLodErrorThreshold = pixels; }
+        float getLodErrorThreshold() const { return mLodErrorThreshold; }
+
         /** This setting controls whether to unload textures from GPU memory before binding a new material.\n
         Useful for rendering very large models with many textures that can't fit into GPU memory at once. Setting this to true usually results in performance loss.
         */
@@ -106,6 +151,13 @@ namespace Falcor
 
     protected:
 
+        // A range of a mesh's index buffer
+        struct IndexRange
+        {
+            uint32_t startIndex;
+            uint32_t indexCount;
+        };
+
         struct CurrentWorkingData
         {
             RenderContext* pContext = nullptr;
@@ -115,7 +167,58 @@ namespace Falcor
             const Model* pModel = nullptr;
             const Material* pMaterial = nullptr;
 
-            uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene, and increments per mesh instance drawn.
+            uint32_t drawID; // Zero-based mesh instance draw order/ID. Resets at the beginning of renderScene. This is also the mesh instance's index in the per-instance data buffer.
+            const TransformStore* pTransforms = nullptr;
+            uint32_t meshInstanceSlot = 0;  // Transform store slot of the current mesh instance
+            uint32_t lod = 0;               // LOD of the current draw
+            const IndexRange* pIndexRanges = nullptr;   // The visible parts of the LOD, or nullptr to draw all of it
+            uint32_t indexRangeCount = 0;
+            bool useMeshInstanceBuffer = true;          // False if the program doesn't read the per-instance data buffer. The instances' data is then set per draw in InternalPerMeshCB.
+        };
+
+        // A mesh instance which passed culling
+        struct DrawItem
+        {
+            uint32_t modelID;
+            uint32_t modelInstanceID;
+            uint32_t modelInstanceIndex;    // Index of the model instance across all models
+            uint32_t meshID;
+            uint32_t meshInstanceID;
+            uint32_t transformSlot;
+            uint32_t lod;
+            uint32_t firstIndexRange;       // The visible meshlets, merged into ranges of mIndexRanges. indexRangeCount is 0 if the whole LOD is drawn.
+            uint32_t indexRangeCount;
+        };
+
+        // A model instance which passed the hierarchical culling
+        struct VisibleModelInstance
+        {
+            uint32_t modelID;
+            uint32_t instanceID;
+            uint32_t modelInstanceIndex;
+            bool cullMeshInstances; // False if the model instance is completely inside the frustum
+            float depth;            // Distance of the bounding box center along the view direction
+            float screenSize;       // Bounding box size divided by depth. Used to pick occluders.
+        };
+
+        // Per mesh instance shader data. Matches MeshInstanceData in ShaderCommon.h.
+        struct MeshInstanceData
+        {
+            glm::mat4 worldMat;
+            glm::mat3x4 worldInvTransposeMat; // HLSL uses column-major and packing rules require 16B alignment, hence use glm:mat3x4
+            uint32_t drawID;
+            uint32_t pad[3];
+        };
+
+        // The part of the draw list built by one parallel task
+        struct DrawListChunk
+        {
+            std::vector<DrawItem> items;
+            std::vector<uint64_t> sortKeys;
+            std::vector<IndexRange> indexRanges;
+            std::vector<uint32_t> visibility; // Scratch visibility bitmask
+            uint32_t occlusionTestCount = 0;
+            uint32_t occludedCount = 0;
         };
 
         SceneRenderer(const Scene::SharedPtr& pScene);
@@ -124,6 +227,7 @@ namespace Falcor
         static const char* kPerMaterialCbName;
         static const char* kPerFrameCbName;
         static const char* kPerMeshCbName;
+        static const char* kMeshInstanceBufferName;
 
         static size_t sBonesOffset;
         static size_t sCameraDataOffset;
@@ -132,8 +236,11 @@ namespace Falcor
         static size_t sWorldMatArraySize;
         static size_t sWorldMatOffset;
         static size_t sWorldInvTransposeMatOffset;
-        static size_t sMeshIdOffset;
         static size_t sDrawIDOffset;
+        static size_t sMeshIdOffset;
+        static size_t sFirstInstanceOffset;
+        static size_t sPositionScaleOffset;
+        static size_t sPositionBiasOffset;
 
         static void updateVariableOffsets(const ProgramReflection* pReflector);
 
@@ -143,24 +250,68 @@ namespace Falcor
         virtual bool setPerMeshData(const CurrentWorkingData& currentData, const Mesh* pMesh);
         virtual bool setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID);
         virtual bool setPerMaterialData(const CurrentWorkingData& currentData, const Material* pMaterial);
-        virtual void executeDraw(const CurrentWorkingData& currentData, uint32_t indexCount, uint32_t instanceCount);
+        /** Issue the draw call of the current mesh.
+            Subclasses which used to override executeDraw(currentData, indexCount, instanceCount) must now draw the index ranges of currentData.pIndexRanges if there are any, or else the current LOD of pMesh. Meshes from a GeometryPool also need their start index and base vertex.
+            \param[in] currentData The current draw. currentData.lod and the index ranges select what part of the mesh is drawn.
+            \param[in] pMesh The mesh to draw
+            \param[in] instanceCount The number of instances to draw
+        */
+        virtual void executeDraw(const CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
         virtual void postFlushDraw(const CurrentWorkingData& currentData);
 
-        void renderModelInstance(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance);
-        void renderMeshInstances(CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, uint32_t meshID);
-        void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t instanceCount);
+        void renderModelInstances(CurrentWorkingData& currentData, uint32_t firstItem, uint32_t itemCount);
+        void renderMeshInstances(CurrentWorkingData& currentData, uint32_t firstItem, uint32_t itemCount);
+        void draw(CurrentWorkingData& currentData, const Mesh* pMesh, uint32_t firstInstance, uint32_t instanceCount);
 
         void setupVR();
         void renderScene(CurrentWorkingData& currentData);
+        void cullModelInstances(const Camera* pCamera);
+        void buildDrawList(const Camera* pCamera);
+        void rasterizeOccluders(const Camera* pCamera);
+        void sortDrawList();
+        void filterModelInstances(CurrentWorkingData& currentData);
+        void updateMeshInstanceBuffer(CurrentWorkingData& currentData);
+        void submitDrawList(CurrentWorkingData& currentData);
+        uint64_t calculateSortKey(const Model* pModel, const Mesh* pMesh, float depth) const;
+        uint32_t selectLod(const Mesh* pMesh, const BoundingBox& worldBox, const glm::vec3& eyePos) const;
+        bool cullMeshlets(const Camera* pCamera, const OcclusionCuller* pOcclusionCuller, const Mesh* pMesh, const glm::mat4& worldMat, bool testFrustum, std::vector<IndexRange>& ranges) const;
 
         CameraControllerType mCamControllerType = CameraControllerType::SixDof;
         CameraController::SharedPtr mpCameraController;
 
-        uint32_t mMaxInstanceCount = 64;
+        uint32_t mMaxInstanceCount = UINT32_MAX;
+        bool mBatchModelInstances = true;   // Draw the instances of a mesh in different model instances together. Subclasses which change the render state in setPerModelInstanceData() must disable it.
         const Material* mpLastMaterial = nullptr;
         bool mCullEnabled = true;
         bool mUnloadTexturesOnMaterialChange = false;
         RenderMode mRenderMode = RenderMode::Mono;
         bool mCompileMaterialWithProgram = true;
+        DrawOrder mDrawOrder = DrawOrder::StateFirst;
+        OcclusionCuller::UniquePtr mpOcclusionCuller;
+        uint32_t mMaxAutoOccluders = 8;
+        float mLodErrorThreshold = 1.0f;
+        float mLodPixelsPerUnit = 0;        // Pixels covered by one unit at distance one, for the current camera and viewport. 0 disables the LOD selection.
+        bool mLodOrthographic = false;      // The current camera uses an orthographic projection, so mLodPixelsPerUnit applies at any distance
+        bool mMeshletCullEnabled = true;
+        bool mMeshletConeCullEnabled = false;   // The current camera and rasterizer state allow culling backfacing meshlets
+
+        std::vector<Camera::Containment> mModelInstanceContainment; // Per model instance frustum containment, indexed like the scene's model instance BVH primitives
+        std::vector<VisibleModelInstance> mVisibleModelInstances;
+        std::vector<uint32_t> mOccluders;                           // Indices into mVisibleModelInstances
+        std::vector<DrawListChunk> mDrawListChunks;                 // The draw list, in scene order. Kept across frames to reuse the allocations.
+        uint32_t mDrawListChunkCount = 0;
+        std::vector<DrawItem> mSortedDrawList;                      // The draw list, in submission order
+        std::vector<DrawItem> mUnsortedDrawList;
+        std::vector<IndexRange> mIndexRanges;                       // The visible meshlets of the draw list's items
+        std::vector<uint8_t> mModelInstanceState;                   // Per model instance result of setPerModelInstanceData(), when batching model instances
+        std::vector<MeshInstanceData> mMeshInstanceData;            // Indexed like mSortedDrawList
+        StructuredBuffer::SharedPtr mpMeshInstanceBuffer;
+        bool mMeshInstanceBufferWarningLogged = false;
+
+        // Sort scratch space
+        std::vector<uint64_t> mSortKeys;
+        std::vector<uint32_t> mSortValues;
+        std::vector<uint64_t> mSortKeyScratch;
+        std::vector<uint32_t> mSortValueScratch;
     };
 }
@@ -0,0 +1,200 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TransformStore.h"
+#include "glm/matrix.hpp"
+#include "Utils/ThreadPool.h"
+
+namespace Falcor
+{
+    static const uint32_t kUpdateGrainSize = 64;   // Model instances per parallel task
+
+    TransformStore::UniquePtr TransformStore::create()
+    {
+        return UniquePtr(new TransformStore());
+    }
+
+    void TransformStore::rebuild(const std::vector<ModelInstanceList>& models)
+    {
+        mModelInstances.clear();
+        mModelInstanceSlots.clear();
+        mModelInstanceVersions.clear();
+        mModelSlotCounts.resize(models.size());
+        mMeshSlotOffsets.resize(models.size());
+        mMeshInstanceVersions.resize(models.size());
+
+        // Instances calculate their matrices lazily, and mesh instances are shared by all the instances of a model.
+        // The serial passes below resolve the matrices, so the parallel passes only read them.
+        uint32_t slotCount = 0;
+        for (uint32_t modelID = 0; modelID < (uint32_t)models.size(); modelID++)
+        {
+            const Model* pModel = models[modelID][0]->getObject().get();
+
+            // Layout of the mesh instances inside a model instance's slot range
+            auto& meshOffsets = mMeshSlotOffsets[modelID];
+            auto& meshVersions = mMeshInstanceVersions[modelID];
+            meshOffsets.resize(pModel->getMeshCount());
+            meshVersions.clear();
+
+            uint32_t modelSlotCount = 0;
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                meshOffsets[meshID] = modelSlotCount;
+                modelSlotCount += pModel->getMeshInstanceCount(meshID);
+
+                for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++)
+                {
+                    const auto& pMeshInstance = pModel->getMeshInstance(meshID, instanceID);
+                    meshVersions.push_back(pMeshInstance->getTransformVersion());
+                    pMeshInstance->getTransformMatrix();
+                }
+            }
+            mModelSlotCounts[modelID] = modelSlotCount;
+
+            for (const auto& pInstance : models[modelID])
+            {
+                mModelInstances.push_back(pInstance.get());
+                mModelInstanceSlots.push_back(slotCount);
+                mModelInstanceVersions.push_back(pInstance->getTransformVersion());
+                pInstance->getTransformMatrix();
+                slotCount += modelSlotCount;
+            }
+        }
+
+        mWorldMatrices.resize(slotCount);
+        mWorldInvTransposeMatrices.resize(slotCount);
+        mWorldBoxes.resize(slotCount);
+
+        ThreadPool::getGlobalPool()->parallelFor((uint32_t)mModelInstances.size(), kUpdateGrainSize, [this](uint32_t first, uint32_t last)
+        {
+            for (uint32_t i = first; i < last; i++)
+            {
+                updateModelInstance(mModelInstances[i], mModelInstanceSlots[i]);
+            }
+        });
+    }
+
+    bool TransformStore::isLayoutCurrent(const std::vector<ModelInstanceList>& models) const
+    {
+        if (models.size() != mModelSlotCounts.size())
+        {
+            return false;
+        }
+
+        for (uint32_t modelID = 0; modelID < (uint32_t)models.size(); modelID++)
+        {
+            const Model* pModel = models[modelID][0]->getObject().get();
+            const auto& meshOffsets = mMeshSlotOffsets[modelID];
+            if (pModel->getMeshCount() != meshOffsets.size())
+            {
+                return false;
+            }
+
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                const uint32_t meshEnd = (meshID + 1 < pModel->getMeshCount()) ? meshOffsets[meshID + 1] : mModelSlotCounts[modelID];
+                if (pModel->getMeshInstanceCount(meshID) != meshEnd - meshOffsets[meshID])
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void TransformStore::update(const std::vector<ModelInstanceList>& models, std::vector<uint32_t>& movedModelInstances)
+    {
+        movedModelInstances.clear();
+        assert(isLayoutCurrent(models));
+
+        uint32_t modelInstanceIndex = 0;
+        for (uint32_t modelID = 0; modelID < (uint32_t)models.size(); modelID++)
+        {
+            const Model* pModel = models[modelID][0]->getObject().get();
+
+            bool meshesMoved = false;
+            uint32_t meshInstanceIndex = 0;
+            auto& meshVersions = mMeshInstanceVersions[modelID];
+            for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+            {
+                for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++, meshInstanceIndex++)
+                {
+                    const auto& pMeshInstance = pModel->getMeshInstance(meshID, instanceID);
+                    const uint32_t version = pMeshInstance->getTransformVersion();
+                    if (version != meshVersions[meshInstanceIndex])
+                    {
+                        meshVersions[meshInstanceIndex] = version;
+                        pMeshInstance->getTransformMatrix();
+                        meshesMoved = true;
+                    }
+                }
+            }
+
+            for (const auto& pInstance : models[modelID])
+            {
+                const uint32_t version = pInstance->getTransformVersion();
+                if (meshesMoved || version != mModelInstanceVersions[modelInstanceIndex])
+                {
+                    mModelInstanceVersions[modelInstanceIndex] = version;
+                    pInstance->getTransformMatrix();
+                    movedModelInstances.push_back(modelInstanceIndex);
+                }
+                modelInstanceIndex++;
+            }
+        }
+
+        const uint32_t* pMoved = movedModelInstances.data();
+        ThreadPool::getGlobalPool()->parallelFor((uint32_t)movedModelInstances.size(), kUpdateGrainSize, [this, pMoved](uint32_t first, uint32_t last)
+        {
+            for (uint32_t i = first; i < last; i++)
+            {
+                updateModelInstance(mModelInstances[pMoved[i]], mModelInstanceSlots[pMoved[i]]);
+            }
+        });
+    }
+
+    void TransformStore::updateModelInstance(const ObjectInstance<Model>* pModelInstance, uint32_t firstSlot)
+    {
+        const Model* pModel = pModelInstance->getObject().get();
+        const glm::mat4& modelMat = pModelInstance->getTransformMatrix();
+
+        uint32_t slot = firstSlot;
+        for (uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            for (uint32_t instanceID = 0; instanceID < pModel->getMeshInstanceCount(meshID); instanceID++, slot++)
+            {
+                const Model::MeshInstance* pMeshInstance = pModel->getMeshInstance(meshID, instanceID).get();
+
+                const glm::mat4 worldMat = modelMat * pMeshInstance->getTransformMatrix();
+                mWorldMatrices[slot] = worldMat;
+                mWorldInvTransposeMatrices[slot] = transpose(inverse(glm::mat3(worldMat)));
+                mWorldBoxes.set(slot, pMeshInstance->getBoundingBox().transform(modelMat));
+            }
+        }
+    }
+}
@@ -0,0 +1,109 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include "glm/mat4x4.hpp"
+#include "glm/mat3x4.hpp"
+#include "Utils/AABB.h"
+#include "Graphics/Model/Model.h"
+#include "Graphics/Model/ObjectInstance.h"
+
+namespace Falcor
+{
+    /** Contiguous storage of the world-space transforms of a scene's mesh instances.\n
+        Every mesh instance of every model instance owns a slot holding its world matrix, the matching normal matrix and its world-space bounding box, stored as separate arrays.
+        Slots are ordered by model, model instance, mesh and mesh instance, the same order SceneRenderer draws in.\n
+        update() compares the transform versions of the instances against the cached ones, and only recalculates the slots of instances which moved. The recalculation is spread over the global thread pool.
+    */
+    class TransformStore
+    {
+    public:
+        using UniquePtr = std::unique_ptr<TransformStore>;
+        using ModelInstanceList = std::vector<ObjectInstance<Model>::SharedPtr>;
+
+        static UniquePtr create();
+
+        /** Reallocate the slots for a new list of models and instances, and calculate all the transforms. Call this when instances are added or removed.
+            \param[in] models Model instance lists, indexed by model ID.
+        */
+        void rebuild(const std::vector<ModelInstanceList>& models);
+
+        /** Check if the models still have the mesh instance layout of the last call to rebuild(). Mesh instances can be added to a model after the scene was built.
+            \param[in] models Model instance lists, indexed by model ID.
+        */
+        bool isLayoutCurrent(const std::vector<ModelInstanceList>& models) const;
+
+        /** Recalculate the slots of instances which moved since the last update.
+            \param[in] models Model instance lists. Must have the same layout as in the last call to rebuild(), see isLayoutCurrent().
+            \param[out] movedModelInstances Running indices of the model instances whose slots were recalculated.
+        */
+        void update(const std::vector<ModelInstanceList>& models, std::vector<uint32_t>& movedModelInstances);
+
+        /** Get the total number of slots
+        */
+        uint32_t getSlotCount() const { return (uint32_t)mWorldMatrices.size(); }
+
+        /** Get the first slot of a model instance.
+            \param[in] modelInstanceIndex Running model instance index, enumerating the instances of all models with the instance ID in the inner loop.
+        */
+        uint32_t getModelInstanceSlot(uint32_t modelInstanceIndex) const { return mModelInstanceSlots[modelInstanceIndex]; }
+
+        /** Get the number of slots of each instance of a model. This is the number of mesh instances in the model.
+        */
+        uint32_t getModelSlotCount(uint32_t modelID) const { return mModelSlotCounts[modelID]; }
+
+        /** Get the offset of a mesh's first instance from the first slot of a model instance.
+            The slot of mesh instance (meshID, instanceID) is getModelInstanceSlot() + getMeshSlotOffset(modelID, meshID) + instanceID.
+        */
+        uint32_t getMeshSlotOffset(uint32_t modelID, uint32_t meshID) const { return mMeshSlotOffsets[modelID][meshID]; }
+
+        const glm::mat4& getWorldMatrix(uint32_t slot) const { return mWorldMatrices[slot]; }
+        const glm::mat3x4& getWorldInvTransposeMatrix(uint32_t slot) const { return mWorldInvTransposeMatrices[slot]; }
+        const BoundingBoxArray& getWorldBoxes() const { return mWorldBoxes; }
+
+    private:
+        TransformStore() = default;
+
+        void updateModelInstance(const ObjectInstance<Model>* pModelInstance, uint32_t firstSlot);
+
+        // Per slot
+        std::vector<glm::mat4> mWorldMatrices;
+        std::vector<glm::mat3x4> mWorldInvTransposeMatrices;
+        BoundingBoxArray mWorldBoxes;
+
+        // Per model instance
+        std::vector<const ObjectInstance<Model>*> mModelInstances;
+        std::vector<uint32_t> mModelInstanceSlots;
+        std::vector<uint32_t> mModelInstanceVersions;
+
+        // Per model
+        std::vector<uint32_t> mModelSlotCounts;
+        std::vector<std::vector<uint32_t>> mMeshSlotOffsets;
+        std::vector<std::vector<uint32_t>> mMeshInstanceVersions;  ///< Mesh instances are shared by all the instances of a model. If one of them moves, all the model's instances need to be updated.
+    };
+}
@@ -0,0 +1,266 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "TextureCache.h"
+#include "TextureHelper.h"
+#include "Utils/OS.h"
+#include "Utils/StringUtils.h"
+#include "Utils/HashUtils.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/AsyncLoadTask.h"
+#include <unordered_map>
+#include <algorithm>
+#include <mutex>
+#include <cstring>
+
+namespace Falcor
+{
+    struct TextureKey
+    {
+        uint64_t hash = 0;      // Of the content, the file or the texels
+        uint64_t size = 0;      // Of the content, in bytes
+        uint32_t options[4] = {};
+        bool operator==(const TextureKey& other) const { return hash == other.hash && size == other.size && memcmp(options, other.options, sizeof(options)) == 0; }
+    };
+
+    struct TextureKeyHash
+    {
+        size_t operator()(const TextureKey& key) const { return (size_t)(key.hash ^ (key.size * 0x9e3779b97f4a7c15ull) ^ key.options[0] ^ ((uint64_t)key.options[1] << 32)); }
+    };
+
+    // The content hash of an image file, valid while the file's modification time doesn't change
+    struct FileHash
+    {
+        time_t modifiedTime = 0;
+        uint64_t hash = 0;
+        uint64_t size = 0;
+    };
+
+    enum class KeyType : uint32_t
+    {
+        File,
+        Texels
+    };
+
+    static std::mutex sMutex;
+    static bool sEnabled = true;
+    static TextureCache::Statistics sStatistics;
+    static std::unordered_map<TextureKey, std::weak_ptr<Texture>, TextureKeyHash> sTextures;
+    static std::unordered_map<std::string, FileHash> sFileHashes;
+    static size_t sEvictionSize = 64;    // The entry count at which the next insertion evicts the released textures
+
+    static uint32_t evictReleasedLocked()
+    {
+        uint32_t count = 0;
+        for(auto it = sTextures.begin(); it != sTextures.end();)
+        {
+            if(it->second.expired())
+            {
+                it = sTextures.erase(it);
+                count++;
+            }
+            else
+            {
+                it++;
+            }
+        }
+        sStatistics.evictionCount += count;
+        return count;
+    }
+
+    static uint64_t getTextureBytes(const Texture* pTexture)
+    {
+        return (uint64_t)pTexture->getDataSize() * pTexture->getArraySize();
+    }
+
+    // Look up a live texture, and count the request
+    static Texture::SharedPtr findTexture(const TextureKey& key)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        auto it = sTextures.find(key);
+        Texture::SharedPtr pTexture = (it != sTextures.end()) ? it->second.lock() : nullptr;
+        if(pTexture)
+        {
+            sStatistics.hitCount++;
+            sStatistics.bytesSaved += getTextureBytes(pTexture.get());
+        }
+        return pTexture;
+    }
+
+    // Register a new texture. If another thread registered the same content in the meantime, returns its texture instead.
+    static Texture::SharedPtr registerTexture(const TextureKey& key, const Texture::SharedPtr& pTexture)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        std::weak_ptr<Texture>& entry = sTextures[key];
+        Texture::SharedPtr pExisting = entry.lock();
+        if(pExisting)
+        {
+            sStatistics.hitCount++;
+            return pExisting;
+        }
+
+        sStatistics.missCount++;
+        entry = pTexture;
+        if(sTextures.size() >= sEvictionSize)
+        {
+            evictReleasedLocked();
+            sEvictionSize = std::max<size_t>(64, sTextures.size() * 2);
+        }
+        return pTexture;
+    }
+
+    static bool getFileHash(const std::string& filename, FileHash& fileHash)
+    {
+        const time_t modifiedTime = getFileModifiedTime(filename);
+        {
+            std::lock_guard<std::mutex> lock(sMutex);
+            auto it = sFileHashes.find(filename);
+            if(it != sFileHashes.end() && it->second.modifiedTime == modifiedTime)
+            {
+                fileHash = it->second;
+                return true;
+            }
+        }
+
+        // Hash outside of the lock, so that loading threads hash their files in parallel
+        MemoryMappedFile::UniquePtr pFile = MemoryMappedFile::create(filename);
+        if(pFile == nullptr)
+        {
+            return false;
+        }
+        fileHash.modifiedTime = modifiedTime;
+        fileHash.hash = hashBytes(pFile->getData(), pFile->getSize());
+        fileHash.size = pFile->getSize();
+
+        std::lock_guard<std::mutex> lock(sMutex);
+        sFileHashes[filename] = fileHash;
+        return true;
+    }
+
+    void TextureCache::setEnabled(bool enabled)
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sEnabled = enabled;
+    }
+
+    bool TextureCache::isEnabled()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sEnabled;
+    }
+
+    TextureCache::Statistics TextureCache::getStatistics()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return sStatistics;
+    }
+
+    void TextureCache::resetStatistics()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sStatistics = Statistics();
+    }
+
+    Texture::SharedPtr TextureCache::getTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
+    {
+        std::string fullpath = filename;
+        if(isEnabled() == false || (doesFileExist(fullpath) == false && findFileInDataDirectories(filename, fullpath) == false))
+        {
+            return createTextureFromFile(filename, generateMipLevels, loadAsSrgb, bindFlags);
+        }
+
+        fullpath = canonicalizeFilename(fullpath);
+        std::transform(fullpath.begin(), fullpath.end(), fullpath.begin(), ::tolower);
+        FileHash fileHash;
+        if(getFileHash(fullpath, fileHash) == false)
+        {
+            return createTextureFromFile(filename, generateMipLevels, loadAsSrgb, bindFlags);
+        }
+
+        // DDS files are created in their own format, so the extension is part of the key too
+        TextureKey key;
+        key.hash = fileHash.hash;
+        key.size = fileHash.size;
+        key.options[0] = (uint32_t)KeyType::File;
+        key.options[1] = (uint32_t)bindFlags;
+        key.options[2] = (generateMipLevels ? 1 : 0) | (loadAsSrgb ? 2 : 0) | (hasSuffix(fullpath, ".dds") ? 4 : 0);
+
+        Texture::SharedPtr pTexture = findTexture(key);
+        if(pTexture)
+        {
+            return pTexture;
+        }
+
+        pTexture = createTextureFromFile(fullpath, generateMipLevels, loadAsSrgb, bindFlags);
+        return pTexture ? registerTexture(key, pTexture) : nullptr;
+    }
+
+    Texture::SharedPtr TextureCache::getTexture2D(uint32_t width, uint32_t height, ResourceFormat format, const void* pData, const std::string& sourceName)
+    {
+        auto createTexture = [&]()
+        {
+            Texture::SharedPtr pTexture = AsyncLoadTask::runOnMainThread([&]() { return Texture::create2D(width, height, format, 1, Texture::kMaxPossible, pData); });
+            pTexture->setSourceFilename(sourceName);
+            return pTexture;
+        };
+
+        if(isEnabled() == false)
+        {
+            return createTexture();
+        }
+
+        const uint32_t widthRatio = getFormatWidthCompressionRatio(format);
+        const uint32_t heightRatio = getFormatHeightCompressionRatio(format);
+        const size_t size = (size_t)((width + widthRatio - 1) / widthRatio) * ((height + heightRatio - 1) / heightRatio) * getFormatBytesPerBlock(format);
+
+        TextureKey key;
+        key.hash = hashBytes(pData, size);
+        key.size = size;
+        key.options[0] = (uint32_t)KeyType::Texels;
+        key.options[1] = width;
+        key.options[2] = height;
+        key.options[3] = (uint32_t)format;
+
+        Texture::SharedPtr pTexture = findTexture(key);
+        return pTexture ? pTexture : registerTexture(key, createTexture());
+    }
+
+    uint32_t TextureCache::evictReleased()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        return evictReleasedLocked();
+    }
+
+    void TextureCache::clear()
+    {
+        std::lock_guard<std::mutex> lock(sMutex);
+        sTextures.clear();
+        sFileHashes.clear();
+        sEvictionSize = 64;
+    }
+}
@@ -0,0 +1,84 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include "API/Texture.h"
+
+namespace Falcor
+{
+    /** Process-wide cache of the textures loaded by the model and scene importers.\n
+        Textures are identified by their content: the hash and size of the image file or of the texel data, together with the options they are created with. Two models referencing the same image, even through different paths, get the same Texture object.
+        The cache holds its textures weakly. A texture is only shared while some model or material still uses it, and the entries of released textures are evicted as the cache grows.
+        Image files are hashed again only when their modification time changes.
+    */
+    class TextureCache
+    {
+    public:
+        struct Statistics
+        {
+            uint32_t hitCount = 0;          ///< Requests which returned a live texture
+            uint32_t missCount = 0;         ///< Requests which created a texture
+            uint64_t bytesSaved = 0;        ///< GPU memory the hits didn't allocate, including the mip-chains
+            uint32_t evictionCount = 0;     ///< Entries removed after their texture was released
+        };
+
+        /** Enable or disable the cache. It's enabled by default. While disabled, every request creates a new texture.
+        */
+        static void setEnabled(bool enabled);
+        static bool isEnabled();
+
+        /** Get the hit and miss statistics since startup or the last resetStatistics() call
+        */
+        static Statistics getStatistics();
+        static void resetStatistics();
+
+        /** Get a texture loaded from an image file. Takes the same arguments as createTextureFromFile().
+            \return A live texture with the same content and options, or a new one. nullptr if the file can't be loaded.
+        */
+        static Texture::SharedPtr getTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+        /** Get a 2D shader-resource texture with a full mip-chain, created from texels in memory
+            \param[in] width The width of the texture
+            \param[in] height The height of the texture
+            \param[in] format The format of the texture
+            \param[in] pData The texels of the top mip-level
+            \param[in] sourceName The name set as the source filename of a new texture
+            \return A live texture with the same content and format, or a new one
+        */
+        static Texture::SharedPtr getTexture2D(uint32_t width, uint32_t height, ResourceFormat format, const void* pData, const std::string& sourceName);
+
+        /** Remove the entries of the released textures
+            \return The number of entries removed
+        */
+        static uint32_t evictReleased();
+
+        /** Forget all the textures. Textures requested afterwards are never shared with earlier ones.
+        */
+        static void clear();
+    };
+}
@@ -32,6 +32,8 @@
 #include "Utils/DDSHeader.h"
 #include "Utils/BinaryFileStream.h"
 #include "Utils/StringUtils.h"
+#include "Utils/AsyncLoadTask.h"
+#include "Graphics/Model/Loaders/BinaryImage.hpp"
 
 #ifdef FALCOR_GL
 static const bool kTopDown = false;
@@ -643,30 +645,30 @@ namespace Falcor
 	{
 		DdsData ddsData;
 		loadDDSDataFromFile(filename, ddsData);
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TexturesDecoded);
 		
 		ResourceFormat format = getDdsResourceFormat(ddsData);
 		assert(format != ResourceFormat::Unknown);
 
-		uint32_t mipLevels;
-		if (generateMips)
+		// Files which store a mip-chain, like the ones compressTextureToDdsFile() writes, use it even if generating mips was requested
+		uint32_t mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
+		if (generateMips && mipLevels == 1)
 		{
 			mipLevels = Texture::kMaxPossible;
-		} 
-		else
-		{
-			mipLevels = (ddsData.header.flags & DdsHeader::kMipCountMask) ? max(ddsData.header.mipCount, 1U) : 1;
 		}
 	
-		if (ddsData.hasDX10Header)
-		{
-            return createTextureFromDx10Dds(ddsData, filename, format, mipLevels, bindFlags);
-		}
-		else
-		{
-            return createTextureFromLegacyDds(ddsData, filename, format, mipLevels, bindFlags);
-		}
-		
-		return nullptr;
+        // The file is read on the calling thread. Async loads create the texture on the main thread.
+        return AsyncLoadTask::runOnMainThread([&]()
+        {
+            if (ddsData.hasDX10Header)
+            {
+                return createTextureFromDx10Dds(ddsData, filename, format, mipLevels, bindFlags);
+            }
+            else
+            {
+                return createTextureFromLegacyDds(ddsData, filename, format, mipLevels, bindFlags);
+            }
+        });
 	}
 
 	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags)
@@ -693,10 +695,152 @@ namespace Falcor
                 texFormat = linearToSrgbFormat(texFormat);
             }
 
-            pTex = Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags);
+            AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TexturesDecoded);
+            pTex = AsyncLoadTask::runOnMainThread([&]() { return Texture::create2D(pBitmap->getWidth(), pBitmap->getHeight(), texFormat, 1, generateMipLevels ? Texture::kMaxPossible : 1, pBitmap->getData(), bindFlags); });
             pTex->setSourceFilename(stripDataDirectories(filename));
         }
         return pTex;
     }
 #undef no_srgb
+
+    // Load an 8-bit image as RGBA. Single-channel images are replicated into RGB.
+    static bool loadRgba8Image(const std::string& filename, bool isTopDown, std::vector<uint8_t>& pixels, uint32_t& width, uint32_t& height)
+    {
+        Bitmap::UniqueConstPtr pBitmap = Bitmap::createFromFile(filename, isTopDown);
+        if(pBitmap == nullptr)
+        {
+            return false;
+        }
+
+        width = pBitmap->getWidth();
+        height = pBitmap->getHeight();
+        const ResourceFormat format = pBitmap->getFormat();
+        const uint32_t srcBytesPerPixel = getFormatBytesPerBlock(format);
+        if(format != ResourceFormat::BGRA8Unorm && format != ResourceFormat::BGRX8Unorm && format != ResourceFormat::RG8Unorm && format != ResourceFormat::R8Unorm)
+        {
+            logError("Can't compress " + filename + ". Only 8-bit images can be block-compressed.");
+            return false;
+        }
+
+        pixels.resize((size_t)width * height * 4);
+        const uint8_t* pSrc = pBitmap->getData();
+        if(format == ResourceFormat::BGRA8Unorm)
+        {
+            FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, pixels.data(), width * 4, FW::ImageFormat::BGRA_8888, pSrc, width * 4, width, height);
+            return true;
+        }
+
+        for(size_t i = 0; i < (size_t)width * height; i++, pSrc += srcBytesPerPixel)
+        {
+            uint8_t* pDst = &pixels[i * 4];
+            switch(format)
+            {
+            case ResourceFormat::BGRX8Unorm:
+                pDst[0] = pSrc[2];
+                pDst[1] = pSrc[1];
+                pDst[2] = pSrc[0];
+                pDst[3] = 255;
+                break;
+            case ResourceFormat::RG8Unorm:
+                pDst[0] = pSrc[0];
+                pDst[1] = pSrc[1];
+                pDst[2] = 0;
+                pDst[3] = 255;
+                break;
+            default:
+                pDst[0] = pDst[1] = pDst[2] = pSrc[0];
+                pDst[3] = 255;
+            }
+        }
+        return true;
+    }
+
+    static DXGI_FORMAT getCompressedDxgiFormat(ResourceFormat format)
+    {
+        switch(format)
+        {
+        case ResourceFormat::BC1Unorm:
+            return DXGI_FORMAT_BC1_UNORM;
+        case ResourceFormat::BC1UnormSrgb:
+            return DXGI_FORMAT_BC1_UNORM_SRGB;
+        case ResourceFormat::BC3Unorm:
+            return DXGI_FORMAT_BC3_UNORM;
+        case ResourceFormat::BC3UnormSrgb:
+            return DXGI_FORMAT_BC3_UNORM_SRGB;
+        case ResourceFormat::BC4Unorm:
+            return DXGI_FORMAT_BC4_UNORM;
+        case ResourceFormat::BC5Unorm:
+            return DXGI_FORMAT_BC5_UNORM;
+        case ResourceFormat::BC7Unorm:
+            return DXGI_FORMAT_BC7_UNORM;
+        case ResourceFormat::BC7UnormSrgb:
+            return DXGI_FORMAT_BC7_UNORM_SRGB;
+        default:
+            should_not_get_here();
+            return DXGI_FORMAT_UNKNOWN;
+        }
+    }
+
+    Texture::SharedPtr createCompressedTextureFromFile(const std::string& filename, ResourceFormat compressedFormat, bool generateMipLevels, BlockCompressor::Quality quality)
+    {
+        std::vector<uint8_t> pixels;
+        uint32_t width;
+        uint32_t height;
+        if(BlockCompressor::isFormatSupported(compressedFormat) == false || loadRgba8Image(filename, kTopDown, pixels, width, height) == false)
+        {
+            return nullptr;
+        }
+        AsyncLoadTask::reportProgress(AsyncLoadTask::ProgressCounter::TexturesDecoded);
+
+        uint32_t mipCount = 1;
+        const std::vector<uint8_t> blocks = generateMipLevels ? BlockCompressor::compressWithMips(pixels.data(), width, height, compressedFormat, quality, mipCount) :
+            BlockCompressor::compress(pixels.data(), width, height, width * 4, compressedFormat, quality);
+
+        Texture::SharedPtr pTex = AsyncLoadTask::runOnMainThread([&]() { return Texture::create2D(width, height, compressedFormat, 1, mipCount, blocks.data()); });
+        pTex->setSourceFilename(stripDataDirectories(filename));
+        return pTex;
+    }
+
+    bool compressTextureToDdsFile(const std::string& filename, const std::string& ddsFilename, ResourceFormat compressedFormat, bool generateMipLevels, BlockCompressor::Quality quality)
+    {
+        // DDS files are always top-down
+        std::vector<uint8_t> pixels;
+        uint32_t width;
+        uint32_t height;
+        if(BlockCompressor::isFormatSupported(compressedFormat) == false || loadRgba8Image(filename, true, pixels, width, height) == false)
+        {
+            return false;
+        }
+
+        uint32_t mipCount = 1;
+        const std::vector<uint8_t> blocks = generateMipLevels ? BlockCompressor::compressWithMips(pixels.data(), width, height, compressedFormat, quality, mipCount) :
+            BlockCompressor::compress(pixels.data(), width, height, width * 4, compressedFormat, quality);
+
+        DdsHeader header = {};
+        header.headerSize = sizeof(DdsHeader);
+        header.flags = DdsHeader::kCapsMask | DdsHeader::kHeightMask | DdsHeader::kWidthMask | DdsHeader::kPixelFormatMask | DdsHeader::kLinearSizeMask | DdsHeader::kMipCountMask;
+        header.height = height;
+        header.width = width;
+        header.linearSize = ((width + 3) / 4) * ((height + 3) / 4) * getFormatBytesPerBlock(compressedFormat);
+        header.mipCount = mipCount;
+        header.pixelFormat.structSize = sizeof(DdsHeader::PixelFormat);
+        header.pixelFormat.flags = DdsHeader::PixelFormat::kFourCCFlag;
+        header.pixelFormat.fourCC = makeFourCC("DX10");
+        header.caps[0] = DdsHeader::kCapsTextureMask | ((mipCount > 1) ? (DdsHeader::kCapsComplexMask | DdsHeader::kCapsMipMapMask) : 0);
+
+        DdsHeaderDX10 dx10Header = {};
+        dx10Header.dxgiFormat = getCompressedDxgiFormat(compressedFormat);
+        dx10Header.resourceDimension = D3D10_RESOURCE_DIMENSION_TEXTURE2D;
+        dx10Header.arraySize = 1;
+
+        BinaryFileStream stream(ddsFilename, BinaryFileStream::Mode::Write);
+        stream << kDdsMagicNumber << header << dx10Header;
+        stream.write(blocks.data(), blocks.size());
+        if(stream.isGood() == false)
+        {
+            logError("Can't write the DDS file " + ddsFilename);
+            return false;
+        }
+        return true;
+    }
 }
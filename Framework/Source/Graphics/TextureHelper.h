@@ -28,6 +28,7 @@
 #pragma once
 #include <string>
 #include "API/Texture.h"
+#include "Graphics/BlockCompressor.h"
 namespace Falcor
 {
     /*!
@@ -42,6 +43,25 @@ namespace Falcor
         \param[in] bindFlags The bind flags to create the texture with
     */
 	Texture::SharedPtr createTextureFromFile(const std::string& filename, bool generateMipLevels, bool loadAsSrgb, Texture::BindFlags bindFlags = Texture::BindFlags::ShaderResource);
+
+    /** create a block-compressed texture from an uncompressed image file, compressing it on the CPU
+        \param[in] filename Filename
+        \param[in] compressedFormat The format to compress to. See BlockCompressor::isFormatSupported().
+        \param[in] generateMipLevels true if the mip-chain should be generated and compressed, otherwise false
+        \param[in] quality The quality of the encoding
+        \return The texture, or nullptr if the file can't be loaded or the format isn't supported
+    */
+    Texture::SharedPtr createCompressedTextureFromFile(const std::string& filename, ResourceFormat compressedFormat, bool generateMipLevels, BlockCompressor::Quality quality = BlockCompressor::Quality::Normal);
+
+    /** Compress an uncompressed image file into a DDS file, which createTextureFromFile() loads with the stored mip-chain
+        \param[in] filename The image file
+        \param[in] ddsFilename The DDS file to write
+        \param[in] compressedFormat The format to compress to. See BlockCompressor::isFormatSupported().
+        \param[in] generateMipLevels true if the mip-chain should be generated and stored, otherwise false
+        \param[in] quality The quality of the encoding
+        \return false if the image can't be loaded, the format isn't supported or the DDS file can't be written
+    */
+    bool compressTextureToDdsFile(const std::string& filename, const std::string& ddsFilename, ResourceFormat compressedFormat, bool generateMipLevels, BlockCompressor::Quality quality = BlockCompressor::Quality::Normal);
     
     /*! @} */
 }
\ No newline at end of file
@@ -26,6 +26,7 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #pragma once
+#include <vector>
 #include "glm/vec3.hpp"
 #include "glm/mat4x4.hpp"
 #include "glm/common.hpp"
@@ -99,4 +100,58 @@ namespace Falcor
             return BoundingBox::fromMinMax( min(bb0.getMinPos(), bb1.getMinPos()), max(bb0.getMaxPos(), bb1.getMaxPos()) );
         }
     };
+
+    /** A list of bounding boxes stored as a structure of arrays, used for batched SIMD tests
+    */
+    struct BoundingBoxArray
+    {
+        std::vector<float> center[3];   ///< X, Y and Z components of the box centers
+        std::vector<float> extent[3];   ///< X, Y and Z components of the box extents
+
+        uint32_t size() const { return (uint32_t)center[0].size(); }
+
+        void clear()
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                center[i].clear();
+                extent[i].clear();
+            }
+        }
+
+        void resize(uint32_t count)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                center[i].resize(count);
+                extent[i].resize(count);
+            }
+        }
+
+        void add(const BoundingBox& box)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                center[i].push_back(box.center[i]);
+                extent[i].push_back(box.extent[i]);
+            }
+        }
+
+        void set(uint32_t index, const BoundingBox& box)
+        {
+            for (uint32_t i = 0; i < 3; i++)
+            {
+                center[i][index] = box.center[i];
+                extent[i][index] = box.extent[i];
+            }
+        }
+
+        BoundingBox get(uint32_t index) const
+        {
+            BoundingBox box;
+            box.center = glm::vec3(center[0][index], center[1][index], center[2][index]);
+            box.extent = glm::vec3(extent[0][index], extent[1][index], extent[2][index]);
+            return box;
+        }
+    };
 }
\ No newline at end of file
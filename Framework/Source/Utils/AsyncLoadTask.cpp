@@ -0,0 +1,170 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "AsyncLoadTask.h"
+#include "Utils/CpuTimer.h"
+#include <cfloat>
+
+namespace Falcor
+{
+    static thread_local AsyncLoadTask* stCurrentTask = nullptr;
+
+    AsyncLoadTask::SharedPtr AsyncLoadTask::create(const LoadFunc& loadFunc)
+    {
+        SharedPtr pTask = SharedPtr(new AsyncLoadTask());
+        pTask->start(loadFunc);
+        return pTask;
+    }
+
+    AsyncLoadTask::~AsyncLoadTask()
+    {
+        stop();
+    }
+
+    void AsyncLoadTask::stop()
+    {
+        cancel();
+        while(mThread.joinable() && update(UINT32_MAX, FLT_MAX) == false);
+    }
+
+    void AsyncLoadTask::start(const LoadFunc& loadFunc)
+    {
+        assert(mThread.joinable() == false);
+        mThread = std::thread(&AsyncLoadTask::threadFunc, this, loadFunc);
+    }
+
+    void AsyncLoadTask::threadFunc(LoadFunc loadFunc)
+    {
+        stCurrentTask = this;
+        bool result = loadFunc();
+        stCurrentTask = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mFinished = true;
+            mStatus = mCancelled ? Status::Cancelled : (result ? Status::Succeeded : Status::Failed);
+        }
+        mRequestAvailable.notify_all();
+    }
+
+    void AsyncLoadTask::postRequest(const std::function<void()>& request)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mRequests.push_back(request);
+        }
+        mRequestAvailable.notify_all();
+    }
+
+    bool AsyncLoadTask::update(uint32_t maxRequests, float timeBudget)
+    {
+        const auto start = CpuTimer::getCurrentTimePoint();
+        uint32_t executed = 0;
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        while(executed < maxRequests)
+        {
+            const float remaining = timeBudget - CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            if(remaining <= 0)
+            {
+                break;
+            }
+
+            if(mRequests.empty())
+            {
+                if(mFinished)
+                {
+                    break;
+                }
+                // Give the loading thread the rest of the budget to post its next request. FLT_MAX doesn't fit in a duration, so an unbounded budget waits without a timeout.
+                auto ready = [this] { return mFinished || mRequests.empty() == false; };
+                if(timeBudget == FLT_MAX)
+                {
+                    mRequestAvailable.wait(lock, ready);
+                }
+                else
+                {
+                    mRequestAvailable.wait_for(lock, std::chrono::duration<float, std::milli>(remaining), ready);
+                }
+                continue;
+            }
+
+            std::function<void()> request = std::move(mRequests.front());
+            mRequests.pop_front();
+            lock.unlock();
+            request();
+            executed++;
+            lock.lock();
+        }
+
+        const bool finished = mFinished && mRequests.empty();
+        lock.unlock();
+
+        if(finished && mThread.joinable())
+        {
+            mThread.join();
+        }
+        return finished;
+    }
+
+    AsyncLoadTask::Status AsyncLoadTask::getStatus() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mStatus;
+    }
+
+    AsyncLoadTask::Progress AsyncLoadTask::getProgress() const
+    {
+        Progress progress;
+        progress.bytesRead = mCounters[(uint32_t)ProgressCounter::BytesRead];
+        progress.totalBytes = mCounters[(uint32_t)ProgressCounter::TotalBytes];
+        progress.meshesCreated = (uint32_t)mCounters[(uint32_t)ProgressCounter::MeshesCreated];
+        progress.texturesDecoded = (uint32_t)mCounters[(uint32_t)ProgressCounter::TexturesDecoded];
+        return progress;
+    }
+
+    AsyncLoadTask* AsyncLoadTask::getCurrent()
+    {
+        return stCurrentTask;
+    }
+
+    void AsyncLoadTask::reportProgress(ProgressCounter counter, uint64_t amount)
+    {
+        AsyncLoadTask* pTask = getCurrent();
+        if(pTask)
+        {
+            pTask->addProgress(counter, amount);
+        }
+    }
+
+    bool AsyncLoadTask::isCancelled()
+    {
+        AsyncLoadTask* pTask = getCurrent();
+        return pTask ? pTask->mCancelled.load() : false;
+    }
+}
@@ -0,0 +1,201 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <memory>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <atomic>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** Runs a loading function on a background thread, while the GPU resources it creates are created on the thread calling update().\n
+        Code running inside the loading function wraps resource creation with runOnMainThread(), reports its progress with reportProgress() and stops early when isCancelled() returns true.
+        Outside of an asynchronous load these functions run the work directly and report nothing, so the same loaders serve both the blocking and the asynchronous paths.
+    */
+    class AsyncLoadTask
+    {
+    public:
+        using SharedPtr = std::shared_ptr<AsyncLoadTask>;
+        using LoadFunc = std::function<bool(void)>;
+
+        enum class Status
+        {
+            Loading,        ///< The loading function is still running
+            Succeeded,      ///< The loading function returned true
+            Failed,         ///< The loading function returned false
+            Cancelled,      ///< cancel() was called before the loading function returned
+        };
+
+        enum class ProgressCounter
+        {
+            BytesRead,          ///< Bytes of source files parsed so far
+            TotalBytes,         ///< Bytes of source files the loaders opened so far. Nested loads add their files as they open them, so this can grow while loading.
+            MeshesCreated,      ///< Meshes created
+            TexturesDecoded,    ///< Textures whose pixel data is ready for upload
+            Count
+        };
+
+        struct Progress
+        {
+            uint64_t bytesRead = 0;
+            uint64_t totalBytes = 0;
+            uint32_t meshesCreated = 0;
+            uint32_t texturesDecoded = 0;
+        };
+
+        /** Start a load
+            \param[in] loadFunc The function to run on the background thread
+        */
+        static SharedPtr create(const LoadFunc& loadFunc);
+
+        /** Cancels the load and waits for the loading function to return. Call it from the thread which calls update(), since the loading function may be blocked on a resource creation request.
+        */
+        virtual ~AsyncLoadTask();
+
+        /** Execute resource creation requests. Call this once per frame from the main thread.\n
+            Requests run until either limit is reached or the load is finished. While the limits aren't reached, the call waits for the loading thread to post its next request, so that parsing and resource creation interleave within the frame.
+            \param[in] maxRequests Maximum number of requests to execute
+            \param[in] timeBudget Maximum time to spend, in milliseconds
+            \return true if the load is finished. Check getStatus() for the result.
+        */
+        bool update(uint32_t maxRequests = 256, float timeBudget = 4.0f);
+
+        /** Request the load to stop. The loading function returns at its next cancellation check, and update() needs to be called until it returns true.
+        */
+        void cancel() { mCancelled = true; }
+
+        /** Get the status of the load
+        */
+        Status getStatus() const;
+
+        /** Get a snapshot of the progress counters. Can be called from any thread.
+        */
+        Progress getProgress() const;
+
+        /** Add to one of the progress counters. Thread-safe, so helper threads spawned by a loader can report through a pointer obtained from getCurrent().
+        */
+        void addProgress(ProgressCounter counter, uint64_t amount) { mCounters[(uint32_t)counter] += amount; }
+
+        /** Get the load running on the calling thread, or nullptr if the thread isn't an async loading thread
+        */
+        static AsyncLoadTask* getCurrent();
+
+        /** Add to a progress counter of the load running on the calling thread, if there is one
+        */
+        static void reportProgress(ProgressCounter counter, uint64_t amount = 1);
+
+        /** Check if the load running on the calling thread was cancelled. Always false outside of an async load.
+        */
+        static bool isCancelled();
+
+        /** Run a function on the main thread and return its result.\n
+            On an async loading thread this posts the function to the task's queue and blocks until update() executes it. On any other thread the function is called directly.
+        */
+        template<typename Func>
+        static auto runOnMainThread(Func func) -> decltype(func())
+        {
+            AsyncLoadTask* pTask = getCurrent();
+            if(pTask == nullptr)
+            {
+                return func();
+            }
+
+            // The request owns the task, so the main thread can finish running it after this thread wakes up
+            auto pRequest = std::make_shared<std::packaged_task<decltype(func())()>>(std::move(func));
+            auto result = pRequest->get_future();
+            pTask->postRequest([pRequest]() { (*pRequest)(); });
+            return result.get();
+        }
+
+    protected:
+        AsyncLoadTask() = default;
+
+        /** Spawn the loading thread. Derived classes call this once their members are initialized.
+        */
+        void start(const LoadFunc& loadFunc);
+
+        /** Cancel the load and execute requests until the loading thread exits. Derived classes whose members are written by the loading function call this from their destructor.
+        */
+        void stop();
+
+    private:
+        AsyncLoadTask(const AsyncLoadTask&) = delete;
+        AsyncLoadTask& operator=(const AsyncLoadTask&) = delete;
+
+        void postRequest(const std::function<void()>& request);
+        void threadFunc(LoadFunc loadFunc);
+
+        // The loads block while waiting for the main thread, so they get a thread of their own rather than a ThreadPool worker
+        std::thread mThread;
+        std::deque<std::function<void()>> mRequests;
+        mutable std::mutex mMutex;
+        std::condition_variable mRequestAvailable;
+        bool mFinished = false;
+        Status mStatus = Status::Loading;
+        std::atomic<bool> mCancelled{ false };
+        std::atomic<uint64_t> mCounters[(uint32_t)ProgressCounter::Count] = {};
+    };
+
+    /** An asynchronous load creating an object of type T. T needs a SharedPtr type.
+    */
+    template<typename T>
+    class AsyncObjectLoad : public AsyncLoadTask
+    {
+    public:
+        using SharedPtr = std::shared_ptr<AsyncObjectLoad>;
+        using ObjectPtr = typename T::SharedPtr;
+        using CreateFunc = std::function<ObjectPtr(void)>;
+
+        /** Start a load
+            \param[in] createFunc The function creating the object on the background thread. Returns nullptr on failure.
+        */
+        static SharedPtr create(const CreateFunc& createFunc)
+        {
+            SharedPtr pLoad = SharedPtr(new AsyncObjectLoad());
+            AsyncObjectLoad* pThis = pLoad.get();
+            pLoad->start([pThis, createFunc]() { pThis->mpObject = createFunc(); return pThis->mpObject != nullptr; });
+            return pLoad;
+        }
+
+        /** Get the loaded object. Returns nullptr until the load succeeded.
+        */
+        ObjectPtr getObject() const { return (getStatus() == Status::Succeeded) ? mpObject : nullptr; }
+
+        ~AsyncObjectLoad() { stop(); }
+
+    private:
+        AsyncObjectLoad() = default;
+        ObjectPtr mpObject;
+    };
+}
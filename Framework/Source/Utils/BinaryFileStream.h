@@ -59,6 +59,7 @@ namespace Falcor
             iosMode |= ((mode == Mode::Write) || (mode == Mode::ReadWrite))? std::ios::out : 0;
             mStream.open(filename.c_str(), iosMode);
             mFilename = filename;
+            mMode = mode;
         }
 
         void close()
@@ -71,6 +72,39 @@ namespace Falcor
             mStream.ignore(count);
         }
 
+        /** Get the offset of the current read/write position from the start of the file
+        */
+        size_t getPosition()
+        {
+            return (size_t)((mMode == Mode::Write) ? mStream.tellp() : mStream.tellg());
+        }
+
+        /** Move the current read/write position
+            \param[in] offset Offset from the start of the file
+        */
+        void setPosition(size_t offset)
+        {
+            if(mMode == Mode::Write)
+            {
+                mStream.seekp(offset);
+            }
+            else
+            {
+                mStream.seekg(offset);
+            }
+        }
+
+        /** Get the size of the file being read
+        */
+        size_t getStreamSize()
+        {
+            std::streamoff currentPos = mStream.tellg();
+            mStream.seekg(0, mStream.end);
+            std::streamoff length = mStream.tellg();
+            mStream.seekg(currentPos);
+            return (size_t)length;
+        }
+
         void remove()
         {
             if(mStream.is_open())
@@ -107,5 +141,6 @@ namespace Falcor
     private:
         std::fstream mStream;
         std::string mFilename;
+        Mode mMode = Mode::ReadWrite;
     };
 }
\ No newline at end of file
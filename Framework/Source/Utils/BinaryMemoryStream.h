@@ -0,0 +1,109 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string.h>
+#include <stdint.h>
+#include <algorithm>
+
+namespace Falcor
+{
+    /** Reads binary data from memory, with the same read interface as BinaryFileStream.\n
+        Used to parse memory-mapped files. The stream doesn't own the memory. readView() returns pointers into it instead of copying the data out.\n
+        Reading past the end of the data puts the stream into a failed state. Failed reads zero the destination.
+    */
+    class BinaryMemoryStream
+    {
+    public:
+        BinaryMemoryStream(const void* pData, size_t size) : mpData((const uint8_t*)pData), mSize(size) {}
+
+        /** Get a pointer to the next count bytes and advance the stream past them
+            \return A pointer into the stream's memory, or nullptr if there are less than count bytes left
+        */
+        const uint8_t* readView(size_t count)
+        {
+            if(count > mSize - mOffset)
+            {
+                mOffset = mSize;
+                mFailed = true;
+                return nullptr;
+            }
+            const uint8_t* pView = mpData + mOffset;
+            mOffset += count;
+            return pView;
+        }
+
+        BinaryMemoryStream& read(void* pData, size_t count)
+        {
+            const uint8_t* pView = readView(count);
+            if(pView)
+            {
+                memcpy(pData, pView, count);
+            }
+            else
+            {
+                memset(pData, 0, count);
+            }
+            return *this;
+        }
+
+        void skip(uint32_t count)
+        {
+            readView(count);
+        }
+
+        /** Get the offset of the current read position from the start of the data
+        */
+        size_t getPosition() const { return mOffset; }
+
+        /** Move the current read position. Moving past the end of the data puts the stream into a failed state.
+            \param[in] offset Offset from the start of the data
+        */
+        void setPosition(size_t offset)
+        {
+            mFailed |= (offset > mSize);
+            mOffset = std::min(offset, mSize);
+        }
+
+        size_t getStreamSize() const { return mSize; }
+        uint32_t getRemainingStreamSize() const { return (uint32_t)(mSize - mOffset); }
+
+        bool isGood() const { return !mFailed; }
+        bool isFail() const { return mFailed; }
+        bool isEof() const { return mOffset == mSize; }
+
+        // Operator overloads
+        template<typename T>
+        BinaryMemoryStream& operator>>(T& val) { return read(&val, sizeof(T)); }
+
+    private:
+        const uint8_t* mpData;
+        size_t mSize;
+        size_t mOffset = 0;
+        bool mFailed = false;
+    };
+}
@@ -0,0 +1,64 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+namespace Falcor
+{
+    /** The initial value of hashBytes(). It's the 64-bit FNV offset basis.
+    */
+    static const uint64_t kHashBytesSeed = 0xcbf29ce484222325ull;
+
+    /** Computes a 64-bit hash of a block of memory, fast enough to keep up with reading files.\n
+        This is not FNV-1a. It uses the FNV prime, but each step takes 8 bytes and folds the high half of the state into the low half, because whole words are mixed in at once. The trailing bytes are hashed one at a time.\n
+        The result is the same between runs, so it can be used in file names. It is not a cryptographic hash.
+        \param[in] pData The data to hash
+        \param[in] size Size of the data in bytes
+        \param[in] hash The hash of the preceding data, to hash several blocks as one. Use kHashBytesSeed for the first block.
+        \return The updated hash
+    */
+    inline uint64_t hashBytes(const void* pData, size_t size, uint64_t hash = kHashBytesSeed)
+    {
+        const uint64_t kPrime = 0x100000001b3ull;
+        const uint8_t* pBytes = (const uint8_t*)pData;
+        size_t i = 0;
+        for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+        {
+            uint64_t word;
+            std::memcpy(&word, pBytes + i, sizeof(word));
+            hash = (hash ^ word) * kPrime;
+            hash ^= hash >> 32;
+        }
+        for(; i < size; i++)
+        {
+            hash = (hash ^ pBytes[i]) * kPrime;
+        }
+        return hash;
+    }
+}
@@ -36,6 +36,7 @@ namespace Falcor
 #else
     bool Logger::sShowErrorBox = false;
 #endif
+    bool Logger::sSuppressAllBoxes = false;
 
     bool Logger::sInit = false;
     FILE* Logger::sLogFile = nullptr;
@@ -130,7 +131,7 @@ namespace Falcor
                 debugBreak();
             }
 
-            if(sShowErrorBox || forceMsgBox)
+            if((sShowErrorBox || forceMsgBox) && sSuppressAllBoxes == false)
             {
                 msgBox(msg);
             }
@@ -65,6 +65,10 @@ namespace Falcor
         */
         static bool isBoxShownOnError() { return sShowErrorBox; }
 
+        /** Never show message boxes, even for messages which force one. Command-line tools use it so that they never wait for user input.
+        */
+        static void suppressAllBoxes(bool suppress) { sSuppressAllBoxes = suppress; }
+
         /** Check if the logger is enabled
         */
         static constexpr bool enabled() { return _LOG_ENABLED != 0; }
@@ -82,6 +86,7 @@ namespace Falcor
 
         Logger() = delete;
         static bool sShowErrorBox;
+        static bool sSuppressAllBoxes;
         static FILE* sLogFile;
         static bool sInit;
         static Level sVerbosity;
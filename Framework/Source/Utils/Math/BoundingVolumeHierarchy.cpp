@@ -0,0 +1,288 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "BoundingVolumeHierarchy.h"
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+namespace Falcor
+{
+    const BoundingBox BoundingVolumeHierarchy::kEmptyBox = BoundingBox::fromMinMax(glm::vec3(0.0f), glm::vec3(0.0f));
+
+    static const uint32_t kSahBinCount = 16;
+
+    static float surfaceArea(const glm::vec3& minPos, const glm::vec3& maxPos)
+    {
+        const glm::vec3 size = maxPos - minPos;
+        return 2.0f * (size.x * size.y + size.y * size.z + size.z * size.x);
+    }
+
+    BoundingVolumeHierarchy::SharedPtr BoundingVolumeHierarchy::create(const std::vector<BoundingBox>& primBoxes, uint32_t maxPrimsPerLeaf)
+    {
+        SharedPtr pBvh = SharedPtr(new BoundingVolumeHierarchy());
+        pBvh->build(primBoxes, std::max(maxPrimsPerLeaf, 1u));
+        return pBvh;
+    }
+
+    void BoundingVolumeHierarchy::build(const std::vector<BoundingBox>& primBoxes, uint32_t maxPrimsPerLeaf)
+    {
+        const uint32_t primCount = (uint32_t)primBoxes.size();
+
+        mPrimBoxes = primBoxes;
+        mPrimIndices.resize(primCount);
+        std::iota(mPrimIndices.begin(), mPrimIndices.end(), 0);
+        mNodes.clear();
+        mDirtyNodes.clear();
+
+        if (primCount == 0)
+        {
+            mPrimSlots.clear();
+            mPrimLeaves.clear();
+            mNodeDirty.clear();
+            return;
+        }
+
+        std::vector<glm::vec3> centroids(primCount);
+        for (uint32_t i = 0; i < primCount; i++)
+        {
+            centroids[i] = primBoxes[i].center;
+        }
+
+        // A binary tree with N leaves has 2N-1 nodes. Reserving up-front keeps node references valid during the build.
+        mNodes.reserve(2 * primCount - 1);
+        mNodes.emplace_back();
+        mNodes[0].firstPrim = 0;
+        mNodes[0].primCount = primCount;
+        subdivide(0, centroids, maxPrimsPerLeaf, 0);
+
+        // Store the primitive boxes in leaf order
+        mPrimSlots.resize(primCount);
+        for (uint32_t i = 0; i < primCount; i++)
+        {
+            mPrimSlots[mPrimIndices[i]] = i;
+            mPrimBoxes[i] = primBoxes[mPrimIndices[i]];
+        }
+
+        // Remember the leaf of every primitive, so refit() can walk up from the updated primitives
+        mPrimLeaves.resize(primCount);
+        for (uint32_t nodeID = 0; nodeID < (uint32_t)mNodes.size(); nodeID++)
+        {
+            const Node& node = mNodes[nodeID];
+            if (node.isLeaf())
+            {
+                std::fill(mPrimLeaves.begin() + node.firstPrim, mPrimLeaves.begin() + node.firstPrim + node.primCount, nodeID);
+            }
+        }
+        mNodeDirty.assign(mNodes.size(), 0);
+    }
+
+    void BoundingVolumeHierarchy::subdivide(uint32_t nodeID, const std::vector<glm::vec3>& centroids, uint32_t maxPrimsPerLeaf, uint32_t depth)
+    {
+        Node& node = mNodes[nodeID];
+        const uint32_t primEnd = node.firstPrim + node.primCount;
+
+        // Calculate the node bounds and the bounds of the primitive centroids
+        glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+        glm::vec3 centroidMin(FLT_MAX), centroidMax(-FLT_MAX);
+        for (uint32_t i = node.firstPrim; i < primEnd; i++)
+        {
+            const uint32_t primID = mPrimIndices[i];
+            boxMin = glm::min(boxMin, mPrimBoxes[primID].getMinPos());
+            boxMax = glm::max(boxMax, mPrimBoxes[primID].getMaxPos());
+            centroidMin = glm::min(centroidMin, centroids[primID]);
+            centroidMax = glm::max(centroidMax, centroids[primID]);
+        }
+        node.box = BoundingBox::fromMinMax(boxMin, boxMax);
+
+        if (node.primCount <= maxPrimsPerLeaf || depth >= kMaxDepth)
+        {
+            return;
+        }
+
+        // Find the split plane with the lowest surface area heuristic cost, using binned centroids
+        const glm::vec3 centroidExtent = centroidMax - centroidMin;
+        uint32_t bestAxis = 0;
+        uint32_t bestSplit = 0;
+        float bestCost = FLT_MAX;
+
+        auto getBin = [&](const glm::vec3& centroid, uint32_t axis)
+        {
+            const float binScale = float(kSahBinCount) / centroidExtent[axis];
+            return std::min(uint32_t((centroid[axis] - centroidMin[axis]) * binScale), kSahBinCount - 1);
+        };
+
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            if (centroidExtent[axis] <= 0)
+            {
+                continue;
+            }
+
+            struct Bin
+            {
+                glm::vec3 boxMin = glm::vec3(FLT_MAX);
+                glm::vec3 boxMax = glm::vec3(-FLT_MAX);
+                uint32_t count = 0;
+            } bins[kSahBinCount];
+
+            for (uint32_t i = node.firstPrim; i < primEnd; i++)
+            {
+                const uint32_t primID = mPrimIndices[i];
+                Bin& bin = bins[getBin(centroids[primID], axis)];
+                bin.boxMin = glm::min(bin.boxMin, mPrimBoxes[primID].getMinPos());
+                bin.boxMax = glm::max(bin.boxMax, mPrimBoxes[primID].getMaxPos());
+                bin.count++;
+            }
+
+            // Sweep from the right to get the cost of everything right of each split plane
+            float rightCost[kSahBinCount];
+            glm::vec3 rightMin(FLT_MAX), rightMax(-FLT_MAX);
+            uint32_t rightCount = 0;
+            for (uint32_t split = kSahBinCount - 1; split > 0; split--)
+            {
+                rightMin = glm::min(rightMin, bins[split].boxMin);
+                rightMax = glm::max(rightMax, bins[split].boxMax);
+                rightCount += bins[split].count;
+                rightCost[split] = (rightCount > 0) ? surfaceArea(rightMin, rightMax) * rightCount : 0.0f;
+            }
+
+            // Sweep from the left and combine
+            glm::vec3 leftMin(FLT_MAX), leftMax(-FLT_MAX);
+            uint32_t leftCount = 0;
+            for (uint32_t split = 1; split < kSahBinCount; split++)
+            {
+                leftMin = glm::min(leftMin, bins[split - 1].boxMin);
+                leftMax = glm::max(leftMax, bins[split - 1].boxMax);
+                leftCount += bins[split - 1].count;
+
+                if (leftCount == 0 || leftCount == node.primCount)
+                {
+                    continue;
+                }
+
+                const float cost = surfaceArea(leftMin, leftMax) * leftCount + rightCost[split];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        uint32_t primMid;
+        if (bestCost == FLT_MAX)
+        {
+            // All the centroids are at the same position. Split the range in the middle.
+            primMid = node.firstPrim + node.primCount / 2;
+        }
+        else
+        {
+            auto primBegin = mPrimIndices.begin() + node.firstPrim;
+            auto primSplit = std::partition(primBegin, primBegin + node.primCount, [&](uint32_t primID) { return getBin(centroids[primID], bestAxis) < bestSplit; });
+            primMid = (uint32_t)(primSplit - mPrimIndices.begin());
+        }
+
+        const uint32_t leftChild = (uint32_t)mNodes.size();
+        mNodes.resize(mNodes.size() + 2);
+
+        Node& left = mNodes[leftChild];
+        left.parent = nodeID;
+        left.firstPrim = node.firstPrim;
+        left.primCount = primMid - node.firstPrim;
+
+        Node& right = mNodes[leftChild + 1];
+        right.parent = nodeID;
+        right.firstPrim = primMid;
+        right.primCount = primEnd - primMid;
+
+        node.leftChild = leftChild;
+
+        subdivide(leftChild, centroids, maxPrimsPerLeaf, depth + 1);
+        subdivide(leftChild + 1, centroids, maxPrimsPerLeaf, depth + 1);
+    }
+
+    void BoundingVolumeHierarchy::setPrimitiveBounds(uint32_t primID, const BoundingBox& box)
+    {
+        const uint32_t slot = mPrimSlots[primID];
+        mPrimBoxes[slot] = box;
+
+        // Mark the path to the root. Stop at the first node which is already marked, its ancestors are too.
+        for (uint32_t nodeID = mPrimLeaves[slot]; nodeID != kInvalidIndex && mNodeDirty[nodeID] == 0; nodeID = mNodes[nodeID].parent)
+        {
+            mNodeDirty[nodeID] = 1;
+            mDirtyNodes.push_back(nodeID);
+        }
+    }
+
+    void BoundingVolumeHierarchy::refitNode(Node& node)
+    {
+        if (node.isLeaf())
+        {
+            glm::vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+            for (uint32_t i = node.firstPrim; i < node.firstPrim + node.primCount; i++)
+            {
+                boxMin = glm::min(boxMin, mPrimBoxes[i].getMinPos());
+                boxMax = glm::max(boxMax, mPrimBoxes[i].getMaxPos());
+            }
+            node.box = BoundingBox::fromMinMax(boxMin, boxMax);
+        }
+        else
+        {
+            node.box = BoundingBox::fromUnion(mNodes[node.leftChild].box, mNodes[node.leftChild + 1].box);
+        }
+    }
+
+    void BoundingVolumeHierarchy::refit()
+    {
+        if (mDirtyNodes.size() * 4 > mNodes.size())
+        {
+            // Most of the tree changed. Children are always stored after their parent, so a reverse sweep updates the nodes bottom-up.
+            for (int32_t nodeID = (int32_t)mNodes.size() - 1; nodeID >= 0; nodeID--)
+            {
+                refitNode(mNodes[nodeID]);
+            }
+        }
+        else
+        {
+            // Only update the ancestors of the updated primitives, children first
+            std::sort(mDirtyNodes.begin(), mDirtyNodes.end(), std::greater<uint32_t>());
+            for (uint32_t nodeID : mDirtyNodes)
+            {
+                refitNode(mNodes[nodeID]);
+            }
+        }
+
+        for (uint32_t nodeID : mDirtyNodes)
+        {
+            mNodeDirty[nodeID] = 0;
+        }
+        mDirtyNodes.clear();
+    }
+}
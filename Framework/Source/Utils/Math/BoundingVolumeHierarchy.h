@@ -0,0 +1,168 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <memory>
+#include "Utils/AABB.h"
+
+namespace Falcor
+{
+    /** Bounding volume hierarchy over a set of axis-aligned bounding boxes.\n
+        Nodes are stored in a flat array. The two children of an inner node are stored next to each other and always after their parent, and the primitives of every subtree occupy a contiguous range of the primitive list.
+    */
+    class BoundingVolumeHierarchy
+    {
+    public:
+        using SharedPtr = std::shared_ptr<BoundingVolumeHierarchy>;
+        using SharedConstPtr = std::shared_ptr<const BoundingVolumeHierarchy>;
+
+        static const uint32_t kInvalidIndex = (uint32_t)-1;
+        static const uint32_t kMaxDepth = 64;
+
+        struct Node
+        {
+            BoundingBox box;
+            uint32_t parent = kInvalidIndex;
+            uint32_t leftChild = kInvalidIndex;     ///< The right child is stored at leftChild + 1. kInvalidIndex for leaves.
+            uint32_t firstPrim = 0;                 ///< Offset of the subtree's first primitive in the primitive list
+            uint32_t primCount = 0;                 ///< Number of primitives in the subtree
+
+            bool isLeaf() const { return leftChild == kInvalidIndex; }
+        };
+
+        /** Result of testing a node's bounding box during traversal
+        */
+        enum class Visit
+        {
+            Skip,       ///< Reject the node and its subtree
+            Descend,    ///< Continue testing the node's children
+            AcceptAll,  ///< Accept all the primitives in the subtree without further tests
+        };
+
+        /** Build a new hierarchy
+            \param[in] primBoxes The bounding boxes of the primitives. The primitive ID is the index in this list.
+            \param[in] maxPrimsPerLeaf Maximum number of primitives stored in a leaf
+        */
+        static SharedPtr create(const std::vector<BoundingBox>& primBoxes, uint32_t maxPrimsPerLeaf = 4);
+
+        /** Update the bounding box of a primitive. The node bounds are not updated until refit() is called.\n
+            The primitive's ancestors are recorded, so refit() only has to visit the parts of the tree which changed.
+        */
+        void setPrimitiveBounds(uint32_t primID, const BoundingBox& box);
+
+        /** Get the bounding box of a primitive
+        */
+        const BoundingBox& getPrimitiveBounds(uint32_t primID) const { return mPrimBoxes[mPrimSlots[primID]]; }
+
+        /** Recalculate the bounds of the nodes containing primitives updated since the last call. The topology of the tree is not changed.
+        */
+        void refit();
+
+        /** Get the bounding box of the entire hierarchy
+        */
+        const BoundingBox& getBounds() const { return mNodes.empty() ? kEmptyBox : mNodes[0].box; }
+
+        uint32_t getPrimitiveCount() const { return (uint32_t)mPrimIndices.size(); }
+        uint32_t getNodeCount() const { return (uint32_t)mNodes.size(); }
+        const Node& getNode(uint32_t nodeID) const { return mNodes[nodeID]; }
+
+        /** Get the ID of the primitive stored at a position in the primitive list. Use Node::firstPrim and Node::primCount to enumerate the primitives of a subtree.
+        */
+        uint32_t getPrimitiveID(uint32_t primIndex) const { return mPrimIndices[primIndex]; }
+
+        /** Traverse the hierarchy depth-first.
+            \param[in] nodeTest Functor with the signature Visit(const BoundingBox&). Called for every visited node, and for the primitives of leaves that need to be tested individually.
+            \param[in] primFunc Functor with the signature void(uint32_t primID, bool fullyAccepted). Called for every primitive which wasn't rejected. fullyAccepted is true if the primitive or one of its ancestors returned Visit::AcceptAll.
+        */
+        template<typename NodeTest, typename PrimFunc>
+        void traverse(NodeTest nodeTest, PrimFunc primFunc) const
+        {
+            if (mNodes.empty())
+            {
+                return;
+            }
+
+            uint32_t stack[kMaxDepth + 1];
+            uint32_t stackSize = 0;
+            stack[stackSize++] = 0;
+
+            while (stackSize > 0)
+            {
+                const Node& node = mNodes[stack[--stackSize]];
+                const Visit visit = nodeTest(node.box);
+
+                if (visit == Visit::Skip)
+                {
+                    continue;
+                }
+
+                if (visit == Visit::AcceptAll)
+                {
+                    for (uint32_t i = node.firstPrim; i < node.firstPrim + node.primCount; i++)
+                    {
+                        primFunc(mPrimIndices[i], true);
+                    }
+                }
+                else if (node.isLeaf())
+                {
+                    for (uint32_t i = node.firstPrim; i < node.firstPrim + node.primCount; i++)
+                    {
+                        // A single primitive leaf has the same box as the primitive
+                        const Visit primVisit = (node.primCount == 1) ? visit : nodeTest(mPrimBoxes[i]);
+                        if (primVisit != Visit::Skip)
+                        {
+                            primFunc(mPrimIndices[i], primVisit == Visit::AcceptAll);
+                        }
+                    }
+                }
+                else
+                {
+                    stack[stackSize++] = node.leftChild + 1;
+                    stack[stackSize++] = node.leftChild;
+                }
+            }
+        }
+
+    private:
+        BoundingVolumeHierarchy() = default;
+
+        void build(const std::vector<BoundingBox>& primBoxes, uint32_t maxPrimsPerLeaf);
+        void subdivide(uint32_t nodeID, const std::vector<glm::vec3>& centroids, uint32_t maxPrimsPerLeaf, uint32_t depth);
+        void refitNode(Node& node);
+
+        static const BoundingBox kEmptyBox;
+
+        std::vector<Node> mNodes;
+        std::vector<uint32_t> mPrimIndices;     ///< Primitive IDs, ordered by the leaves
+        std::vector<uint32_t> mPrimSlots;       ///< Position of each primitive ID in mPrimIndices
+        std::vector<BoundingBox> mPrimBoxes;    ///< Primitive bounding boxes, in the same order as mPrimIndices
+        std::vector<uint32_t> mPrimLeaves;      ///< The leaf containing each primitive, in the same order as mPrimIndices
+        std::vector<uint8_t> mNodeDirty;        ///< Set for nodes whose bounds need to be recalculated by refit()
+        std::vector<uint32_t> mDirtyNodes;      ///< The nodes with mNodeDirty set
+    };
+}
@@ -0,0 +1,104 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "RadixSort.h"
+
+namespace Falcor
+{
+    static const uint32_t kDigitBits = 8;
+    static const uint32_t kDigitCount = 1 << kDigitBits;
+    static const uint32_t kPassCount = 64 / kDigitBits;
+
+    void radixSort(std::vector<uint64_t>& keys, std::vector<uint32_t>& values, std::vector<uint64_t>& keyScratch, std::vector<uint32_t>& valueScratch)
+    {
+        assert(keys.size() == values.size());
+        const size_t count = keys.size();
+        if (count < 2)
+        {
+            return;
+        }
+
+        // Build the histograms of all the passes in a single read of the keys. They are small enough to live on the stack, so the sort doesn't allocate.
+        uint32_t histograms[kPassCount * kDigitCount] = {};
+        for (size_t i = 0; i < count; i++)
+        {
+            uint64_t key = keys[i];
+            for (uint32_t pass = 0; pass < kPassCount; pass++)
+            {
+                histograms[pass * kDigitCount + (key & (kDigitCount - 1))]++;
+                key >>= kDigitBits;
+            }
+        }
+
+        keyScratch.resize(count);
+        valueScratch.resize(count);
+
+        uint64_t* pSrcKeys = keys.data();
+        uint32_t* pSrcValues = values.data();
+        uint64_t* pDstKeys = keyScratch.data();
+        uint32_t* pDstValues = valueScratch.data();
+
+        for (uint32_t pass = 0; pass < kPassCount; pass++)
+        {
+            uint32_t* pHistogram = &histograms[pass * kDigitCount];
+            const uint32_t shift = pass * kDigitBits;
+
+            // If all the keys have the same digit, this pass wouldn't change the order
+            if (pHistogram[(pSrcKeys[0] >> shift) & (kDigitCount - 1)] == count)
+            {
+                continue;
+            }
+
+            // Turn the histogram into the first output index of each digit
+            uint32_t offset = 0;
+            for (uint32_t digit = 0; digit < kDigitCount; digit++)
+            {
+                const uint32_t digitCount = pHistogram[digit];
+                pHistogram[digit] = offset;
+                offset += digitCount;
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint32_t dst = pHistogram[(pSrcKeys[i] >> shift) & (kDigitCount - 1)]++;
+                pDstKeys[dst] = pSrcKeys[i];
+                pDstValues[dst] = pSrcValues[i];
+            }
+
+            std::swap(pSrcKeys, pDstKeys);
+            std::swap(pSrcValues, pDstValues);
+        }
+
+        // An odd number of passes leaves the result in the scratch buffers
+        if (pSrcKeys != keys.data())
+        {
+            keys.swap(keyScratch);
+            values.swap(valueScratch);
+        }
+    }
+}
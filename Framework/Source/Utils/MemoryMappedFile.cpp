@@ -0,0 +1,113 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "MemoryMappedFile.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Falcor
+{
+#ifdef _WIN32
+    MemoryMappedFile::UniquePtr MemoryMappedFile::create(const std::string& filename)
+    {
+        HANDLE hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if(hFile == INVALID_HANDLE_VALUE)
+        {
+            return nullptr;
+        }
+
+        LARGE_INTEGER fileSize;
+        if(GetFileSizeEx(hFile, &fileSize) == FALSE || fileSize.QuadPart == 0)
+        {
+            CloseHandle(hFile);
+            return nullptr;
+        }
+
+        // The view keeps the mapping and the file alive, so both handles can be closed right away
+        HANDLE hMapping = CreateFileMappingA(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(hFile);
+        if(hMapping == nullptr)
+        {
+            return nullptr;
+        }
+
+        void* pView = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(hMapping);
+        if(pView == nullptr)
+        {
+            return nullptr;
+        }
+
+        return UniquePtr(new MemoryMappedFile((const uint8_t*)pView, (size_t)fileSize.QuadPart));
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        UnmapViewOfFile(mpData);
+    }
+#else
+    MemoryMappedFile::UniquePtr MemoryMappedFile::create(const std::string& filename)
+    {
+        int fd = open(filename.c_str(), O_RDONLY);
+        if(fd == -1)
+        {
+            return nullptr;
+        }
+
+        struct stat fileStat;
+        if(fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        // The mapping keeps a reference to the file, so the descriptor can be closed right away
+        const size_t size = (size_t)fileStat.st_size;
+        void* pView = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if(pView == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        madvise(pView, size, MADV_SEQUENTIAL);
+
+        return UniquePtr(new MemoryMappedFile((const uint8_t*)pView, size));
+    }
+
+    MemoryMappedFile::~MemoryMappedFile()
+    {
+        munmap((void*)mpData, mSize);
+    }
+#endif
+}
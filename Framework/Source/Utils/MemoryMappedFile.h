@@ -0,0 +1,67 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <string>
+#include <memory>
+#include <stdint.h>
+
+namespace Falcor
+{
+    /** A read-only view of a whole file mapped into the address space.\n
+        Pages are loaded by the OS on first access, so reading a file this way doesn't copy it into an intermediate buffer. The mapping stays valid for the lifetime of the object.
+    */
+    class MemoryMappedFile
+    {
+    public:
+        using UniquePtr = std::unique_ptr<MemoryMappedFile>;
+
+        /** Map a file for reading
+            \param[in] filename The full path of the file
+            \return A new object, or nullptr if the file can't be opened or mapped. Empty files can't be mapped.
+        */
+        static UniquePtr create(const std::string& filename);
+
+        ~MemoryMappedFile();
+
+        /** Get a pointer to the start of the file
+        */
+        const uint8_t* getData() const { return mpData; }
+
+        /** Get the size of the file in bytes
+        */
+        size_t getSize() const { return mSize; }
+
+    private:
+        MemoryMappedFile(const uint8_t* pData, size_t size) : mpData(pData), mSize(size) {}
+        MemoryMappedFile(const MemoryMappedFile&) = delete;
+        MemoryMappedFile& operator=(const MemoryMappedFile&) = delete;
+
+        const uint8_t* mpData;
+        size_t mSize;
+    };
+}
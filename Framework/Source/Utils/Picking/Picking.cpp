@@ -29,6 +29,7 @@
 #include "Framework.h"
 #include "Utils/Picking/Picking.h"
 #include "Graphics/FboHelper.h"
+#include "Utils/Math/FalcorMath.h"
 
 namespace Falcor
 {
@@ -45,6 +46,33 @@ namespace Falcor
         return mPickResult.pModelInstance != nullptr;
     }
 
+    bool Picking::pick(const glm::vec2& mousePos, const Camera::SharedPtr& pCamera)
+    {
+        if (mpRaycaster == nullptr)
+        {
+            mpRaycaster = SceneRaycaster::create(mpScene);
+        }
+
+        const glm::vec3 rayDir = mousePosToWorldRay(mousePos, pCamera->getViewMatrix(), pCamera->getProjMatrix());
+
+        SceneRaycaster::Hit hit;
+        if (mpRaycaster->raycast(pCamera->getPosition(), rayDir, hit))
+        {
+            const auto& pModelInstance = mpScene->getModelInstance(hit.modelID, hit.modelInstanceID);
+            mPickResult = Instance(pModelInstance, pModelInstance->getObject()->getMeshInstance(hit.meshID, hit.meshInstanceID));
+            mPickDistance = hit.distance;
+            mPickBarycentrics = hit.barycentrics;
+        }
+        else
+        {
+            mPickResult = Instance();
+            mPickDistance = 0.0f;
+            mPickBarycentrics = glm::vec2(0.0f);
+        }
+
+        return mPickResult.pModelInstance != nullptr;
+    }
+
     ObjectInstance<Mesh>::SharedPtr Picking::getPickedMeshInstance() const
     {
         return mPickResult.pMeshInstance;
@@ -71,6 +99,8 @@ namespace Falcor
     Picking::Picking(const Scene::SharedPtr& pScene, uint32_t fboWidth, uint32_t fboHeight)
         : SceneRenderer(pScene)
     {
+        // Gizmos change the render state per model instance
+        mBatchModelInstances = false;
         mpGraphicsState = GraphicsState::create();
 
         // Create FBO
@@ -181,9 +211,7 @@ namespace Falcor
 
     bool Picking::setPerMeshInstanceData(const CurrentWorkingData& currentData, const Scene::ModelInstance* pModelInstance, const Model::MeshInstance* pMeshInstance, uint32_t drawInstanceID)
     {
-        ConstantBuffer* pCB = currentData.pContext->getGraphicsVars()->getConstantBuffer(kPerMeshCbName).get();
-        pCB->setBlob(&currentData.drawID, sDrawIDOffset + drawInstanceID * sizeof(uint32_t), sizeof(uint32_t));
-
+        // The draw ID is written to the per-instance data by the scene renderer
         mDrawIDToInstance[currentData.drawID] = Instance(const_cast<Scene::ModelInstance*>(pModelInstance)->shared_from_this(), const_cast<Model::MeshInstance*>(pMeshInstance)->shared_from_this());
 
         return SceneRenderer::setPerMeshInstanceData(currentData, pModelInstance, pMeshInstance, drawInstanceID);
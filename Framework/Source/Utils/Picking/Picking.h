@@ -28,6 +28,7 @@
 #pragma once
 
 #include "Graphics/Scene/SceneRenderer.h"
+#include "Graphics/Scene/SceneRaycaster.h"
 #include "Graphics/Model/ObjectInstance.h"
 #include "Graphics/Scene/Editor/Gizmo.h"
 #include <unordered_set>
@@ -56,6 +57,14 @@ namespace Falcor
         */
         bool pick(RenderContext* pContext, const glm::vec2& mousePos, const Camera::SharedPtr& pCamera);
 
+        /** Performs a picking operation on the CPU by casting a ray from the camera through the scene's triangles, and stores the result.\n
+            Nothing is rendered and there is no GPU round trip. Only meshes with CPU geometry can be picked, see Model::LoadFlags::KeepCpuGeometry.
+            \param[in] mousePos Mouse position in the range [0,1] with (0,0) being the top left corner. Same coordinate space as in MouseEvent.
+            \param[in] pCamera Active camera to pick from.
+            \return Whether an object was picked or not.
+        */
+        bool pick(const glm::vec2& mousePos, const Camera::SharedPtr& pCamera);
+
         /** Gets the picked mesh instance.
             \return Pointer to the picked mesh instance, otherwise nullptr if nothing was picked.
         */
@@ -66,6 +75,14 @@ namespace Falcor
         */
         Scene::ModelInstance::SharedPtr getPickedModelInstance() const;
 
+        /** Gets the distance from the camera to the picked point. Only set by the CPU pick(), which resets it to 0 on a miss.
+        */
+        float getPickedDistance() const { return mPickDistance; }
+
+        /** Gets the barycentric coordinates of the picked point in its triangle, see SceneRaycaster::Hit. Only set by the CPU pick(), which resets it to 0 on a miss.
+        */
+        glm::vec2 getPickedBarycentrics() const { return mPickBarycentrics; }
+
         /** Resize the internal FBO used for picking.
             \param[in] width Width of the FBO.
             \param[in] height Height of the FBO.
@@ -104,6 +121,10 @@ namespace Falcor
 
         std::unordered_map<uint32_t, Instance> mDrawIDToInstance;
         Instance mPickResult;
+        float mPickDistance = 0.0f;
+        glm::vec2 mPickBarycentrics = glm::vec2(0.0f);
+
+        SceneRaycaster::UniquePtr mpRaycaster;
 
         Fbo::SharedPtr mpFBO;
         GraphicsState::SharedPtr mpGraphicsState;
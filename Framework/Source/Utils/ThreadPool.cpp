@@ -0,0 +1,162 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "Framework.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <algorithm>
+
+namespace Falcor
+{
+    namespace
+    {
+        struct ParallelForJob
+        {
+            ThreadPool::RangeFunc func;
+            uint32_t itemCount = 0;
+            uint32_t grainSize = 0;
+            uint32_t chunkCount = 0;
+            std::atomic<uint32_t> nextChunk{ 0 };
+            std::atomic<uint32_t> doneChunks{ 0 };
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            // Process chunks until there are none left
+            void run()
+            {
+                uint32_t chunk;
+                while ((chunk = nextChunk.fetch_add(1)) < chunkCount)
+                {
+                    const uint32_t first = chunk * grainSize;
+                    func(first, std::min(first + grainSize, itemCount));
+
+                    if (doneChunks.fetch_add(1) + 1 == chunkCount)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        finished.notify_all();
+                    }
+                }
+            }
+        };
+    }
+
+    ThreadPool::SharedPtr ThreadPool::create(uint32_t workerCount)
+    {
+        if (workerCount == 0)
+        {
+            workerCount = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+        }
+        return SharedPtr(new ThreadPool(workerCount));
+    }
+
+    ThreadPool* ThreadPool::getGlobalPool()
+    {
+        static SharedPtr spPool = create();
+        return spPool.get();
+    }
+
+    ThreadPool::ThreadPool(uint32_t workerCount)
+    {
+        for (uint32_t i = 0; i < workerCount; i++)
+        {
+            mWorkers.emplace_back(&ThreadPool::workerLoop, this);
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mTerminate = true;
+        }
+        mTaskAvailable.notify_all();
+
+        for (auto& worker : mWorkers)
+        {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mMutex);
+                mTaskAvailable.wait(lock, [this] { return mTerminate || mTasks.empty() == false; });
+                if (mTerminate)
+                {
+                    return;
+                }
+                task = std::move(mTasks.front());
+                mTasks.pop_front();
+            }
+            task();
+        }
+    }
+
+    void ThreadPool::parallelFor(uint32_t itemCount, uint32_t grainSize, const RangeFunc& func)
+    {
+        assert(grainSize > 0);
+        const uint32_t chunkCount = getChunkCount(itemCount, grainSize);
+        if (chunkCount == 0)
+        {
+            return;
+        }
+        if (chunkCount == 1 || mWorkers.empty())
+        {
+            for (uint32_t first = 0; first < itemCount; first += grainSize)
+            {
+                func(first, std::min(first + grainSize, itemCount));
+            }
+            return;
+        }
+
+        // Workers may pick up their task after the calling thread already returned, so the job is reference counted
+        auto pJob = std::make_shared<ParallelForJob>();
+        pJob->func = func;
+        pJob->itemCount = itemCount;
+        pJob->grainSize = grainSize;
+        pJob->chunkCount = chunkCount;
+
+        const uint32_t helperCount = std::min((uint32_t)mWorkers.size(), chunkCount - 1);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (uint32_t i = 0; i < helperCount; i++)
+            {
+                mTasks.push_back([pJob] { pJob->run(); });
+            }
+        }
+        mTaskAvailable.notify_all();
+
+        pJob->run();
+
+        std::unique_lock<std::mutex> lock(pJob->mutex);
+        pJob->finished.wait(lock, [&pJob] { return pJob->doneChunks.load() == pJob->chunkCount; });
+    }
+}
@@ -0,0 +1,88 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#pragma once
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+
+namespace Falcor
+{
+    /** A pool of worker threads for data-parallel CPU work.\n
+        The thread calling parallelFor() participates in the work and returns only after all the work is done, so nested calls from inside a worker can't deadlock.
+    */
+    class ThreadPool
+    {
+    public:
+        using SharedPtr = std::shared_ptr<ThreadPool>;
+
+        /** Function processing the items [first, last)
+        */
+        using RangeFunc = std::function<void(uint32_t first, uint32_t last)>;
+
+        /** Create a new pool
+            \param[in] workerCount Number of worker threads. If this is 0, the pool creates one worker less than the number of hardware threads.
+        */
+        static SharedPtr create(uint32_t workerCount = 0);
+
+        /** Get the pool shared by the framework's systems. Created on first use.
+        */
+        static ThreadPool* getGlobalPool();
+
+        ~ThreadPool();
+
+        /** Get the number of threads processing a parallelFor() call, including the calling thread
+        */
+        uint32_t getThreadCount() const { return (uint32_t)mWorkers.size() + 1; }
+
+        /** Process the items [0, itemCount) in parallel.\n
+            The items are split into chunks of grainSize items, and func is called once per chunk. Chunks run in no particular order, but callers can get a deterministic result by writing each chunk's output into its own slot.
+            \param[in] itemCount Number of items
+            \param[in] grainSize Number of items per chunk. Should be large enough to hide the cost of dispatching a chunk.
+            \param[in] func Function processing a chunk
+        */
+        void parallelFor(uint32_t itemCount, uint32_t grainSize, const RangeFunc& func);
+
+        /** Get the number of chunks parallelFor() splits itemCount items into
+        */
+        static uint32_t getChunkCount(uint32_t itemCount, uint32_t grainSize) { return (itemCount + grainSize - 1) / grainSize; }
+
+    private:
+        ThreadPool(uint32_t workerCount);
+        void workerLoop();
+
+        std::vector<std::thread> mWorkers;
+        std::deque<std::function<void()>> mTasks;
+        std::mutex mMutex;
+        std::condition_variable mTaskAvailable;
+        bool mTerminate = false;
+    };
+}
@@ -26,79 +26,614 @@
 # OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 ***************************************************************************/
 #include "ObjToBin.h"
+#include "Graphics/Model/Loaders/BinaryModelExporter.h"
+#include "Utils/MemoryMappedFile.h"
+#include "Utils/CpuTimer.h"
+#include "Utils/HashUtils.h"
+#include "Externals/RapidJson/include/rapidjson/document.h"
+#include "Externals/RapidJson/include/rapidjson/stringbuffer.h"
+#include "Externals/RapidJson/include/rapidjson/prettywriter.h"
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cctype>
+#include <thread>
 
-ObjToBin::ObjToBin(std::vector<std::string> objFiles)
+static const uint32_t kManifestVersion = 1;
+
+static std::string toLowerCase(std::string str)
+{
+    std::transform(str.begin(), str.end(), str.begin(), [](char c) { return (char)tolower(c); });
+    return str;
+}
+
+static std::string hashToString(uint64_t hash)
+{
+    char str[17];
+    snprintf(str, sizeof(str), "%016llx", (unsigned long long)hash);
+    return str;
+}
+
+// Get the first word of each line starting with one of the keywords. Returns the rest of the line, without the trailing whitespace.
+static void findKeywordLines(const char* pText, size_t size, const std::vector<std::string>& keywords, std::vector<std::string>& values)
+{
+    size_t lineStart = 0;
+    while (lineStart < size)
+    {
+        const char* pEnd = (const char*)memchr(pText + lineStart, '\n', size - lineStart);
+        const size_t lineEnd = pEnd ? pEnd - pText : size;
+        size_t i = lineStart;
+        while (i < lineEnd && (pText[i] == ' ' || pText[i] == '\t'))
+        {
+            i++;
+        }
+        size_t wordEnd = i;
+        while (wordEnd < lineEnd && isspace((unsigned char)pText[wordEnd]) == 0)
+        {
+            wordEnd++;
+        }
+        const std::string word = toLowerCase(std::string(pText + i, wordEnd - i));
+        if (std::find(keywords.begin(), keywords.end(), word) != keywords.end())
+        {
+            size_t valueEnd = lineEnd;
+            while (valueEnd > wordEnd && isspace((unsigned char)pText[valueEnd - 1]))
+            {
+                valueEnd--;
+            }
+            if (valueEnd > wordEnd + 1)
+            {
+                values.push_back(std::string(pText + wordEnd + 1, valueEnd - wordEnd - 1));
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+}
+
+// Get the material libraries an OBJ file references, and the textures they reference
+static std::vector<std::string> findObjDependencies(const MemoryMappedFile* pObjFile, const std::string& directory)
+{
+    std::vector<std::string> libraries;
+    findKeywordLines((const char*)pObjFile->getData(), pObjFile->getSize(), { "mtllib" }, libraries);
+
+    std::vector<std::string> dependencies;
+    for (const std::string& library : libraries)
+    {
+        const std::string libraryPath = directory + '\\' + library;
+        dependencies.push_back(libraryPath);
+
+        // The texture is the last word, after the map options
+        std::string text;
+        std::vector<std::string> maps;
+        if (readFileToString(libraryPath, text))
+        {
+            findKeywordLines(text.data(), text.size(), { "map_ka", "map_kd", "map_ks", "map_ke", "map_ns", "map_d", "map_bump", "bump", "disp", "decal", "refl" }, maps);
+        }
+        for (const std::string& map : maps)
+        {
+            const size_t nameStart = map.find_last_of(" \t");
+            dependencies.push_back(directory + '\\' + (nameStart == std::string::npos ? map : map.substr(nameStart + 1)));
+        }
+    }
+
+    std::sort(dependencies.begin(), dependencies.end());
+    dependencies.erase(std::unique(dependencies.begin(), dependencies.end()), dependencies.end());
+    return dependencies;
+}
+
+// Create a directory and its missing parents
+static bool createDirectories(const std::string& path)
 {
-    mObjFiles = objFiles;
+    if (path.empty() || isDirectoryExists(path))
+    {
+        return true;
+    }
+    const size_t parentEnd = path.find_last_of("\\/");
+    if (parentEnd != std::string::npos && createDirectories(path.substr(0, parentEnd)) == false)
+    {
+        return false;
+    }
+    return createDirectory(path) || isDirectoryExists(path);
 }
 
-void ObjToBin::convertObjToBin(const std::string& objFile)
+static uint64_t getFileSize(const std::string& path)
 {
-    printf("Converting %s ...\n", objFile.c_str());
-    auto pModel = Model::createFromFile(objFile.c_str());
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    return file ? (uint64_t)file.tellg() : 0;
+}
 
-    if (pModel)
+// The formats the -compress option accepts
+static bool parseTextureFormat(const std::string& name, ResourceFormat& format)
+{
+    static const std::pair<const char*, ResourceFormat> kFormats[] =
     {
+        { "bc1", ResourceFormat::BC1Unorm }, { "bc1srgb", ResourceFormat::BC1UnormSrgb }, { "bc3", ResourceFormat::BC3Unorm }, { "bc3srgb", ResourceFormat::BC3UnormSrgb },
+        { "bc4", ResourceFormat::BC4Unorm }, { "bc5", ResourceFormat::BC5Unorm }, { "bc7", ResourceFormat::BC7Unorm }, { "bc7srgb", ResourceFormat::BC7UnormSrgb },
+    };
+    for (const auto& entry : kFormats)
+    {
+        if (name == entry.first)
+        {
+            format = entry.second;
+            return true;
+        }
+    }
+    return false;
+}
 
-        std::string fullpath;
-        if (findFileInDataDirectories(objFile, fullpath) == false)
+static bool parseQuality(const std::string& name, BlockCompressor::Quality& quality)
+{
+    static const std::pair<const char*, BlockCompressor::Quality> kQualities[] =
+    {
+        { "fast", BlockCompressor::Quality::Fast }, { "normal", BlockCompressor::Quality::Normal }, { "high", BlockCompressor::Quality::High },
+    };
+    for (const auto& entry : kQualities)
+    {
+        if (name == entry.first)
         {
-            printf("    Cannot find OBJ file.\n");
+            quality = entry.second;
+            return true;
         }
+    }
+    return false;
+}
 
-        std::string binFilename = Falcor::swapFileExtension(fullpath, ".obj", ".bin");
+static const char* getStatusString(uint32_t status)
+{
+    static const char* kStrings[] = { "up-to-date", "converted", "failed" };
+    return kStrings[status];
+}
 
-        if (!Falcor::doesFileExist(binFilename))
+bool ObjToBin::parseCommandLine(int argc, char* argv[], Options& options)
+{
+    std::vector<std::string> paths;
+    bool valid = true;
+    for (int i = 1; i < argc && valid; i++)
+    {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "-force")
+        {
+            options.force = true;
+        }
+        else if (arg == "-j" && hasValue)
+        {
+            options.maxParallelLoads = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "-flags" && hasValue)
+        {
+            options.loadFlags = (Model::LoadFlags)strtoul(argv[++i], nullptr, 0);
+        }
+        else if (arg == "-ext" && hasValue)
+        {
+            options.extensions = splitString(toLowerCase(argv[++i]), ",");
+        }
+        else if (arg == "-manifest" && hasValue)
         {
-            printf("    Writing %s ...\n", binFilename.c_str());
-            pModel->exportToBinaryFile(binFilename);
+            options.manifestFile = argv[++i];
+        }
+        else if (arg == "-compress" && hasValue)
+        {
+            valid = parseTextureFormat(toLowerCase(argv[++i]), options.textureFormat) && valid;
+        }
+        else if (arg == "-quality" && hasValue)
+        {
+            valid = parseQuality(toLowerCase(argv[++i]), options.textureQuality) && valid;
+        }
+        else if (arg.size() && arg[0] == '-')
+        {
+            valid = false;
         }
         else
         {
-            printf("    BIN file already exists.\n");
+            paths.push_back(arg);
         }
     }
-    else
+
+    valid = valid && (paths.size() == 1 || paths.size() == 2);
+    if (valid == false)
+    {
+        printf("Syntax: ObjToBin [options] <input directory> [output directory]\n");
+        printf("    -j <count>          Number of models to load at the same time. Defaults to the number of hardware threads.\n");
+        printf("    -flags <value>      Model::LoadFlags to convert with, in decimal or 0x hexadecimal\n");
+        printf("    -ext <.a,.b>        Extensions of the source files. Defaults to .obj.\n");
+        printf("    -manifest <file>    Manifest file. Defaults to ObjToBin.json in the output directory.\n");
+        printf("    -force              Convert the models even if they are up to date\n");
+        printf("    -compress <format>  Also compress the textures of the converted OBJ files to DDS files in the output directory.\n");
+        printf("                        The format is one of bc1, bc1srgb, bc3, bc3srgb, bc4, bc5, bc7 or bc7srgb.\n");
+        printf("    -quality <quality>  Texture compression quality: fast, normal or high. Defaults to normal.\n");
+        return false;
+    }
+
+    options.inputDirectory = paths[0];
+    options.outputDirectory = paths.size() == 2 ? paths[1] : paths[0];
+    if (options.manifestFile.empty())
     {
-        printf("   ");
+        options.manifestFile = options.outputDirectory + "\\ObjToBin.json";
     }
+    return true;
 }
 
-void ObjToBin::onLoad()
+ObjToBin::ObjToBin(const Options& options) : mOptions(options)
 {
-    for (const auto& objFile : mObjFiles)
+    if (mOptions.maxParallelLoads == 0)
     {
-        convertObjToBin(objFile);
+        mOptions.maxParallelLoads = std::max(std::thread::hardware_concurrency(), 1u);
     }
-    shutdownApp();
 }
 
-void ObjToBin::onShutdown()
+void ObjToBin::findSources(const std::string& relativeDirectory)
 {
+    const std::string directory = relativeDirectory.empty() ? mOptions.inputDirectory : getInputPath(relativeDirectory);
+    std::vector<std::string> names;
+    enumerateFiles(directory + "\\*", names);
+    std::sort(names.begin(), names.end());
+    for (const std::string& name : names)
+    {
+        if (name == "." || name == "..")
+        {
+            continue;
+        }
 
+        const std::string relativePath = relativeDirectory.empty() ? name : relativeDirectory + '\\' + name;
+        if (isDirectoryExists(getInputPath(relativePath)))
+        {
+            findSources(relativePath);
+            continue;
+        }
+
+        const size_t extensionStart = name.find_last_of('.');
+        const std::string extension = toLowerCase(extensionStart == std::string::npos ? "" : name.substr(extensionStart));
+        if (std::find(mOptions.extensions.begin(), mOptions.extensions.end(), extension) != mOptions.extensions.end())
+        {
+            Asset asset;
+            asset.source = relativePath;
+            asset.output = relativePath.substr(0, relativePath.size() - extension.size()) + ".bin";
+            mAssets.push_back(asset);
+        }
+    }
 }
 
+void ObjToBin::hashSources()
+{
+    // The settings are part of every hash, so changing them rebuilds everything
+    const uint32_t settings[] = { kManifestVersion, BinaryModelExporter::kLatestVersion, (uint32_t)mOptions.loadFlags, (uint32_t)mOptions.textureFormat, (uint32_t)mOptions.textureQuality };
+    const uint64_t seed = hashBytes(settings, sizeof(settings));
 
-int main(int argc, char* argv[])
+    // Models are hashed in parallel. Each writes only its own asset.
+    ThreadPool::getGlobalPool()->parallelFor((uint32_t)mAssets.size(), 1, [this, seed](uint32_t first, uint32_t last)
+    {
+        for (uint32_t i = first; i < last; i++)
+        {
+            Asset& asset = mAssets[i];
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            const std::string path = getInputPath(asset.source);
+            MemoryMappedFile::UniquePtr pFile = MemoryMappedFile::create(path);
+            if (pFile == nullptr)
+            {
+                asset.hash = 0;
+                continue;
+            }
+            asset.hash = hashBytes(pFile->getData(), pFile->getSize(), seed);
+            asset.sourceBytes = pFile->getSize();
+
+            // Missing dependencies hash their name, so that adding them later rebuilds the model
+            if (hasSuffix(asset.source, ".obj", false))
+            {
+                for (const std::string& dependency : findObjDependencies(pFile.get(), getDirectoryFromFile(path)))
+                {
+                    asset.hash = hashBytes(dependency.data(), dependency.size(), asset.hash);
+                    if (hasSuffix(dependency, ".mtl", false) == false)
+                    {
+                        asset.textures.push_back(dependency);
+                    }
+                    MemoryMappedFile::UniquePtr pDependency = MemoryMappedFile::create(dependency);
+                    if (pDependency)
+                    {
+                        asset.hash = hashBytes(pDependency->getData(), pDependency->getSize(), asset.hash);
+                        asset.sourceBytes += pDependency->getSize();
+                    }
+                }
+            }
+            asset.hashTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+        }
+    });
+}
+
+void ObjToBin::readManifest()
+{
+    std::string text;
+    if (readFileToString(mOptions.manifestFile, text) == false)
+    {
+        return;
+    }
+
+    rapidjson::Document doc;
+    doc.Parse(text.c_str());
+    if (doc.HasParseError() || doc.IsObject() == false || doc.HasMember("assets") == false || doc["assets"].IsArray() == false)
+    {
+        printf("Ignoring the invalid manifest %s\n", mOptions.manifestFile.c_str());
+        return;
+    }
+
+    const rapidjson::Value& assets = doc["assets"];
+    for (rapidjson::SizeType i = 0; i < assets.Size(); i++)
+    {
+        const rapidjson::Value& entry = assets[i];
+        if (entry.IsObject() == false || entry.HasMember("source") == false || entry.HasMember("hash") == false || entry.HasMember("status") == false)
+        {
+            continue;
+        }
+
+        // Failed conversions are retried
+        Asset asset;
+        asset.source = entry["source"].GetString();
+        asset.hash = strtoull(entry["hash"].GetString(), nullptr, 16);
+        asset.status = std::string(entry["status"].GetString()) == getStatusString((uint32_t)Status::Failed) ? Status::Failed : Status::Converted;
+        asset.output = entry.HasMember("output") ? entry["output"].GetString() : "";
+        asset.outputBytes = entry.HasMember("outputBytes") ? entry["outputBytes"].GetUint64() : 0;
+        asset.loadTime = entry.HasMember("loadTime") ? (float)entry["loadTime"].GetDouble() : 0;
+        asset.exportTime = entry.HasMember("exportTime") ? (float)entry["exportTime"].GetDouble() : 0;
+        asset.meshCount = entry.HasMember("meshCount") ? entry["meshCount"].GetUint() : 0;
+        asset.vertexCount = entry.HasMember("vertexCount") ? entry["vertexCount"].GetUint() : 0;
+        asset.primitiveCount = entry.HasMember("primitiveCount") ? entry["primitiveCount"].GetUint() : 0;
+        asset.compressedTextureCount = entry.HasMember("compressedTextureCount") ? entry["compressedTextureCount"].GetUint() : 0;
+        mPreviousAssets[asset.source] = asset;
+    }
+}
+
+void ObjToBin::finishConversion(Asset& asset, const Model::SharedPtr& pModel)
+{
+    if (pModel == nullptr)
+    {
+        printf("Failed to load %s\n", asset.source.c_str());
+        return;
+    }
+
+    // The export reads the meshes back from the GPU, so it runs on the main thread
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    const std::string outputPath = getOutputPath(asset.output);
+    if (createDirectories(getDirectoryFromFile(outputPath)) == false)
+    {
+        printf("Can't create the directory of %s\n", outputPath.c_str());
+        return;
+    }
+    pModel->exportToBinaryFile(outputPath);
+    asset.exportTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    asset.outputBytes = getFileSize(outputPath);
+    if (asset.outputBytes == 0)
+    {
+        printf("Failed to export %s\n", asset.source.c_str());
+        return;
+    }
+
+    asset.meshCount = pModel->getMeshCount();
+    asset.vertexCount = pModel->getVertexCount();
+    asset.primitiveCount = pModel->getPrimitiveCount();
+    asset.status = Status::Converted;
+    printf("Converted %s in %.0f ms (%.0f ms export), %llu -> %llu bytes\n", asset.source.c_str(), asset.loadTime + asset.exportTime, asset.exportTime, (unsigned long long)asset.sourceBytes, (unsigned long long)asset.outputBytes);
+
+    if (mOptions.textureFormat != ResourceFormat::Unknown)
+    {
+        compressTextures(asset);
+    }
+}
+
+void ObjToBin::compressTextures(Asset& asset)
+{
+    // The DDS files mirror the textures' place in the input tree. The compressor runs on the thread pool.
+    const std::string inputPrefix = toLowerCase(canonicalizeFilename(mOptions.inputDirectory + '\\'));
+    for (const std::string& texture : asset.textures)
+    {
+        const std::string source = canonicalizeFilename(texture);
+        if (hasSuffix(source, ".dds", false) || doesFileExist(source) == false)
+        {
+            continue;
+        }
+        if (toLowerCase(source.substr(0, inputPrefix.size())) != inputPrefix)
+        {
+            printf("Not compressing %s, which is outside of the input directory\n", source.c_str());
+            continue;
+        }
+
+        const std::string relativePath = source.substr(inputPrefix.size());
+        const size_t extensionStart = relativePath.find_last_of('.');
+        const std::string ddsPath = getOutputPath(relativePath.substr(0, extensionStart) + ".dds");
+        if (mCompressedTextures.insert(toLowerCase(ddsPath)).second == false)
+        {
+            continue;
+        }
+
+        if (createDirectories(getDirectoryFromFile(ddsPath)) && compressTextureToDdsFile(source, ddsPath, mOptions.textureFormat, true, mOptions.textureQuality))
+        {
+            asset.compressedTextureCount++;
+        }
+        else
+        {
+            printf("Failed to compress %s\n", source.c_str());
+        }
+    }
+}
+
+void ObjToBin::convert(const std::vector<Asset*>& staleAssets)
+{
+    // Each load parses on its own thread and posts its GPU resource creation to this one
+    struct Conversion
+    {
+        Asset* pAsset;
+        Model::AsyncLoad::SharedPtr pLoad;
+        CpuTimer::TimePoint start;
+    };
+    std::vector<Conversion> conversions;
+    size_t nextAsset = 0;
+    while (nextAsset < staleAssets.size() || conversions.size())
+    {
+        while (conversions.size() < mOptions.maxParallelLoads && nextAsset < staleAssets.size())
+        {
+            Asset* pAsset = staleAssets[nextAsset++];
+            const std::string path = getInputPath(pAsset->source);
+            conversions.push_back({ pAsset, Model::createFromFileAsync(path.c_str(), mOptions.loadFlags), CpuTimer::getCurrentTimePoint() });
+        }
+
+        // A short budget per load, so that a load which is busy parsing doesn't hold up the others' requests
+        for (size_t i = 0; i < conversions.size();)
+        {
+            Conversion& conversion = conversions[i];
+            if (conversion.pLoad->update(256, 1.0f) == false)
+            {
+                i++;
+                continue;
+            }
+            conversion.pAsset->loadTime = CpuTimer::calcDuration(conversion.start, CpuTimer::getCurrentTimePoint());
+            finishConversion(*conversion.pAsset, conversion.pLoad->getObject());
+            conversions.erase(conversions.begin() + i);
+        }
+    }
+}
+
+bool ObjToBin::writeManifest(float totalTime) const
+{
+    rapidjson::Document doc;
+    doc.SetObject();
+    auto& allocator = doc.GetAllocator();
+    auto addString = [&allocator](rapidjson::Value& object, const char* key, const std::string& value)
+    {
+        object.AddMember(rapidjson::StringRef(key), rapidjson::Value(value.c_str(), (rapidjson::SizeType)value.size(), allocator), allocator);
+    };
+
+    uint64_t totals[3] = {};
+    uint64_t sourceBytes = 0;
+    uint64_t outputBytes = 0;
+    float loadTime = 0;
+    float exportTime = 0;
+    rapidjson::Value assets(rapidjson::kArrayType);
+    for (const Asset& asset : mAssets)
+    {
+        rapidjson::Value entry(rapidjson::kObjectType);
+        addString(entry, "source", asset.source);
+        addString(entry, "output", asset.output);
+        addString(entry, "hash", hashToString(asset.hash));
+        addString(entry, "status", getStatusString((uint32_t)asset.status));
+        entry.AddMember("sourceBytes", asset.sourceBytes, allocator);
+        entry.AddMember("outputBytes", asset.outputBytes, allocator);
+        entry.AddMember("hashTime", (double)asset.hashTime, allocator);
+        entry.AddMember("loadTime", (double)asset.loadTime, allocator);
+        entry.AddMember("exportTime", (double)asset.exportTime, allocator);
+        entry.AddMember("meshCount", asset.meshCount, allocator);
+        entry.AddMember("vertexCount", asset.vertexCount, allocator);
+        entry.AddMember("primitiveCount", asset.primitiveCount, allocator);
+        entry.AddMember("compressedTextureCount", asset.compressedTextureCount, allocator);
+        assets.PushBack(entry, allocator);
+
+        totals[(uint32_t)asset.status]++;
+        sourceBytes += asset.sourceBytes;
+        outputBytes += asset.outputBytes;
+        if (asset.status == Status::Converted)
+        {
+            loadTime += asset.loadTime;
+            exportTime += asset.exportTime;
+        }
+    }
+
+    rapidjson::Value summary(rapidjson::kObjectType);
+    summary.AddMember("upToDate", totals[(uint32_t)Status::UpToDate], allocator);
+    summary.AddMember("converted", totals[(uint32_t)Status::Converted], allocator);
+    summary.AddMember("failed", totals[(uint32_t)Status::Failed], allocator);
+    summary.AddMember("sourceBytes", sourceBytes, allocator);
+    summary.AddMember("outputBytes", outputBytes, allocator);
+    summary.AddMember("loadTime", (double)loadTime, allocator);
+    summary.AddMember("exportTime", (double)exportTime, allocator);
+    summary.AddMember("totalTime", (double)totalTime, allocator);
+
+    doc.AddMember("version", kManifestVersion, allocator);
+    doc.AddMember("loadFlags", (uint32_t)mOptions.loadFlags, allocator);
+    doc.AddMember("binaryVersion", BinaryModelExporter::kLatestVersion, allocator);
+    doc.AddMember("summary", summary, allocator);
+    doc.AddMember("assets", assets, allocator);
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+
+    std::ofstream file(mOptions.manifestFile, std::ios::binary);
+    file.write(buffer.GetString(), buffer.GetSize());
+    return file.good();
+}
+
+uint32_t ObjToBin::run()
 {
-    if (argc >= 2)
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    mpWindow = Window::create(Window::Desc(), &mDummyCallbacks);
+    gpDevice = Device::create(mpWindow, Device::Desc());
+    if (gpDevice == nullptr)
     {
-        std::vector<std::string> objFiles;
+        printf("Can't create the device\n");
+        return 1;
+    }
 
-        for (int argi = 1; argi < argc; ++argi)
+    findSources("");
+    hashSources();
+    readManifest();
+
+    // A model is up to date if the last run converted the same sources with the same settings, and its output is still there
+    std::vector<Asset*> staleAssets;
+    for (Asset& asset : mAssets)
+    {
+        auto previous = mPreviousAssets.find(asset.source);
+        const bool upToDate = asset.hash != 0 && mOptions.force == false && previous != mPreviousAssets.end() && previous->second.status != Status::Failed &&
+            previous->second.hash == asset.hash && previous->second.output == asset.output && doesFileExist(getOutputPath(asset.output));
+        if (upToDate)
         {
-            objFiles.push_back(std::string(argv[argi]));
+            // Keep the statistics of the conversion which produced the output
+            const float hashTime = asset.hashTime;
+            asset = previous->second;
+            asset.hashTime = hashTime;
+            asset.status = Status::UpToDate;
         }
+        else if (asset.hash != 0)
+        {
+            staleAssets.push_back(&asset);
+        }
+        else
+        {
+            printf("Can't read %s\n", asset.source.c_str());
+        }
+    }
+    printf("Found %zu models, %zu to convert, using %u parallel loads\n", mAssets.size(), staleAssets.size(), mOptions.maxParallelLoads);
 
-        ObjToBin ObjToBin(objFiles);
-        SampleConfig config;
-        config.windowDesc.width = 256;
-        config.windowDesc.height = 256;
-        config.windowDesc.title = "ObjToBin";
-        ObjToBin.run(config);
+    convert(staleAssets);
+
+    // Unreadable sources never reach convert() but still count as failures
+    uint32_t convertedCount = 0;
+    uint32_t failureCount = 0;
+    for (const Asset& asset : mAssets)
+    {
+        convertedCount += (asset.status == Status::Converted) ? 1 : 0;
+        failureCount += (asset.status == Status::Failed) ? 1 : 0;
     }
-    else
+    const float totalTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+    if (createDirectories(getDirectoryFromFile(mOptions.manifestFile)) == false || writeManifest(totalTime) == false)
     {
-        printf("Syntax: ObjToBin <list of obj files>\n");
+        printf("Can't write the manifest %s\n", mOptions.manifestFile.c_str());
     }
-}
\ No newline at end of file
+    printf("Converted %u models in %.1f s, %u failed\n", convertedCount, totalTime / 1000.0f, failureCount);
+
+    // Avoid the assert in ~Device(), as the tests do
+    gpDevice->getRenderContext()->getLowLevelData()->getFence()->cpuSignal();
+    return failureCount;
+}
+
+int main(int argc, char* argv[])
+{
+    ObjToBin::Options options;
+    if (ObjToBin::parseCommandLine(argc, argv, options) == false)
+    {
+        return 1;
+    }
+
+    Logger::init();
+    Logger::suppressAllBoxes(true);
+    ObjToBin converter(options);
+    const uint32_t failureCount = converter.run();
+    Logger::shutdown();
+    return failureCount ? 1 : 0;
+}
@@ -27,19 +27,93 @@
 ***************************************************************************/
 #pragma once
 #include "Falcor.h"
+#include <unordered_map>
+#include <unordered_set>
 
 using namespace Falcor;
 
-class ObjToBin : public Sample
+/** Headless batch converter into the binary model format.\n
+    Converts every model under a directory tree, several at a time, and skips the models whose sources didn't change since the last run.
+    A model's sources are its file and, for OBJ files, the material libraries and textures it references. They are hashed together with the conversion settings.
+    Each run writes a JSON manifest with the hash, timings and sizes of every model, which the next run reads back to find the up-to-date outputs.
+*/
+class ObjToBin
 {
-public:    
-    void onLoad() override;
-    void onShutdown() override;
+public:
+    struct Options
+    {
+        std::string inputDirectory;
+        std::string outputDirectory;                        ///< Mirrors the input tree. Defaults to the input directory.
+        std::string manifestFile;                           ///< Defaults to ObjToBin.json in the output directory
+        std::vector<std::string> extensions = { ".obj" };   ///< Source file extensions, lower case
+        Model::LoadFlags loadFlags = Model::LoadFlags::None;
+        uint32_t maxParallelLoads = 0;                      ///< Number of models loaded at the same time. 0 uses the number of hardware threads.
+        bool force = false;                                 ///< Convert the up-to-date models too
+        ResourceFormat textureFormat = ResourceFormat::Unknown; ///< If set, the textures of converted OBJ files are also compressed to DDS files in this format
+        BlockCompressor::Quality textureQuality = BlockCompressor::Quality::Normal;
+    };
+
+    /** Parse the command line
+        \return false if the arguments are invalid, in which case the usage was printed
+    */
+    static bool parseCommandLine(int argc, char* argv[], Options& options);
+
+    ObjToBin(const Options& options);
+
+    /** Convert the models and write the manifest
+        \return The number of models which failed to convert
+    */
+    uint32_t run();
 
-    ObjToBin(std::vector<std::string> objFiles);
-    void convertObjToBin(const std::string& objFile);
 private:
-    inline void shutdown() {}
+    enum class Status
+    {
+        UpToDate,
+        Converted,
+        Failed
+    };
+
+    struct Asset
+    {
+        std::string source;             // Relative to the input directory
+        std::string output;             // Relative to the output directory
+        uint64_t hash = 0;              // Of the sources and the settings
+        uint64_t sourceBytes = 0;       // Including the referenced files
+        uint64_t outputBytes = 0;
+        float hashTime = 0;             // In milliseconds
+        float loadTime = 0;
+        float exportTime = 0;
+        uint32_t meshCount = 0;
+        uint32_t vertexCount = 0;
+        uint32_t primitiveCount = 0;
+        uint32_t compressedTextureCount = 0;
+        std::vector<std::string> textures;      // Full paths of the referenced textures, not saved in the manifest
+        Status status = Status::Failed;
+    };
+
+    void findSources(const std::string& relativeDirectory);
+    void hashSources();
+    void readManifest();
+    void convert(const std::vector<Asset*>& staleAssets);
+    void finishConversion(Asset& asset, const Model::SharedPtr& pModel);
+    void compressTextures(Asset& asset);
+    bool writeManifest(float totalTime) const;
+
+    std::string getInputPath(const std::string& relativePath) const { return mOptions.inputDirectory + '\\' + relativePath; }
+    std::string getOutputPath(const std::string& relativePath) const { return mOptions.outputDirectory + '\\' + relativePath; }
+
+    Options mOptions;
+    std::vector<Asset> mAssets;
+    std::unordered_map<std::string, Asset> mPreviousAssets;    // From the last run's manifest, by source
+    std::unordered_set<std::string> mCompressedTextures;        // Written by this run, so that shared textures are compressed once
 
-    std::vector<std::string> mObjFiles;
-};
\ No newline at end of file
+    // Importing creates GPU resources, so the converter needs a device. The window is never shown.
+    class DummyWindowCallbacks : public Window::ICallbacks
+    {
+        void renderFrame() override {}
+        void handleWindowSizeChange() override {}
+        void handleKeyboardEvent(const KeyboardEvent& keyEvent) override {}
+        void handleMouseEvent(const MouseEvent& mouseEvent) override {}
+    } mDummyCallbacks;
+    Window::SharedPtr mpWindow;
+};
@@ -0,0 +1,138 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "AssimpImportCacheTest.h"
+#include "Graphics/Model/Loaders/AssimpImportCache.h"
+#include <fstream>
+#include <chrono>
+
+static const std::string kModelFilename = "AssimpImportCacheTest.obj";
+static const std::string kCacheDirectory = "AssimpImportCacheTest";
+
+// Written into the test models, so that entries cached by previous runs never match
+static const std::string kRunID = std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
+
+void AssimpImportCacheTest::addTests()
+{
+    addTestToList<TestCacheHit>();
+    addTestToList<TestContentChangeMisses>();
+}
+
+void AssimpImportCacheTest::onInit()
+{
+    AssimpImportCache::setDirectory(getWorkingDirectory() + '\\' + kCacheDirectory);
+}
+
+void AssimpImportCacheTest::writeTestModel(const std::string& filename, uint32_t gridSize)
+{
+    std::ofstream file(filename);
+    file << "# " << kRunID << "\n";
+    for(uint32_t y = 0; y <= gridSize; y++)
+    {
+        for(uint32_t x = 0; x <= gridSize; x++)
+        {
+            file << "v " << x << " 0 " << y << "\nvt " << float(x) / gridSize << " " << float(y) / gridSize << "\nvn 0 1 0\n";
+        }
+    }
+
+    for(uint32_t y = 0; y < gridSize; y++)
+    {
+        for(uint32_t x = 0; x < gridSize; x++)
+        {
+            // OBJ indices are 1-based
+            const uint32_t i = y * (gridSize + 1) + x + 1;
+            const uint32_t j = i + gridSize + 1;
+            file << "f " << i << "/" << i << "/" << i << " " << j << "/" << j << "/" << j << " " << i + 1 << "/" << i + 1 << "/" << i + 1 << "\n";
+            file << "f " << i + 1 << "/" << i + 1 << "/" << i + 1 << " " << j << "/" << j << "/" << j << " " << j + 1 << "/" << j + 1 << "/" << j + 1 << "\n";
+        }
+    }
+}
+
+testing_func(AssimpImportCacheTest, TestCacheHit)
+{
+    writeTestModel(kModelFilename, 64);
+    AssimpImportCache::resetStatistics();
+
+    Model::SharedPtr pImported = Model::createFromFile(kModelFilename.c_str());
+    Model::SharedPtr pCached = Model::createFromFile(kModelFilename.c_str());
+    if(pImported == nullptr || pCached == nullptr)
+    {
+        return test_fail("Failed to load the test model");
+    }
+
+    AssimpImportCache::Statistics stats = AssimpImportCache::getStatistics();
+    if(stats.storeFailureCount != 0)
+    {
+        return test_fail("Failed to write the cached model");
+    }
+    if(stats.hitCount != 1)
+    {
+        return test_fail("Second load didn't hit the cache");
+    }
+
+    if(pImported->getMeshCount() != pCached->getMeshCount() || pImported->getVertexCount() != pCached->getVertexCount() || pImported->getIndexCount() != pCached->getIndexCount())
+    {
+        return test_fail("Cached model doesn't match the imported model");
+    }
+
+    return test_pass();
+}
+
+testing_func(AssimpImportCacheTest, TestContentChangeMisses)
+{
+    writeTestModel(kModelFilename, 64);
+    Model::createFromFile(kModelFilename.c_str());
+    AssimpImportCache::resetStatistics();
+
+    // Same file name, different content
+    writeTestModel(kModelFilename, 32);
+    Model::SharedPtr pModel = Model::createFromFile(kModelFilename.c_str());
+    AssimpImportCache::Statistics stats = AssimpImportCache::getStatistics();
+    if(pModel == nullptr || stats.missCount != 1 || stats.hitCount != 0)
+    {
+        return test_fail("Changed file was loaded from the cache");
+    }
+
+    // Different flags
+    AssimpImportCache::resetStatistics();
+    Model::createFromFile(kModelFilename.c_str(), Model::LoadFlags::DontMergeMeshes);
+    stats = AssimpImportCache::getStatistics();
+    if(stats.missCount != 1 || stats.hitCount != 0)
+    {
+        return test_fail("Load with different flags was loaded from the cache");
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    AssimpImportCacheTest aict;
+    aict.init(true);
+    aict.run();
+    return 0;
+}
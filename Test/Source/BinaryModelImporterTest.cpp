@@ -0,0 +1,203 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BinaryModelImporterTest.h"
+#include "TestHelper.h"
+#include <fstream>
+
+static const std::string kModelFilename = "BinaryModelImporterTest.bin";
+static const std::string kModelV9Filename = "BinaryModelImporterTestV9.bin";
+static const std::string kTruncatedFilename = "BinaryModelImporterTestTruncated.bin";
+static const uint32_t kBenchmarkRepeatCount = 5;
+
+void BinaryModelImporterTest::addTests()
+{
+    addTestToList<TestInputModesMatch>();
+    addTestToList<TestVersion9RoundTrip>();
+    addTestToList<TestVersion9Truncated>();
+    addTestToList<BenchmarkInputModes>();
+    addTestToList<TestAsyncLoad>();
+    addTestToList<TestAsyncLoadCancel>();
+}
+
+void BinaryModelImporterTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+}
+
+BinaryModelImporterTest::~BinaryModelImporterTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+    std::remove(kTruncatedFilename.c_str());
+}
+
+testing_func(BinaryModelImporterTest, TestInputModesMatch)
+{
+    float duration;
+    Model::SharedPtr pMapped = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pStreamed = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::Stream, Model::LoadFlags::KeepCpuGeometry, duration);
+    if(pMapped == nullptr || pStreamed == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    std::string error;
+    if(pMapped->getMeshCount() != 2 || TestHelper::areModelsEqual(pMapped.get(), pStreamed.get(), error) == false)
+    {
+        return test_fail("Memory-mapped and stream imports don't match. " + error);
+    }
+
+    return test_pass();
+}
+
+testing_func(BinaryModelImporterTest, TestVersion9RoundTrip)
+{
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pMapped = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pStreamed = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::Stream, Model::LoadFlags::KeepCpuGeometry, duration);
+    if(pOriginal == nullptr || pMapped == nullptr || pStreamed == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    std::string error;
+    if(TestHelper::areModelsEqual(pOriginal.get(), pMapped.get(), error) == false || TestHelper::areModelsEqual(pOriginal.get(), pStreamed.get(), error) == false)
+    {
+        return test_fail("Version 9 import doesn't match the original. " + error);
+    }
+
+    return test_pass();
+}
+
+testing_func(BinaryModelImporterTest, TestVersion9Truncated)
+{
+    // The directory references blobs past the end of the truncated file. The import must reject it instead of reading or allocating from those ranges.
+    std::ifstream source(kModelV9Filename, std::ios::binary);
+    std::vector<char> data((std::istreambuf_iterator<char>(source)), std::istreambuf_iterator<char>());
+    std::ofstream(kTruncatedFilename, std::ios::binary).write(data.data(), data.size() * 3 / 4);
+
+    float duration;
+    for(BinaryModelImporter::InputMode inputMode : { BinaryModelImporter::InputMode::MemoryMapped, BinaryModelImporter::InputMode::Stream })
+    {
+        if(TestHelper::importBinaryModel(kTruncatedFilename, inputMode, Model::LoadFlags::KeepCpuGeometry, duration) != nullptr)
+        {
+            return test_fail("Truncated version 9 file was imported");
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(BinaryModelImporterTest, BenchmarkInputModes)
+{
+    // Alternate between the modes so all of them see the same file cache state
+    float bestMapped = FLT_MAX;
+    float bestStreamed = FLT_MAX;
+    float bestV9 = FLT_MAX;
+    for(uint32_t i = 0; i < kBenchmarkRepeatCount; i++)
+    {
+        float duration;
+        if(TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::None, duration) == nullptr)
+        {
+            return test_fail("Memory-mapped import failed");
+        }
+        bestMapped = std::min(bestMapped, duration);
+
+        if(TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::Stream, Model::LoadFlags::None, duration) == nullptr)
+        {
+            return test_fail("Stream import failed");
+        }
+        bestStreamed = std::min(bestStreamed, duration);
+
+        if(TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::None, duration) == nullptr)
+        {
+            return test_fail("Version 9 import failed");
+        }
+        bestV9 = std::min(bestV9, duration);
+    }
+
+    logInfo("BinaryModelImporter: memory-mapped " + std::to_string(bestMapped) + "ms, stream " + std::to_string(bestStreamed) + "ms, version 9 memory-mapped " + std::to_string(bestV9) + "ms (best of " + std::to_string(kBenchmarkRepeatCount) + ")");
+    return test_pass();
+}
+
+testing_func(BinaryModelImporterTest, TestAsyncLoad)
+{
+    Model::AsyncLoad::SharedPtr pLoad = Model::createFromFileAsync(kModelFilename.c_str(), Model::LoadFlags::KeepCpuGeometry);
+
+    // Drive the load the way a viewer would, one bounded batch per frame
+    uint32_t frameCount = 1;
+    while(pLoad->update(16, 2.0f) == false)
+    {
+        frameCount++;
+    }
+
+    float duration;
+    Model::SharedPtr pAsync = pLoad->getObject();
+    Model::SharedPtr pSync = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    if(pLoad->getStatus() != AsyncLoadTask::Status::Succeeded || pAsync == nullptr || pSync == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    std::string error;
+    if(TestHelper::areModelsEqual(pSync.get(), pAsync.get(), error) == false)
+    {
+        return test_fail("Async import doesn't match the blocking import. " + error);
+    }
+
+    AsyncLoadTask::Progress progress = pLoad->getProgress();
+    if(progress.meshesCreated != pAsync->getMeshCount() || progress.texturesDecoded != 1 || progress.totalBytes == 0 || progress.bytesRead != progress.totalBytes)
+    {
+        return test_fail("Async import reported wrong progress");
+    }
+
+    logInfo("BinaryModelImporter: async import took " + std::to_string(frameCount) + " frames");
+    return test_pass();
+}
+
+testing_func(BinaryModelImporterTest, TestAsyncLoadCancel)
+{
+    Model::AsyncLoad::SharedPtr pLoad = Model::createFromFileAsync(kModelFilename.c_str());
+    pLoad->cancel();
+    while(pLoad->update() == false);
+
+    if(pLoad->getStatus() != AsyncLoadTask::Status::Cancelled || pLoad->getObject() != nullptr)
+    {
+        return test_fail("Cancelled load didn't stop");
+    }
+    return test_pass();
+}
+
+int main()
+{
+    BinaryModelImporterTest bmit;
+    bmit.init(true);
+    bmit.run();
+    return 0;
+}
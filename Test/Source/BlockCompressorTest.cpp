@@ -0,0 +1,484 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BlockCompressorTest.h"
+#include "Graphics/BlockCompressor.h"
+#include <random>
+
+// The BC7 two-subset partitions and their second anchors, for decoding mode 1 blocks
+static const uint16_t kPartitions2[64] =
+{
+    0xcccc, 0x8888, 0xeeee, 0xecc8, 0xc880, 0xfeec, 0xfec8, 0xec80, 0xc800, 0xffec, 0xfe80, 0xe800, 0xffe8, 0xff00, 0xfff0, 0xf000,
+    0xf710, 0x008e, 0x7100, 0x08ce, 0x008c, 0x7310, 0x3100, 0x8cce, 0x088c, 0x3110, 0x6666, 0x366c, 0x17e8, 0x0ff0, 0x718e, 0x399c,
+    0xaaaa, 0xf0f0, 0x5a5a, 0x33cc, 0x3c3c, 0x55aa, 0x9696, 0xa55a, 0x73ce, 0x13c8, 0x324c, 0x3bdc, 0x6996, 0xc33c, 0x9966, 0x0660,
+    0x0272, 0x04e4, 0x4e40, 0x2720, 0xc936, 0x936c, 0x39c6, 0x639c, 0x9336, 0x9cc6, 0x817e, 0xe718, 0xccf0, 0x0fcc, 0x7744, 0xee22,
+};
+
+static const uint8_t kAnchors2[64] =
+{
+    15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15, 15,
+    15,  2,  8,  2,  2,  8,  8, 15,  2,  8,  2,  2,  8,  8,  2,  2,
+    15, 15,  6,  8,  2,  8, 15, 15,  2,  8,  2,  2,  2, 15, 15,  6,
+     6,  2,  6,  8, 15, 15,  2,  2, 15, 15, 15, 15, 15,  2,  2, 15,
+};
+
+static const uint32_t kWeights2[4] = { 0, 21, 43, 64 };
+static const uint32_t kWeights3[8] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+static const uint32_t kWeights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+class BitReader
+{
+public:
+    BitReader(const uint8_t* pData) : mpData(pData) {}
+    uint32_t read(uint32_t bitCount)
+    {
+        uint32_t value = 0;
+        for(uint32_t i = 0; i < bitCount; i++, mPosition++)
+        {
+            value |= ((mpData[mPosition >> 3] >> (mPosition & 7)) & 1u) << i;
+        }
+        return value;
+    }
+private:
+    const uint8_t* mpData;
+    uint32_t mPosition = 0;
+};
+
+static void decodeColorBlock(const uint8_t* pBlock, bool forceFourColors, uint8_t texels[16][4])
+{
+    uint16_t endpoints[2];
+    uint32_t indices;
+    memcpy(endpoints, pBlock, sizeof(endpoints));
+    memcpy(&indices, pBlock + 4, sizeof(indices));
+
+    uint32_t palette[4][4];
+    for(uint32_t e = 0; e < 2; e++)
+    {
+        const uint32_t r = (endpoints[e] >> 11) & 31, g = (endpoints[e] >> 5) & 63, b = endpoints[e] & 31;
+        palette[e][0] = (r << 3) | (r >> 2);
+        palette[e][1] = (g << 2) | (g >> 4);
+        palette[e][2] = (b << 3) | (b >> 2);
+        palette[e][3] = 255;
+    }
+
+    const bool fourColors = forceFourColors || endpoints[0] > endpoints[1];
+    for(uint32_t c = 0; c < 3; c++)
+    {
+        palette[2][c] = fourColors ? (2 * palette[0][c] + palette[1][c]) / 3 : (palette[0][c] + palette[1][c]) / 2;
+        palette[3][c] = fourColors ? (palette[0][c] + 2 * palette[1][c]) / 3 : 0;
+    }
+    palette[2][3] = 255;
+    palette[3][3] = fourColors ? 255 : 0;
+
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        const uint32_t index = (indices >> (2 * i)) & 3;
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            texels[i][c] = (uint8_t)palette[index][c];
+        }
+    }
+}
+
+static void decodeChannelBlock(const uint8_t* pBlock, uint32_t channel, uint8_t texels[16][4])
+{
+    const uint32_t a = pBlock[0], b = pBlock[1];
+    uint32_t palette[8] = { a, b };
+    if(a > b)
+    {
+        for(uint32_t i = 2; i < 8; i++) palette[i] = ((8 - i) * a + (i - 1) * b) / 7;
+    }
+    else
+    {
+        for(uint32_t i = 2; i < 6; i++) palette[i] = ((6 - i) * a + (i - 1) * b) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint64_t indices = 0;
+    memcpy(&indices, pBlock + 2, 6);
+    for(uint32_t i = 0; i < 16; i++)
+    {
+        texels[i][channel] = (uint8_t)palette[(indices >> (3 * i)) & 7];
+    }
+}
+
+// Decodes the BC7 modes the compressor writes
+static bool decodeBc7Block(const uint8_t* pBlock, uint8_t texels[16][4])
+{
+    BitReader reader(pBlock);
+    uint32_t mode = 0;
+    while(mode < 8 && reader.read(1) == 0)
+    {
+        mode++;
+    }
+
+    if(mode == 6)
+    {
+        uint32_t endpoints[2][4];
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            endpoints[0][c] = reader.read(7);
+            endpoints[1][c] = reader.read(7);
+        }
+        const uint32_t pBits[2] = { reader.read(1), reader.read(1) };
+        for(uint32_t c = 0; c < 4; c++)
+        {
+            endpoints[0][c] = (endpoints[0][c] << 1) | pBits[0];
+            endpoints[1][c] = (endpoints[1][c] << 1) | pBits[1];
+        }
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t weight = kWeights4[reader.read(i == 0 ? 3 : 4)];
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                texels[i][c] = (uint8_t)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+        }
+        return true;
+    }
+    else if(mode == 5)
+    {
+        const uint32_t rotation = reader.read(2);
+        uint32_t endpoints[2][4];
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            for(uint32_t e = 0; e < 2; e++)
+            {
+                const uint32_t value = reader.read(7);
+                endpoints[e][c] = (value << 1) | (value >> 6);
+            }
+        }
+        endpoints[0][3] = reader.read(8);
+        endpoints[1][3] = reader.read(8);
+        uint32_t weights[2][16];
+        for(uint32_t set = 0; set < 2; set++)
+        {
+            for(uint32_t i = 0; i < 16; i++) weights[set][i] = kWeights2[reader.read(i == 0 ? 1 : 2)];
+        }
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            for(uint32_t c = 0; c < 4; c++)
+            {
+                const uint32_t weight = weights[(c == 3) ? 1 : 0][i];
+                texels[i][c] = (uint8_t)(((64 - weight) * endpoints[0][c] + weight * endpoints[1][c] + 32) >> 6);
+            }
+            if(rotation)
+            {
+                std::swap(texels[i][rotation - 1], texels[i][3]);
+            }
+        }
+        return true;
+    }
+    else if(mode == 1)
+    {
+        const uint32_t partition = reader.read(6);
+        uint32_t endpoints[4][3];
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            for(uint32_t e = 0; e < 4; e++) endpoints[e][c] = reader.read(6);
+        }
+        const uint32_t pBits[2] = { reader.read(1), reader.read(1) };
+        for(uint32_t e = 0; e < 4; e++)
+        {
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                const uint32_t value = (endpoints[e][c] << 1) | pBits[e / 2];
+                endpoints[e][c] = (value << 1) | (value >> 6);
+            }
+        }
+        for(uint32_t i = 0; i < 16; i++)
+        {
+            const uint32_t subset = (kPartitions2[partition] >> i) & 1;
+            const bool isAnchor = (i == 0) || (i == kAnchors2[partition]);
+            const uint32_t weight = kWeights3[reader.read(isAnchor ? 2 : 3)];
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                texels[i][c] = (uint8_t)(((64 - weight) * endpoints[2 * subset][c] + weight * endpoints[2 * subset + 1][c] + 32) >> 6);
+            }
+            texels[i][3] = 255;
+        }
+        return true;
+    }
+    return false;
+}
+
+static float calcPsnr(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b, uint32_t channelCount, bool skipTransparent)
+{
+    double squaredError = 0;
+    size_t count = 0;
+    for(size_t i = 0; i < a.size(); i += 4)
+    {
+        if(skipTransparent && a[i + 3] < 128)
+        {
+            continue;
+        }
+        for(uint32_t c = 0; c < channelCount; c++)
+        {
+            const double diff = (double)a[i + c] - (double)b[i + c];
+            squaredError += diff * diff;
+        }
+        count += channelCount;
+    }
+    const double mse = squaredError / (double)std::max<size_t>(count, 1);
+    return mse > 0 ? (float)(10 * log10(255.0 * 255.0 / mse)) : 100.0f;
+}
+
+void BlockCompressorTest::addTests()
+{
+    addTestToList<TestRoundTripQuality>();
+    addTestToList<TestBc1Transparency>();
+    addTestToList<TestSolidColors>();
+    addTestToList<TestMipChain>();
+}
+
+std::vector<uint8_t> BlockCompressorTest::createTestImage(uint32_t width, uint32_t height)
+{
+    // Gradients with noisy tiles and an alpha ramp on the right half
+    std::vector<uint8_t> image(width * height * 4);
+    std::mt19937 rng(1);
+    for(uint32_t y = 0; y < height; y++)
+    {
+        for(uint32_t x = 0; x < width; x++)
+        {
+            uint8_t* pTexel = &image[(y * width + x) * 4];
+            pTexel[0] = ((x / 32 + y / 32) % 3 == 0) ? (uint8_t)(rng() & 0xff) : (uint8_t)x;
+            pTexel[1] = (uint8_t)y;
+            pTexel[2] = (uint8_t)((x * y) >> 8);
+            pTexel[3] = (x < width / 2) ? 255 : (uint8_t)y;
+        }
+    }
+    return image;
+}
+
+bool BlockCompressorTest::decompress(const std::vector<uint8_t>& blocks, uint32_t width, uint32_t height, ResourceFormat format, std::vector<uint8_t>& rgba)
+{
+    const uint32_t blocksX = (width + 3) / 4;
+    const uint32_t blocksY = (height + 3) / 4;
+    const uint32_t blockSize = (format == ResourceFormat::BC1Unorm || format == ResourceFormat::BC4Unorm) ? 8 : 16;
+    if(blocks.size() < (size_t)blocksX * blocksY * blockSize)
+    {
+        return false;
+    }
+
+    rgba.assign(width * height * 4, 0);
+    for(uint32_t by = 0; by < blocksY; by++)
+    {
+        for(uint32_t bx = 0; bx < blocksX; bx++)
+        {
+            const uint8_t* pBlock = &blocks[(by * blocksX + bx) * blockSize];
+            uint8_t texels[16][4] = {};
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                texels[i][3] = 255;
+            }
+
+            switch(format)
+            {
+            case ResourceFormat::BC1Unorm:
+                decodeColorBlock(pBlock, false, texels);
+                break;
+            case ResourceFormat::BC3Unorm:
+                decodeColorBlock(pBlock + 8, true, texels);
+                decodeChannelBlock(pBlock, 3, texels);
+                break;
+            case ResourceFormat::BC4Unorm:
+                decodeChannelBlock(pBlock, 0, texels);
+                break;
+            case ResourceFormat::BC5Unorm:
+                decodeChannelBlock(pBlock, 0, texels);
+                decodeChannelBlock(pBlock + 8, 1, texels);
+                break;
+            case ResourceFormat::BC7Unorm:
+                if(decodeBc7Block(pBlock, texels) == false)
+                {
+                    return false;
+                }
+                break;
+            default:
+                return false;
+            }
+
+            for(uint32_t i = 0; i < 16; i++)
+            {
+                const uint32_t x = bx * 4 + i % 4;
+                const uint32_t y = by * 4 + i / 4;
+                if(x < width && y < height)
+                {
+                    memcpy(&rgba[(y * width + x) * 4], texels[i], 4);
+                }
+            }
+        }
+    }
+    return true;
+}
+
+testing_func(BlockCompressorTest, TestRoundTripQuality)
+{
+    struct FormatDesc
+    {
+        ResourceFormat format;
+        const char* name;
+        uint32_t channelCount;
+        float minPsnr;
+    };
+    static const FormatDesc kFormats[] =
+    {
+        { ResourceFormat::BC1Unorm, "BC1", 3, 30 },
+        { ResourceFormat::BC3Unorm, "BC3", 4, 30 },
+        { ResourceFormat::BC4Unorm, "BC4", 1, 32 },
+        { ResourceFormat::BC5Unorm, "BC5", 2, 35 },
+        { ResourceFormat::BC7Unorm, "BC7", 4, 42 },
+    };
+    static const BlockCompressor::Quality kQualities[] = { BlockCompressor::Quality::Fast, BlockCompressor::Quality::Normal, BlockCompressor::Quality::High };
+
+    const uint32_t size = 256;
+    const std::vector<uint8_t> image = createTestImage(size, size);
+    for(const FormatDesc& desc : kFormats)
+    {
+        float fastPsnr = 0;
+        for(BlockCompressor::Quality quality : kQualities)
+        {
+            const std::vector<uint8_t> blocks = BlockCompressor::compress(image.data(), size, size, size * 4, desc.format, quality);
+            std::vector<uint8_t> decoded;
+            if(decompress(blocks, size, size, desc.format, decoded) == false)
+            {
+                return test_fail(std::string(desc.name) + " output could not be decoded");
+            }
+
+            // BC1 only keeps 1 bit of alpha, so the transparent texels' colors are undefined
+            const float psnr = calcPsnr(image, decoded, desc.channelCount, desc.format == ResourceFormat::BC1Unorm);
+            if(psnr < desc.minPsnr)
+            {
+                return test_fail(std::string(desc.name) + " PSNR of " + std::to_string(psnr) + " dB is below " + std::to_string(desc.minPsnr) + " dB");
+            }
+            if(quality == BlockCompressor::Quality::Fast)
+            {
+                fastPsnr = psnr;
+            }
+            else if(psnr + 0.1f < fastPsnr)
+            {
+                return test_fail(std::string(desc.name) + " has a lower PSNR at a higher quality setting");
+            }
+        }
+    }
+    return test_pass();
+}
+
+testing_func(BlockCompressorTest, TestBc1Transparency)
+{
+    const uint32_t size = 64;
+    const std::vector<uint8_t> image = createTestImage(size, size);
+    const std::vector<uint8_t> blocks = BlockCompressor::compress(image.data(), size, size, size * 4, ResourceFormat::BC1Unorm);
+    std::vector<uint8_t> decoded;
+    if(decompress(blocks, size, size, ResourceFormat::BC1Unorm, decoded) == false)
+    {
+        return test_fail("BC1 output could not be decoded");
+    }
+
+    for(size_t i = 0; i < image.size(); i += 4)
+    {
+        if((image[i + 3] >= 128) != (decoded[i + 3] == 255))
+        {
+            return test_fail("BC1 alpha doesn't match the 50% threshold of the source");
+        }
+    }
+    return test_pass();
+}
+
+testing_func(BlockCompressorTest, TestSolidColors)
+{
+    // BC7 reproduces any opaque solid color exactly at every quality, odd sizes included. The channels are often 0 or 255, which opaque mode 6 blocks can't all reach.
+    std::mt19937 rng(7);
+    const uint32_t width = 13;
+    const uint32_t height = 7;
+    const BlockCompressor::Quality qualities[] = { BlockCompressor::Quality::Fast, BlockCompressor::Quality::Normal, BlockCompressor::Quality::High };
+    std::vector<uint8_t> image(width * height * 4);
+    for(uint32_t color = 0; color < 256; color++)
+    {
+        uint8_t rgb[3];
+        for(uint32_t c = 0; c < 3; c++)
+        {
+            const uint32_t value = rng() % 384;
+            rgb[c] = (uint8_t)((value < 256) ? value : ((value & 1) ? 255 : 0));
+        }
+        for(size_t i = 0; i < image.size(); i += 4)
+        {
+            memcpy(&image[i], rgb, 3);
+            image[i + 3] = 255;
+        }
+
+        for(BlockCompressor::Quality quality : qualities)
+        {
+            const std::vector<uint8_t> blocks = BlockCompressor::compress(image.data(), width, height, width * 4, ResourceFormat::BC7Unorm, quality);
+            std::vector<uint8_t> decoded;
+            if(decompress(blocks, width, height, ResourceFormat::BC7Unorm, decoded) == false)
+            {
+                return test_fail("BC7 output could not be decoded");
+            }
+            if(decoded != image)
+            {
+                return test_fail("Solid color (" + std::to_string(rgb[0]) + ", " + std::to_string(rgb[1]) + ", " + std::to_string(rgb[2]) + ") wasn't reproduced exactly by BC7");
+            }
+        }
+    }
+    return test_pass();
+}
+
+testing_func(BlockCompressorTest, TestMipChain)
+{
+    const uint32_t width = 256;
+    const uint32_t height = 64;
+    const std::vector<uint8_t> image = createTestImage(width, height);
+    uint32_t mipCount = 0;
+    const std::vector<uint8_t> blocks = BlockCompressor::compressWithMips(image.data(), width, height, ResourceFormat::BC7UnormSrgb, BlockCompressor::Quality::Fast, mipCount);
+    if(mipCount != 9)
+    {
+        return test_fail("Wrong mip count");
+    }
+
+    size_t expectedSize = 0;
+    for(uint32_t mip = 0; mip < mipCount; mip++)
+    {
+        const uint32_t mipWidth = std::max(width >> mip, 1u);
+        const uint32_t mipHeight = std::max(height >> mip, 1u);
+        expectedSize += ((mipWidth + 3) / 4) * ((mipHeight + 3) / 4) * 16;
+    }
+    if(blocks.size() != expectedSize)
+    {
+        return test_fail("Mip chain size doesn't match the block count");
+    }
+    return test_pass();
+}
+
+int main()
+{
+    BlockCompressorTest bct;
+    bct.init(true);
+    bct.run();
+    return 0;
+}
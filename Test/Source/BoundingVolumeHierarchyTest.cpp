@@ -0,0 +1,264 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "BoundingVolumeHierarchyTest.h"
+#include "Utils/Math/BoundingVolumeHierarchy.h"
+#include <fstream>
+#include <random>
+#include <algorithm>
+
+static const std::string kModelFilename = "BoundingVolumeHierarchyTest.obj";
+static const uint32_t kQueryCount = 200;
+
+void BoundingVolumeHierarchyTest::addTests()
+{
+    addTestToList<TestQueryMatchesBruteForce>();
+    addTestToList<TestRefitMatchesBruteForce>();
+    addTestToList<TestSceneInstancesInBox>();
+}
+
+BoundingVolumeHierarchyTest::~BoundingVolumeHierarchyTest()
+{
+    std::remove(kModelFilename.c_str());
+}
+
+static BoundingBox createRandomBox(std::mt19937& rng, float range, float maxSize)
+{
+    std::uniform_real_distribution<float> pos(-range, range);
+    std::uniform_real_distribution<float> size(0, maxSize);
+    BoundingBox box;
+    box.center = vec3(pos(rng), pos(rng), pos(rng));
+    box.extent = vec3(size(rng), size(rng), size(rng));
+    return box;
+}
+
+static bool overlaps(const BoundingBox& a, const BoundingBox& b)
+{
+    return all(lessThanEqual(a.getMinPos(), b.getMaxPos())) && all(lessThanEqual(b.getMinPos(), a.getMaxPos()));
+}
+
+// Queries the hierarchy with the same node test as Scene::getModelInstancesInBox(). Returns an empty string if the result matches testing every box.
+static std::string compareQueries(const BoundingVolumeHierarchy* pBvh, const std::vector<BoundingBox>& boxes, std::mt19937& rng)
+{
+    for(uint32_t query = 0; query < kQueryCount; query++)
+    {
+        const BoundingBox queryBox = createRandomBox(rng, 100, 40);
+        const vec3 queryMin = queryBox.getMinPos();
+        const vec3 queryMax = queryBox.getMaxPos();
+        auto nodeTest = [&](const BoundingBox& box)
+        {
+            if(overlaps(box, queryBox) == false)
+            {
+                return BoundingVolumeHierarchy::Visit::Skip;
+            }
+            if(all(lessThanEqual(queryMin, box.getMinPos())) && all(lessThanEqual(box.getMaxPos(), queryMax)))
+            {
+                return BoundingVolumeHierarchy::Visit::AcceptAll;
+            }
+            return BoundingVolumeHierarchy::Visit::Descend;
+        };
+
+        std::vector<uint32_t> found;
+        bool wrongAccept = false;
+        pBvh->traverse(nodeTest, [&](uint32_t primID, bool fullyAccepted)
+        {
+            found.push_back(primID);
+            const BoundingBox& box = boxes[primID];
+            wrongAccept = wrongAccept || (fullyAccepted && (any(lessThan(box.getMinPos(), queryMin)) || any(greaterThan(box.getMaxPos(), queryMax))));
+        });
+
+        std::vector<uint32_t> expected;
+        for(uint32_t primID = 0; primID < (uint32_t)boxes.size(); primID++)
+        {
+            if(overlaps(boxes[primID], queryBox))
+            {
+                expected.push_back(primID);
+            }
+        }
+
+        std::sort(found.begin(), found.end());
+        if(found != expected)
+        {
+            return "Query " + std::to_string(query) + " found " + std::to_string(found.size()) + " primitives, expected " + std::to_string(expected.size());
+        }
+        if(wrongAccept)
+        {
+            return "A primitive outside of the query box was fully accepted";
+        }
+    }
+    return "";
+}
+
+testing_func(BoundingVolumeHierarchyTest, TestQueryMatchesBruteForce)
+{
+    std::mt19937 rng(1);
+    if(BoundingVolumeHierarchy::create({})->getNodeCount() != 0)
+    {
+        return test_fail("Empty hierarchy has nodes");
+    }
+
+    for(uint32_t primCount : { 1u, 5u, 2000u })
+    {
+        std::vector<BoundingBox> boxes;
+        for(uint32_t i = 0; i < primCount; i++)
+        {
+            boxes.push_back(createRandomBox(rng, 100, 5));
+        }
+
+        for(uint32_t maxPrimsPerLeaf : { 1u, 4u, 16u })
+        {
+            BoundingVolumeHierarchy::SharedPtr pBvh = BoundingVolumeHierarchy::create(boxes, maxPrimsPerLeaf);
+            if(pBvh->getPrimitiveCount() != primCount)
+            {
+                return test_fail("Primitive count doesn't match");
+            }
+            const std::string error = compareQueries(pBvh.get(), boxes, rng);
+            if(error.empty() == false)
+            {
+                return test_fail(error);
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(BoundingVolumeHierarchyTest, TestRefitMatchesBruteForce)
+{
+    std::mt19937 rng(2);
+    std::vector<BoundingBox> boxes;
+    for(uint32_t i = 0; i < 2000; i++)
+    {
+        boxes.push_back(createRandomBox(rng, 100, 5));
+    }
+    BoundingVolumeHierarchy::SharedPtr pBvh = BoundingVolumeHierarchy::create(boxes);
+
+    // Move some of the primitives far away from where the tree was built, then a few more after the first refit
+    for(uint32_t moveCount : { 200u, 7u })
+    {
+        for(uint32_t i = 0; i < moveCount; i++)
+        {
+            const uint32_t primID = rng() % (uint32_t)boxes.size();
+            boxes[primID] = createRandomBox(rng, 100, 10);
+            pBvh->setPrimitiveBounds(primID, boxes[primID]);
+        }
+        pBvh->refit();
+
+        for(const BoundingBox& box : boxes)
+        {
+            if(any(lessThan(box.getMinPos(), pBvh->getBounds().getMinPos())) || any(greaterThan(box.getMaxPos(), pBvh->getBounds().getMaxPos())))
+            {
+                return test_fail("Refit bounds don't contain all the primitives");
+            }
+        }
+
+        const std::string error = compareQueries(pBvh.get(), boxes, rng);
+        if(error.empty() == false)
+        {
+            return test_fail("After refit: " + error);
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(BoundingVolumeHierarchyTest, TestSceneInstancesInBox)
+{
+    {
+        // A unit cube
+        std::ofstream file(kModelFilename);
+        file << "v -1 -1 -1\nv 1 -1 -1\nv 1 1 -1\nv -1 1 -1\nv -1 -1 1\nv 1 -1 1\nv 1 1 1\nv -1 1 1\n";
+        file << "f 1 3 2\nf 1 4 3\nf 5 6 7\nf 5 7 8\nf 1 2 6\nf 1 6 5\nf 4 7 3\nf 4 8 7\nf 1 5 8\nf 1 8 4\nf 2 3 7\nf 2 7 6\n";
+    }
+
+    // Two models, so that the running instance indices map to different model IDs
+    Model::SharedPtr pModels[] = { Model::createFromFile(kModelFilename.c_str()), Model::createFromFile(kModelFilename.c_str()) };
+    if(pModels[0] == nullptr || pModels[1] == nullptr)
+    {
+        return test_fail("Failed to load the test model");
+    }
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<float> pos(-100, 100);
+    std::uniform_real_distribution<float> scale(0.5f, 4);
+    Scene::SharedPtr pScene = Scene::create();
+    for(uint32_t i = 0; i < 500; i++)
+    {
+        pScene->addModelInstance(pModels[i % 2], "Cube" + std::to_string(i), vec3(pos(rng), pos(rng), pos(rng)), vec3(0), vec3(scale(rng)));
+    }
+
+    std::vector<Scene::ModelInstanceRef> found;
+    for(uint32_t pass = 0; pass < 2; pass++)
+    {
+        for(uint32_t query = 0; query < kQueryCount; query++)
+        {
+            const BoundingBox queryBox = createRandomBox(rng, 100, 40);
+            pScene->getModelInstancesInBox(queryBox, found);
+
+            std::vector<std::pair<uint32_t, uint32_t>> foundIDs;
+            for(const auto& ref : found)
+            {
+                foundIDs.push_back({ ref.modelID, ref.instanceID });
+            }
+            std::vector<std::pair<uint32_t, uint32_t>> expectedIDs;
+            for(uint32_t modelID = 0; modelID < pScene->getModelCount(); modelID++)
+            {
+                for(uint32_t instanceID = 0; instanceID < pScene->getModelInstanceCount(modelID); instanceID++)
+                {
+                    if(overlaps(pScene->getModelInstance(modelID, instanceID)->getBoundingBox(), queryBox))
+                    {
+                        expectedIDs.push_back({ modelID, instanceID });
+                    }
+                }
+            }
+
+            std::sort(foundIDs.begin(), foundIDs.end());
+            if(foundIDs != expectedIDs)
+            {
+                return test_fail("Scene query " + std::to_string(query) + " found " + std::to_string(foundIDs.size()) + " instances, expected " + std::to_string(expectedIDs.size()));
+            }
+        }
+
+        // Moving instances refits the hierarchy instead of rebuilding it, so query again
+        for(uint32_t i = 0; i < 50; i++)
+        {
+            const uint32_t modelID = rng() % 2;
+            const auto& pInstance = pScene->getModelInstance(modelID, rng() % pScene->getModelInstanceCount(modelID));
+            pInstance->setTranslation(vec3(pos(rng), pos(rng), pos(rng)), false);
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    BoundingVolumeHierarchyTest bvht;
+    bvht.init(true);
+    bvht.run();
+    return 0;
+}
@@ -0,0 +1,148 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "CameraCullingTest.h"
+#include "TestHelper.h"
+#include <bitset>
+
+void CameraCullingTest::addTests()
+{
+    addTestToList<TestBatchMatchesScalar>();
+    addTestToList<TestBatchPerformance>();
+}
+
+Camera::SharedPtr CameraCullingTest::createTestCamera()
+{
+    Camera::SharedPtr pCamera = Camera::create();
+    pCamera->setPosition(vec3(0, 0, 0));
+    pCamera->setTarget(vec3(0, 0, -1));
+    pCamera->setUpVector(vec3(0, 1, 0));
+    pCamera->setAspectRatio(16.0f / 9.0f);
+    pCamera->setDepthRange(0.1f, 100.0f);
+    return pCamera;
+}
+
+BoundingBoxArray CameraCullingTest::createRandomBoxes(uint32_t count)
+{
+    // Scatter boxes in a volume around the camera so that some are culled, some are inside and some straddle the frustum planes
+    BoundingBoxArray boxes;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        BoundingBox box;
+        box.center = (vec3(TestHelper::randFloatZeroToOne(), TestHelper::randFloatZeroToOne(), TestHelper::randFloatZeroToOne()) * 2.0f - 1.0f) * 120.0f;
+        box.extent = vec3(TestHelper::randFloatZeroToOne(), TestHelper::randFloatZeroToOne(), TestHelper::randFloatZeroToOne()) * 5.0f;
+        boxes.add(box);
+    }
+    return boxes;
+}
+
+testing_func(CameraCullingTest, TestBatchMatchesScalar)
+{
+    Camera::SharedPtr pCamera = createTestCamera();
+
+    // Include counts which aren't multiples of the SIMD width
+    const uint32_t counts[] = { 0, 1, 3, 4, 7, 8, 9, 31, 32, 33, 1000 };
+    for (uint32_t count : counts)
+    {
+        BoundingBoxArray boxes = createRandomBoxes(count);
+        std::vector<uint32_t> visibility;
+        pCamera->cullBoundingBoxes(boxes, visibility);
+
+        if (visibility.size() != (count + 31) / 32)
+        {
+            return test_fail("Visibility mask has the wrong size");
+        }
+
+        for (uint32_t i = 0; i < count; i++)
+        {
+            const bool visible = (visibility[i / 32] & (1u << (i % 32))) != 0;
+            if (visible == pCamera->isObjectCulled(boxes.get(i)))
+            {
+                return test_fail("Batched culling result doesn't match Camera::isObjectCulled()");
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(CameraCullingTest, TestBatchPerformance)
+{
+    const uint32_t kBoxCount = 1 << 20;
+    const uint32_t kIterations = 10;
+
+    Camera::SharedPtr pCamera = createTestCamera();
+    BoundingBoxArray boxes = createRandomBoxes(kBoxCount);
+
+    // Scalar path. Use AoS boxes, like the callers of isObjectCulled() do.
+    std::vector<BoundingBox> boxList(kBoxCount);
+    for (uint32_t i = 0; i < kBoxCount; i++)
+    {
+        boxList[i] = boxes.get(i);
+    }
+
+    uint32_t scalarVisible = 0;
+    CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t iter = 0; iter < kIterations; iter++)
+    {
+        for (const auto& box : boxList)
+        {
+            scalarVisible += pCamera->isObjectCulled(box) ? 0 : 1;
+        }
+    }
+    const float scalarTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    // Batched path
+    uint32_t batchVisible = 0;
+    std::vector<uint32_t> visibility;
+    start = CpuTimer::getCurrentTimePoint();
+    for (uint32_t iter = 0; iter < kIterations; iter++)
+    {
+        pCamera->cullBoundingBoxes(boxes, visibility);
+        for (uint32_t word : visibility)
+        {
+            batchVisible += (uint32_t)std::bitset<32>(word).count();
+        }
+    }
+    const float batchTime = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()) / kIterations;
+
+    if (scalarVisible != batchVisible)
+    {
+        return test_fail("Batched and scalar culling found a different number of visible boxes");
+    }
+
+    const std::string timings = std::to_string(kBoxCount) + " boxes. Scalar: " + std::to_string(scalarTime) + " ms, batched: " + std::to_string(batchTime) + " ms";
+    return TestBase::TestData(TestBase::TestResult::Pass, mName, timings);
+}
+
+int main()
+{
+    CameraCullingTest cct;
+    cct.init();
+    cct.run();
+    return 0;
+}
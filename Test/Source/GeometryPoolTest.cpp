@@ -0,0 +1,102 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "GeometryPoolTest.h"
+#include "TestHelper.h"
+
+static const std::string kModelFilename = "GeometryPoolTest.bin";
+static const std::string kModelV9Filename = "GeometryPoolTestV9.bin";
+
+void GeometryPoolTest::addTests()
+{
+    addTestToList<TestPoolGeometry>();
+}
+
+void GeometryPoolTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+}
+
+GeometryPoolTest::~GeometryPoolTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+}
+
+testing_func(GeometryPoolTest, TestPoolGeometry)
+{
+    const Model::LoadFlags flags = Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::PoolGeometry;
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pV8 = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, flags, duration);
+    Model::SharedPtr pV9 = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::Stream, flags, duration);
+    if(pOriginal == nullptr || pV8 == nullptr || pV9 == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    std::string error;
+    if(TestHelper::areModelsEqual(pOriginal.get(), pV8.get(), error) == false || TestHelper::areModelsEqual(pOriginal.get(), pV9.get(), error) == false)
+    {
+        return test_fail("Pooled import doesn't match the original. " + error);
+    }
+
+    // The test model's meshes share a layout and are small, so they must all end up in one Vao with 16-bit indices
+    for(const Model* pPooled : { pV8.get(), pV9.get() })
+    {
+        const Vao* pVao = pPooled->getMesh(0)->getVao().get();
+        uint32_t indexEnd = 0;
+        for(uint32_t meshID = 0; meshID < pPooled->getMeshCount(); meshID++)
+        {
+            const Mesh* pMesh = pPooled->getMesh(meshID).get();
+            if(pMesh->getVao().get() != pVao)
+            {
+                return test_fail("Pooled meshes don't share a Vao");
+            }
+            indexEnd = std::max(indexEnd, pMesh->getStartIndex() + pMesh->getIndexCount());
+        }
+
+        if(pVao->getIndexBufferFormat() != ResourceFormat::R16Uint)
+        {
+            return test_fail("Pooled meshes don't use 16-bit indices");
+        }
+        if(pVao->getIndexBuffer()->getSize() != indexEnd * sizeof(uint16_t))
+        {
+            return test_fail("Pooled index ranges don't cover the index buffer");
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    GeometryPoolTest gpt;
+    gpt.init(true);
+    gpt.run();
+    return 0;
+}
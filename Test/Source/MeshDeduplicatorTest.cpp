@@ -0,0 +1,209 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "MeshDeduplicatorTest.h"
+#include "TestHelper.h"
+#include "Graphics/Model/MeshDeduplicator.h"
+#include "Graphics/Model/Loaders/BinaryModelSpec.h"
+#include "Utils/BinaryFileStream.h"
+
+static const std::string kModelFilename = "MeshDeduplicatorTest.bin";
+static const std::string kModelV9Filename = "MeshDeduplicatorTestV9.bin";
+static const std::string kDuplicateModelFilename = "MeshDeduplicatorTestDuplicates.bin";
+static const uint32_t kDuplicateGridSize = 8;
+
+void MeshDeduplicatorTest::addTests()
+{
+    addTestToList<TestDeduplicateGeometry>();
+}
+
+void MeshDeduplicatorTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+    writeDuplicateMeshModel(kDuplicateModelFilename);
+}
+
+MeshDeduplicatorTest::~MeshDeduplicatorTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+    std::remove(kDuplicateModelFilename.c_str());
+}
+
+static void writeString(BinaryFileStream& stream, const std::string& str)
+{
+    stream << (int32_t)str.size();
+    stream.write(str.data(), str.size());
+}
+
+void MeshDeduplicatorTest::writeDuplicateMeshModel(const std::string& filename)
+{
+    BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+    const int32_t textureCount = 0;
+    const int32_t meshCount = 2;
+    const int32_t instanceCount = 2;
+    stream.write("BinScene", 8);
+    stream << (int32_t)8 << textureCount << meshCount << instanceCount;
+
+    // Two byte-identical meshes. Every quad of the flat grid owns its 4 corners, so the corners shared by neighbouring quads are repeated.
+    // All values are exact in floating point, so the generated bitangents of the repeated vertices are identical too.
+    const int32_t vertexCount = kDuplicateGridSize * kDuplicateGridSize * 4;
+    for(int32_t mesh = 0; mesh < meshCount; mesh++)
+    {
+        stream << (int32_t)3 << vertexCount << (int32_t)1;
+        stream << (int32_t)AttribType_Position << (int32_t)AttribFormat_F32 << (int32_t)3;
+        stream << (int32_t)AttribType_Normal << (int32_t)AttribFormat_F32 << (int32_t)3;
+        stream << (int32_t)AttribType_TexCoord << (int32_t)AttribFormat_F32 << (int32_t)2;
+
+        for(uint32_t y = 0; y < kDuplicateGridSize; y++)
+        {
+            for(uint32_t x = 0; x < kDuplicateGridSize; x++)
+            {
+                for(uint32_t corner = 0; corner < 4; corner++)
+                {
+                    const vec2 pos = vec2(x + (corner & 1), y + (corner >> 1));
+                    stream << vec3(pos.x, 0, pos.y) << vec3(0, 1, 0) << pos / float(kDuplicateGridSize);
+                }
+            }
+        }
+
+        stream << vec3(0) << vec4(0.5f, 0.5f, 0.5f, 0) << vec3(0.1f) << 16.0f << 0.0f << 0.0f;
+        for(int32_t slot = 0; slot < TextureType_Max; slot++)
+        {
+            stream << (int32_t)-1;
+        }
+        stream << (int32_t)(kDuplicateGridSize * kDuplicateGridSize * 6);
+        for(uint32_t quad = 0; quad < kDuplicateGridSize * kDuplicateGridSize; quad++)
+        {
+            const uint32_t v = quad * 4;
+            stream << v << v + 2 << v + 1 << v + 1 << v + 2 << v + 3;
+        }
+    }
+
+    // One instance of each mesh
+    for(int32_t mesh = 0; mesh < meshCount; mesh++)
+    {
+        stream << mesh << (int32_t)1 << glm::translate(mat4(), vec3(float(mesh * kDuplicateGridSize), 0, 0));
+        writeString(stream, "grid" + std::to_string(mesh));
+        writeString(stream, "");
+    }
+}
+
+testing_func(MeshDeduplicatorTest, TestDeduplicateGeometry)
+{
+    // Welding a mesh whose vertices are all different must leave it untouched
+    MeshDeduplicator::clearRegistry();
+    float duration;
+    const Model::LoadFlags flags = Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::DeduplicateGeometry;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pFirst = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, flags, duration);
+    if(pOriginal == nullptr || pFirst == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    std::string error;
+    if(TestHelper::areModelsEqual(pOriginal.get(), pFirst.get(), error) == false)
+    {
+        return test_fail("Deduplication changed the model. " + error);
+    }
+
+    Model::SharedPtr pV9 = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::Stream, flags, duration);
+    if(pV9 == nullptr || TestHelper::areModelsEqual(pOriginal.get(), pV9.get(), error) == false)
+    {
+        return test_fail("Deduplication changed the version 9 model. " + error);
+    }
+
+    // Loading the model again must reuse the buffers of the first one
+    Model::SharedPtr pSecond = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::Stream, flags, duration);
+    if(pSecond == nullptr || TestHelper::areModelsEqual(pOriginal.get(), pSecond.get(), error) == false)
+    {
+        return test_fail("Deduplication changed the model. " + error);
+    }
+    for(uint32_t meshID = 0; meshID < pFirst->getMeshCount(); meshID++)
+    {
+        if(pSecond->getMesh(meshID)->getVao() != pFirst->getMesh(meshID)->getVao())
+        {
+            return test_fail("An identical mesh wasn't reused");
+        }
+        if(pSecond->getMesh(meshID) == pFirst->getMesh(meshID) || pSecond->getMesh(meshID)->getId() == pFirst->getMesh(meshID)->getId())
+        {
+            return test_fail("A mesh object of another model was returned");
+        }
+    }
+    pSecond = nullptr;
+
+    // Once the first model is released, nothing is left to reuse
+    const Vao::SharedPtr pVao = pFirst->getMesh(0)->getVao();
+    pFirst = nullptr;
+    Model::SharedPtr pThird = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, flags, duration);
+    if(pThird == nullptr || pThird->getMesh(0)->getVao() == pVao)
+    {
+        return test_fail("A released mesh was reused");
+    }
+
+    pThird = nullptr;
+
+    // Repeated vertices are welded and the second of two identical meshes becomes an instance of the first
+    Model::SharedPtr pSeparate = TestHelper::importBinaryModel(kDuplicateModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    if(pSeparate == nullptr || pSeparate->getMeshCount() != 2 || pSeparate->getMesh(0)->getVertexCount() != kDuplicateGridSize * kDuplicateGridSize * 4)
+    {
+        return test_fail("Failed to import the duplicate mesh model");
+    }
+    pSeparate = nullptr;
+
+    MeshDeduplicator::clearRegistry();
+    Model::SharedPtr pMerged = TestHelper::importBinaryModel(kDuplicateModelFilename, BinaryModelImporter::InputMode::Stream, flags, duration);
+    if(pMerged == nullptr)
+    {
+        return test_fail("Failed to import the duplicate mesh model with deduplication");
+    }
+    if(pMerged->getMeshCount() != 1 || pMerged->getMeshInstanceCount(0) != 2)
+    {
+        return test_fail("The identical meshes weren't merged into one mesh with two instances");
+    }
+    const uint32_t weldedVertexCount = (kDuplicateGridSize + 1) * (kDuplicateGridSize + 1);
+    if(pMerged->getMesh(0)->getVertexCount() != weldedVertexCount)
+    {
+        return test_fail("The repeated vertices weren't welded. Expected " + std::to_string(weldedVertexCount) + " vertices, got " + std::to_string(pMerged->getMesh(0)->getVertexCount()));
+    }
+    if(pMerged->getMeshInstance(0, 0)->getTransformMatrix() == pMerged->getMeshInstance(0, 1)->getTransformMatrix())
+    {
+        return test_fail("The instances of the merged mesh lost their transforms");
+    }
+
+    MeshDeduplicator::clearRegistry();
+    return test_pass();
+}
+
+int main()
+{
+    MeshDeduplicatorTest mdt;
+    mdt.init(true);
+    mdt.run();
+    return 0;
+}
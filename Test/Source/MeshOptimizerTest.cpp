@@ -0,0 +1,128 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "MeshOptimizerTest.h"
+#include "TestHelper.h"
+#include "Graphics/Model/MeshOptimizer.h"
+#include <algorithm>
+
+static const std::string kModelFilename = "MeshOptimizerTest.bin";
+static const std::string kModelV9Filename = "MeshOptimizerTestV9.bin";
+
+void MeshOptimizerTest::addTests()
+{
+    addTestToList<TestOptimizeMeshes>();
+}
+
+void MeshOptimizerTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+}
+
+MeshOptimizerTest::~MeshOptimizerTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+}
+
+// The triangles of a mesh as position triples, rotated to a canonical first vertex so the winding is kept
+static std::vector<std::vector<float>> getSortedTriangles(const Mesh* pMesh)
+{
+    const std::vector<glm::vec3>& positions = pMesh->getCpuPositions();
+    const std::vector<uint32_t>& indices = pMesh->getCpuIndices();
+    std::vector<std::vector<float>> triangles;
+    for(size_t i = 0; i + 2 < indices.size(); i += 3)
+    {
+        std::vector<float> tri;
+        for(uint32_t j = 0; j < 3; j++)
+        {
+            const glm::vec3& p = positions[indices[i + j]];
+            tri.insert(tri.end(), { p.x, p.y, p.z });
+        }
+        auto first = tri.begin();
+        for(uint32_t j = 1; j < 3; j++)
+        {
+            if(std::lexicographical_compare(tri.begin() + j * 3, tri.begin() + j * 3 + 3, first, first + 3))
+            {
+                first = tri.begin() + j * 3;
+            }
+        }
+        std::rotate(tri.begin(), first, tri.end());
+        triangles.push_back(tri);
+    }
+    std::sort(triangles.begin(), triangles.end());
+    return triangles;
+}
+
+testing_func(MeshOptimizerTest, TestOptimizeMeshes)
+{
+    const Model::LoadFlags flags = Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::OptimizeMeshes;
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pV8 = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::Stream, flags, duration);
+    Model::SharedPtr pV9 = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::MemoryMapped, flags, duration);
+    if(pOriginal == nullptr || pV8 == nullptr || pV9 == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    for(const Model* pOptimized : { pV8.get(), pV9.get() })
+    {
+        if(pOptimized->getMeshCount() != pOriginal->getMeshCount())
+        {
+            return test_fail("Mesh count doesn't match");
+        }
+
+        for(uint32_t meshID = 0; meshID < pOriginal->getMeshCount(); meshID++)
+        {
+            const Mesh* pMeshA = pOriginal->getMesh(meshID).get();
+            const Mesh* pMeshB = pOptimized->getMesh(meshID).get();
+            if(getSortedTriangles(pMeshA) != getSortedTriangles(pMeshB))
+            {
+                return test_fail("The optimized mesh has different triangles");
+            }
+
+            const std::vector<uint32_t>& indicesA = pMeshA->getCpuIndices();
+            const std::vector<uint32_t>& indicesB = pMeshB->getCpuIndices();
+            float acmrBefore = MeshOptimizer::calculateACMR(indicesA.data(), (uint32_t)indicesA.size(), pMeshA->getVertexCount());
+            float acmrAfter = MeshOptimizer::calculateACMR(indicesB.data(), (uint32_t)indicesB.size(), pMeshB->getVertexCount());
+            if(acmrAfter > acmrBefore * 1.1f)
+            {
+                return test_fail("The optimized mesh has a worse ACMR");
+            }
+        }
+    }
+    return test_pass();
+}
+
+int main()
+{
+    MeshOptimizerTest mot;
+    mot.init(true);
+    mot.run();
+    return 0;
+}
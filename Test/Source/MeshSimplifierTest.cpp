@@ -0,0 +1,134 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "MeshSimplifierTest.h"
+#include "TestHelper.h"
+#include "Graphics/Model/Loaders/BinaryModelExporter.h"
+
+static const std::string kModelFilename = "MeshSimplifierTest.bin";
+static const std::string kModelV9Filename = "MeshSimplifierTestV9.bin";
+static const std::string kModelV10Filename = "MeshSimplifierTestV10.bin";
+
+void MeshSimplifierTest::addTests()
+{
+    addTestToList<TestGenerateLods>();
+}
+
+void MeshSimplifierTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+}
+
+MeshSimplifierTest::~MeshSimplifierTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+    std::remove(kModelV10Filename.c_str());
+}
+
+testing_func(MeshSimplifierTest, TestGenerateLods)
+{
+    const Model::LoadFlags flags = Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::GenerateLods;
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pLods = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::MemoryMapped, flags, duration);
+    if(pOriginal == nullptr || pLods == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    // LOD 0 is the full mesh, so the rest of the model must be unchanged
+    std::string error;
+    if(TestHelper::areModelsEqual(pOriginal.get(), pLods.get(), error) == false)
+    {
+        return test_fail("Generating LODs changed the model. " + error);
+    }
+
+    uint32_t lodCount = 0;
+    for(uint32_t meshID = 0; meshID < pLods->getMeshCount(); meshID++)
+    {
+        const Mesh* pMesh = pLods->getMesh(meshID).get();
+        lodCount = std::max(lodCount, pMesh->getLodCount());
+        if(pMesh->getLod(0).indexCount != pMesh->getIndexCount() || pMesh->getLod(0).error != 0)
+        {
+            return test_fail("LOD 0 isn't the full mesh");
+        }
+        for(uint32_t lod = 1; lod < pMesh->getLodCount(); lod++)
+        {
+            const Mesh::Lod& coarse = pMesh->getLod(lod);
+            const Mesh::Lod& fine = pMesh->getLod(lod - 1);
+            if(coarse.indexCount >= fine.indexCount || coarse.error < fine.error)
+            {
+                return test_fail("LODs must have decreasing index counts and increasing errors");
+            }
+        }
+    }
+    if(lodCount <= 1)
+    {
+        return test_fail("No LODs were generated");
+    }
+
+    // Version 10 stores the LODs, so reimporting without GenerateLods must bring them back unchanged
+    BinaryModelExporter::exportToFile(kModelV10Filename, pLods.get(), 10);
+    Model::SharedPtr pReimported = TestHelper::importBinaryModel(kModelV10Filename, BinaryModelImporter::InputMode::Stream, Model::LoadFlags::KeepCpuGeometry, duration);
+    if(pReimported == nullptr)
+    {
+        return test_fail("Failed to import the version 10 model");
+    }
+    if(TestHelper::areModelsEqual(pLods.get(), pReimported.get(), error) == false)
+    {
+        return test_fail("Version 10 import doesn't match the exported model. " + error);
+    }
+    for(uint32_t meshID = 0; meshID < pLods->getMeshCount(); meshID++)
+    {
+        const Mesh* pExported = pLods->getMesh(meshID).get();
+        const Mesh* pImported = pReimported->getMesh(meshID).get();
+        if(pExported->getLodCount() != pImported->getLodCount())
+        {
+            return test_fail("Version 10 import lost LODs");
+        }
+        for(uint32_t lod = 0; lod < pExported->getLodCount(); lod++)
+        {
+            const Mesh::Lod& exported = pExported->getLod(lod);
+            const Mesh::Lod& imported = pImported->getLod(lod);
+            if(exported.indexCount != imported.indexCount || exported.error != imported.error || exported.startIndex - pExported->getStartIndex() != imported.startIndex - pImported->getStartIndex())
+            {
+                return test_fail("Version 10 LODs don't match the exported ones");
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    MeshSimplifierTest mst;
+    mst.init(true);
+    mst.run();
+    return 0;
+}
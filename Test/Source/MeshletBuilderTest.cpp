@@ -0,0 +1,141 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "MeshletBuilderTest.h"
+#include "TestHelper.h"
+#include "Graphics/Model/MeshletBuilder.h"
+
+static const std::string kModelFilename = "MeshletBuilderTest.bin";
+static const std::string kModelV9Filename = "MeshletBuilderTestV9.bin";
+
+void MeshletBuilderTest::addTests()
+{
+    addTestToList<TestBuildMeshlets>();
+}
+
+void MeshletBuilderTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+}
+
+MeshletBuilderTest::~MeshletBuilderTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+}
+
+testing_func(MeshletBuilderTest, TestBuildMeshlets)
+{
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pV8 = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::BuildMeshlets, duration);
+    Model::SharedPtr pV9 = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::Stream, Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::BuildMeshlets | Model::LoadFlags::PoolGeometry, duration);
+    if(pOriginal == nullptr || pV8 == nullptr || pV9 == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    std::string error;
+    if(TestHelper::areModelsEqual(pOriginal.get(), pV8.get(), error) == false || TestHelper::areModelsEqual(pOriginal.get(), pV9.get(), error) == false)
+    {
+        return test_fail("Building meshlets changed the model. " + error);
+    }
+
+    const glm::vec3 eyePositions[] = { glm::vec3(1000, 0, 0), glm::vec3(0, 1000, 0), glm::vec3(0, -1000, 0), glm::vec3(-300, 200, 700) };
+    uint32_t backfacingCount = 0;
+    for(const Model* pModel : { pV8.get(), pV9.get() })
+    {
+        for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+        {
+            const Mesh* pMesh = pModel->getMesh(meshID).get();
+            const std::vector<Meshlet>& meshlets = pMesh->getMeshlets();
+            const std::vector<glm::vec3>& positions = pMesh->getCpuPositions();
+            const std::vector<uint32_t>& indices = pMesh->getCpuIndices();
+            if(meshlets.empty())
+            {
+                return test_fail("A mesh wasn't split into meshlets");
+            }
+
+            // The meshlets must cover the full detail LOD in order, within the size limits
+            uint32_t nextIndex = pMesh->getStartIndex();
+            for(const Meshlet& meshlet : meshlets)
+            {
+                if(meshlet.startIndex != nextIndex || meshlet.indexCount == 0 || meshlet.indexCount > MeshletBuilder::kDefaultMaxTriangles * 3 || meshlet.vertexCount > MeshletBuilder::kDefaultMaxVertices)
+                {
+                    return test_fail("Meshlets don't partition the mesh within the size limits");
+                }
+                nextIndex += meshlet.indexCount;
+
+                for(uint32_t i = meshlet.startIndex - pMesh->getStartIndex(); i < meshlet.startIndex - pMesh->getStartIndex() + meshlet.indexCount; i += 3)
+                {
+                    const glm::vec3& p0 = positions[indices[i]];
+                    const glm::vec3 n = glm::cross(positions[indices[i + 1]] - p0, positions[indices[i + 2]] - p0);
+                    for(uint32_t j = 0; j < 3; j++)
+                    {
+                        const glm::vec3 d = glm::abs(positions[indices[i + j]] - meshlet.box.center) - meshlet.box.extent;
+                        if(d.x > 1e-4f || d.y > 1e-4f || d.z > 1e-4f)
+                        {
+                            return test_fail("A meshlet's box doesn't contain its triangles");
+                        }
+                    }
+
+                    // The cone test is conservative: a back-facing meshlet has no front-facing triangles
+                    for(const glm::vec3& eyePos : eyePositions)
+                    {
+                        if(meshlet.isBackfacing(eyePos) && glm::dot(n, eyePos - p0) > 1e-4f * glm::length(n) * glm::length(eyePos - p0))
+                        {
+                            return test_fail("A meshlet was culled by its normal cone, but has front-facing triangles");
+                        }
+                    }
+                }
+                for(const glm::vec3& eyePos : eyePositions)
+                {
+                    backfacingCount += meshlet.isBackfacing(eyePos) ? 1 : 0;
+                }
+            }
+            if(nextIndex != pMesh->getStartIndex() + pMesh->getIndexCount())
+            {
+                return test_fail("Meshlets don't cover the whole mesh");
+            }
+        }
+    }
+
+    if(backfacingCount == 0)
+    {
+        return test_fail("No meshlet could be culled by its normal cone");
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    MeshletBuilderTest mbt;
+    mbt.init(true);
+    mbt.run();
+    return 0;
+}
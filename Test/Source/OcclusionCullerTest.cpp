@@ -0,0 +1,208 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "OcclusionCullerTest.h"
+#include "TestHelper.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+// A 20x20 wall facing the camera, 10 units in front of it. The camera is at the origin and looks down -z.
+static const float kWallDistance = 10.0f;
+static const float kWallHalfSize = 10.0f;
+
+void OcclusionCullerTest::addTests()
+{
+    addTestToList<TestWallOccludes>();
+    addTestToList<TestNoFalseOcclusion>();
+    addTestToList<TestNearPlane>();
+}
+
+OcclusionCuller::UniquePtr OcclusionCullerTest::createWallScene()
+{
+    const mat4 proj = perspectiveMatrix(radians(60.0f), 2.0f, 0.1f, 1000.0f);
+    const mat4 view = lookAt(vec3(0, 0, 0), vec3(0, 0, -1), vec3(0, 1, 0));
+
+    const vec3 positions[] = { vec3(-1, -1, 0), vec3(1, -1, 0), vec3(1, 1, 0), vec3(-1, 1, 0) };
+    const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+    const mat4 world = translate(mat4(), vec3(0, 0, -kWallDistance)) * scale(mat4(), vec3(kWallHalfSize));
+
+    OcclusionCuller::UniquePtr pCuller = OcclusionCuller::create();
+    pCuller->beginFrame(proj * view);
+    pCuller->rasterizeOccluder(positions, indices, arraysize(indices), world);
+    pCuller->finalizeOccluders();
+    return pCuller;
+}
+
+static BoundingBox createBox(const vec3& center, const vec3& extent)
+{
+    BoundingBox box;
+    box.center = center;
+    box.extent = extent;
+    return box;
+}
+
+testing_func(OcclusionCullerTest, TestWallOccludes)
+{
+    OcclusionCuller::UniquePtr pCuller = createWallScene();
+
+    // A grid of small boxes behind the wall
+    uint32_t occluded = 0;
+    uint32_t tested = 0;
+    for (int32_t x = -2; x <= 2; x++)
+    {
+        for (int32_t y = -2; y <= 2; y++)
+        {
+            tested++;
+            occluded += pCuller->isOccluded(createBox(vec3(x * 4, y * 4, -30), vec3(1))) ? 1 : 0;
+        }
+    }
+    pCuller->recordTests(tested, occluded);
+
+    if (occluded != tested)
+    {
+        return test_fail("Boxes behind the wall weren't occluded");
+    }
+
+    const BoundingBox visibleBoxes[] =
+    {
+        createBox(vec3(0, 0, -5), vec3(1)),     // In front of the wall
+        createBox(vec3(0, 0, -10), vec3(1)),    // Intersects the wall
+        createBox(vec3(60, 0, -30), vec3(1)),   // Behind the wall, but to the side of it
+        createBox(vec3(0, 0, -30), vec3(40, 1, 1)), // Wider than the wall
+        createBox(vec3(0, 0, 5), vec3(1)),      // Behind the camera
+        createBox(vec3(0, 0, -kWallDistance), vec3(kWallHalfSize, kWallHalfSize, 0)), // The wall's own box
+    };
+
+    for (const auto& box : visibleBoxes)
+    {
+        if (pCuller->isOccluded(box))
+        {
+            return test_fail("A box which isn't hidden by the wall was occluded");
+        }
+    }
+    pCuller->recordTests(arraysize(visibleBoxes), 0);
+
+    const OcclusionCuller::Statistics stats = pCuller->getStatistics();
+    if (stats.occluderTriangleCount != 2)
+    {
+        return test_fail("Wrong number of occluder triangles");
+    }
+
+    const std::string counts = "Tested " + std::to_string(stats.testedBoxCount) + " boxes, occluded " + std::to_string(stats.occludedBoxCount);
+    return TestBase::TestData(TestBase::TestResult::Pass, mName, counts);
+}
+
+testing_func(OcclusionCullerTest, TestNoFalseOcclusion)
+{
+    OcclusionCuller::UniquePtr pCuller = createWallScene();
+
+    // A box is really hidden if all its corners are behind the wall plane and project inside the wall
+    auto isHidden = [](const BoundingBox& box)
+    {
+        for (uint32_t corner = 0; corner < 8; corner++)
+        {
+            const vec3 sign((corner & 1) ? 1.0f : -1.0f, (corner & 2) ? 1.0f : -1.0f, (corner & 4) ? 1.0f : -1.0f);
+            const vec3 p = box.center + box.extent * sign;
+            if (p.z >= -kWallDistance)
+            {
+                return false;
+            }
+            const vec2 onWall = vec2(p.x, p.y) * (kWallDistance / -p.z);
+            if (abs(onWall.x) > kWallHalfSize || abs(onWall.y) > kWallHalfSize)
+            {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    const uint32_t kBoxCount = 100000;
+    uint32_t occluded = 0;
+    uint32_t hidden = 0;
+    for (uint32_t i = 0; i < kBoxCount; i++)
+    {
+        const vec3 center = vec3(TestHelper::randFloatZeroToOne() * 2 - 1, TestHelper::randFloatZeroToOne() * 2 - 1, -TestHelper::randFloatZeroToOne()) * vec3(40, 20, 60);
+        const vec3 extent = vec3(TestHelper::randFloatZeroToOne(), TestHelper::randFloatZeroToOne(), TestHelper::randFloatZeroToOne()) * 3.0f;
+        const BoundingBox box = createBox(center, extent);
+
+        const bool isOccluded = pCuller->isOccluded(box);
+        const bool reallyHidden = isHidden(box);
+        occluded += isOccluded ? 1 : 0;
+        hidden += reallyHidden ? 1 : 0;
+
+        if (isOccluded && reallyHidden == false)
+        {
+            return test_fail("A visible box was occluded");
+        }
+    }
+    pCuller->recordTests(kBoxCount, occluded);
+
+    const std::string counts = std::to_string(occluded) + " of " + std::to_string(hidden) + " hidden boxes were occluded";
+    return TestBase::TestData(TestBase::TestResult::Pass, mName, counts);
+}
+
+testing_func(OcclusionCullerTest, TestNearPlane)
+{
+    // A floor which starts between the eye and the near plane, and a box which crosses the near plane
+    const vec3 positions[] = { vec3(-10, -1, -0.05f), vec3(10, -1, -0.05f), vec3(10, -1, -50), vec3(-10, -1, -50) };
+    const uint32_t indices[] = { 0, 1, 2, 0, 2, 3 };
+    const mat4 view = lookAt(vec3(0, 0, 0), vec3(0, 0, -1), vec3(0, 1, 0));
+    const BoundingBox box = createBox(vec3(0, -1, -5), vec3(1, 1, 5));
+
+    // With an orthographic projection, w is always one, so only the depth tells that the floor crosses the near plane
+    const mat4 projections[] =
+    {
+        perspectiveMatrix(radians(60.0f), 2.0f, 0.1f, 1000.0f),
+        orthographicMatrix(-20, 20, -10, 10, 0.1f, 1000.0f),
+    };
+
+    for (const mat4& proj : projections)
+    {
+        OcclusionCuller::UniquePtr pCuller = OcclusionCuller::create();
+        pCuller->beginFrame(proj * view);
+        pCuller->rasterizeOccluder(positions, indices, arraysize(indices), mat4());
+        pCuller->finalizeOccluders();
+
+        if (pCuller->getStatistics().occluderTriangleCount != 0)
+        {
+            return test_fail("Occluder triangles crossing the near plane were rasterized");
+        }
+        if (pCuller->isOccluded(box))
+        {
+            return test_fail("A box crossing the near plane was occluded");
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    OcclusionCullerTest oct;
+    oct.init();
+    oct.run();
+    return 0;
+}
@@ -0,0 +1,181 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "PixelConversionTest.h"
+#include "Graphics/Model/Loaders/BinaryImage.hpp"
+#include "Utils/CpuTimer.h"
+#include "glm/gtc/packing.hpp"
+#include <random>
+#include <functional>
+
+// The size of the textures the benchmark converts, as large as the ones binary models usually embed
+static const uint32_t kTextureSize = 2048;
+static const uint32_t kBenchmarkRepeatCount = 5;
+
+void PixelConversionTest::addTests()
+{
+    addTestToList<TestPixelConversion>();
+    addTestToList<BenchmarkPixelConversion>();
+}
+
+testing_func(PixelConversionTest, TestPixelConversion)
+{
+    // Every width up to a few SIMD steps, so the kernels' scalar tails are covered. Two rows check the strides.
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<float> floatDist(-70000.0f, 70000.0f);
+    for(uint32_t width = 1; width <= 40; width++)
+    {
+        const uint32_t count = width * 2;
+        std::vector<uint8_t> rgb(count * 3), bgra(count * 4), rgba(count * 4);
+        std::vector<float> rgb32(count * 3), rgba32(count * 4);
+        std::vector<uint16_t> half(count * 4);
+        for(uint8_t& value : rgb) value = (uint8_t)rng();
+        for(uint8_t& value : bgra) value = (uint8_t)rng();
+        for(float& value : rgb32) value = floatDist(rng);
+
+        FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, rgba.data(), width * 4, FW::ImageFormat::R8_G8_B8, rgb.data(), width * 3, width, 2);
+        for(uint32_t i = 0; i < count; i++)
+        {
+            if(rgba[i * 4] != rgb[i * 3] || rgba[i * 4 + 1] != rgb[i * 3 + 1] || rgba[i * 4 + 2] != rgb[i * 3 + 2] || rgba[i * 4 + 3] != 0xff)
+            {
+                return test_fail("R8_G8_B8 to R8_G8_B8_A8 conversion is wrong");
+            }
+        }
+
+        FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, rgba.data(), width * 4, FW::ImageFormat::BGRA_8888, bgra.data(), width * 4, width, 2);
+        for(uint32_t i = 0; i < count; i++)
+        {
+            if(rgba[i * 4] != bgra[i * 4 + 2] || rgba[i * 4 + 1] != bgra[i * 4 + 1] || rgba[i * 4 + 2] != bgra[i * 4] || rgba[i * 4 + 3] != bgra[i * 4 + 3])
+            {
+                return test_fail("BGRA_8888 to R8_G8_B8_A8 conversion is wrong");
+            }
+        }
+
+        // The generic path must agree with the kernel on the channel order
+        FW::blitPixels(FW::ImageFormat::RGBA_Vec4f, (uint8_t*)rgba32.data(), width * 16, FW::ImageFormat::BGRA_8888, bgra.data(), width * 4, width, 2);
+        for(uint32_t i = 0; i < count * 4; i++)
+        {
+            if(rgba32[i] != rgba[i] / 255.0f)
+            {
+                return test_fail("BGRA_8888 generic conversion doesn't match the kernel");
+            }
+        }
+
+        FW::blitPixels(FW::ImageFormat::RGBA_Vec4f, (uint8_t*)rgba32.data(), width * 16, FW::ImageFormat::RGB_Vec3f, (const uint8_t*)rgb32.data(), width * 12, width, 2);
+        FW::blitToRGBAHalf(half.data(), width * 8, FW::ImageFormat::RGB_Vec3f, (const uint8_t*)rgb32.data(), width * 12, width, 2);
+        for(uint32_t i = 0; i < count; i++)
+        {
+            if(memcmp(&rgba32[i * 4], &rgb32[i * 3], sizeof(float) * 3) != 0 || rgba32[i * 4 + 3] != 1.0f || half[i * 4 + 3] != 0x3c00)
+            {
+                return test_fail("RGB_Vec3f to RGBA conversion is wrong");
+            }
+            for(uint32_t c = 0; c < 3; c++)
+            {
+                // Within half an ULP, which is 2^-25 for the subnormal halves, and infinite past the largest half
+                const float source = rgb32[i * 3 + c];
+                const float converted = glm::unpackHalf1x16(half[i * 4 + c]);
+                const bool isValid = (fabs(source) >= 65520.0f) ? (std::isinf(converted) && (converted > 0) == (source > 0)) : (fabs(converted - source) <= std::max(fabs(source) * (1.0f / 2048.0f), 1.0f / 33554432.0f));
+                if(isValid == false)
+                {
+                    return test_fail("RGB_Vec3f to half conversion is wrong");
+                }
+            }
+        }
+    }
+
+    // The generic path. BGR_888 stores blue in the first byte.
+    const uint8_t bgr[3] = { 51, 102, 255 };
+    float rgbaFloat[4];
+    FW::blitPixels(FW::ImageFormat::RGBA_Vec4f, (uint8_t*)rgbaFloat, 16, FW::ImageFormat::BGR_888, bgr, 3, 1, 1);
+    if(rgbaFloat[0] != 1.0f || rgbaFloat[1] != 0.4f || rgbaFloat[2] != 0.2f || rgbaFloat[3] != 1.0f)
+    {
+        return test_fail("Generic conversion is wrong");
+    }
+    if(FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, nullptr, 0, FW::ImageFormat::S3TC_DXT1, nullptr, 0, 1, 1))
+    {
+        return test_fail("Compressed formats were accepted");
+    }
+
+    return test_pass();
+}
+
+testing_func(PixelConversionTest, BenchmarkPixelConversion)
+{
+    const uint32_t texelCount = kTextureSize * kTextureSize;
+    std::vector<uint8_t> rgb(texelCount * 3), rgba(texelCount * 4);
+    std::vector<float> rgb32(texelCount * 3), rgba32(texelCount * 4);
+    std::vector<uint16_t> half(texelCount * 4);
+    std::mt19937 rng(6);
+    for(uint8_t& value : rgb) value = (uint8_t)rng();
+    for(float& value : rgb32) value = (float)rng() / (float)rng.max();
+
+    // The per-texel loop the importer used before, for comparison
+    auto padRgbScalar = [&]()
+    {
+        for(uint32_t i = 0; i < texelCount; i++)
+        {
+            rgba[i * 4 + 0] = rgb[i * 3 + 0];
+            rgba[i * 4 + 1] = rgb[i * 3 + 1];
+            rgba[i * 4 + 2] = rgb[i * 3 + 2];
+            rgba[i * 4 + 3] = 0xff;
+        }
+    };
+
+    const std::pair<std::string, std::function<void()>> conversions[] =
+    {
+        { "RGB8 -> RGBA8 scalar", padRgbScalar },
+        { "RGB8 -> RGBA8", [&]() { FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, rgba.data(), kTextureSize * 4, FW::ImageFormat::R8_G8_B8, rgb.data(), kTextureSize * 3, kTextureSize, kTextureSize); } },
+        { "BGRA8 -> RGBA8", [&]() { FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, rgba.data(), kTextureSize * 4, FW::ImageFormat::BGRA_8888, rgba.data(), kTextureSize * 4, kTextureSize, kTextureSize); } },
+        { "RGB32F -> RGBA32F", [&]() { FW::blitPixels(FW::ImageFormat::RGBA_Vec4f, (uint8_t*)rgba32.data(), kTextureSize * 16, FW::ImageFormat::RGB_Vec3f, (const uint8_t*)rgb32.data(), kTextureSize * 12, kTextureSize, kTextureSize); } },
+        { "RGB32F -> RGBA16F", [&]() { FW::blitToRGBAHalf(half.data(), kTextureSize * 8, FW::ImageFormat::RGB_Vec3f, (const uint8_t*)rgb32.data(), kTextureSize * 12, kTextureSize, kTextureSize); } },
+        { "BGR8 -> RGBA8 generic", [&]() { FW::blitPixels(FW::ImageFormat::R8_G8_B8_A8, rgba.data(), kTextureSize * 4, FW::ImageFormat::BGR_888, rgb.data(), kTextureSize * 3, kTextureSize, kTextureSize); } },
+    };
+
+    std::string results;
+    for(const auto& conversion : conversions)
+    {
+        float best = FLT_MAX;
+        for(uint32_t i = 0; i < kBenchmarkRepeatCount; i++)
+        {
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            conversion.second();
+            best = std::min(best, CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint()));
+        }
+        results += (results.empty() ? "" : ", ") + conversion.first + " " + std::to_string(best) + "ms";
+    }
+
+    logInfo("Pixel conversion of " + std::to_string(kTextureSize) + "x" + std::to_string(kTextureSize) + " texels: " + results + " (best of " + std::to_string(kBenchmarkRepeatCount) + ")");
+    return test_pass();
+}
+
+int main()
+{
+    PixelConversionTest pct;
+    pct.init(true);
+    pct.run();
+    return 0;
+}
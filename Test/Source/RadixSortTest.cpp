@@ -0,0 +1,90 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "RadixSortTest.h"
+#include "Utils/Math/RadixSort.h"
+#include <random>
+#include <algorithm>
+
+void RadixSortTest::addTests()
+{
+    addTestToList<TestMatchesStableSort>();
+}
+
+testing_func(RadixSortTest, TestMatchesStableSort)
+{
+    std::mt19937_64 rng(3);
+
+    // The masks select which key bits are random, so some digit passes are skipped and many keys are equal
+    const uint64_t keyMasks[] = { ~0ull, 0xFFull, 0xF0F0ull, 0xFF00000000000000ull, 0x3ull, 0 };
+    const uint32_t counts[] = { 0, 1, 2, 3, 255, 256, 1000, 65537 };
+
+    // The scratch buffers are shared by all the sorts, like the scene renderer does across frames
+    std::vector<uint64_t> keyScratch;
+    std::vector<uint32_t> valueScratch;
+
+    for (uint64_t mask : keyMasks)
+    {
+        for (uint32_t count : counts)
+        {
+            std::vector<uint64_t> keys(count);
+            std::vector<uint32_t> values(count);
+            std::vector<std::pair<uint64_t, uint32_t>> expected(count);
+            for (uint32_t i = 0; i < count; i++)
+            {
+                keys[i] = rng() & mask;
+                values[i] = i;
+                expected[i] = { keys[i], i };
+            }
+
+            std::stable_sort(expected.begin(), expected.end(), [](const std::pair<uint64_t, uint32_t>& a, const std::pair<uint64_t, uint32_t>& b) { return a.first < b.first; });
+            radixSort(keys, values, keyScratch, valueScratch);
+
+            if (keys.size() != count || values.size() != count)
+            {
+                return test_fail("The sort changed the number of items");
+            }
+            for (uint32_t i = 0; i < count; i++)
+            {
+                if (keys[i] != expected[i].first || values[i] != expected[i].second)
+                {
+                    return test_fail("The sort doesn't match std::stable_sort for " + std::to_string(count) + " keys");
+                }
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    RadixSortTest rst;
+    rst.init(true);
+    rst.run();
+    return 0;
+}
@@ -0,0 +1,172 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "SceneRaycasterTest.h"
+#include "Graphics/Scene/SceneRaycaster.h"
+#include <fstream>
+
+static const std::string kModelFilename = "SceneRaycasterTest.obj";
+
+void SceneRaycasterTest::addTests()
+{
+    addTestToList<TestClosestHit>();
+    addTestToList<TestHiddenInstances>();
+    addTestToList<TestNoCpuGeometry>();
+}
+
+SceneRaycasterTest::~SceneRaycasterTest()
+{
+    std::remove(kModelFilename.c_str());
+}
+
+void SceneRaycasterTest::writeTestModel(const std::string& filename)
+{
+    // A quad covering [-1, 1] in X and Y at z = 0, made of two triangles
+    std::ofstream file(filename);
+    file << "v -1 -1 0\nv 1 -1 0\nv 1 1 0\nv -1 1 0\n";
+    file << "f 1 2 3\nf 1 3 4\n";
+}
+
+// Three quads along the Z axis, at z = 0, -5 and -10
+static Scene::SharedPtr createTestScene(Model::LoadFlags flags)
+{
+    Model::SharedPtr pModel = Model::createFromFile(kModelFilename.c_str(), flags);
+    if(pModel == nullptr)
+    {
+        return nullptr;
+    }
+
+    Scene::SharedPtr pScene = Scene::create();
+    pScene->addModelInstance(pModel, "Front", vec3(0, 0, 0));
+    pScene->addModelInstance(pModel, "Middle", vec3(0, 0, -5));
+    pScene->addModelInstance(pModel, "Back", vec3(0, 0, -10));
+    return pScene;
+}
+
+testing_func(SceneRaycasterTest, TestClosestHit)
+{
+    writeTestModel(kModelFilename);
+    Scene::SharedPtr pScene = createTestScene(Model::LoadFlags::KeepCpuGeometry);
+    if(pScene == nullptr)
+    {
+        return test_fail("Failed to load the test model");
+    }
+    SceneRaycaster::UniquePtr pRaycaster = SceneRaycaster::create(pScene);
+
+    SceneRaycaster::Hit hit;
+    if(pRaycaster->raycast(vec3(0.5f, 0.25f, 10), vec3(0, 0, -1), hit) == false)
+    {
+        return test_fail("Ray through the quads missed");
+    }
+    if(hit.modelInstanceID != 0 || std::abs(hit.distance - 10.0f) > 1e-4f)
+    {
+        return test_fail("Closest hit is not the front quad");
+    }
+
+    // The triangle and barycentrics must reconstruct the hit point
+    const std::vector<vec3>& positions = pScene->getModel(hit.modelID)->getMesh(hit.meshID)->getCpuPositions();
+    const std::vector<uint32_t>& indices = pScene->getModel(hit.modelID)->getMesh(hit.meshID)->getCpuIndices();
+    const vec3 p0 = positions[indices[hit.triangleID * 3 + 0]];
+    const vec3 p1 = positions[indices[hit.triangleID * 3 + 1]];
+    const vec3 p2 = positions[indices[hit.triangleID * 3 + 2]];
+    const vec3 point = p0 * (1.0f - hit.barycentrics.x - hit.barycentrics.y) + p1 * hit.barycentrics.x + p2 * hit.barycentrics.y;
+    if(glm::length(point - vec3(0.5f, 0.25f, 0)) > 1e-4f)
+    {
+        return test_fail("Barycentrics don't match the hit point");
+    }
+
+    // Rays from behind hit the back quad first, distances are in units of the direction's length
+    if(pRaycaster->raycast(vec3(0, 0, -20), vec3(0, 0, 2), hit) == false || hit.modelInstanceID != 2 || std::abs(hit.distance - 5.0f) > 1e-4f)
+    {
+        return test_fail("Reversed ray didn't hit the back quad");
+    }
+
+    if(pRaycaster->raycast(vec3(0, 0, 10), vec3(0, 0, -1), hit, 9.0f))
+    {
+        return test_fail("Hit beyond the maximum distance");
+    }
+    if(pRaycaster->raycast(vec3(1.5f, 0, 10), vec3(0, 0, -1), hit) || pRaycaster->raycast(vec3(0, 0, 10), vec3(0, 0, 1), hit))
+    {
+        return test_fail("Ray beside or away from the quads hit");
+    }
+
+    return test_pass();
+}
+
+testing_func(SceneRaycasterTest, TestHiddenInstances)
+{
+    writeTestModel(kModelFilename);
+    Scene::SharedPtr pScene = createTestScene(Model::LoadFlags::KeepCpuGeometry);
+    if(pScene == nullptr)
+    {
+        return test_fail("Failed to load the test model");
+    }
+    SceneRaycaster::UniquePtr pRaycaster = SceneRaycaster::create(pScene);
+
+    SceneRaycaster::Hit hit;
+    pScene->getModelInstance(0, 0)->setVisible(false);
+    if(pRaycaster->raycast(vec3(0, 0, 10), vec3(0, 0, -1), hit) == false || hit.modelInstanceID != 1 || std::abs(hit.distance - 15.0f) > 1e-4f)
+    {
+        return test_fail("Hidden model instance was hit");
+    }
+
+    pScene->getModelInstance(0, 0)->setVisible(true);
+    pScene->getModel(0)->getMeshInstance(0, 0)->setVisible(false);
+    if(pRaycaster->raycast(vec3(0, 0, 10), vec3(0, 0, -1), hit))
+    {
+        return test_fail("Hidden mesh instance was hit");
+    }
+
+    return test_pass();
+}
+
+testing_func(SceneRaycasterTest, TestNoCpuGeometry)
+{
+    // Without CPU geometry nothing can be hit, which is why the scene editor falls back to GPU picking on a miss
+    writeTestModel(kModelFilename);
+    Scene::SharedPtr pScene = createTestScene(Model::LoadFlags::None);
+    if(pScene == nullptr)
+    {
+        return test_fail("Failed to load the test model");
+    }
+
+    SceneRaycaster::Hit hit;
+    if(SceneRaycaster::create(pScene)->raycast(vec3(0, 0, 10), vec3(0, 0, -1), hit))
+    {
+        return test_fail("Mesh without CPU geometry was hit");
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    SceneRaycasterTest srt;
+    srt.init(true);
+    srt.run();
+    return 0;
+}
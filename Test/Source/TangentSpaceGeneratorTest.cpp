@@ -0,0 +1,283 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "TangentSpaceGeneratorTest.h"
+#include "Graphics/Model/TangentSpaceGenerator.h"
+#include <fstream>
+#include <random>
+
+static const std::string kModelFilename = "TangentSpaceGeneratorTest.obj";
+
+void TangentSpaceGeneratorTest::addTests()
+{
+    addTestToList<TestMatchesSequentialGeneration>();
+    addTestToList<TestAssimpBitangents>();
+}
+
+TangentSpaceGeneratorTest::~TangentSpaceGeneratorTest()
+{
+    std::remove(kModelFilename.c_str());
+}
+
+// The sequential per-triangle code the importers used before TangentSpaceGenerator. Each triangle overwrites the bitangents of its vertices.
+static void generateReferenceBitangents(const std::vector<uint32_t>& indices, const std::vector<vec3>& positions, const std::vector<vec3>& normals, const std::vector<vec2>& uvs, std::vector<vec3>& bitangents)
+{
+    for(size_t first = 0; first + 3 <= indices.size(); first += 3)
+    {
+        const uint32_t* tri = indices.data() + first;
+        const vec3 posDelta[2] = { positions[tri[1]] - positions[tri[0]], positions[tri[2]] - positions[tri[0]] };
+        vec2 s = uvs[tri[1]] - uvs[tri[0]];
+        vec2 t = uvs[tri[2]] - uvs[tri[0]];
+        s.y = -s.y;
+        t.y = -t.y;
+
+        vec3 tangent;
+        vec3 bitangent;
+        if((s == vec2(0, 0)) || (t == vec2(0, 0)))
+        {
+            const vec3& normal = normals[tri[0]];
+            if(std::abs(normal.x) > std::abs(normal.y))
+            {
+                bitangent = vec3(normal.z, 0.f, -normal.x) / glm::length(vec2(normal.x, normal.z));
+            }
+            else
+            {
+                bitangent = vec3(0.f, normal.z, -normal.y) / glm::length(vec2(normal.y, normal.z));
+            }
+            tangent = glm::cross(bitangent, normal);
+        }
+        else
+        {
+            const float dirCorrection = (t.x * s.y - t.y * s.x) < 0.0f ? -1.0f : 1.0f;
+            tangent = (posDelta[1] * s.y - posDelta[0] * t.y) * dirCorrection;
+            bitangent = (posDelta[1] * s.x - posDelta[0] * t.x) * dirCorrection;
+        }
+
+        for(uint32_t i = 0; i < 3; i++)
+        {
+            const vec3& normal = normals[tri[i]];
+            const vec3 localTangent = glm::normalize(tangent - normal * glm::dot(tangent, normal));
+            vec3 localBitangent = glm::normalize(bitangent - normal * glm::dot(bitangent, normal));
+            localBitangent = glm::normalize(localBitangent - localTangent * glm::dot(localBitangent, localTangent));
+            if(std::isfinite(localBitangent.x) == false || std::isfinite(localBitangent.y) == false || std::isfinite(localBitangent.z) == false)
+            {
+                localBitangent = glm::normalize(glm::cross(localTangent, normal));
+            }
+            bitangents[tri[i]] = localBitangent;
+        }
+    }
+}
+
+testing_func(TangentSpaceGeneratorTest, TestMatchesSequentialGeneration)
+{
+    // Random triangles over shared vertices, with some collapsed texture coordinates and degenerate normals, split into two overlapping lists
+    const uint32_t vertexCount = 100000;
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1, 1);
+    std::vector<vec3> positions(vertexCount);
+    std::vector<vec3> normals(vertexCount);
+    std::vector<vec2> uvs(vertexCount);
+    for(uint32_t i = 0; i < vertexCount; i++)
+    {
+        positions[i] = vec3(dist(rng), dist(rng), dist(rng));
+        normals[i] = (i % 17 == 0) ? vec3(0) : glm::normalize(vec3(dist(rng), dist(rng), dist(rng)));
+        uvs[i] = (i % 5 == 0) ? vec2(0.5f) : vec2(dist(rng), dist(rng));
+    }
+    std::vector<uint32_t> indices(vertexCount * 6);
+    for(uint32_t& index : indices)
+    {
+        index = rng() % (vertexCount - vertexCount / 10);
+    }
+
+    std::vector<vec3> expected(vertexCount, vec3(2));
+    generateReferenceBitangents(indices, positions, normals, uvs, expected);
+
+    const uint32_t firstListSize = (uint32_t)indices.size() / 9 * 3;
+    TangentSpaceGenerator::MeshDesc desc;
+    std::vector<vec3> bitangents(vertexCount, vec3(2));
+    desc.pPositions = (const uint8_t*)positions.data();
+    desc.positionStride = sizeof(vec3);
+    desc.pNormals = (const uint8_t*)normals.data();
+    desc.normalStride = sizeof(vec3);
+    desc.pTexCrds = (const uint8_t*)uvs.data();
+    desc.texCrdStride = sizeof(vec2);
+    desc.vertexCount = vertexCount;
+    desc.submeshIndices = { indices.data(), indices.data() + firstListSize };
+    desc.submeshIndexCounts = { firstListSize, (uint32_t)indices.size() - firstListSize };
+    desc.pBitangents = (uint8_t*)bitangents.data();
+    desc.bitangentStride = sizeof(vec3);
+    if(TangentSpaceGenerator::generateBitangents(desc) == false)
+    {
+        return test_fail("Valid indices were rejected");
+    }
+
+    // Bit-identical, including the NaNs of the degenerate normals and the untouched unused vertices
+    if(memcmp(bitangents.data(), expected.data(), bitangents.size() * sizeof(vec3)) != 0)
+    {
+        return test_fail("Bitangents don't match the sequential generation");
+    }
+
+    indices[0] = vertexCount;
+    desc.submeshIndices = { indices.data() };
+    desc.submeshIndexCounts = { (uint32_t)indices.size() };
+    std::vector<vec3> unchanged = bitangents;
+    if(TangentSpaceGenerator::generateBitangents(desc) || memcmp(bitangents.data(), unchanged.data(), bitangents.size() * sizeof(vec3)) != 0)
+    {
+        return test_fail("Out of range indices were accepted");
+    }
+
+    return test_pass();
+}
+
+void TangentSpaceGeneratorTest::writeTestModel(const std::string& filename, uint32_t gridSize)
+{
+    // A curved grid with texture coordinates rotated against its axes, so that the bitangents differ per triangle
+    std::ofstream file(filename);
+    const float angle = 0.5f;
+    for(uint32_t y = 0; y <= gridSize; y++)
+    {
+        for(uint32_t x = 0; x <= gridSize; x++)
+        {
+            const float height = 0.3f * sin(x * 0.7f) * cos(y * 0.5f);
+            const vec3 normal = glm::normalize(vec3(-0.21f * cos(x * 0.7f) * cos(y * 0.5f), 1, 0.15f * sin(x * 0.7f) * sin(y * 0.5f)));
+            const vec2 uv = vec2(x * cos(angle) - y * sin(angle), x * sin(angle) + y * cos(angle)) / float(gridSize);
+            file << "v " << x << " " << height << " " << y << "\nvt " << uv.x << " " << uv.y << "\nvn " << normal.x << " " << normal.y << " " << normal.z << "\n";
+        }
+    }
+
+    for(uint32_t y = 0; y < gridSize; y++)
+    {
+        for(uint32_t x = 0; x < gridSize; x++)
+        {
+            // OBJ indices are 1-based
+            const uint32_t i = y * (gridSize + 1) + x + 1;
+            const uint32_t j = i + gridSize + 1;
+            file << "f " << i << "/" << i << "/" << i << " " << j << "/" << j << "/" << j << " " << i + 1 << "/" << i + 1 << "/" << i + 1 << "\n";
+            file << "f " << i + 1 << "/" << i + 1 << "/" << i + 1 << " " << j << "/" << j << "/" << j << " " << j + 1 << "/" << j + 1 << "/" << j + 1 << "\n";
+        }
+    }
+}
+
+// Reads a float3 attribute of the mesh's vertices back from its vertex buffer. Returns false if the mesh doesn't have it.
+static bool readAttribute(const Mesh* pMesh, uint32_t location, std::vector<vec3>& data)
+{
+    const Vao* pVao = pMesh->getVao().get();
+    const Vao::ElementDesc element = pVao->getElementIndexByLocation(location);
+    if(element.vbIndex == Vao::ElementDesc::kInvalidIndex)
+    {
+        return false;
+    }
+
+    const VertexBufferLayout::SharedConstPtr& pLayout = pVao->getVertexLayout()->getBufferLayout(element.vbIndex);
+    if(pLayout->getElementFormat(element.elementIndex) != ResourceFormat::RGB32Float)
+    {
+        return false;
+    }
+
+    const uint32_t stride = pLayout->getStride();
+    const uint32_t offset = pLayout->getElementOffset(element.elementIndex);
+    const Buffer::SharedPtr pBuffer = pVao->getVertexBuffer(element.vbIndex);
+    const uint8_t* pData = (const uint8_t*)pBuffer->map(Buffer::MapType::Read) + (size_t)pMesh->getBaseVertex() * stride;
+    data.resize(pMesh->getVertexCount());
+    for(uint32_t i = 0; i < pMesh->getVertexCount(); i++)
+    {
+        memcpy(&data[i], pData + (size_t)i * stride + offset, sizeof(vec3));
+    }
+    pBuffer->unmap();
+    return true;
+}
+
+testing_func(TangentSpaceGeneratorTest, TestAssimpBitangents)
+{
+    writeTestModel(kModelFilename, 32);
+    Model::SharedPtr pModel = Model::createFromFile(kModelFilename.c_str());
+    if(pModel == nullptr || pModel->getMeshCount() == 0)
+    {
+        return test_fail("Failed to load the test model");
+    }
+
+    // The bitangents the importer uploaded must be the ones the sequential code generates from the uploaded geometry
+    for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+    {
+        const Mesh* pMesh = pModel->getMesh(meshID).get();
+        std::vector<vec3> positions, normals, texCrds, bitangents;
+        if(readAttribute(pMesh, VERTEX_POSITION_LOC, positions) == false || readAttribute(pMesh, VERTEX_NORMAL_LOC, normals) == false || readAttribute(pMesh, VERTEX_TEXCOORD_LOC, texCrds) == false)
+        {
+            return test_fail("The test model is missing vertex attributes");
+        }
+        if(readAttribute(pMesh, VERTEX_BITANGENT_LOC, bitangents) == false)
+        {
+            return test_fail("The importer didn't generate bitangents");
+        }
+        if(pMesh->getVao()->getIndexBufferFormat() != ResourceFormat::R32Uint)
+        {
+            return test_fail("Unexpected index format");
+        }
+
+        const Buffer::SharedPtr pIndexBuffer = pMesh->getVao()->getIndexBuffer();
+        const uint32_t* pIndices = (const uint32_t*)pIndexBuffer->map(Buffer::MapType::Read) + pMesh->getStartIndex();
+        std::vector<uint32_t> indices(pIndices, pIndices + pMesh->getIndexCount());
+        pIndexBuffer->unmap();
+
+        std::vector<vec2> uvs(texCrds.size());
+        for(size_t i = 0; i < texCrds.size(); i++)
+        {
+            uvs[i] = vec2(texCrds[i]);
+        }
+        std::vector<vec3> expected(bitangents.size(), vec3(0));
+        generateReferenceBitangents(indices, positions, normals, uvs, expected);
+        if(memcmp(bitangents.data(), expected.data(), bitangents.size() * sizeof(vec3)) != 0)
+        {
+            return test_fail("The imported bitangents don't match the sequential generation");
+        }
+
+        for(size_t i = 0; i < bitangents.size(); i++)
+        {
+            if(fabs(glm::length(bitangents[i]) - 1.0f) > 1e-4f || fabs(glm::dot(bitangents[i], normals[i])) > 1e-4f)
+            {
+                return test_fail("An imported bitangent isn't a unit vector perpendicular to the normal");
+            }
+        }
+    }
+
+    pModel = Model::createFromFile(kModelFilename.c_str(), Model::LoadFlags::DontGenerateTangentSpace);
+    std::vector<vec3> bitangents;
+    if(pModel == nullptr || readAttribute(pModel->getMesh(0).get(), VERTEX_BITANGENT_LOC, bitangents))
+    {
+        return test_fail("Bitangents were generated although DontGenerateTangentSpace was set");
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    TangentSpaceGeneratorTest tsgt;
+    tsgt.init(true);
+    tsgt.run();
+    return 0;
+}
@@ -27,6 +27,11 @@
 ***************************************************************************/
 #include "TestHelper.h"
 #include "API/VertexLayout.h"
+#include "Graphics/Model/Loaders/BinaryModelExporter.h"
+#include "Graphics/Model/Loaders/BinaryModelSpec.h"
+#include "Graphics/Model/Loaders/BinaryImage.hpp"
+#include "Utils/BinaryFileStream.h"
+#include "Utils/CpuTimer.h"
 
 namespace Falcor
 {
@@ -89,5 +94,145 @@ namespace Falcor
         {
             return nearCompare(lhs.x, rhs.x) && nearCompare(lhs.y, rhs.y) && nearCompare(lhs.z, rhs.z) && nearCompare(lhs.w, rhs.w);
         }
+
+        // A height-field grid with a single texture, large enough for the file reads to dominate the import time
+        static const uint32_t kGridSize = 1024;
+        static const uint32_t kTextureSize = 2048;
+
+        static void writeString(BinaryFileStream& stream, const std::string& str)
+        {
+            stream << (int32_t)str.size();
+            stream.write(str.data(), str.size());
+        }
+
+        Model::SharedPtr importBinaryModel(const std::string& filename, BinaryModelImporter::InputMode inputMode, Model::LoadFlags flags, float& durationMs)
+        {
+            Model::SharedPtr pModel = Model::create();
+            CpuTimer::TimePoint start = CpuTimer::getCurrentTimePoint();
+            bool result = BinaryModelImporter::import(*pModel, filename, flags, inputMode);
+            durationMs = CpuTimer::calcDuration(start, CpuTimer::getCurrentTimePoint());
+            return result ? pModel : nullptr;
+        }
+
+        static void writeVersion8GridModel(const std::string& filename)
+        {
+            BinaryFileStream stream(filename, BinaryFileStream::Mode::Write);
+            const int32_t textureCount = 1;
+            const int32_t meshCount = 1;
+            const int32_t instanceCount = 1;
+            stream.write("BinScene", 8);
+            stream << (int32_t)8 << textureCount << meshCount << instanceCount;
+
+            // Texture
+            const int32_t texelCount = kTextureSize * kTextureSize;
+            std::vector<uint32_t> texels(texelCount);
+            for(int32_t i = 0; i < texelCount; i++)
+            {
+                texels[i] = ((i / 64) & 1) ? 0xffffffff : 0xff000000;
+            }
+            writeString(stream, "checker.png");
+            stream.write("BinImage", 8);
+            stream << (int32_t)2 << (int32_t)kTextureSize << (int32_t)kTextureSize << (int32_t)4 << (int32_t)0 << (int32_t)FW::ImageFormat::R8_G8_B8_A8 << (int32_t)(texelCount * 4);
+            stream.write(texels.data(), texelCount * 4);
+
+            // Mesh header. The tangents are skipped by the importer.
+            const int32_t vertexCount = kGridSize * kGridSize;
+            const int32_t submeshCount = 2;
+            stream << (int32_t)4 << vertexCount << submeshCount;
+            stream << (int32_t)AttribType_Position << (int32_t)AttribFormat_F32 << (int32_t)3;
+            stream << (int32_t)AttribType_Normal << (int32_t)AttribFormat_F32 << (int32_t)3;
+            stream << (int32_t)AttribType_Tangent << (int32_t)AttribFormat_F32 << (int32_t)3;
+            stream << (int32_t)AttribType_TexCoord << (int32_t)AttribFormat_F32 << (int32_t)2;
+
+            // Interleaved vertices
+            for(uint32_t y = 0; y < kGridSize; y++)
+            {
+                for(uint32_t x = 0; x < kGridSize; x++)
+                {
+                    const vec2 uv = vec2(x, y) / float(kGridSize - 1);
+                    stream << vec3(uv.x, sin(uv.x * 10.0f) * cos(uv.y * 10.0f), uv.y) << vec3(0, 1, 0) << vec3(1, 0, 0) << uv;
+                }
+            }
+
+            // Each submesh covers half of the rows. Only the first one is textured.
+            const uint32_t quadRowsPerSubmesh = (kGridSize - 1) / submeshCount;
+            for(int32_t submesh = 0; submesh < submeshCount; submesh++)
+            {
+                stream << vec3(0) << vec4(0.5f, 0.5f, 0.5f, 0) << vec3(0.1f) << 16.0f << 0.0f << 0.0f;
+                for(int32_t slot = 0; slot < TextureType_Max; slot++)
+                {
+                    stream << (int32_t)((submesh == 0 && slot == TextureType_Diffuse) ? 0 : -1);
+                }
+
+                const uint32_t firstRow = submesh * quadRowsPerSubmesh;
+                stream << (int32_t)(quadRowsPerSubmesh * (kGridSize - 1) * 2);
+                for(uint32_t y = firstRow; y < firstRow + quadRowsPerSubmesh; y++)
+                {
+                    for(uint32_t x = 0; x < kGridSize - 1; x++)
+                    {
+                        const uint32_t v = y * kGridSize + x;
+                        stream << v << v + kGridSize << v + 1 << v + 1 << v + kGridSize << v + kGridSize + 1;
+                    }
+                }
+            }
+
+            // Instance
+            stream << (int32_t)0 << (int32_t)1 << mat4();
+            writeString(stream, "grid");
+            writeString(stream, "");
+        }
+
+        void writeBinaryGridModel(const std::string& filename, const std::string& v9Filename)
+        {
+            writeVersion8GridModel(filename);
+
+            float duration;
+            Model::SharedPtr pModel = importBinaryModel(filename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::None, duration);
+            if(pModel)
+            {
+                BinaryModelExporter::exportToFile(v9Filename, pModel.get(), 9);
+            }
+        }
+
+        bool areModelsEqual(const Model* pA, const Model* pB, std::string& error)
+        {
+            if(pA->getMeshCount() != pB->getMeshCount())
+            {
+                error = "Mesh count doesn't match";
+                return false;
+            }
+
+            for(uint32_t meshID = 0; meshID < pA->getMeshCount(); meshID++)
+            {
+                const Mesh::SharedPtr& pMeshA = pA->getMesh(meshID);
+                const Mesh::SharedPtr& pMeshB = pB->getMesh(meshID);
+                if(pMeshA->getVertexCount() != pMeshB->getVertexCount() || pMeshA->getIndexCount() != pMeshB->getIndexCount())
+                {
+                    error = "Vertex or index count doesn't match";
+                    return false;
+                }
+
+                if(pMeshA->getCpuPositions() != pMeshB->getCpuPositions() || pMeshA->getCpuIndices() != pMeshB->getCpuIndices())
+                {
+                    error = "Vertex positions or indices don't match";
+                    return false;
+                }
+
+                const BoundingBox& boxA = pMeshA->getBoundingBox();
+                const BoundingBox& boxB = pMeshB->getBoundingBox();
+                if(boxA.center != boxB.center || boxA.extent != boxB.extent)
+                {
+                    error = "Bounding boxes don't match";
+                    return false;
+                }
+
+                if(pMeshA->getMaterial()->getTextureCount() != pMeshB->getMaterial()->getTextureCount())
+                {
+                    error = "Materials don't match";
+                    return false;
+                }
+            }
+            return true;
+        }
     }
 }
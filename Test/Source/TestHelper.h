@@ -27,6 +27,7 @@
 ***************************************************************************/
 #pragma once
 #include "Falcor.h"
+#include "Graphics/Model/Loaders/BinaryModelImporter.h"
 
 namespace Falcor
 {
@@ -38,5 +39,11 @@ namespace Falcor
         vec4 randVec4ZeroToOne();
         bool nearCompare(const float lhs, const float rhs);
         bool nearVec4(const vec4& lhs, const vec4& rhs);
+
+        // Writes a version 8 binary model of a textured grid with two meshes, and the same model exported as version 9
+        void writeBinaryGridModel(const std::string& filename, const std::string& v9Filename);
+        Model::SharedPtr importBinaryModel(const std::string& filename, BinaryModelImporter::InputMode inputMode, Model::LoadFlags flags, float& durationMs);
+        // Compares the meshes' counts, CPU geometry, bounding boxes and texture counts. Needs Model::LoadFlags::KeepCpuGeometry.
+        bool areModelsEqual(const Model* pA, const Model* pB, std::string& error);
     }
 }
@@ -0,0 +1,210 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "TextureCacheTest.h"
+#include "Graphics/TextureCache.h"
+#include "Utils/Bitmap.h"
+
+static const std::string kImageFilenames[3] = { "TextureCacheTestA.png", "TextureCacheTestB.png", "TextureCacheTestC.png" };
+static const uint32_t kTextureSize = 256;
+
+void TextureCacheTest::addTests()
+{
+    addTestToList<TestTexelDataSharing>();
+    addTestToList<TestFileSharing>();
+    addTestToList<TestEviction>();
+    addTestToList<TestDisabled>();
+}
+
+TextureCacheTest::~TextureCacheTest()
+{
+    for(const std::string& filename : kImageFilenames)
+    {
+        std::remove(filename.c_str());
+    }
+}
+
+std::vector<uint8_t> TextureCacheTest::createTexels(uint32_t seed)
+{
+    std::vector<uint8_t> texels(kTextureSize * kTextureSize * 4);
+    for(uint32_t i = 0; i < kTextureSize * kTextureSize; i++)
+    {
+        texels[i * 4 + 0] = (uint8_t)(i * seed);
+        texels[i * 4 + 1] = (uint8_t)(i / kTextureSize + seed);
+        texels[i * 4 + 2] = (uint8_t)(i % kTextureSize);
+        texels[i * 4 + 3] = 0xff;
+    }
+    return texels;
+}
+
+void TextureCacheTest::writeImage(const std::string& filename, uint32_t seed)
+{
+    std::vector<uint8_t> texels = createTexels(seed);
+    Bitmap::saveImage(filename, kTextureSize, kTextureSize, Bitmap::FileFormat::PngFile, Bitmap::ExportFlags::ExportAlpha, ResourceFormat::BGRA8Unorm, true, texels.data());
+}
+
+testing_func(TextureCacheTest, TestTexelDataSharing)
+{
+    TextureCache::clear();
+    TextureCache::resetStatistics();
+
+    // Identical texels are shared whatever their source is called
+    const std::vector<uint8_t> texels = createTexels(1);
+    Texture::SharedPtr pFirst = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, texels.data(), "first.png");
+    Texture::SharedPtr pSecond = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, texels.data(), "second.png");
+    if(pFirst == nullptr || pSecond != pFirst)
+    {
+        return test_fail("Identical texels weren't shared");
+    }
+
+    TextureCache::Statistics stats = TextureCache::getStatistics();
+    if(stats.missCount != 1 || stats.hitCount != 1 || stats.bytesSaved < (uint64_t)kTextureSize * kTextureSize * 4)
+    {
+        return test_fail("Wrong statistics after sharing a texture");
+    }
+
+    // A different format or content is a different texture
+    Texture::SharedPtr pSrgb = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8UnormSrgb, texels.data(), "first.png");
+    const std::vector<uint8_t> otherTexels = createTexels(2);
+    Texture::SharedPtr pOther = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, otherTexels.data(), "first.png");
+    if(pSrgb == nullptr || pOther == nullptr || pSrgb == pFirst || pOther == pFirst || pOther == pSrgb)
+    {
+        return test_fail("Different textures were shared");
+    }
+
+    stats = TextureCache::getStatistics();
+    if(stats.missCount != 3 || stats.hitCount != 1)
+    {
+        return test_fail("Wrong statistics after creating different textures");
+    }
+
+    TextureCache::clear();
+    return test_pass();
+}
+
+testing_func(TextureCacheTest, TestFileSharing)
+{
+    TextureCache::clear();
+    TextureCache::resetStatistics();
+
+    // Two paths to the same image share the texture. The third image has different content.
+    writeImage(kImageFilenames[0], 1);
+    writeImage(kImageFilenames[1], 1);
+    writeImage(kImageFilenames[2], 2);
+    Texture::SharedPtr pFirst = TextureCache::getTextureFromFile(kImageFilenames[0], true, false);
+    Texture::SharedPtr pSecond = TextureCache::getTextureFromFile(kImageFilenames[1], true, false);
+    Texture::SharedPtr pOther = TextureCache::getTextureFromFile(kImageFilenames[2], true, false);
+    if(pFirst == nullptr || pSecond == nullptr || pOther == nullptr)
+    {
+        return test_fail("Failed to load the test images");
+    }
+    if(pSecond != pFirst)
+    {
+        return test_fail("Identical image files weren't shared");
+    }
+    if(pOther == pFirst)
+    {
+        return test_fail("Different image files were shared");
+    }
+
+    // The load options are part of the identity
+    Texture::SharedPtr pSrgb = TextureCache::getTextureFromFile(kImageFilenames[0], true, true);
+    Texture::SharedPtr pNoMips = TextureCache::getTextureFromFile(kImageFilenames[0], false, false);
+    if(pSrgb == nullptr || pNoMips == nullptr || pSrgb == pFirst || pNoMips == pFirst || pNoMips == pSrgb)
+    {
+        return test_fail("Textures loaded with different options were shared");
+    }
+
+    TextureCache::Statistics stats = TextureCache::getStatistics();
+    if(stats.missCount != 4 || stats.hitCount != 1)
+    {
+        return test_fail("Wrong statistics after loading the images");
+    }
+
+    TextureCache::clear();
+    return test_pass();
+}
+
+testing_func(TextureCacheTest, TestEviction)
+{
+    TextureCache::clear();
+    TextureCache::resetStatistics();
+
+    const std::vector<uint8_t> texels = createTexels(3);
+    Texture::SharedPtr pTexture = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, texels.data(), "texture.png");
+    if(pTexture == nullptr)
+    {
+        return test_fail("Failed to create the texture");
+    }
+    if(TextureCache::evictReleased() != 0)
+    {
+        return test_fail("A texture still in use was evicted");
+    }
+
+    // Once released, the entry is evicted and the texture is created again
+    pTexture = nullptr;
+    if(TextureCache::evictReleased() != 1 || TextureCache::getStatistics().evictionCount != 1)
+    {
+        return test_fail("The released texture wasn't evicted");
+    }
+
+    pTexture = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, texels.data(), "texture.png");
+    TextureCache::Statistics stats = TextureCache::getStatistics();
+    if(pTexture == nullptr || stats.missCount != 2 || stats.hitCount != 0)
+    {
+        return test_fail("A released texture was reused");
+    }
+
+    TextureCache::clear();
+    return test_pass();
+}
+
+testing_func(TextureCacheTest, TestDisabled)
+{
+    TextureCache::clear();
+    TextureCache::resetStatistics();
+
+    TextureCache::setEnabled(false);
+    const std::vector<uint8_t> texels = createTexels(4);
+    Texture::SharedPtr pFirst = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, texels.data(), "texture.png");
+    Texture::SharedPtr pSecond = TextureCache::getTexture2D(kTextureSize, kTextureSize, ResourceFormat::RGBA8Unorm, texels.data(), "texture.png");
+    TextureCache::setEnabled(true);
+    if(pFirst == nullptr || pSecond == nullptr || pFirst == pSecond)
+    {
+        return test_fail("A texture was shared while the cache was disabled");
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    TextureCacheTest tct;
+    tct.init(true);
+    tct.run();
+    return 0;
+}
@@ -0,0 +1,141 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "ThreadPoolTest.h"
+#include "Utils/ThreadPool.h"
+#include <atomic>
+
+void ThreadPoolTest::addTests()
+{
+    addTestToList<TestParallelForCoverage>();
+    addTestToList<TestNestedParallelFor>();
+}
+
+testing_func(ThreadPoolTest, TestParallelForCoverage)
+{
+    const uint32_t kCases[][2] = { { 0, 1 }, { 1, 1 }, { 1, 16 }, { 7, 3 }, { 1000, 1 }, { 1000, 7 }, { 100000, 256 } };
+    ThreadPool::SharedPtr pSingle = ThreadPool::create(1);
+    ThreadPool::SharedPtr pMulti = ThreadPool::create(3);
+    if(pMulti->getThreadCount() != 4)
+    {
+        return test_fail("Thread count doesn't include the calling thread");
+    }
+
+    for(ThreadPool* pPool : { pSingle.get(), pMulti.get(), ThreadPool::getGlobalPool() })
+    {
+        for(const auto& c : kCases)
+        {
+            const uint32_t itemCount = c[0];
+            const uint32_t grainSize = c[1];
+            std::vector<std::atomic<uint32_t>> visits(itemCount);
+            for(auto& v : visits)
+            {
+                v = 0;
+            }
+            std::atomic<uint32_t> chunkCount(0);
+            std::atomic<bool> badChunk(false);
+
+            pPool->parallelFor(itemCount, grainSize, [&](uint32_t first, uint32_t last)
+            {
+                // Chunks start on a multiple of the grain size and are full, except for the last one
+                if(first % grainSize != 0 || last != std::min(first + grainSize, itemCount))
+                {
+                    badChunk = true;
+                }
+                for(uint32_t i = first; i < last; i++)
+                {
+                    visits[i]++;
+                }
+                chunkCount++;
+            });
+
+            if(badChunk)
+            {
+                return test_fail("A chunk has the wrong range");
+            }
+            if(chunkCount != ThreadPool::getChunkCount(itemCount, grainSize))
+            {
+                return test_fail("Chunk count doesn't match getChunkCount()");
+            }
+            for(uint32_t i = 0; i < itemCount; i++)
+            {
+                if(visits[i] != 1)
+                {
+                    return test_fail("Item " + std::to_string(i) + " of " + std::to_string(itemCount) + " was processed " + std::to_string(visits[i]) + " times");
+                }
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(ThreadPoolTest, TestNestedParallelFor)
+{
+    // Every outer chunk runs an inner loop on the same pool. With a single worker, both threads end up waiting on inner loops, which must not deadlock.
+    const uint32_t kOuterCount = 64;
+    const uint32_t kInnerCount = 1000;
+    for(uint32_t workerCount : { 1u, 3u })
+    {
+        ThreadPool::SharedPtr pPool = ThreadPool::create(workerCount);
+        std::vector<uint64_t> sums(kOuterCount, 0);
+        pPool->parallelFor(kOuterCount, 1, [&](uint32_t first, uint32_t last)
+        {
+            for(uint32_t outer = first; outer < last; outer++)
+            {
+                std::atomic<uint64_t> sum(0);
+                pPool->parallelFor(kInnerCount, 10, [&](uint32_t innerFirst, uint32_t innerLast)
+                {
+                    for(uint32_t inner = innerFirst; inner < innerLast; inner++)
+                    {
+                        sum += outer * kInnerCount + inner;
+                    }
+                });
+                sums[outer] = sum;
+            }
+        });
+
+        for(uint32_t outer = 0; outer < kOuterCount; outer++)
+        {
+            const uint64_t expected = (uint64_t)outer * kInnerCount * kInnerCount + (uint64_t)kInnerCount * (kInnerCount - 1) / 2;
+            if(sums[outer] != expected)
+            {
+                return test_fail("Nested loop " + std::to_string(outer) + " didn't process all its items");
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    ThreadPoolTest tpt;
+    tpt.init(true);
+    tpt.run();
+    return 0;
+}
@@ -0,0 +1,162 @@
+/***************************************************************************
+# Copyright (c) 2015, NVIDIA CORPORATION. All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions
+# are met:
+#  * Redistributions of source code must retain the above copyright
+#    notice, this list of conditions and the following disclaimer.
+#  * Redistributions in binary form must reproduce the above copyright
+#    notice, this list of conditions and the following disclaimer in the
+#    documentation and/or other materials provided with the distribution.
+#  * Neither the name of NVIDIA CORPORATION nor the names of its
+#    contributors may be used to endorse or promote products derived
+#    from this software without specific prior written permission.
+#
+# THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS ``AS IS'' AND ANY
+# EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+# IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+# PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+# CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+# EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+# PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+# PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY
+# OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+# (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+# OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+***************************************************************************/
+#include "VertexCompressionTest.h"
+#include "TestHelper.h"
+#include "Graphics/Model/Loaders/BinaryModelExporter.h"
+
+static const std::string kModelFilename = "VertexCompressionTest.bin";
+static const std::string kModelV9Filename = "VertexCompressionTestV9.bin";
+static const std::string kExportFilename = "VertexCompressionTestExport.bin";
+
+void VertexCompressionTest::addTests()
+{
+    addTestToList<TestCompressVertices>();
+    addTestToList<TestExportCompressedVertices>();
+}
+
+void VertexCompressionTest::onInit()
+{
+    TestHelper::writeBinaryGridModel(kModelFilename, kModelV9Filename);
+}
+
+VertexCompressionTest::~VertexCompressionTest()
+{
+    std::remove(kModelFilename.c_str());
+    std::remove(kModelV9Filename.c_str());
+    std::remove(kExportFilename.c_str());
+}
+
+static size_t getVertexBufferSize(const Model* pModel)
+{
+    size_t size = 0;
+    for(uint32_t meshID = 0; meshID < pModel->getMeshCount(); meshID++)
+    {
+        const Vao* pVao = pModel->getMesh(meshID)->getVao().get();
+        for(uint32_t i = 0; i < pVao->getVertexBuffersCount(); i++)
+        {
+            size += pVao->getVertexBuffer(i) ? pVao->getVertexBuffer(i)->getSize() : 0;
+        }
+    }
+    return size;
+}
+
+testing_func(VertexCompressionTest, TestCompressVertices)
+{
+    const Model::LoadFlags flags = Model::LoadFlags::KeepCpuGeometry | Model::LoadFlags::CompressVertices | Model::LoadFlags::QuantizePositions;
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pV8 = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, flags, duration);
+    Model::SharedPtr pV9 = TestHelper::importBinaryModel(kModelV9Filename, BinaryModelImporter::InputMode::Stream, flags, duration);
+    if(pOriginal == nullptr || pV8 == nullptr || pV9 == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    // The CPU geometry is taken before the compression, so it must match exactly
+    std::string error;
+    if(TestHelper::areModelsEqual(pOriginal.get(), pV8.get(), error) == false || TestHelper::areModelsEqual(pOriginal.get(), pV9.get(), error) == false)
+    {
+        return test_fail("Compressed import doesn't match the original. " + error);
+    }
+
+    for(const Model* pCompressed : { pV8.get(), pV9.get() })
+    {
+        if(getVertexBufferSize(pCompressed) * 2 > getVertexBufferSize(pOriginal.get()) + getVertexBufferSize(pOriginal.get()) / 4)
+        {
+            return test_fail("Compressed vertex buffers aren't much smaller");
+        }
+
+        // The dequantized box must contain the mesh's bounding box
+        for(uint32_t meshID = 0; meshID < pCompressed->getMeshCount(); meshID++)
+        {
+            const Mesh* pMesh = pCompressed->getMesh(meshID).get();
+            const BoundingBox& box = pMesh->getBoundingBox();
+            const glm::vec3 tolerance = 1e-3f * glm::max(pMesh->getPositionScale(), glm::vec3(1));
+            const glm::vec3 boxMin = pMesh->getPositionBias() - tolerance;
+            const glm::vec3 boxMax = pMesh->getPositionBias() + pMesh->getPositionScale() + tolerance;
+            if(glm::any(glm::lessThan(box.getMinPos(), boxMin)) || glm::any(glm::greaterThan(box.getMaxPos(), boxMax)))
+            {
+                return test_fail("Position quantization range doesn't cover the mesh");
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+testing_func(VertexCompressionTest, TestExportCompressedVertices)
+{
+    // The binary format has no compressed attributes, so the exporter decodes them. The quantized positions must come back within the quantization step.
+    float duration;
+    Model::SharedPtr pOriginal = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::KeepCpuGeometry, duration);
+    Model::SharedPtr pCompressed = TestHelper::importBinaryModel(kModelFilename, BinaryModelImporter::InputMode::MemoryMapped, Model::LoadFlags::CompressVertices | Model::LoadFlags::QuantizePositions, duration);
+    if(pOriginal == nullptr || pCompressed == nullptr)
+    {
+        return test_fail("Failed to import the test model");
+    }
+
+    for(uint32_t version : { 8u, 9u })
+    {
+        BinaryModelExporter::exportToFile(kExportFilename, pCompressed.get(), version);
+        Model::SharedPtr pExported = TestHelper::importBinaryModel(kExportFilename, BinaryModelImporter::InputMode::Stream, Model::LoadFlags::KeepCpuGeometry, duration);
+        std::remove(kExportFilename.c_str());
+        if(pExported == nullptr || pExported->getMeshCount() != pOriginal->getMeshCount())
+        {
+            return test_fail("Failed to import the exported version " + std::to_string(version) + " model");
+        }
+
+        for(uint32_t meshID = 0; meshID < pOriginal->getMeshCount(); meshID++)
+        {
+            const Mesh* pMeshA = pOriginal->getMesh(meshID).get();
+            const Mesh* pMeshB = pExported->getMesh(meshID).get();
+            if(pMeshA->getCpuIndices() != pMeshB->getCpuIndices() || pMeshA->getCpuPositions().size() != pMeshB->getCpuPositions().size())
+            {
+                return test_fail("Exported version " + std::to_string(version) + " mesh has different indices");
+            }
+
+            const glm::vec3 tolerance = pCompressed->getMesh(meshID)->getPositionScale() / 65535.0f + 1e-6f;
+            for(size_t i = 0; i < pMeshA->getCpuPositions().size(); i++)
+            {
+                if(glm::any(glm::greaterThan(glm::abs(pMeshA->getCpuPositions()[i] - pMeshB->getCpuPositions()[i]), tolerance)))
+                {
+                    return test_fail("Exported version " + std::to_string(version) + " positions weren't dequantized");
+                }
+            }
+        }
+    }
+
+    return test_pass();
+}
+
+int main()
+{
+    VertexCompressionTest vct;
+    vct.init(true);
+    vct.run();
+    return 0;
+}